@@ -0,0 +1,205 @@
+/**
+ * @file    AttitudeFilter.c
+ *
+ * Closed-loop attitude filter, shared by the Lab4 applications and the host
+ * tools. A port of IntegrateClosedLoop.m, written in the common subset of C
+ * and C++ so g++ can build it too.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <AttitudeFilter.h>
+
+
+/*  PRIVATE FUNCTIONS   */
+static void normalize(const float v[3], float out[3])
+{
+    float norm = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (norm != 0.0f)   // Avoid division by zero
+    {
+        out[0] = v[0] / norm;
+        out[1] = v[1] / norm;
+        out[2] = v[2] / norm;
+    }
+    else
+    {
+        out[0] = v[0];
+        out[1] = v[1];
+        out[2] = v[2];
+    }
+}
+
+static void cross(const float a[3], const float b[3], float out[3])
+{
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// out = R * v
+static void rotate(float R[3][3], const float v[3], float out[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        out[i] = R[i][0] * v[0] + R[i][1] * v[1] + R[i][2] * v[2];
+    }
+}
+
+
+/*
+ * Rexp.m: Rodrigues form of exp(-[w x] dt), keeps R on SO(3) so the product
+ * never needs re-orthogonalizing. Series below 0.2 rad/s as in the MATLAB.
+ */
+static void Rexp(const float w[3], float dt, float out[3][3])
+{
+    float wnorm = sqrtf(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    float sincW, oneMinusCosW;
+    if (wnorm < 0.2f)
+    {
+        float w2 = wnorm * wnorm, dt2 = dt * dt;
+        sincW = dt * (1.0f - dt2 * w2 / 6.0f + dt2 * dt2 * w2 * w2 / 120.0f);
+        oneMinusCosW = dt2 * (0.5f - dt2 * w2 / 24.0f + dt2 * dt2 * w2 * w2 / 720.0f);
+    }
+    else
+    {
+        sincW = sinf(wnorm * dt) / wnorm;
+        oneMinusCosW = (1.0f - cosf(wnorm * dt)) / (wnorm * wnorm);
+    }
+    // I - sincW [w x] + oneMinusCosW [w x]^2
+    float W[3][3] = {
+        {0.0f, -w[2], w[1]},
+        {w[2], 0.0f, -w[0]},
+        {-w[1], w[0], 0.0f}
+    };
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            float W2 = W[i][0] * W[0][j] + W[i][1] * W[1][j] + W[i][2] * W[2][j];
+            out[i][j] = (i == j ? 1.0f : 0.0f) - sincW * W[i][j] + oneMinusCosW * W2;
+        }
+    }
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** ATT_Init(f, gains, R0)
+ *
+ * Sets the gains, zeroes the bias estimate and starts from R0.
+ *
+ * @param   f       (ATT_Filter *)      filter
+ * @param   gains   (const ATT_Gains *) feedback gains
+ * @param   R0      (float[3][3])       initial DCM, NULL for the identity
+ */
+void ATT_Init(ATT_Filter *f, const ATT_Gains *gains, float R0[3][3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            f->R[i][j] = R0 != NULL ? R0[i][j] : (i == j ? 1.0f : 0.0f);
+        }
+        f->bias[i] = 0.0f;
+    }
+    f->gains = *gains;
+}
+
+/** ATT_Update(f, gyro, acc, mag, accInertial, magInertial, dt)
+ *
+ * One filter step. The accel and mag readings and references only need the
+ * right direction, they are normalized here.
+ *
+ * @param   f           (ATT_Filter *)  filter
+ * @param   gyro        (float[3])      body rate, rad/s
+ * @param   acc         (float[3])      accel reading
+ * @param   mag         (float[3])      mag reading
+ * @param   accInertial (float[3])      gravity in the inertial frame
+ * @param   magInertial (float[3])      Earth field in the inertial frame
+ * @param   dt          (float)         time step, s
+ */
+void ATT_Update(ATT_Filter *f, const float gyro[3], const float acc[3], const float mag[3],
+                const float accInertial[3], const float magInertial[3], float dt)
+{
+    float a[3], m[3], ai[3], mi[3], expected[3];
+    normalize(acc, a);
+    normalize(mag, m);
+    normalize(accInertial, ai);
+    normalize(magInertial, mi);
+
+    // error between measured and expected directions
+    float wmeas_a[3], wmeas_m[3];
+    rotate(f->R, ai, expected);
+    cross(a, expected, wmeas_a);
+    rotate(f->R, mi, expected);
+    cross(m, expected, wmeas_m);
+
+    const ATT_Gains *g = &f->gains;
+    float w[3];
+    for (int i = 0; i < 3; i++)
+    {
+        w[i] = gyro[i] - f->bias[i] + g->kp_acc * wmeas_a[i] + g->kp_mag * wmeas_m[i];
+        f->bias[i] += (-g->ki_acc * wmeas_a[i] - g->ki_mag * wmeas_m[i]) * dt;
+    }
+
+    // R+ = Rexp(w dt) * R
+    float dR[3][3], Rplus[3][3];
+    Rexp(w, dt, dR);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            Rplus[i][j] = dR[i][0] * f->R[0][j] + dR[i][1] * f->R[1][j] + dR[i][2] * f->R[2][j];
+        }
+    }
+    memcpy(f->R, Rplus, sizeof(Rplus));
+}
+
+
+/** ATT_TEST
+ *
+ * Uncomment the below "#define" to run the ATT_TEST.
+ *
+ * SUCCESS - No sensors needed: a still board 30 degrees off the starting
+ *           attitude with a 0.05 rad/s gyro bias on every axis. After 30 s
+ *           at 50 Hz the printed DCM is the tilted one and the bias
+ *           estimate reads 0.05, 0.05, 0.05.
+ */
+//#define ATT_TEST
+#ifdef ATT_TEST
+
+#include <Board.h>
+
+
+int main(void)
+{
+    BOARD_Init();
+
+    ATT_Gains gains = {5.0f, 0.5f, 5.0f, 0.5f};
+    ATT_Filter f;
+    ATT_Init(&f, &gains, NULL);
+
+    // body is rolled 30 degrees: R = Rx(30 deg)
+    float c = 0.8660254f, s = 0.5f;
+    float accInertial[3] = {0.0f, 0.0f, 1.0f};
+    float magInertial[3] = {22770.0f, 5329.0f, 41510.2f};
+    float acc[3] = {0.0f, s, c};
+    float mag[3] = {magInertial[0], c * magInertial[1] + s * magInertial[2], -s * magInertial[1] + c * magInertial[2]};
+    float gyro[3] = {0.05f, 0.05f, 0.05f};
+
+    for (int k = 0; k < 1500; k++)
+    {
+        ATT_Update(&f, gyro, acc, mag, accInertial, magInertial, 0.02f);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        printf("%8.4f %8.4f %8.4f\r\n", f.R[i][0], f.R[i][1], f.R[i][2]);
+    }
+    printf("bias %.4f, %.4f, %.4f\r\n", f.bias[0], f.bias[1], f.bias[2]);
+    while (TRUE);
+}
+
+#endif  /*  ATT_TEST    */
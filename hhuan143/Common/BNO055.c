@@ -15,6 +15,7 @@
 #include <BNO055.h> 
 #include <timers.h>
 #include <Board.h>
+#include <Bringup.h>
 
 
 /*  MODULE-LEVEL DEFINITIONS, MACROS    */
@@ -240,6 +241,19 @@ static enum
     OPERATION_MODE_NDOF = 0X0C
 } BNO055_opmode;
 
+// BNO055_InitStep() progress, each phase ends in a wait for the sensor
+typedef enum {
+    INIT_START,
+    INIT_CHECK_ID,
+    INIT_CONFIGURE,
+    INIT_UNITS,
+    INIT_MODE_SWITCH,
+    INIT_DONE,
+    INIT_FAILED,
+} BNO055_init_phase;
+
+static BNO055_init_phase init_phase = INIT_START;
+
 
 /*  PROTOTYPES  */
 void DelayMicros(uint32_t microsec);
@@ -257,83 +271,90 @@ void DelayMicros(uint32_t microsec);
  */
 int8_t BNO055_Init(void)
 {
-    BOARD_Init(); // Initialize board and printf functionality.
-    TIMER_Init(); // Initialize timer module for delay functions.
-    if (I2C_Init() != SUCCESS)
+    int32_t wait;
+    while ((wait = BNO055_InitStep()) >= 0)
     {
-        printf("I2C initialization error\r\n");
-        return ERROR;
+        DelayMicros(wait * 1000);
     }
+    return wait == BRINGUP_READY ? SUCCESS : ERROR;
+}
 
+/** BNO055_InitStep()
+ *
+ * BNO055_Init() one part at a time for Bringup.h: each call does the next
+ * part and returns the ms the sensor needs before the following one, so the
+ * ~1 s power-on wait can overlap other devices.
+ *
+ * @return  (int32_t)   wait in ms, BRINGUP_READY or BRINGUP_FAILED
+ */
+int32_t BNO055_InitStep(void)
+{
     unsigned char byteReturn;
-    // Delaying to ensure that successive programs do not glitch the sensor.
-    DelayMicros(1000000); 
-
-    // Read chip ID to verify sensor connection.
-    byteReturn = I2C_ReadRegister(BNO055_ADDRESS_A, BNO055_CHIP_ID_ADDR);
-    if (byteReturn != BNO055_ID)
+    switch (init_phase)
     {
-        return ERROR;
+        case INIT_START:
+            BOARD_Init(); // Initialize board and printf functionality.
+            TIMER_Init(); // Initialize timer module for delay functions.
+            if (I2C_Init() != SUCCESS)
+            {
+                printf("I2C initialization error\r\n");
+                init_phase = INIT_FAILED;
+                return BRINGUP_FAILED;
+            }
+            // Delaying to ensure that successive programs do not glitch the sensor.
+            init_phase = INIT_CHECK_ID;
+            return 1000;
+
+        case INIT_CHECK_ID:
+            // Read chip ID to verify sensor connection.
+            byteReturn = I2C_ReadRegister(BNO055_ADDRESS_A, BNO055_CHIP_ID_ADDR);
+            if (byteReturn != BNO055_ID)
+            {
+                init_phase = INIT_FAILED;
+                return BRINGUP_FAILED;
+            }
+            /**
+             * Default state is in CONFIG_MODE. This is the only mode in which all the 
+             * writable register map entries can be changed. (Exceptions from this rule
+             * are the interrupt registers (INT and INT_MSK) and the operation mode
+             * register (OPR_MODE), which can be modified in any operation mode.)
+             */
+            I2C_WriteReg(BNO055_ADDRESS_A, BNO055_OPR_MODE_ADDR, OPERATION_MODE_CONFIG);
+            // Delay between changing op modes > 19 msec.
+            init_phase = INIT_CONFIGURE;
+            return 25;
+
+        case INIT_CONFIGURE:
+            I2C_WriteReg(BNO055_ADDRESS_A, BNO055_PWR_MODE_ADDR, POWER_MODE_NORMAL);
+            // Set the register page to page 1.
+            I2C_WriteReg(BNO055_ADDRESS_A, BNO055_PAGE_ID_ADDR, BNO055_PAGE1);
+            // Config gyro for 250 dps.
+            I2C_WriteReg(BNO055_ADDRESS_A, BNO055_GYR_CONFIG_0, GYRO_CONFIG_PARAMS_0);
+            // Config accelerometer to +/- 2g.
+            I2C_WriteReg(BNO055_ADDRESS_A, BNO055_ACC_CONFIG, ACC_CONFIG_PARAMS);
+            // Set the register page to page 0.
+            I2C_WriteReg(BNO055_ADDRESS_A, BNO055_PAGE_ID_ADDR, BNO055_PAGE0);
+            init_phase = INIT_UNITS;
+            return 20;
+
+        case INIT_UNITS:
+            // Set units.
+            I2C_WriteReg(BNO055_ADDRESS_A, BNO055_UNIT_SEL_ADDR, UNITS_PARAM);
+            // Set operation mode to AMG.
+            I2C_WriteReg(BNO055_ADDRESS_A, BNO055_OPR_MODE_ADDR, OPERATION_MODE_AMG);
+            init_phase = INIT_MODE_SWITCH;
+            return 30;
+
+        case INIT_MODE_SWITCH:
+            init_phase = INIT_DONE;
+            return BRINGUP_READY;
+
+        case INIT_DONE:
+            return BRINGUP_READY;
+
+        default:
+            return BRINGUP_FAILED;
     }
-
-    /**
-     * Default state is in CONFIG_MODE. This is the only mode in which all the 
-     * writable register map entries can be changed. (Exceptions from this rule
-     * are the interrupt registers (INT and INT_MSK) and the operation mode
-     * register (OPR_MODE), which can be modified in any operation mode.)
-     */
-    byteReturn = I2C_WriteReg(
-        BNO055_ADDRESS_A,
-        BNO055_OPR_MODE_ADDR,
-        OPERATION_MODE_CONFIG
-    );
-    // Delay between changing op modes > 19 msec.
-    DelayMicros(25000);
-    byteReturn = I2C_WriteReg(
-        BNO055_ADDRESS_A,
-        BNO055_PWR_MODE_ADDR,
-        POWER_MODE_NORMAL
-    );
-    // Set the register page to page 1.
-    byteReturn = I2C_WriteReg(
-        BNO055_ADDRESS_A,
-        BNO055_PAGE_ID_ADDR,
-        BNO055_PAGE1
-    );
-    // Config gyro for 250 dps.
-    byteReturn = I2C_WriteReg(
-        BNO055_ADDRESS_A,
-        BNO055_GYR_CONFIG_0,
-        GYRO_CONFIG_PARAMS_0
-    );
-    // Config accelerometer to +/- 2g.
-    byteReturn = I2C_WriteReg(
-        BNO055_ADDRESS_A,
-        BNO055_ACC_CONFIG,
-        ACC_CONFIG_PARAMS
-    );
-    // Set the register page to page 0.
-    byteReturn = I2C_WriteReg(
-        BNO055_ADDRESS_A,
-        BNO055_PAGE_ID_ADDR,
-        BNO055_PAGE0
-    );
-    // Set units.
-    DelayMicros(20000);
-    byteReturn = I2C_WriteReg(
-        BNO055_ADDRESS_A,
-        BNO055_UNIT_SEL_ADDR,
-        UNITS_PARAM
-    );
-    // Set operation mode to AMG.
-    byteReturn = I2C_WriteReg(
-        BNO055_ADDRESS_A,
-        BNO055_OPR_MODE_ADDR,
-        OPERATION_MODE_AMG
-    );
-    DelayMicros(30000);
-    return byteReturn;
-
 }
 
 /** BNO055_ReadAccelX()
@@ -468,6 +489,7 @@ void DelayMicros(uint32_t microsec)
 #include <stdio.h>
 #include <stdlib.h>
 #include <Board.h>
+#include <Bringup.h>
 #include <BNO055.h>
 
 int main(void)
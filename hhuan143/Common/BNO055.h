@@ -47,6 +47,16 @@
  */
 int8_t BNO055_Init(void);
 
+/** BNO055_InitStep()
+ *
+ * BNO055_Init() one part at a time for Bringup.h: each call does the next
+ * part and returns the ms the sensor needs before the following one, so the
+ * ~1 s power-on wait can overlap other devices.
+ *
+ * @return  (int32_t)   wait in ms, BRINGUP_READY or BRINGUP_FAILED
+ */
+int32_t BNO055_InitStep(void);
+
 /** BNO055_ReadAccelX()
  *
  * Reads sensor axis as given by name.
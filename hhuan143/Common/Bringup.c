@@ -0,0 +1,236 @@
+/**
+ * @file    Bringup.c
+ *
+ * Interleaved power-on initialization of several devices.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Board.h>
+#include <timers.h>
+#include <Bringup.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+typedef enum {
+    DEVICE_PENDING,
+    DEVICE_READY,
+    DEVICE_FAILED,
+    DEVICE_TIMED_OUT,
+} Status;
+
+typedef struct {
+    const char *name;
+    BRINGUP_Step step;
+    uint32_t deadline_us;               // from the start of BRINGUP_Run()
+    uint32_t due_us;                    // next step, from the start
+    uint32_t ready_us;                  // when it finished (ready or not), from the start
+    uint32_t busy_us;                   // time spent inside its steps
+    uint16_t steps;
+    Status status;
+} Device;
+
+static Device devices[BRINGUP_MAX_DEVICES];
+static uint8_t count;
+static uint32_t total_us;               // length of the last BRINGUP_Run()
+
+
+/*  PRIVATE FUNCTIONS   */
+// one step of a device that is due, elapsed is the time since the start
+static void step(Device *d, uint32_t elapsed)
+{
+    uint32_t begin = TIMERS_GetMicroSeconds();
+    int32_t result = d->step();
+    uint32_t end = TIMERS_GetMicroSeconds();
+    d->busy_us += end - begin;
+    d->steps++;
+    elapsed += end - begin;
+
+    if (result == BRINGUP_READY || result == BRINGUP_FAILED)
+    {
+        d->status = result == BRINGUP_READY ? DEVICE_READY : DEVICE_FAILED;
+        d->ready_us = elapsed;
+    }
+    else
+    {
+        d->due_us = elapsed + (uint32_t) result * 1000;
+    }
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** BRINGUP_Init()
+ *
+ * Forgets every device. TIMER_Init() must have run.
+ */
+void BRINGUP_Init(void)
+{
+    count = 0;
+    total_us = 0;
+}
+
+/** BRINGUP_Add(name, step, deadline_ms)
+ *
+ * Registers a device. Its first step runs as soon as BRINGUP_Run() starts.
+ *
+ * @param   name        (const char *)  for the report, not copied
+ * @param   step        (BRINGUP_Step)  returns a wait in ms, BRINGUP_READY
+ *                                      or BRINGUP_FAILED
+ * @param   deadline_ms (uint32_t)      time from the start of BRINGUP_Run()
+ *                                      the device must be ready by
+ * @return  (int8_t)    device id, or ERROR if the table is full
+ */
+int8_t BRINGUP_Add(const char *name, BRINGUP_Step step, uint32_t deadline_ms)
+{
+    if (step == NULL || count >= BRINGUP_MAX_DEVICES)
+    {
+        return ERROR;
+    }
+    Device empty = {0};
+    Device *d = &devices[count];
+    *d = empty;
+    d->name = name;
+    d->step = step;
+    d->deadline_us = deadline_ms * 1000;
+    d->status = DEVICE_PENDING;
+    return count++;
+}
+
+/** BRINGUP_Run()
+ *
+ * Steps every device until each one is ready, failed or past its deadline.
+ *
+ * @return  (int8_t)    SUCCESS if every device is ready, ERROR otherwise
+ */
+int8_t BRINGUP_Run(void)
+{
+    uint32_t start = TIMERS_GetMicroSeconds();
+    uint8_t pending = count;
+    while (pending > 0)
+    {
+        pending = 0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            Device *d = &devices[i];
+            if (d->status != DEVICE_PENDING)
+            {
+                continue;
+            }
+            uint32_t elapsed = TIMERS_GetMicroSeconds() - start;
+            if (elapsed >= d->due_us)
+            {
+                step(d, elapsed);
+            }
+            if (d->status == DEVICE_PENDING && d->due_us > d->deadline_us)
+            {
+                // would only get its next step after the deadline
+                d->status = DEVICE_TIMED_OUT;
+                d->ready_us = TIMERS_GetMicroSeconds() - start;
+            }
+            if (d->status == DEVICE_PENDING)
+            {
+                pending++;
+            }
+        }
+        // nothing else to do at boot, the waits are spent polling
+    }
+    total_us = TIMERS_GetMicroSeconds() - start;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (devices[i].status != DEVICE_READY)
+        {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/** BRINGUP_IsReady(id)
+ *
+ * @param   id  (int8_t)    from BRINGUP_Add()
+ * @return  (int8_t)    TRUE once the device finished its init, FALSE otherwise
+ */
+int8_t BRINGUP_IsReady(int8_t id)
+{
+    if (id < 0 || id >= count)
+    {
+        return FALSE;
+    }
+    return devices[id].status == DEVICE_READY;
+}
+
+/** BRINGUP_PrintReport()
+ *
+ * Prints each device's time to ready (or why it failed) and step count.
+ */
+void BRINGUP_PrintReport(void)
+{
+    static const char *status[] = {"pending", "ready", "FAILED", "TIMED OUT"};
+    printf("device       status    at ms  busy ms  steps\r\n");
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const Device *d = &devices[i];
+        printf("%-12s %-9s %6lu %8lu %6u\r\n", d->name, status[d->status],
+               (unsigned long) (d->ready_us / 1000), (unsigned long) (d->busy_us / 1000), d->steps);
+    }
+    printf("boot %lu ms\r\n", (unsigned long) (total_us / 1000));
+}
+
+
+/** BRINGUP_TEST
+ *
+ * Uncomment the below "#define" to run the BRINGUP_TEST.
+ *
+ * SUCCESS - "slow" (3 x 300 ms waits) is ready at about 900 ms and "fast"
+ *           (10 x 20 ms waits) at about 200 ms, so boot takes about 900 ms
+ *           instead of 1100; "stuck" times out at about 400 ms (its next
+ *           step would be past the 500 ms deadline), "broken" fails on its
+ *           second step, and the run returns ERROR.
+ */
+//#define BRINGUP_TEST
+#ifdef BRINGUP_TEST
+
+
+static int32_t slow(void)
+{
+    static uint8_t phase = 0;
+    return phase++ < 3 ? 300 : BRINGUP_READY;
+}
+
+static int32_t fast(void)
+{
+    static uint8_t phase = 0;
+    return phase++ < 10 ? 20 : BRINGUP_READY;
+}
+
+static int32_t stuck(void)
+{
+    return 100;
+}
+
+static int32_t broken(void)
+{
+    static uint8_t phase = 0;
+    return phase++ < 1 ? 10 : BRINGUP_FAILED;
+}
+
+int main(void)
+{
+    BOARD_Init();
+    TIMER_Init();
+
+    BRINGUP_Init();
+    BRINGUP_Add("slow", slow, 2000);
+    BRINGUP_Add("fast", fast, 2000);
+    BRINGUP_Add("stuck", stuck, 500);
+    BRINGUP_Add("broken", broken, 2000);
+    printf("run: %s\r\n", BRINGUP_Run() == SUCCESS ? "SUCCESS" : "ERROR");
+    BRINGUP_PrintReport();
+
+    while (TRUE);
+}
+
+#endif  /*  BRINGUP_TEST    */
@@ -54,6 +54,15 @@
 #include <stm32f4xx_hal_tim.h>
 
 
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define CAPTOUCH_PERIOD_QUEUE 32    // periods kept until CAPTOUCH_GetPeriod(), power of two
+
+typedef struct {
+    uint32_t time_us;               // TIMERS_GetMicroSeconds() of the rising edge
+    uint32_t period_us;             // time since the previous rising edge
+} CAPTOUCH_Period;
+
+
 /*  PROTOTYPES  */
 /** CAPTOUCH_Init()
  *
@@ -73,5 +82,16 @@ void CAPTOUCH_Init(void);
  */
 char CAPTOUCH_IsTouched(void);
 
+/** CAPTOUCH_GetPeriod(period)
+ *
+ * Takes the oldest oscillator period not read yet, for filtering every edge
+ * outside the interrupt. The last CAPTOUCH_PERIOD_QUEUE periods are kept,
+ * newer ones are lost while it is full. No I/O is done in this function.
+ *
+ * @param   period  (CAPTOUCH_Period *) filled in
+ * @return  (char)    [TRUE, FALSE] FALSE if none is waiting
+ */
+char CAPTOUCH_GetPeriod(CAPTOUCH_Period *period);
+
 
 #endif  /* CAPTOUCH_H */
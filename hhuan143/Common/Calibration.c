@@ -0,0 +1,169 @@
+/**
+ * @file    Calibration.c
+ *
+ * Single calibration stage for the IMU sensor triads (accel, mag, gyro).
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <Calibration.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+// Two copies per sensor, CAL_Set() fills the idle one and then flips the
+// index, so a CAL_Apply() from an interrupt never sees a half written map.
+static CAL_Affine cal_table[CAL_NUM_SENSORS][2];
+static volatile uint8_t cal_active[CAL_NUM_SENSORS];
+
+
+/*  FUNCTIONS   */
+/** CAL_Init()
+ *
+ * Resets every sensor to the identity map (out = raw).
+ */
+void CAL_Init(void)
+{
+    for (int s = 0; s < CAL_NUM_SENSORS; s++)
+    {
+        CAL_Identity(&cal_table[s][0]);
+        CAL_Identity(&cal_table[s][1]);
+        cal_active[s] = 0;
+    }
+}
+
+/** CAL_Identity(cal)
+ *
+ * Sets cal to the identity map.
+ */
+void CAL_Identity(CAL_Affine *cal)
+{
+    memset(cal, 0, sizeof(*cal));
+    cal->A[0][0] = 1.0f;
+    cal->A[1][1] = 1.0f;
+    cal->A[2][2] = 1.0f;
+}
+
+/** CAL_TwoPoint(cal, axis, rawA, valA, rawB, valB)
+ *
+ * Line through (rawA, valA) and (rawB, valB).
+ */
+void CAL_TwoPoint(CAL_Affine *cal, int axis, float rawA, float valA, float rawB, float valB)
+{
+    float gain = (valB - valA) / (rawB - rawA);
+    CAL_BiasScale(cal, axis, rawA - valA / gain, gain);
+}
+
+/** CAL_BiasScale(cal, axis, bias, gain)
+ *
+ * out = (raw - bias) * gain  ==>  A = gain, b = -bias * gain
+ */
+void CAL_BiasScale(CAL_Affine *cal, int axis, float bias, float gain)
+{
+    for (int j = 0; j < 3; j++)
+    {
+        cal->A[axis][j] = 0.0f;
+    }
+    cal->A[axis][axis] = gain;
+    cal->b[axis] = -bias * gain;
+}
+
+/** CAL_PreMultiply(cal, M)
+ *
+ * A = A * M, b is unchanged since M acts on the raw vector only.
+ */
+void CAL_PreMultiply(CAL_Affine *cal, const float M[3][3])
+{
+    float res[3][3];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            res[i][j] = cal->A[i][0] * M[0][j]
+                      + cal->A[i][1] * M[1][j]
+                      + cal->A[i][2] * M[2][j];
+        }
+    }
+    memcpy(cal->A, res, sizeof(res));
+}
+
+/** CAL_Set(sensor, cal)
+ *
+ * Installs the map used by CAL_Apply() for the given sensor. The new map is
+ * copied into the idle buffer and published with a single byte write.
+ */
+void CAL_Set(CAL_Sensor sensor, const CAL_Affine *cal)
+{
+    uint8_t idle = cal_active[sensor] ^ 1;
+    cal_table[sensor][idle] = *cal;
+    __asm volatile ("" ::: "memory");
+    cal_active[sensor] = idle;
+}
+
+/** CAL_Get(sensor, cal)
+ *
+ * Copies out the map currently installed for the given sensor.
+ */
+void CAL_Get(CAL_Sensor sensor, CAL_Affine *cal)
+{
+    *cal = cal_table[sensor][cal_active[sensor]];
+}
+
+/** CAL_Apply(sensor, raw, out)
+ *
+ * One multiply-add chain per output axis, the FPU contracts these to VFMA.
+ */
+void CAL_Apply(CAL_Sensor sensor, const int16_t raw[3], float out[3])
+{
+    const CAL_Affine *c = &cal_table[sensor][cal_active[sensor]];
+    float x = raw[0];
+    float y = raw[1];
+    float z = raw[2];
+
+    out[0] = c->b[0] + c->A[0][0] * x + c->A[0][1] * y + c->A[0][2] * z;
+    out[1] = c->b[1] + c->A[1][0] * x + c->A[1][1] * y + c->A[1][2] * z;
+    out[2] = c->b[2] + c->A[2][0] * x + c->A[2][1] * y + c->A[2][2] * z;
+}
+
+
+/** CAL_TEST
+ *
+ * Uncomment the below "#define" to run the CAL_TEST.
+ *
+ * SUCCESS - Accelerometer is printed in g's: ~(0, 0, 1) when the IMU is face
+ *           up and ~(1, 0, 0) when facing forward.
+ */
+//#define CAL_TEST
+#ifdef CAL_TEST
+
+#include <Board.h>
+#include <BNO055.h>
+
+
+int main(void)
+{
+    BOARD_Init();
+    BNO055_Init();
+    CAL_Init();
+
+    // Nominal +/-2g range, 1000 LSB/g.
+    CAL_Affine acc;
+    CAL_Identity(&acc);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        CAL_TwoPoint(&acc, axis, -1000.0f, -1.0f, 1000.0f, 1.0f);
+    }
+    CAL_Set(CAL_ACCEL, &acc);
+
+    while (TRUE)
+    {
+        int16_t raw[3] = {BNO055_ReadAccelX(), BNO055_ReadAccelY(), BNO055_ReadAccelZ()};
+        float g[3];
+        CAL_Apply(CAL_ACCEL, raw, g);
+        printf("%6d %6d %6d -> %6.3f %6.3f %6.3f\r\n", raw[0], raw[1], raw[2], g[0], g[1], g[2]);
+        HAL_Delay(100);
+    }
+}
+
+#endif  /*  CAL_TEST    */
@@ -0,0 +1,124 @@
+/**
+ * @file    Calibration.h
+ *
+ * Single calibration stage for the IMU sensor triads (accel, mag, gyro).
+ * Every sensor is described by one affine map
+ *
+ *      out = A * raw + b
+ *
+ * where A holds scale factors, cross coupling and misalignment and b holds the
+ * offset in output units. The maps are built once at init from whatever
+ * calibration constants the application has (2-point tumble values, bias and
+ * scale factors, misalignment matrices) and afterwards every raw sample is
+ * converted with a single fused multiply-add pass.
+ *
+ * Matrices are row-major, same as MatrixMath.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef CALIBRATION_H
+#define	CALIBRATION_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+typedef enum {
+    CAL_ACCEL,
+    CAL_MAG,
+    CAL_GYRO,
+    CAL_NUM_SENSORS
+} CAL_Sensor;
+
+/** Affine calibration for one sensor triad: out = A * raw + b. */
+typedef struct {
+    float A[3][3];
+    float b[3];
+} CAL_Affine;
+
+
+/*  PROTOTYPES  */
+/** CAL_Init()
+ *
+ * Resets every sensor to the identity map (out = raw).
+ */
+void CAL_Init(void);
+
+/** CAL_Identity(cal)
+ *
+ * Sets cal to the identity map.
+ *
+ * @param   cal     (CAL_Affine *)  map to reset
+ */
+void CAL_Identity(CAL_Affine *cal);
+
+/** CAL_TwoPoint(cal, axis, rawA, valA, rawB, valB)
+ *
+ * Sets the scale and offset of one axis from a 2-point calibration, so that
+ * rawA maps to valA and rawB maps to valB. Off-diagonal terms of the row are
+ * cleared.
+ *
+ * @param   cal     (CAL_Affine *)  map to modify
+ * @param   axis    (int)           0, 1 or 2 for x, y, z
+ * @param   rawA    (float)         raw reading of the first reference
+ * @param   valA    (float)         expected value of the first reference
+ * @param   rawB    (float)         raw reading of the second reference
+ * @param   valB    (float)         expected value of the second reference
+ */
+void CAL_TwoPoint(CAL_Affine *cal, int axis, float rawA, float valA, float rawB, float valB);
+
+/** CAL_BiasScale(cal, axis, bias, gain)
+ *
+ * Sets one axis to out = (raw - bias) * gain. Off-diagonal terms of the row
+ * are cleared.
+ *
+ * @param   cal     (CAL_Affine *)  map to modify
+ * @param   axis    (int)           0, 1 or 2 for x, y, z
+ * @param   bias    (float)         raw offset
+ * @param   gain    (float)         output units per raw count
+ */
+void CAL_BiasScale(CAL_Affine *cal, int axis, float bias, float gain);
+
+/** CAL_PreMultiply(cal, M)
+ *
+ * Folds a matrix that is applied to the raw vector before the existing map
+ * (e.g. a misalignment correction) into cal: A = A * M.
+ *
+ * @param   cal     (CAL_Affine *)  map to modify
+ * @param   M       (float[3][3])   matrix applied to the raw vector
+ */
+void CAL_PreMultiply(CAL_Affine *cal, const float M[3][3]);
+
+/** CAL_Set(sensor, cal)
+ *
+ * Installs the map used by CAL_Apply() for the given sensor. The swap is
+ * atomic with respect to CAL_Apply() called from an interrupt, as long as
+ * only one context calls CAL_Set() for a sensor.
+ *
+ * @param   sensor  (CAL_Sensor)        CAL_ACCEL, CAL_MAG or CAL_GYRO
+ * @param   cal     (const CAL_Affine *) map to copy in
+ */
+void CAL_Set(CAL_Sensor sensor, const CAL_Affine *cal);
+
+/** CAL_Get(sensor, cal)
+ *
+ * Copies out the map currently installed for the given sensor.
+ *
+ * @param   sensor  (CAL_Sensor)    CAL_ACCEL, CAL_MAG or CAL_GYRO
+ * @param   cal     (CAL_Affine *)  destination
+ */
+void CAL_Get(CAL_Sensor sensor, CAL_Affine *cal);
+
+/** CAL_Apply(sensor, raw, out)
+ *
+ * Converts a raw sensor triple to physical units.
+ *
+ * @param   sensor  (CAL_Sensor)    CAL_ACCEL, CAL_MAG or CAL_GYRO
+ * @param   raw     (int16_t[3])    raw x, y, z readings
+ * @param   out     (float[3])      calibrated x, y, z
+ */
+void CAL_Apply(CAL_Sensor sensor, const int16_t raw[3], float out[3]);
+
+
+#endif  /*  CALIBRATION_H   */
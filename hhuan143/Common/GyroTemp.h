@@ -0,0 +1,105 @@
+/**
+ * @file    GyroTemp.h
+ *
+ * Gyro bias against temperature. One bin per degree C (the BNO055 reports
+ * whole degrees) holds the raw bias of x, y, z in 1/16 counts and how much
+ * data went into it. Bins are taught from still periods while the board runs
+ * (see Stillness.h); empty bins are linearly interpolated from the nearest
+ * taught bins on either side and held flat past the ends.
+ *
+ * GTEMP_Apply() installs the bias for the current temperature in the CAL_GYRO
+ * map, so the gyro leaves the calibration stage already compensated and the
+ * closed-loop integral term only sees what the table doesn't know yet.
+ *
+ * The table is kept in the last flash sector (GTEMP_FLASH_SECTOR, 128 KB at
+ * GTEMP_FLASH_ADDR), which the application must not reach: link with
+ * GyroTemp.ld and the build fails if it does. Erasing it stalls the CPU for
+ * ~1-2 s, so save rarely.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef GYROTEMP_H
+#define	GYROTEMP_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define GTEMP_T_MIN (-10)               // temperature of bin 0, deg C
+#define GTEMP_BINS 80                   // -10 .. 69 deg C
+#define GTEMP_FRAC 16.0f                // stored bias units per raw count
+#define GTEMP_MAX_WEIGHT 8              // still periods a bin averages, then it tracks
+#define GTEMP_FLASH_SECTOR FLASH_SECTOR_7
+#define GTEMP_FLASH_ADDR 0x08060000u
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** GTEMP_Init()
+ *
+ * Takes the scale of the current CAL_GYRO map (so call after it has been
+ * installed) and loads the table from flash, empty if there is none.
+ *
+ * @return  (int8_t) SUCCESS if a table was loaded, ERROR if it starts empty
+ */
+int8_t GTEMP_Init(void);
+
+/** GTEMP_ReadTemp()
+ *
+ * @return  (int8_t) BNO055 temperature, deg C
+ */
+int8_t GTEMP_ReadTemp(void);
+
+/** GTEMP_Learn(temp, bias)
+ *
+ * Folds a measured still bias into the bin of temp.
+ *
+ * @param   temp    (int8_t)        temperature it was measured at, deg C
+ * @param   bias    (float[3])      mean raw gyro x, y, z while still
+ * @return  (int8_t) TRUE if the table changed
+ */
+int8_t GTEMP_Learn(int8_t temp, const float bias[3]);
+
+/** GTEMP_Lookup(temp, bias)
+ *
+ * Interpolates the table.
+ *
+ * @param   temp    (int8_t)        deg C
+ * @param   bias    (float[3])      raw gyro bias x, y, z
+ * @return  (int8_t) FALSE if the table is empty (bias untouched)
+ */
+int8_t GTEMP_Lookup(int8_t temp, float bias[3]);
+
+/** GTEMP_Apply(temp)
+ *
+ * Installs the bias for temp in the CAL_GYRO map if it differs from the one
+ * installed. Cheap when nothing changed, call every loop.
+ *
+ * @param   temp    (int8_t)        deg C
+ * @return  (int8_t) TRUE if a new map was installed
+ */
+int8_t GTEMP_Apply(int8_t temp);
+
+/** GTEMP_Save()
+ *
+ * Erases the flash sector and writes the table.
+ *
+ * @return  (int8_t) SUCCESS or ERROR
+ */
+int8_t GTEMP_Save(void);
+
+
+#endif  /*  GYROTEMP_H   */
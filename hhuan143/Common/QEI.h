@@ -64,6 +64,13 @@
 
 #define ENC_A GPIO_PIN_4
 #define ENC_B GPIO_PIN_5
+
+#define QEI_STEP_QUEUE 64 // steps kept until QEI_GetStep(), power of two
+
+typedef struct {
+    uint32_t time_us; // TIMERS_GetMicroSeconds() of the edge
+    int8_t step;      // +1 clockwise, -1 counter clockwise
+} QEI_Step;
  
 /**
  * @function QEI_Init(void)
@@ -89,5 +96,15 @@ int QEI_GetPosition(void);
 */
 void QEI_ResetPosition(); 
 
+/**
+ * @function QEI_GetStep(QEI_Step *step)
+ * @param step - filled in with the oldest quadrature step not read yet
+ * @brief  Every valid edge of A or B is one step, so speed and direction can be taken from
+ *         each edge instead of sampling the position. The last QEI_STEP_QUEUE steps are
+ *         kept, newer ones are lost while it is full.
+ * @return TRUE if step was filled in, FALSE if none is waiting
+*/
+char QEI_GetStep(QEI_Step *step);
+
 #endif	/* QEI_H */
 
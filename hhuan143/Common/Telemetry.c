@@ -0,0 +1,296 @@
+/**
+ * @file    Telemetry.c
+ *
+ * COBS framed binary records on the serial console.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <Board.h>
+#include <Console.h>
+#include <LoopMonitor.h>
+#include <Telemetry.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define TELEM_PACKET (sizeof(TELEM_Header) + TELEM_MAX_PAYLOAD + 2)
+#define TELEM_FRAME (TELEM_PACKET + TELEM_PACKET / 254 + 2)    // COBS overhead and the delimiter
+
+static uint16_t seq;
+
+
+/*  PRIVATE FUNCTIONS   */
+// CRC-16/CCITT-FALSE, check value 0x29B1 for "123456789"
+static uint16_t crc16(const uint8_t *data, uint16_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t) data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// each zero is replaced by the distance to the next one, out has no zeros;
+// returns the encoded length (the delimiter is not written)
+static uint16_t cobs_encode(const uint8_t *in, uint16_t length, uint8_t *out)
+{
+    uint16_t code_at = 0;               // where the current block's distance goes
+    uint16_t o = 1;
+    uint8_t code = 1;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if (in[i] == 0)
+        {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF)             // 254 data bytes, block full
+        {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        }
+    }
+    out[code_at] = code;
+    return o;
+}
+
+// Shepperd's method, from the largest of w, x, y, z so the division is safe
+static void dcm_to_quaternion(float R[3][3], float q[4])
+{
+    float trace = R[0][0] + R[1][1] + R[2][2];
+    if (trace > R[0][0] && trace > R[1][1] && trace > R[2][2])
+    {
+        float s = 2.0f * sqrtf(1.0f + trace);          // 4w
+        q[0] = 0.25f * s;
+        q[1] = (R[1][2] - R[2][1]) / s;
+        q[2] = (R[2][0] - R[0][2]) / s;
+        q[3] = (R[0][1] - R[1][0]) / s;
+    }
+    else if (R[0][0] > R[1][1] && R[0][0] > R[2][2])
+    {
+        float s = 2.0f * sqrtf(1.0f + R[0][0] - R[1][1] - R[2][2]);  // 4x
+        q[0] = (R[1][2] - R[2][1]) / s;
+        q[1] = 0.25f * s;
+        q[2] = (R[0][1] + R[1][0]) / s;
+        q[3] = (R[2][0] + R[0][2]) / s;
+    }
+    else if (R[1][1] > R[2][2])
+    {
+        float s = 2.0f * sqrtf(1.0f - R[0][0] + R[1][1] - R[2][2]);  // 4y
+        q[0] = (R[2][0] - R[0][2]) / s;
+        q[1] = (R[0][1] + R[1][0]) / s;
+        q[2] = 0.25f * s;
+        q[3] = (R[1][2] + R[2][1]) / s;
+    }
+    else
+    {
+        float s = 2.0f * sqrtf(1.0f - R[0][0] - R[1][1] + R[2][2]);  // 4z
+        q[0] = (R[0][1] - R[1][0]) / s;
+        q[1] = (R[2][0] + R[0][2]) / s;
+        q[2] = (R[1][2] + R[2][1]) / s;
+        q[3] = 0.25f * s;
+    }
+    if (q[0] < 0.0f)                    // one sign for the same attitude, plots stay continuous
+    {
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            q[i] = -q[i];
+        }
+    }
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** TELEM_Init()
+ *
+ * Restarts the sequence count and sends a lone delimiter, so whatever text
+ * came before does not run into the first frame.
+ */
+void TELEM_Init(void)
+{
+    const char delimiter = 0;
+    seq = 0;
+    CONSOLE_Write(&delimiter, 1);
+}
+
+/** TELEM_Send(type, t_us, payload, length)
+ *
+ * Frames and queues one record.
+ *
+ * @param   type    (uint8_t)       record type
+ * @param   t_us    (uint32_t)      sample time, TIMERS_GetMicroSeconds()
+ * @param   payload (const void *)  record body
+ * @param   length  (uint8_t)       bytes, at most TELEM_MAX_PAYLOAD
+ * @return  (int8_t)    SUCCESS, or ERROR if the record is too long or the
+ *                      console had no room for it
+ */
+int8_t TELEM_Send(uint8_t type, uint32_t t_us, const void *payload, uint8_t length)
+{
+    if (length > TELEM_MAX_PAYLOAD)
+    {
+        return ERROR;
+    }
+    uint8_t packet[TELEM_PACKET];
+    uint8_t frame[TELEM_FRAME];
+    TELEM_Header header = {TELEM_VERSION, type, seq++, t_us};
+    memcpy(packet, &header, sizeof(header));
+    memcpy(&packet[sizeof(header)], payload, length);
+    uint16_t size = sizeof(header) + length;
+    uint16_t crc = crc16(packet, size);
+    packet[size++] = crc & 0xFF;
+    packet[size++] = crc >> 8;
+
+    uint16_t encoded = cobs_encode(packet, size, frame);
+    frame[encoded++] = 0;
+    uint32_t dropped = CONSOLE_GetDropped();
+    CONSOLE_Write((const char *) frame, encoded);
+    return CONSOLE_GetDropped() == dropped ? SUCCESS : ERROR;
+}
+
+/** TELEM_SendRaw(t_us, acc, mag, gyro)
+ *
+ * @param   t_us    (uint32_t)      sample time
+ * @param   acc     (int16_t[3])    accelerometer counts
+ * @param   mag     (int16_t[3])    magnetometer counts
+ * @param   gyro    (int16_t[3])    gyro counts
+ * @return  (int8_t)    as TELEM_Send()
+ */
+int8_t TELEM_SendRaw(uint32_t t_us, const int16_t acc[3], const int16_t mag[3], const int16_t gyro[3])
+{
+    TELEM_Raw r;
+    memcpy(r.acc, acc, sizeof(r.acc));
+    memcpy(r.mag, mag, sizeof(r.mag));
+    memcpy(r.gyro, gyro, sizeof(r.gyro));
+    return TELEM_Send(TELEM_RAW, t_us, &r, sizeof(r));
+}
+
+/** TELEM_SendCalibrated(t_us, acc, mag, gyro)
+ *
+ * @param   t_us    (uint32_t)  sample time
+ * @param   acc     (float[3])  g
+ * @param   mag     (float[3])  nT
+ * @param   gyro    (float[3])  deg/s
+ * @return  (int8_t)    as TELEM_Send()
+ */
+int8_t TELEM_SendCalibrated(uint32_t t_us, const float acc[3], const float mag[3], const float gyro[3])
+{
+    TELEM_Calibrated c;
+    memcpy(c.acc, acc, sizeof(c.acc));
+    memcpy(c.mag, mag, sizeof(c.mag));
+    memcpy(c.gyro, gyro, sizeof(c.gyro));
+    return TELEM_Send(TELEM_CALIBRATED, t_us, &c, sizeof(c));
+}
+
+/** TELEM_SendAttitude(t_us, R, bias)
+ *
+ * Sends R as a unit quaternion (16 bytes instead of 36).
+ *
+ * @param   t_us    (uint32_t)      sample time
+ * @param   R       (float[3][3])   inertial to body DCM
+ * @param   bias    (float[3])      gyro bias estimate, rad/s
+ * @return  (int8_t)    as TELEM_Send()
+ */
+int8_t TELEM_SendAttitude(uint32_t t_us, float R[3][3], const float bias[3])
+{
+    TELEM_Attitude a;
+    dcm_to_quaternion(R, a.q);
+    memcpy(a.bias, bias, sizeof(a.bias));
+    return TELEM_Send(TELEM_ATTITUDE, t_us, &a, sizeof(a));
+}
+
+/** TELEM_SendLoop(t_us, id)
+ *
+ * Sends the counters of a LoopMonitor loop.
+ *
+ * @param   t_us    (uint32_t)  time of the snapshot
+ * @param   id      (int8_t)    from LOOPMON_Add()
+ * @return  (int8_t)    as TELEM_Send(), ERROR for an unknown loop
+ */
+int8_t TELEM_SendLoop(uint32_t t_us, int8_t id)
+{
+    LOOPMON_Stats s;
+    if (LOOPMON_GetStats(id, &s) == ERROR)
+    {
+        return ERROR;
+    }
+    TELEM_Loop l = {id, s.worst_path, 0, s.runs, s.misses, s.max_period_us, s.max_exec_us};
+    return TELEM_Send(TELEM_LOOP, t_us, &l, sizeof(l));
+}
+
+
+/** TELEMETRY_TEST
+ *
+ * Uncomment the below "#define" to run the TELEMETRY_TEST.
+ *
+ * SUCCESS - With the board connected, run
+ *
+ *               telem2cap /dev/ttyACM0 --baud 115200 -o test.imucap --attitude att.csv
+ *
+ *           for a few seconds: it reports ~200 raw frames per second with
+ *           no CRC errors and no sequence gaps. The raw channels count up
+ *           (acc = n, mag = 2n, gyro = -n), the attitude is a 1 deg/s turn
+ *           about z with a yaw that goes round in att.csv, and the loop
+ *           record shows 200 runs per second.
+ */
+//#define TELEMETRY_TEST
+#ifdef TELEMETRY_TEST
+
+#include <timers.h>
+#include <Scheduler.h>
+
+
+static int8_t loop;
+
+static void sample(void)
+{
+    static uint32_t n = 0;
+    LOOPMON_Start(loop);
+    uint32_t t = TIMERS_GetMicroSeconds();
+    int16_t count = n;
+    int16_t acc[3] = {count, count, count};
+    int16_t mag[3] = {2 * count, 2 * count, 2 * count};
+    int16_t gyro[3] = {-count, -count, -count};
+    TELEM_SendRaw(t, acc, mag, gyro);
+    if (n % 4 == 0)
+    {
+        float yaw = (n / 200.0f) * (M_PI / 180.0f);
+        float R[3][3] = {{cosf(yaw), sinf(yaw), 0}, {-sinf(yaw), cosf(yaw), 0}, {0, 0, 1}};
+        float bias[3] = {0.001f, -0.002f, 0.003f};
+        TELEM_SendAttitude(t, R, bias);
+    }
+    n++;
+    LOOPMON_End(loop);
+}
+
+static void loop_stats(void)
+{
+    TELEM_SendLoop(TIMERS_GetMicroSeconds(), loop);
+}
+
+int main(void)
+{
+    BOARD_Init();
+    TIMER_Init();
+    SCHED_Init();
+    TELEM_Init();
+
+    loop = LOOPMON_Add("telemetry", 5000, 5000);
+    SCHED_Add(sample, 5, 0, SCHED_PRIORITY_SENSOR);
+    SCHED_Add(loop_stats, 1000, 0, SCHED_PRIORITY_BACKGROUND);
+    SCHED_Run();
+}
+
+#endif  /*  TELEMETRY_TEST  */
@@ -0,0 +1,161 @@
+/**
+ * @file    Telemetry.h
+ *
+ * Binary telemetry on the USB serial port (USART2), in place of printf("%f")
+ * of the angles. Each record is a TELEM_Header, a fixed payload for its type
+ * and a CRC-16, COBS encoded and ended by a 0x00, so a reader that starts
+ * mid-stream (or sees a line of text from printf) loses one frame and locks
+ * on at the next zero:
+ *
+ *      version  type  seq  t_us  payload  crc16      COBS(...)  0x00
+ *       u8      u8   u16   u32   0..64    u16
+ *
+ * Everything is little-endian, the structs below are laid out without
+ * padding and copied as they are. The CRC is CRC-16/CCITT-FALSE (poly
+ * 0x1021, init 0xFFFF) over header and payload. seq counts every frame sent,
+ * so gaps show the frames the console dropped when its ring was full. t_us is
+ * TIMERS_GetMicroSeconds() of the sample, it wraps every ~71 minutes and the
+ * decoder unwraps it.
+ *
+ * Frames go through CONSOLE_Write() whole or not at all. Bytes on the wire,
+ * COBS and delimiter included, and what they cost at 115200 baud (11520 B/s):
+ *
+ *      TELEM_RAW           30 B    200 Hz = 52%
+ *      TELEM_CALIBRATED    48 B     50 Hz = 21%
+ *      TELEM_ATTITUDE      40 B     50 Hz = 17%
+ *      TELEM_LOOP          32 B      1 Hz
+ *
+ * A new field means a new version, a new record a new type; the decoder
+ * (tools/telem2cap) skips types it does not know.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef TELEMETRY_H
+#define	TELEMETRY_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define TELEM_VERSION 1
+#define TELEM_MAX_PAYLOAD 64
+
+// record types
+#define TELEM_RAW 1
+#define TELEM_CALIBRATED 2
+#define TELEM_ATTITUDE 3
+#define TELEM_LOOP 4
+
+typedef struct {
+    uint8_t version;                    // TELEM_VERSION
+    uint8_t type;                       // TELEM_RAW, ...
+    uint16_t seq;                       // frames sent so far
+    uint32_t t_us;                      // sample time
+} TELEM_Header;
+
+typedef struct {                        // sensor counts as read
+    int16_t acc[3];
+    int16_t mag[3];
+    int16_t gyro[3];
+} TELEM_Raw;
+
+typedef struct {                        // after the Calibration maps
+    float acc[3];                       // g
+    float mag[3];                       // nT
+    float gyro[3];                      // deg/s
+} TELEM_Calibrated;
+
+typedef struct {
+    float q[4];                         // w, x, y, z of the inertial to body DCM R
+    float bias[3];                      // gyro bias estimate, rad/s
+} TELEM_Attitude;
+
+typedef struct {                        // LOOPMON_Stats without the histograms
+    uint8_t id;
+    uint8_t worst_path;
+    uint16_t reserved;
+    uint32_t runs;
+    uint32_t misses;
+    uint32_t max_period_us;
+    uint32_t max_exec_us;
+} TELEM_Loop;
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** TELEM_Init()
+ *
+ * Restarts the sequence count and sends a lone delimiter, so whatever text
+ * came before does not run into the first frame.
+ */
+void TELEM_Init(void);
+
+/** TELEM_Send(type, t_us, payload, length)
+ *
+ * Frames and queues one record.
+ *
+ * @param   type    (uint8_t)       record type
+ * @param   t_us    (uint32_t)      sample time, TIMERS_GetMicroSeconds()
+ * @param   payload (const void *)  record body
+ * @param   length  (uint8_t)       bytes, at most TELEM_MAX_PAYLOAD
+ * @return  (int8_t)    SUCCESS, or ERROR if the record is too long or the
+ *                      console had no room for it
+ */
+int8_t TELEM_Send(uint8_t type, uint32_t t_us, const void *payload, uint8_t length);
+
+/** TELEM_SendRaw(t_us, acc, mag, gyro)
+ *
+ * @param   t_us    (uint32_t)      sample time
+ * @param   acc     (int16_t[3])    accelerometer counts
+ * @param   mag     (int16_t[3])    magnetometer counts
+ * @param   gyro    (int16_t[3])    gyro counts
+ * @return  (int8_t)    as TELEM_Send()
+ */
+int8_t TELEM_SendRaw(uint32_t t_us, const int16_t acc[3], const int16_t mag[3], const int16_t gyro[3]);
+
+/** TELEM_SendCalibrated(t_us, acc, mag, gyro)
+ *
+ * @param   t_us    (uint32_t)  sample time
+ * @param   acc     (float[3])  g
+ * @param   mag     (float[3])  nT
+ * @param   gyro    (float[3])  deg/s
+ * @return  (int8_t)    as TELEM_Send()
+ */
+int8_t TELEM_SendCalibrated(uint32_t t_us, const float acc[3], const float mag[3], const float gyro[3]);
+
+/** TELEM_SendAttitude(t_us, R, bias)
+ *
+ * Sends R as a unit quaternion (16 bytes instead of 36).
+ *
+ * @param   t_us    (uint32_t)      sample time
+ * @param   R       (float[3][3])   inertial to body DCM
+ * @param   bias    (float[3])      gyro bias estimate, rad/s
+ * @return  (int8_t)    as TELEM_Send()
+ */
+int8_t TELEM_SendAttitude(uint32_t t_us, float R[3][3], const float bias[3]);
+
+/** TELEM_SendLoop(t_us, id)
+ *
+ * Sends the counters of a LoopMonitor loop.
+ *
+ * @param   t_us    (uint32_t)  time of the snapshot
+ * @param   id      (int8_t)    from LOOPMON_Add()
+ * @return  (int8_t)    as TELEM_Send(), ERROR for an unknown loop
+ */
+int8_t TELEM_SendLoop(uint32_t t_us, int8_t id);
+
+
+#endif  /*  TELEMETRY_H */
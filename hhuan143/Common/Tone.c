@@ -0,0 +1,393 @@
+/**
+ * @file    Tone.c
+ *
+ * DMA driven direct digital synthesis on PWM_0.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <timers.h>
+#include <pwm.h>
+#include <Tone.h>
+
+
+/*  PROTOTYPES  */
+static void TONE_Fill(uint16_t *out);
+static void TONE_HalfDone(DMA_HandleTypeDef *hdma);
+static void TONE_FullDone(DMA_HandleTypeDef *hdma);
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define TONE_LENGTH (2 * TONE_BLOCK)    // samples in the DMA buffer
+#define TONE_MIDDLE (TONE_PWM_TOP / 2)  // duty of silence
+
+typedef struct {
+    volatile uint32_t step;             // phase increment per sample, set by TONE_SetFrequency()
+    volatile uint32_t target;           // amplitude, set by TONE_SetAmplitude()
+    uint32_t phase;                     // interrupt only, the top 8 bits index the table
+    int32_t level;                      // interrupt only, amplitude << 8 now
+} Voice;
+
+static int8_t initStatus = FALSE;
+static uint16_t samples[TONE_LENGTH];
+static Voice voices[TONE_VOICES];
+static int8_t sine[TONE_TABLE_SIZE];
+static const int8_t *volatile waveform = sine;
+static float stepsPerHz;                // 2^32 / sample rate
+static volatile uint32_t underruns;
+static uint32_t pwmPreload;             // TIM1 CR1 ARPE and CCMR1 OC1PE as the PWM module set them
+
+
+/*  PRIVATE FUNCTIONS   */
+/** TONE_Fill(out)
+ *
+ * Mixes the next TONE_BLOCK samples of every voice that is sounding or
+ * fading out.
+ *
+ * @param   out (uint16_t *)    half of the DMA buffer, CCR1 values
+ */
+static void TONE_Fill(uint16_t *out)
+{
+    int32_t mix[TONE_BLOCK] = {0};
+    const int8_t *table = waveform;
+    for (uint8_t v = 0; v < TONE_VOICES; v++)
+    {
+        Voice *voice = &voices[v];
+        int32_t target = (int32_t) (voice->target << 8);
+        int32_t level = voice->level;
+        if (level == 0 && target == 0)
+        {
+            continue;
+        }
+        uint32_t step = voice->step;
+        uint32_t phase = voice->phase;
+        int32_t slope = (target - level) / TONE_BLOCK;
+        for (uint16_t i = 0; i < TONE_BLOCK; i++)
+        {
+            mix[i] += table[phase >> 24] * (level >> 8);
+            phase += step;
+            level += slope;
+        }
+        voice->phase = phase;
+        voice->level = target;          // drop what the division left over
+    }
+
+    for (uint16_t i = 0; i < TONE_BLOCK; i++)
+    {
+        int32_t sample = TONE_MIDDLE + (mix[i] >> 8);
+        if (sample < 0)
+        {
+            sample = 0;
+        }
+        else if (sample > TONE_PWM_TOP - 1)
+        {
+            sample = TONE_PWM_TOP - 1;
+        }
+        out[i] = (uint16_t) sample;
+    }
+}
+
+/** TONE_HalfDone(hdma)
+ *
+ * DMA half transfer, the first half has played: refill it while the second
+ * one plays.
+ *
+ * @param   hdma    (DMA_HandleTypeDef *)   &hdma_tim1_ch1
+ */
+static void TONE_HalfDone(DMA_HandleTypeDef *hdma)
+{
+    if (__HAL_DMA_GET_COUNTER(hdma) > TONE_BLOCK)
+    {
+        underruns++;                    // already back in the first half
+    }
+    TONE_Fill(&samples[0]);
+}
+
+/** TONE_FullDone(hdma)
+ *
+ * DMA transfer complete, the second half has played.
+ *
+ * @param   hdma    (DMA_HandleTypeDef *)   &hdma_tim1_ch1
+ */
+static void TONE_FullDone(DMA_HandleTypeDef *hdma)
+{
+    if (__HAL_DMA_GET_COUNTER(hdma) <= TONE_BLOCK)
+    {
+        underruns++;                    // already in the second half
+    }
+    TONE_Fill(&samples[TONE_BLOCK]);
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** TONE_Init()
+ *
+ * Takes over TIM1 for PWM_0 (calls PWM_Init() if needed) and starts the
+ * DMA with every voice silent, so PWM_0 sits at half duty.
+ *
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t TONE_Init(void)
+{
+    if (initStatus == TRUE)
+    {
+        return SUCCESS;
+    }
+    if (PWM_Init() == ERROR || PWM_SetDutyCycle(PWM_0, 0) == ERROR)    // adds the pin, starts CH1
+    {
+        return ERROR;
+    }
+
+    for (uint16_t i = 0; i < TONE_TABLE_SIZE; i++)
+    {
+        sine[i] = (int8_t) lrintf(127.0f * sinf(6.2831853f * i / TONE_TABLE_SIZE));
+    }
+    for (uint8_t v = 0; v < TONE_VOICES; v++)
+    {
+        voices[v].step = 0;
+        voices[v].target = 0;
+        voices[v].phase = 0;
+        voices[v].level = 0;
+    }
+    for (uint16_t i = 0; i < TONE_LENGTH; i++)
+    {
+        samples[i] = TONE_MIDDLE;
+    }
+    waveform = sine;
+    underruns = 0;
+
+    // TIM1 is on APB2, clocked at twice PCLK2 when APB2 is divided
+    uint32_t timerClock = HAL_RCC_GetPCLK2Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE2) != 0)
+    {
+        timerClock *= 2;
+    }
+    stepsPerHz = 4294967296.0f * TONE_PWM_TOP * TONE_REPEAT / timerClock;
+
+    // DMA2 Stream3 channel 6 is the TIM1 CH1 request (Stream1 would also be,
+    // but USART6 RX has it)
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    hdma_tim1_ch1.Instance = DMA2_Stream3;
+    hdma_tim1_ch1.Init.Channel = DMA_CHANNEL_6;
+    hdma_tim1_ch1.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_tim1_ch1.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim1_ch1.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim1_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim1_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim1_ch1.Init.Mode = DMA_CIRCULAR;
+    hdma_tim1_ch1.Init.Priority = DMA_PRIORITY_HIGH;
+    hdma_tim1_ch1.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_tim1_ch1) != HAL_OK)
+    {
+        return ERROR;
+    }
+    hdma_tim1_ch1.XferHalfCpltCallback = TONE_HalfDone;
+    hdma_tim1_ch1.XferCpltCallback = TONE_FullDone;
+    HAL_NVIC_SetPriority(DMA2_Stream3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+
+    // Carrier at the full timer clock. The repetition counter makes an update
+    // every TONE_REPEAT periods, and CCDS turns the CC1 DMA request into one
+    // per update; CCR1 is preloaded so each sample starts on a period edge.
+    TIM1->CR1 &= ~TIM_CR1_CEN;
+    pwmPreload = (TIM1->CR1 & TIM_CR1_ARPE) | (TIM1->CCMR1 & TIM_CCMR1_OC1PE);
+    TIM1->PSC = 0;
+    TIM1->ARR = TONE_PWM_TOP - 1;
+    TIM1->RCR = TONE_REPEAT - 1;
+    TIM1->CCR1 = TONE_MIDDLE;
+    TIM1->CCMR1 |= TIM_CCMR1_OC1PE;
+    TIM1->CR1 |= TIM_CR1_ARPE;
+    TIM1->CR2 |= TIM_CR2_CCDS;
+    TIM1->EGR = TIM_EGR_UG;             // load PSC, ARR and RCR now
+    if (HAL_DMA_Start_IT(&hdma_tim1_ch1, (uint32_t) samples, (uint32_t) &TIM1->CCR1, TONE_LENGTH) != HAL_OK)
+    {
+        return ERROR;
+    }
+    TIM1->DIER |= TIM_DIER_CC1DE;
+    TIM1->CR1 |= TIM_CR1_CEN;
+
+    initStatus = TRUE;
+    return SUCCESS;
+}
+
+/** TONE_End()
+ *
+ * Stops the DMA and gives TIM1 back to the PWM module at its last
+ * PWM_SetFrequency() and duty cycles.
+ *
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t TONE_End(void)
+{
+    if (initStatus == FALSE)
+    {
+        return ERROR;
+    }
+    TIM1->DIER &= ~TIM_DIER_CC1DE;
+    HAL_NVIC_DisableIRQ(DMA2_Stream3_IRQn);
+    HAL_DMA_Abort(&hdma_tim1_ch1);
+    HAL_DMA_DeInit(&hdma_tim1_ch1);
+
+    // Back to the 1 MHz count PWM_Init() sets up
+    TIM1->CR2 &= ~TIM_CR2_CCDS;
+    TIM1->CCMR1 = (TIM1->CCMR1 & ~TIM_CCMR1_OC1PE) | (pwmPreload & TIM_CCMR1_OC1PE);
+    TIM1->CR1 = (TIM1->CR1 & ~TIM_CR1_ARPE) | (pwmPreload & TIM_CR1_ARPE);
+    TIM1->PSC = TIMERS_GetSystemClockFreq() / 1000000 - 1;
+    TIM1->RCR = 0;
+    TIM1->EGR = TIM_EGR_UG;
+    initStatus = FALSE;
+    return PWM_SetFrequency(PWM_GetFrequency()) == ERROR ? ERROR : SUCCESS;
+}
+
+/** TONE_Set(voice, frequency, amplitude)
+ *
+ * TONE_SetFrequency() and TONE_SetAmplitude() together.
+ *
+ * @param   voice       (uint8_t)   0 to TONE_VOICES - 1
+ * @param   frequency   (float)     Hz, 0 to TONE_MAX_FREQUENCY
+ * @param   amplitude   (uint8_t)   0 (silent) to TONE_MAX_AMPLITUDE
+ * @return  (int8_t)    SUCCESS, or ERROR if voice or frequency is out of range
+ */
+int8_t TONE_Set(uint8_t voice, float frequency, uint8_t amplitude)
+{
+    if (TONE_SetFrequency(voice, frequency) == ERROR)
+    {
+        return ERROR;
+    }
+    return TONE_SetAmplitude(voice, amplitude);
+}
+
+/** TONE_SetFrequency(voice, frequency)
+ *
+ * Changes the pitch from the next block, keeping the phase.
+ *
+ * @param   voice       (uint8_t)   0 to TONE_VOICES - 1
+ * @param   frequency   (float)     Hz, 0 to TONE_MAX_FREQUENCY
+ * @return  (int8_t)    SUCCESS, or ERROR if voice or frequency is out of range
+ */
+int8_t TONE_SetFrequency(uint8_t voice, float frequency)
+{
+    if (initStatus == FALSE || voice >= TONE_VOICES || !(frequency >= 0.0f && frequency <= TONE_MAX_FREQUENCY))
+    {
+        return ERROR;
+    }
+    voices[voice].step = (uint32_t) (frequency * stepsPerHz);
+    return SUCCESS;
+}
+
+/** TONE_SetAmplitude(voice, amplitude)
+ *
+ * Ramps the voice to a new amplitude over the next block.
+ *
+ * @param   voice       (uint8_t)   0 to TONE_VOICES - 1
+ * @param   amplitude   (uint8_t)   0 (silent) to TONE_MAX_AMPLITUDE
+ * @return  (int8_t)    SUCCESS, or ERROR if voice is out of range
+ */
+int8_t TONE_SetAmplitude(uint8_t voice, uint8_t amplitude)
+{
+    if (initStatus == FALSE || voice >= TONE_VOICES)
+    {
+        return ERROR;
+    }
+    voices[voice].target = amplitude;
+    return SUCCESS;
+}
+
+/** TONE_SetWaveform(table)
+ *
+ * Plays every voice from another wave table from the next block. The table
+ * is used in place, so it must stay valid.
+ *
+ * @param   table   (const int8_t *)    TONE_TABLE_SIZE samples of one cycle,
+ *                                      or NULL for the built in sine
+ */
+void TONE_SetWaveform(const int8_t *table)
+{
+    waveform = table != NULL ? table : sine;
+}
+
+/** TONE_GetUnderruns()
+ *
+ * Blocks the DMA reached before they were filled (the interrupt was held
+ * off for a whole block); each one replays the samples of two blocks ago.
+ *
+ * @return  (uint32_t)  count since TONE_Init()
+ */
+uint32_t TONE_GetUnderruns(void)
+{
+    return underruns;
+}
+
+
+/** TONE_TEST
+ *
+ * Uncomment the below "#define" to run the TONE_TEST, with a speaker (through
+ * a capacitor or a low pass) on PWM_0.
+ *
+ * SUCCESS - A C major chord builds up one note every second, then each note
+ *           slides up an octave and back without clicks, then the chord fades
+ *           out. The DWT cycle counter gives the time spent filling one block
+ *           with all four voices, which should be a few percent of the
+ *           1.6 ms a block lasts, and no underruns are counted.
+ */
+//#define TONE_TEST
+#ifdef TONE_TEST
+
+#include <Board.h>
+
+
+int main(void)
+{
+    BOARD_Init();
+    TIMER_Init();
+    if (TONE_Init() == ERROR)
+    {
+        printf("TONE_Init failed\r\n");
+    }
+
+    const float chord[TONE_VOICES] = {261.63f, 329.63f, 392.00f, 523.25f};
+    for (uint8_t v = 0; v < TONE_VOICES; v++)
+    {
+        TONE_Set(v, chord[v], 60);
+        HAL_Delay(1000);
+    }
+
+    for (uint16_t step = 0; step <= 200; step++)
+    {
+        float ratio = step <= 100 ? 1.0f + step / 100.0f : 3.0f - step / 100.0f;
+        for (uint8_t v = 0; v < TONE_VOICES; v++)
+        {
+            TONE_SetFrequency(v, chord[v] * ratio);
+        }
+        HAL_Delay(10);
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    static uint16_t scratch[TONE_BLOCK];
+    __disable_irq();                    // the voices are the interrupt's
+    uint32_t start = DWT->CYCCNT;
+    TONE_Fill(scratch);
+    uint32_t cycles = DWT->CYCCNT - start;
+    __enable_irq();
+    printf("cycles per block: %lu of %lu\r\n", (unsigned long) cycles,
+           (unsigned long) (TIMERS_GetSystemClockFreq() / TONE_SAMPLE_RATE * TONE_BLOCK));
+
+    for (int16_t amplitude = 60; amplitude >= 0; amplitude -= 2)
+    {
+        for (uint8_t v = 0; v < TONE_VOICES; v++)
+        {
+            TONE_SetAmplitude(v, amplitude);
+        }
+        HAL_Delay(30);
+    }
+    printf("underruns: %lu\r\n", (unsigned long) TONE_GetUnderruns());
+
+    while (TRUE);
+}
+
+#endif  /*  TONE_TEST */
@@ -237,11 +237,11 @@ char PWM_SetDutyCycle(PWM PWM_x, unsigned int Duty) {
             duty_cycles[3] = Duty;
             break;
         case 0x10: // PWM_4
-            TIM4->CCR1 = (uint32_t)((Duty/100.0)*(TIM1->ARR));
+            TIM4->CCR1 = (uint32_t)((Duty/100.0)*(TIM4->ARR));
             duty_cycles[4] = Duty;
             break;
         case 0x20: // PWM_5
-            TIM4->CCR3 = (uint32_t)((Duty/100.0)*(TIM1->ARR));
+            TIM4->CCR3 = (uint32_t)((Duty/100.0)*(TIM4->ARR));
             duty_cycles[5] = Duty;
             break;
     }
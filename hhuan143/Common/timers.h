@@ -34,11 +34,27 @@ uint32_t TIMERS_GetMilliSeconds(void);
 /**
  * @function TIMERS_GetMicroSeconds(void)
  * @param None
- * @return current microsecond count
+ * @return current microsecond count, wraps every ~71.6 minutes
  * @brief ^
  * @author Adam Korycki, 2023.09.29 */
 uint32_t TIMERS_GetMicroSeconds(void);
 
+/**
+ * @function TIMERS_GetTimestamp(void)
+ * @param None
+ * @return microseconds since TIMER_Init(), 64 bits (never wraps)
+ * @brief TIM2 count extended by the overflow interrupt. Safe from any ISR, including ones that run
+ * while the overflow is still pending */
+uint64_t TIMERS_GetTimestamp(void);
+
+/**
+ * @function TIMERS_WakeAt(uint32_t us)
+ * @param us - TIMERS_GetMicroSeconds() value to wake up at
+ * @return TRUE if the alarm is set, FALSE if that time has already passed
+ * @brief Raises one TIM2 compare interrupt at the given time, so __WFI() returns. Only wakes the CPU,
+ * nothing is called. Times more than ~35 minutes ahead count as passed */
+char TIMERS_WakeAt(uint32_t us);
+
 /**
  * @function TIMERS_GetSystemClockFreq(void)
  * @param None
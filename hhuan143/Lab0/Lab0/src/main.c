@@ -4,24 +4,12 @@
 #include <pwm.h>
 #include <ADC.h>
 #include <buttons.h>
+#include <Filter.h>
 
-#define WINDOW_SIZE 10  // Number of samples for averaging
+#define WINDOW_SIZE 8  // Number of samples for averaging, a power of two
 
-int adc_samples[WINDOW_SIZE] = {0};
-int sample_index = 0;
-int sum = 0;
-
-int moving_average(int new_sample) {
-    // Subtract the oldest sample from the sum
-    sum -= adc_samples[sample_index];
-    // Add the new sample
-    adc_samples[sample_index] = new_sample;
-    sum += new_sample;
-    // Update the sample index (circular buffer)
-    sample_index = (sample_index + 1) % WINDOW_SIZE;
-    // Return the average
-    return sum / WINDOW_SIZE;
-}
+static int32_t pot_samples[WINDOW_SIZE];
+static FILTER_MovingAverage pot_filter;
 
 
 int main(void) {
@@ -29,9 +17,10 @@ int main(void) {
     ADC_Init();
     PWM_Init();
     BUTTONS_Init();
+    FILTER_AverageInit(&pot_filter, pot_samples, WINDOW_SIZE);
     while(1){
         int raw_pot_val = ADC_Read(ADC_CHANNEL_4);
-        int filter_pot_val = moving_average(raw_pot_val);
+        int filter_pot_val = FILTER_AverageAdd(&pot_filter, raw_pot_val);
         printf("raw pot value: %d\n", raw_pot_val);
         printf("filtered pot value: %d\n", filter_pot_val);
         PWM_SetDutyCycle(PWM_0, 50);
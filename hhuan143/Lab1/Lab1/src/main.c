@@ -1,72 +1,89 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <Board.h>
-#include <pwm.h>
+#include <timers.h>
+#include <Tone.h>
 #include <ADC.h>
 #include <buttons.h>
+#include <Filter.h>
+#include <Strike.h>
+#include <Scheduler.h>
 
-#define WINDOW_SIZE 10  // Sample size for moving average filter
+#define WINDOW_SIZE 32  // Sample size for moving average filter, a power of two
+#define SCAN_RATE 4000  // ADC scans per second, a block every 8 ms
+#define SENSOR_PERIOD_MS (1000 * ADC_SCAN_BLOCK / SCAN_RATE)
+#define PIEZO_THRESHOLD 55
+#define TONE_HOLD_MS 300  // Tone length after the piezo is let go
+#define TONE_VOICE 0
+#define TONE_MIN_AMPLITUDE 64  // Loudness of the lightest strike, still clearly audible
+#define PIEZO_FULL_SCALE 4095  // 12 bit ADC
 
-int adc_samples[WINDOW_SIZE] = {0};
-int sample_index = 0;
-int sum = 0;
+static int32_t flex_samples[WINDOW_SIZE];
+static FILTER_MovingAverage flex_filter;
+static int32_t filter_flex_val = 0;
+static uint32_t flex_sequence = 0;
+static int8_t tone_off_id = ERROR;  // pending tone_off() one shot
 
-int moving_average(int new_sample) {
-    // Subtract the oldest sample from the sum
-    sum -= adc_samples[sample_index];
-    // Add the new sample
-    adc_samples[sample_index] = new_sample;
-    sum += new_sample;
-    // Update the sample index
-    sample_index = (sample_index + 1) % WINDOW_SIZE;
-    // Return average
-    return sum / WINDOW_SIZE;
+
+static void tone_off(void) {
+    // Fade out once the hold after the last strike is over
+    TONE_SetAmplitude(TONE_VOICE, 0);
+    tone_off_id = ERROR;
+}
+
+static void hold_tone(void) {
+    // (Re)start the hold, the tone stops TONE_HOLD_MS after the last call
+    if (tone_off_id != ERROR) {
+        SCHED_Remove(tone_off_id);
+    }
+    tone_off_id = SCHED_Add(tone_off, SCHED_ONE_SHOT, TONE_HOLD_MS, SCHED_PRIORITY_UI);
 }
 
+static uint8_t loudness(uint16_t peak) {
+    // Threshold to full scale maps onto TONE_MIN_AMPLITUDE to TONE_MAX_AMPLITUDE
+    uint32_t above = peak > PIEZO_THRESHOLD ? peak - PIEZO_THRESHOLD : 0;
+    return TONE_MIN_AMPLITUDE + above * (TONE_MAX_AMPLITUDE - TONE_MIN_AMPLITUDE) / (PIEZO_FULL_SCALE - PIEZO_THRESHOLD);
+}
+
+static void sensor_task(void) {
+    // Average the flex sensor over the newest scan block
+    const uint16_t *block = ADC_GetBlock(&flex_sequence);
+    if (block != NULL) {
+        filter_flex_val = FILTER_AverageBlock(&flex_filter, block + ADC_ScanIndex(ADC_0), ADC_SCAN_BLOCK,
+                                              ADC_NUM_CHANNELS, NULL);
+    }
+
+    STRIKE_Event strike;
+    while (STRIKE_Get(&strike) == SUCCESS) {
+        // Pitch from the flex sensor, loudness from how hard the piezo was hit
+        TONE_Set(TONE_VOICE, filter_flex_val, loudness(strike.peak));
+        hold_tone();
+    }
+    // A press that stays on the piezo keeps the tone going, the hold starts when it is let go
+    if (tone_off_id != ERROR && STRIKE_Held()) {
+        hold_tone();
+    }
+}
 
 
 int main(void) {
     // Initialize all hardware
     BOARD_Init();
+    TIMER_Init();
     ADC_Init();
-    PWM_Init();
-
-    int time = 80000;
-    while (1) {
-        // Read raw ADC values
-        int raw_flex_val = ADC_Read(ADC_0);
-        int filter_flex_val = moving_average(raw_flex_val);
-        // printf("%d\n", filter_flex_val);
-        double volt_flex_val = ((double)filter_flex_val * 3.3) / (double)4096;
-        //printf("Voltage: %f V\n", volt_flex_val); // Corrected format specifier for float
-
-        int raw_piezo_val = ADC_Read(ADC_1);
-        //printf("Frequency: %d\n", filter_flex_val);
-
-        double flex_resistance = 47000*((3.3-volt_flex_val) / volt_flex_val);
-        //printf("resistance: %f\n",flex_resistance);
+    if (TONE_Init() == ERROR) {
+        printf("ERROR: TONE_Init failed\r\n");
+        return 1;
+    }
+    FILTER_AverageInit(&flex_filter, flex_samples, WINDOW_SIZE);
 
-        double flex_degree = 3.81*flex_resistance+20700;
-        //printf("degree: %f\n",flex_degree);
-        if (raw_piezo_val > 55) {
-            // Start delay
-            PWM_SetDutyCycle(PWM_0, 50);
-            PWM_SetFrequency(filter_flex_val);
-            //PWM_SetFrequency(flex_degree);
-            
-            while(time != 0){
-                time--;
-                raw_piezo_val = ADC_Read(ADC_1);
-                if (raw_piezo_val > 55){
-                    time = 80000;
-                }
-            }
-        }
-        else{
-            // Reset the PWM when piezo value is below the threshold
-            PWM_SetDutyCycle(PWM_0, 0);
-            PWM_SetFrequency(0);
-            time = 80000;
-        }
+    // The ADC scans on its own and the piezo is watched in the DMA interrupt,
+    // so the CPU sleeps in SCHED_Run() between blocks
+    if (STRIKE_Init(ADC_1, PIEZO_THRESHOLD, SCAN_RATE) == ERROR) {
+        printf("ERROR: STRIKE_Init failed\r\n");
+        return 1;
     }
+    SCHED_Init();
+    SCHED_Add(sensor_task, SENSOR_PERIOD_MS, 0, SCHED_PRIORITY_SENSOR);
+    SCHED_Run();
 }
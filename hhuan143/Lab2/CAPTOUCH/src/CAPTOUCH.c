@@ -2,33 +2,27 @@
 #include <stdlib.h>
 #include <timers.h>
 #include <CAPTOUCH.h>
+#include <RingBuffer.h>
+#include <Filter.h>
 
 static volatile u_int32_t start_time = 0;
 static volatile u_int32_t freq = 0;
 static volatile u_int32_t filtered_freq = 0;
 
-#define WINDOW_SIZE 10  // Sample size for moving average filter
+static CAPTOUCH_Period period_storage[CAPTOUCH_PERIOD_QUEUE];
+static RING_Buffer periods; // every edge, EXTI ISR to CAPTOUCH_GetPeriod()
 
-int samples[WINDOW_SIZE] = {0};
-int sample_index = 0;
-int sum = 0;
+#define WINDOW_SIZE 8  // Sample size for moving average filter, a power of two
 
-uint32_t moving_average(uint32_t new_sample) {
-    // Subtract the oldest sample from the sum
-    sum -= samples[sample_index];
-    // Add the new sample
-    samples[sample_index] = new_sample;
-    sum += new_sample;
-    // Update the sample index
-    sample_index = (sample_index + 1) % WINDOW_SIZE;
-    // Return average
-    return sum / WINDOW_SIZE;
-}
+static int32_t period_samples[WINDOW_SIZE];
+static FILTER_MovingAverage period_filter; // only touched in the EXTI ISR once running
 
 void CAPTOUCH_Init(void) {
     // Init other libraries
     BOARD_Init();
     TIMER_Init();
+    RING_Init(&periods, period_storage, sizeof(CAPTOUCH_Period), CAPTOUCH_PERIOD_QUEUE);
+    FILTER_AverageInit(&period_filter, period_samples, WINDOW_SIZE);
 
     // Configure GPIO pin PB5 
     GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -56,8 +50,10 @@ void EXTI9_5_IRQHandler(void) {
         //find the time between two rising edge
         u_int32_t curr_time = TIMERS_GetMicroSeconds();
         freq = curr_time - start_time;
-        filtered_freq = moving_average(freq);
-        start_time = TIMERS_GetMicroSeconds();        
+        filtered_freq = FILTER_AverageAdd(&period_filter, freq);
+        CAPTOUCH_Period period = {curr_time, freq};
+        RING_Put(&periods, &period);
+        start_time = curr_time;
     }
 }
 
@@ -78,5 +74,15 @@ char CAPTOUCH_IsTouched(void){
     }
 }
 
-
-
+/** CAPTOUCH_GetPeriod(period)
+ *
+ * Takes the oldest oscillator period not read yet, for filtering every edge
+ * outside the interrupt. The last CAPTOUCH_PERIOD_QUEUE periods are kept,
+ * newer ones are lost while it is full. No I/O is done in this function.
+ *
+ * @param   period  (CAPTOUCH_Period *) filled in
+ * @return  (char)    [TRUE, FALSE] FALSE if none is waiting
+ */
+char CAPTOUCH_GetPeriod(CAPTOUCH_Period *period){
+    return RING_Get(&periods, period) == SUCCESS;
+}
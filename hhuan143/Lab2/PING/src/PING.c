@@ -1,5 +1,6 @@
 #include <PING.h>
 #include <pwm.h>
+#include <RingBuffer.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -10,10 +11,14 @@ static volatile unsigned int echo_time = 0;
 static volatile unsigned int distance_mm = 0;
 static volatile int current_state = 0;
 
+static PING_Echo echo_storage[PING_ECHO_QUEUE];
+static RING_Buffer echoes; // EXTI ISR to PING_GetEcho()
+
 char PING_Init(void) {
     // Init other libraries
     BOARD_Init();
     TIMER_Init();
+    RING_Init(&echoes, echo_storage, sizeof(PING_Echo), PING_ECHO_QUEUE);
 
     // Initialize GPIO output pin (PB8, PWM_5 on shield)
     GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -70,6 +75,8 @@ void EXTI9_5_IRQHandler(void) {
         }else if (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_5) == 0){
             //falling edge
             echo_end = TIMERS_GetMicroSeconds();
+            PING_Echo echo = {echo_end, echo_end - echo_start};
+            RING_Put(&echoes, &echo);
         }
     }
 }
@@ -118,3 +125,15 @@ unsigned int PING_GetTimeofFlight(void){
     echo_time = echo_end - echo_start; //raw microsecond
     return echo_time;
 }
+
+/**
+ * @function    PING_GetEcho(PING_Echo *echo)
+ * @brief       Takes the oldest echo not read yet, so every measurement can be processed
+ *              even when the caller runs less often than the sensor. The last
+ *              PING_ECHO_QUEUE echoes are kept, newer ones are lost while it is full.
+ *              No I/O should be done in this function
+ * @return      TRUE if echo was filled in, FALSE if none is waiting
+ */
+char PING_GetEcho(PING_Echo *echo){
+    return RING_Get(&echoes, echo) == SUCCESS;
+}
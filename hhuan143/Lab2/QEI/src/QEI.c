@@ -1,11 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <QEI.h>
+#include <timers.h>
+#include <RingBuffer.h>
 
 static volatile uint8_t last_state;
 static volatile signed int encoder_position = 0;
 
+static QEI_Step step_storage[QEI_STEP_QUEUE];
+static RING_Buffer steps; // both EXTI ISRs (same priority) to QEI_GetStep()
+
 void QEI_Init(void) {
+    RING_Init(&steps, step_storage, sizeof(QEI_Step), QEI_STEP_QUEUE);
+
     //Configure GPIO pins : PB4 PB5
     GPIO_InitTypeDef GPIO_InitStruct = {0};
     GPIO_InitStruct.Pin = ENC_A | ENC_B;
@@ -31,39 +38,46 @@ void QEI_IRQ(void) {
     uint8_t a = HAL_GPIO_ReadPin(GPIOB, ENC_A);
     uint8_t b = HAL_GPIO_ReadPin(GPIOB, ENC_B);
     uint8_t current_state = (a << 1) | b;
+    int8_t step = 0;
 
     // State machine to determine direction
     switch (last_state) {
         case 0b00:
             if (current_state == 0b01){
-                encoder_position--; //ccw
+                step = -1; //ccw
             }else if (current_state == 0b10){
-                encoder_position++; //cw
+                step = 1; //cw
             }
             break;
         case 0b01:
             if (current_state == 0b11){
-                encoder_position--;
+                step = -1;
             }else if (current_state == 0b00){ 
-                encoder_position++;
+                step = 1;
             }
             break;
         case 0b11:
             if (current_state == 0b10){ 
-                encoder_position--;
+                step = -1;
             }else if (current_state == 0b01){
-                encoder_position++;
+                step = 1;
             }
             break;
         case 0b10:
             if (current_state == 0b00){
-                encoder_position--;
+                step = -1;
             }else if (current_state == 0b11){
-                encoder_position++;
+                step = 1;
             }
             break;
     }
 
+    if (step != 0) {
+        encoder_position += step;
+        QEI_Step edge = {TIMERS_GetMicroSeconds(), step};
+        RING_Put(&steps, &edge);
+    }
+
     // Update the last state
     last_state = current_state;
 }
@@ -104,4 +118,16 @@ int QEI_GetPosition(void){
 */
 void QEI_ResetPosition(){
     encoder_position = 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @function QEI_GetStep(QEI_Step *step)
+ * @param step - filled in with the oldest quadrature step not read yet
+ * @brief  Every valid edge of A or B is one step, so speed and direction can be taken from
+ *         each edge instead of sampling the position. The last QEI_STEP_QUEUE steps are
+ *         kept, newer ones are lost while it is full.
+ * @return TRUE if step was filled in, FALSE if none is waiting
+*/
+char QEI_GetStep(QEI_Step *step){
+    return RING_Get(&steps, step) == SUCCESS;
+}
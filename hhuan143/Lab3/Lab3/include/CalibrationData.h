@@ -0,0 +1,44 @@
+/**
+ * @file    CalibrationData.h
+ *
+ * GENERATED by tools/calgen, do not edit. Regenerate with:
+ *
+ *     calgen --accel hhuan143/matlab/Lab3/acc_raw.csv --mag hhuan143/matlab/Lab3/mag_raw.csv --gyro-still hhuan143/matlab/Lab3/gyro_10min.csv --accel-sign -1,-1,1 --mag-sign -1,-1,-1 --gyro-gain 0.0105882353 -o hhuan143/Lab3/Lab3/include/CalibrationData.h
+ */
+
+#ifndef CALIBRATION_DATA_H
+#define CALIBRATION_DATA_H
+
+#include <Calibration.h>
+
+/** Accelerometer, raw -> g. */
+static const CAL_Affine CAL_ACCEL_DATA = {
+    {
+        {-0.000984684006f, 3.9179425e-06f, -1.02010563e-05f},
+        {1.1213871e-05f, -0.000947990481f, -1.82916401e-05f},
+        {2.35572393e-05f, 2.64111668e-05f, 0.000923618982f},
+    },
+    {-0.0133674763f, 0.0163117946f, 0.0027833384f}
+};
+
+/** Magnetometer, raw -> nT. */
+static const CAL_Affine CAL_MAG_DATA = {
+    {
+        {-54.3872796f, 0.524169955f, 7.61720555f},
+        {-3.52942454f, -68.6812597f, 4.23920876f},
+        {14.9978435f, 3.16744754f, -59.9173068f},
+    },
+    {-32.7748786f, 22711.9021f, -7511.30974f}
+};
+
+/** Gyro, raw -> rate with the stationary bias removed. */
+static const CAL_Affine CAL_GYRO_DATA = {
+    {
+        {0.0105882353f, 0.0f, 0.0f},
+        {0.0f, 0.0105882353f, 0.0f},
+        {0.0f, 0.0f, 0.0105882353f},
+    },
+    {0.138231272f, 0.204677294f, -0.0578387644f}
+};
+
+#endif  /*  CALIBRATION_DATA_H  */
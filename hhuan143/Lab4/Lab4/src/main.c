@@ -4,54 +4,44 @@
 #include <BNO055.h>
 #include <timers.h>
 #include <math.h>
+#include <Calibration.h>
+#include <MagCal.h>
+#include <Stillness.h>
+#include <GyroTemp.h>
+#include <AttitudeFilter.h>
+#include <Scheduler.h>
+#include <LoopMonitor.h>
+#include <Telemetry.h>
+#include <Format.h>
 
 
-//2 point calibration for accelerometer
-#define ACC_X_FACEFOWARD -1000
-#define ACC_X_FACEBACKWARD 990
+//calibration maps, regenerate with tools/calgen (see tools/README.md)
+#include <CalibrationData.h>
 
-#define ACC_Y_FACERIGHT 920
-#define ACC_Y_FACELEFT -1080
-
-#define ACC_Z_FACEUP 980
-#define ACC_Z_FACEDOWN -1010
-
-//expected values for magnetometer (raw values should be mapped to this)
-#define EXPECTED_MAG_UP 41237.2
-#define EXPECTED_MAG_DOWN -41237.2
-
-#define EXPECTED_MAG_NORTH 23233.9
-#define EXPECTED_MAG_SOUTH -23233.9
-
-#define EXPECTED_MAG_EAST 5192.3
-#define EXPECTED_MAG_WEST -5192.3
-
-//2 point calibration for the magnetometer
-#define MAG_X_NORTH 700
-#define MAG_X_SOUTH -120
-
-#define MAG_Y_NORTH 770
-#define MAG_Y_SOUTH -50
-
-#define MAG_Z_FACEUP -840
-#define MAG_Z_FACEDOWN 405
-
-//gyro scale factor clibration for each axis (raw sensor reading from turning gyro)
-#define GYRO_SCALE_X 13500
-#define GYRO_SCALE_Y 13500
-#define GYRO_SCALE_Z 13500
-
-//gyro bias, from averaging 10 mins of raw data (drift)
-#define GYRO_BIAS_X -14
-#define GYRO_BIAS_Y -17.5
-#define GYRO_BIAS_Z 5.7
-
-// Define constants
+// Define constants, starting gains of the attitude filter (tools/tune sweeps them)
 #define Kp_a 10.0f
 #define Ki_a (Kp_a / 10.0f)
 #define Kp_m 10.0f
 #define Ki_m (Kp_m / 10.0f)
 
+#define GYRO_BIAS_TIMEOUT 1500 //samples (30s at 50Hz) to wait for the board to be still at power up
+#define GYRO_TEMP_SAVE_MS 600000 //at most one flash write of the gyro temperature table per 10 minutes
+#define ESTIMATOR_PERIOD_MS 20 //50Hz sensor read and filter step
+#define DISPLAY_PERIOD_MS 100 //10Hz angle print
+#define MONITOR_POLL_MS 100 //console check for the loop timing table ('l' prints, 'c' clears)
+#define TELEMETRY_LOOP_MS 1000 //loop counters in the telemetry stream
+
+//binary raw/calibrated/attitude records on the serial port in place of the angle print, decode with
+//tools/telem2cap (see tools/README.md)
+//#define TELEMETRY
+
+//estimator branches tagged in the loop monitor, the slowest run keeps its tags
+#define PATH_GYRO_LEARN 0x01 //still period ended, gyro temperature table taught
+#define PATH_GYRO_APPLY 0x02 //gyro bias map moved to a new temperature
+#define PATH_GYRO_SAVE 0x04 //gyro temperature table save handed to gyro_save_task()
+
+static int8_t estimator_loop;
+
 //global variables to store sensor values
 static volatile int32_t x_avg_acc, y_avg_acc, z_avg_acc;
 
@@ -59,6 +49,8 @@ static volatile int32_t x_avg_mag, y_avg_mag, z_avg_mag;
 
 static volatile int32_t x_avg_gyro, y_avg_gyro, z_avg_gyro;
 
+static float gyro_dps[3]; //calibrated rate of the last sample
+
 static volatile float angle_x = 0.0f, angle_y = 0.0f, angle_z = 0.0f;
 
 // Define vector and matrix types
@@ -88,10 +80,13 @@ typedef struct {
     float roll;  // φ (rotation around x-axis)
 } EulerAngles;
 
-// Initialize rotation matrix and bias estimate
-//static volatile Matrix3x3 R = {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
-static volatile Matrix3x3 R = {{{0.9617, 0.2725, 0.0301}, {-0.2709, 0.9277, 0.2569}, {0.0421, -0.2552, 0.9660}}};
-static volatile Vector3 biasEstimate = {0, 0, 0};
+// Initialize rotation matrix, bias estimate and gains
+static ATT_Filter attitude = {
+    //{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+    {{0.9617, 0.2725, 0.0301}, {-0.2709, 0.9277, 0.2569}, {0.0421, -0.2552, 0.9660}},
+    {0, 0, 0},
+    {Kp_a, Ki_a, Kp_m, Ki_m}
+};
 
 // Collects 'num_samples' and returns the average for accelerometer
 void collect_and_average_accelerometer(uint16_t num_samples) {
@@ -129,140 +124,53 @@ void collect_and_average_magnetometer(uint16_t num_samples) {
 
 //collect raw gyro data and converted to degree
 void collect_and_convert_gyroscope() {
-    float dt = 0.02;
+    float dt = ESTIMATOR_PERIOD_MS / 1000.0f;
 
-    float gyro_raw_x = 0;
-    float gyro_raw_y = 0;
-    float gyro_raw_z = 0;
-    
-    gyro_raw_x += BNO055_ReadGyroX();
-    gyro_raw_y += BNO055_ReadGyroY();    
-    gyro_raw_z += BNO055_ReadGyroZ();
-    //printf("%d, %d, %d\n", gyro_raw_x, gyro_raw_y, gyro_raw_z);
+    int16_t gyro_raw[3] = {BNO055_ReadGyroX(), BNO055_ReadGyroY(), BNO055_ReadGyroZ()};
+    x_avg_gyro = gyro_raw[0]; //raw kept for gyro_temp_update()
+    y_avg_gyro = gyro_raw[1];
+    z_avg_gyro = gyro_raw[2];
+    //printf("%d, %d, %d\n", gyro_raw[0], gyro_raw[1], gyro_raw[2]);
 
     // Convert to °/s and integrate
-    angle_x += ((gyro_raw_x - GYRO_BIAS_X) / GYRO_SCALE_X) * dt * 180;
-    angle_y += ((gyro_raw_y - GYRO_BIAS_Y) / GYRO_SCALE_Y) * dt * 180;
-    angle_z += ((gyro_raw_z - GYRO_BIAS_Z) / GYRO_SCALE_Z) * dt * 180;
-}
-
-// Helper function to compute cross product
-Vector3 cross(Vector3 a, Vector3 b) {
-    Vector3 result;
-    result.x = a.y * b.z - a.z * b.y;
-    result.y = a.z * b.x - a.x * b.z;
-    result.z = a.x * b.y - a.y * b.x;
-    return result;
+    CAL_Apply(CAL_GYRO, gyro_raw, gyro_dps);
+    angle_x += gyro_dps[0] * dt;
+    angle_y += gyro_dps[1] * dt;
+    angle_z += gyro_dps[2] * dt;
 }
 
-// Function to compute the norm of a vector
-float vector_norm(Vector3 v) {
-    return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+//install the accel, mag and gyro calibration maps generated by tools/calgen
+void calibration_init() {
+    CAL_Init();
+    CAL_Set(CAL_ACCEL, &CAL_ACCEL_DATA);
+    CAL_Set(CAL_MAG, &CAL_MAG_DATA);
+    CAL_Set(CAL_GYRO, &CAL_GYRO_DATA);
+    GTEMP_Init(); //gyro bias vs temperature from flash, replaces the CAL_GYRO_DATA bias once taught
+    GTEMP_Apply(GTEMP_ReadTemp());
 }
 
-// Function to normalize a vector
-Vector3 normalize(Vector3 v) {
-    float norm = vector_norm(v);  // Compute the norm of the vector
-    if (norm != 0.0f) {           // Avoid division by zero
-        v.x /= norm;              // Divide each component by the norm
-        v.y /= norm;
-        v.z /= norm;
-    }
-    return v;  // Return the normalized vector
-}
-
-// Helper function to compute matrix exponential (simplified for small angles)
-Matrix3x3 Rexp(Vector3 w, float deltaT) {
-    Matrix3x3 result = {{
-        {1.0f, -w.z * deltaT, w.y * deltaT},
-        {w.z * deltaT, 1.0f, -w.x * deltaT},
-        {-w.y * deltaT, w.x * deltaT, 1.0f}
-    }};
-    return result;
-}
-
-// Main function to integrate gyroscope data with closed-loop correction (no magnetometer)
+// Main function to integrate gyroscope data with closed-loop correction, the filter itself is Common/AttitudeFilter
 void IntegrateClosedLoop(Vector3 gyros, Vector3 accels, Vector3 mags, Vector3 accelInertial, Vector3 magInertial, float deltaT) {
-    // Normalize accelerometer reading and inertial reference vector
-    accels = normalize(accels);
-    mags = normalize(mags);
-    accelInertial = normalize(accelInertial);
-    magInertial = normalize(magInertial);
-
-    // Remove bias from gyroscope readings
-    Vector3 gyroInputWithBias = {gyros.x - biasEstimate.x, gyros.y - biasEstimate.y, gyros.z - biasEstimate.z};
-
-    // Compute accelerometer feedback term using cross product
-    Vector3 wmeas_a = cross(accels, (Vector3){
-        R.m[0][0] * accelInertial.x + R.m[0][1] * accelInertial.y + R.m[0][2] * accelInertial.z,
-        R.m[1][0] * accelInertial.x + R.m[1][1] * accelInertial.y + R.m[1][2] * accelInertial.z,
-        R.m[2][0] * accelInertial.x + R.m[2][1] * accelInertial.y + R.m[2][2] * accelInertial.z
-    });
-
-    Vector3 wmeas_m = cross(mags, (Vector3){
-        R.m[0][0] * magInertial.x + R.m[0][1] * magInertial.y + R.m[0][2] * magInertial.z,
-        R.m[1][0] * magInertial.x + R.m[1][1] * magInertial.y + R.m[1][2] * magInertial.z,
-        R.m[2][0] * magInertial.x + R.m[2][1] * magInertial.y + R.m[2][2] * magInertial.z
-    });
-
-    // Apply feedback to gyroscope input (only accelerometer feedback)
-    Vector3 gyroInputWithFeedback = {
-        gyroInputWithBias.x + Kp_a * wmeas_a.x + Kp_m * wmeas_m.x,
-        gyroInputWithBias.y + Kp_a * wmeas_a.y + Kp_m * wmeas_m.y,
-        gyroInputWithBias.z + Kp_a * wmeas_a.z + Kp_m * wmeas_m.z
-    };
-
-    // Update bias estimate (only accelerometer feedback)
-    Vector3 bdot = {
-        -Ki_a * wmeas_a.x - Ki_m * wmeas_m.x,
-        -Ki_a * wmeas_a.y - Ki_m * wmeas_m.y,
-        -Ki_a * wmeas_a.z - Ki_m * wmeas_m.z
-    };
-    biasEstimate.x += bdot.x * deltaT;
-    biasEstimate.y += bdot.y * deltaT;
-    biasEstimate.z += bdot.z * deltaT;
-
-    //printf("\rYaw: %5.2f°, Pitch: %5.2f°, Roll: %5.2f°", gyroInputWithFeedback.x, gyroInputWithFeedback.y, gyroInputWithFeedback.z);
-    Vector3 Bplus = {
-        biasEstimate.x + bdot.x * deltaT,
-        biasEstimate.y + bdot.y * deltaT,
-        biasEstimate.z + bdot.z * deltaT
-    };
-    biasEstimate = Bplus;
-
-    // Update rotation matrix using matrix exponential
-    Matrix3x3 deltaR = Rexp(gyroInputWithFeedback, deltaT);
-    //deltaR has non-zero output as i turn sensor
-    // Compute Rplus = deltaR * R
-    Matrix3x3 Rplus;
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            Rplus.m[i][j] = 0;
-            for (int k = 0; k < 3; k++) {
-                Rplus.m[i][j] += deltaR.m[i][k] * R.m[k][j];
-            }
-        }
-    }
-    //print_matrix("Rplus", Rplus); //this line Rplus is all zeros
-    R = Rplus;
-
-    
-    // Print the updated rotation matrix (Rplus)
-    //print_matrix("Updated R (Rplus)", Rplus);
+    float gyro[3] = {gyros.x, gyros.y, gyros.z};
+    float acc[3] = {accels.x, accels.y, accels.z};
+    float mag[3] = {mags.x, mags.y, mags.z};
+    float acc_inertial[3] = {accelInertial.x, accelInertial.y, accelInertial.z};
+    float mag_inertial[3] = {magInertial.x, magInertial.y, magInertial.z};
+    ATT_Update(&attitude, gyro, acc, mag, acc_inertial, mag_inertial, deltaT);
 }
 
 // Function to extract Euler angles from a rotation matrix
-EulerAngles ExtractEulerAngles(Matrix3x3 R) {
+EulerAngles ExtractEulerAngles(float R[3][3]) {
     EulerAngles angles;
 
     // Extract pitch (θ)
-    angles.pitch = asinf(-R.m[0][2]);
+    angles.pitch = asinf(-R[0][2]);
 
     // Extract roll (φ)
-    angles.roll = atan2f(R.m[1][2], R.m[2][2]);
+    angles.roll = atan2f(R[1][2], R[2][2]);
 
     // Extract yaw (ψ)
-    angles.yaw = atan2f(R.m[0][1], R.m[0][0]);
+    angles.yaw = atan2f(R[0][1], R[0][0]);
 
     return angles;
 }
@@ -276,81 +184,208 @@ Vector3 DegreesToRadians(Vector3 degrees) {
     return radians;
 }
 
+static int8_t gyro_temp_unsaved = FALSE;
+static int8_t gyro_temp_save_pending = FALSE; //gyro_temp_update() asked for a save, gyro_temp_save() not run yet
+static uint32_t gyro_temp_last_save = 0; //ms, boot until the first save
+
+//hold still at power up: average the raw gyro until the bias is known to STILL_TOLERANCE, teach it to
+//the temperature table, and start the integral loop from what is left after the CAL_GYRO map instead
+//of from zero
+int8_t gyro_bias_init() {
+    STILL_Init(STILL_TOLERANCE, STILL_WINDOW);
+    for (uint16_t i = 0; i < GYRO_BIAS_TIMEOUT; i++) {
+        int16_t acc_raw[3] = {BNO055_ReadAccelX(), BNO055_ReadAccelY(), BNO055_ReadAccelZ()};
+        int16_t gyro_raw[3] = {BNO055_ReadGyroX(), BNO055_ReadGyroY(), BNO055_ReadGyroZ()};
+        if (STILL_Update(acc_raw, gyro_raw) == STILL_CONVERGED) {
+            float mean[3];
+            STILL_GetGyroBias(mean);
+            int8_t temp = GTEMP_ReadTemp();
+            gyro_temp_unsaved |= GTEMP_Learn(temp, mean);
+            GTEMP_Apply(temp);
+            STILL_Init(STILL_TOLERANCE, STILL_WINDOW); //gyro_temp_update() starts a new still period
+            CAL_Affine cal;
+            CAL_Get(CAL_GYRO, &cal);
+            Vector3 residual_deg = {
+                cal.A[0][0] * mean[0] + cal.A[0][1] * mean[1] + cal.A[0][2] * mean[2] + cal.b[0],
+                cal.A[1][0] * mean[0] + cal.A[1][1] * mean[1] + cal.A[1][2] * mean[2] + cal.b[1],
+                cal.A[2][0] * mean[0] + cal.A[2][1] * mean[1] + cal.A[2][2] * mean[2] + cal.b[2]
+            };
+            Vector3 residual = DegreesToRadians(residual_deg);
+            attitude.bias[0] = residual.x;
+            attitude.bias[1] = residual.y;
+            attitude.bias[2] = residual.z;
+            return SUCCESS;
+        }
+        HAL_Delay(20);
+    }
+    return ERROR;
+}
+
+//gyro bias vs temperature: teach the table whenever the board has been still long enough and keep the
+//CAL_GYRO map on the bias of the current temperature. Returns TRUE when the table should be saved: right
+//after a still period (nothing to integrate) and at most every GYRO_TEMP_SAVE_MS, counted from boot for the
+//first one so the power up bias is not written while the app is starting. The caller runs gyro_temp_save()
+//outside the estimator, the flash write stalls the CPU for a second or two
+int8_t gyro_temp_update(const int16_t acc_raw[3]) {
+    int8_t temp = GTEMP_ReadTemp();
+    int16_t gyro_raw[3] = {x_avg_gyro, y_avg_gyro, z_avg_gyro};
+    int8_t still = FALSE;
+    if (STILL_Update(acc_raw, gyro_raw) == STILL_CONVERGED) {
+        float mean[3];
+        STILL_GetGyroBias(mean);
+        gyro_temp_unsaved |= GTEMP_Learn(temp, mean);
+        STILL_Init(STILL_TOLERANCE, STILL_WINDOW);
+        still = TRUE;
+        LOOPMON_Mark(estimator_loop, PATH_GYRO_LEARN);
+    }
+
+    CAL_Affine before, after;
+    CAL_Get(CAL_GYRO, &before);
+    if (GTEMP_Apply(temp)) {
+        //the map now removes part of what the integral loop had been carrying
+        CAL_Get(CAL_GYRO, &after);
+        Vector3 shift_deg = {after.b[0] - before.b[0], after.b[1] - before.b[1], after.b[2] - before.b[2]};
+        Vector3 shift = DegreesToRadians(shift_deg);
+        attitude.bias[0] += shift.x;
+        attitude.bias[1] += shift.y;
+        attitude.bias[2] += shift.z;
+        LOOPMON_Mark(estimator_loop, PATH_GYRO_APPLY);
+    }
+
+    uint32_t now = TIMERS_GetMilliSeconds();
+    if (still && gyro_temp_unsaved && !gyro_temp_save_pending && now - gyro_temp_last_save >= GYRO_TEMP_SAVE_MS) {
+        gyro_temp_save_pending = TRUE;
+        LOOPMON_Mark(estimator_loop, PATH_GYRO_SAVE);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+//erases flash sector 7 and writes the gyro temperature table, blocks for a second or two
+void gyro_temp_save(void) {
+    GTEMP_Save();
+    gyro_temp_last_save = TIMERS_GetMilliSeconds();
+    gyro_temp_unsaved = FALSE;
+    gyro_temp_save_pending = FALSE;
+}
+
+static EulerAngles angles;
+
+static int8_t estimator_restart = TRUE; //the next step has no previous one to measure from
+static uint32_t estimator_last_us;
+
+//time step (s) since the previous estimator run, the nominal period after a restart
+static float estimator_dt(void) {
+    uint32_t now = TIMERS_GetMicroSeconds();
+    float dt = estimator_restart ? ESTIMATOR_PERIOD_MS / 1000.0f : (now - estimator_last_us) / 1000000.0f;
+    estimator_last_us = now;
+    estimator_restart = FALSE;
+    return dt;
+}
+
+//background one shot: the flash write stops everything for a second or two, so it runs after the estimator
+//and the other tasks, and the estimator restarts its time step instead of integrating the pause as one step
+void gyro_save_task(void) {
+    gyro_temp_save();
+    estimator_restart = TRUE;
+}
+
+//50Hz: read the sensors, calibrate and run the attitude filter
+void estimator_task(void) {
+    LOOPMON_Start(estimator_loop);
+    float deltaT = estimator_dt(); // Time step (s)
+#ifdef TELEMETRY
+    uint32_t sample_us = TIMERS_GetMicroSeconds();
+#endif
+    //get raw sensor readings
+    collect_and_average_accelerometer(1);
+
+    //apply accelerometer calibration
+    int16_t acc_raw[3] = {x_avg_acc, y_avg_acc, z_avg_acc};
+    float acc_calibrated[3];
+    CAL_Apply(CAL_ACCEL, acc_raw, acc_calibrated);
+    //printf("\rcalibrated: %.2f, %.2f, %.2f\n", acc_calibrated[0], acc_calibrated[1], acc_calibrated[2]);
+
+    //get raw sensor readings
+    collect_and_average_magnetometer(1);
+
+    //apply magnetometer calibration
+    int16_t mag_raw[3] = {x_avg_mag, y_avg_mag, z_avg_mag};
+    MAGCAL_Update(mag_raw); //keeps refining hard/soft iron as the board moves
+    float mag_calibrated[3];
+    CAL_Apply(CAL_MAG, mag_raw, mag_calibrated);
+    //printf("\r%.2f, %.2f, %.2f", mag_calibrated[0], mag_calibrated[1], mag_calibrated[2]);
+
+    //collect and calibrate gyro
+    collect_and_convert_gyroscope();
+    if (gyro_temp_update(acc_raw) && SCHED_Add(gyro_save_task, SCHED_ONE_SHOT, 0, SCHED_PRIORITY_BACKGROUND) == ERROR) {
+        gyro_save_task(); //task table full, save now rather than never
+    }
+    //printf("\rdegree: X: %.2f°, Y: %.2f°, Z: %.2f°", angle_x, angle_y, angle_z);
+
+    // Example sensor data
+    Vector3 gyros_deg = {gyro_dps[0], gyro_dps[1], gyro_dps[2]}; // calibrated gyro rate (deg/s), not the integrated angles
+    Vector3 gyros_rad = DegreesToRadians(gyros_deg);
+    Vector3 accels = {acc_calibrated[0], acc_calibrated[1], acc_calibrated[2]};  // Accelerometer data (g) calibrated data reads (~0, ~0, ~1) (xyz) for faceup IMU
+    Vector3 accelInertial = {0.0f, 0.0f, -1.0f}; // Inertial gravity vector 
+    Vector3 mags = {mag_calibrated[0], mag_calibrated[1], mag_calibrated[2]};
+    Vector3 magInertial = {-23233.9f, 1000.0f, -41237.2f};  // Magnetic field points towards magnetic north, calibrated data read: (~23000, ~-1000, ~41000) (xyz) for IMU x pointed north/faceup
+
+    // Integrate orientation
+    IntegrateClosedLoop(gyros_rad, accels, mags, accelInertial, magInertial, deltaT);
+
+    // Extract Euler angles from the rotation matrix
+    angles = ExtractEulerAngles(attitude.R);
+
+#ifdef TELEMETRY
+    int16_t gyro_raw[3] = {x_avg_gyro, y_avg_gyro, z_avg_gyro};
+    TELEM_SendRaw(sample_us, acc_raw, mag_raw, gyro_raw);
+    TELEM_SendCalibrated(sample_us, acc_calibrated, mag_calibrated, gyro_dps);
+    TELEM_SendAttitude(sample_us, attitude.R, attitude.bias);
+#endif
+    LOOPMON_End(estimator_loop);
+}
+
+//10Hz: the serial print takes a few ms at 115200, keep it out of the filter rate
+void display_task(void) {
+    // Convert Euler angles from radians to degrees (inline conversion)
+    float yaw_deg = angles.yaw * (180.0f / M_PI);
+    float pitch_deg = angles.pitch * (180.0f / M_PI);
+    float roll_deg = angles.roll * (180.0f / M_PI);
+    // Output Euler angles in degrees
+    char yaw_text[12], pitch_text[12], roll_text[12];
+    FMT_Fixed(yaw_text, sizeof(yaw_text), yaw_deg, 2, -5);
+    FMT_Fixed(pitch_text, sizeof(pitch_text), pitch_deg, 2, -5);
+    FMT_Fixed(roll_text, sizeof(roll_text), roll_deg, 2, -5);
+    printf("\rYaw: %s°, Pitch: %s°, Roll: %s°", yaw_text, pitch_text, roll_text);
+    fflush(stdout); // Flush the output buffer to ensure it's printed immediately
+}
+
+//1Hz: estimator timing, so a capture shows whether samples were late
+void telemetry_task(void) {
+    TELEM_SendLoop(TIMERS_GetMicroSeconds(), estimator_loop);
+}
+
 int main(void) {
     //init all hardware
     BOARD_Init();
     BNO055_Init();
     TIMER_Init();
-    while(1){
-        //get raw sensor readings
-        collect_and_average_accelerometer(1);
-
-        //2 point calibration for accelerometer, calcualting bias and scale factor
-        float x_scale_factor = (ACC_X_FACEBACKWARD-ACC_X_FACEFOWARD) / -2;
-        float x_bias = (ACC_X_FACEFOWARD+(ACC_X_FACEBACKWARD)) / 2;
-        float x_calibrated = (x_avg_acc - x_bias) / x_scale_factor;
-        //printf("x: %.2f, %.2f\n", x_scale_factor, x_bias);
-
-        float y_scale_factor = (ACC_Y_FACELEFT-ACC_Y_FACERIGHT) / -2;
-        float y_bias = (ACC_Y_FACERIGHT+(ACC_Y_FACELEFT)) / 2;
-        float y_calibrated = (y_avg_acc - y_bias) / y_scale_factor;
-        //printf("y: %.2f, %.2f\n", y_scale_factor, y_bias);
-
-        float z_scale_factor = (ACC_Z_FACEDOWN-ACC_Z_FACEUP) / -2;
-        float z_bias = (ACC_Z_FACEUP+(ACC_Z_FACEDOWN)) / 2;
-        float z_calibrated = (z_avg_acc - z_bias) / z_scale_factor;
-        //printf("z: %.2f, %.2f\n", z_scale_factor, z_bias);
-        
-        //printf("\rcalibrated: %.2f, %.2f, %.2f\n", x_calibrated, y_calibrated, z_calibrated);
-
-        //get raw sensor readings
-        collect_and_average_magnetometer(1);
-
-        //2 point calibrations for the magnetometer
-        float x_scale_factor_mag = (EXPECTED_MAG_SOUTH-EXPECTED_MAG_NORTH) / (MAG_X_SOUTH-MAG_X_NORTH);
-        float x_bias_mag = EXPECTED_MAG_NORTH - (x_scale_factor_mag*MAG_X_NORTH);
-        float x_calibrated_mag = (x_scale_factor_mag*x_avg_mag) + x_bias_mag;
-        //printf("x: %.2f, %.2f\n", x_scale_factor_mag, x_bias_mag);
-
-        float y_scale_factor_mag = (EXPECTED_MAG_SOUTH-EXPECTED_MAG_NORTH) / (MAG_Y_SOUTH-MAG_Y_NORTH);
-        float y_bias_mag = EXPECTED_MAG_NORTH - (y_scale_factor_mag*MAG_Y_NORTH);
-        float y_calibrated_mag = (y_scale_factor_mag*y_avg_mag) + y_bias_mag;
-        //printf("y: %.2f, %.2f\n", y_scale_factor_mag, y_bias_mag);
-
-        float z_scale_factor_mag = (EXPECTED_MAG_DOWN-EXPECTED_MAG_UP) / (MAG_Z_FACEDOWN-MAG_Z_FACEUP);
-        float z_bias_mag = EXPECTED_MAG_UP - (z_scale_factor_mag*MAG_Z_FACEUP);
-        float z_calibrated_mag = (z_scale_factor_mag*z_avg_mag) + z_bias_mag;
-        //printf("z: %.2f, %.2f\n", z_scale_factor_mag, z_bias_mag);
-        
-        //printf("\r%.2f, %.2f, %.2f", x_calibrated_mag, y_calibrated_mag, z_calibrated_mag);
-        
-        //collect and calibrate gyro, all previous code may need to be uncommented due to timing
-        collect_and_convert_gyroscope();
-        //printf("\rdegree: X: %.2f°, Y: %.2f°, Z: %.2f°", angle_x, angle_y, angle_z);
-        
-        // Example sensor data
-        Vector3 gyros_deg = {angle_x, angle_y, angle_z}; // Gyroscope data (rad/s)
-        Vector3 gyros_rad = DegreesToRadians(gyros_deg);
-        Vector3 accels = {x_calibrated, y_calibrated, z_calibrated};  // Accelerometer data (g) calibrated data reads (~0, ~0, ~1) (xyz) for faceup IMU
-        Vector3 accelInertial = {0.0f, 0.0f, -1.0f}; // Inertial gravity vector 
-        Vector3 mags = {x_calibrated_mag, y_calibrated_mag, z_calibrated_mag};
-        Vector3 magInertial = {-23233.9f, 1000.0f, -41237.2f};  // Magnetic field points towards magnetic north, calibrated data read: (~23000, ~-1000, ~41000) (xyz) for IMU x pointed north/faceup
-        float deltaT = 0.02f; // Time step (s)
-
-        // Integrate orientation
-        IntegrateClosedLoop(gyros_rad, accels, mags, accelInertial, magInertial, deltaT);
-
-        // Extract Euler angles from the rotation matrix
-        EulerAngles angles = ExtractEulerAngles(R);
-
-        // Convert Euler angles from radians to degrees (inline conversion)
-        float yaw_deg = angles.yaw * (180.0f / M_PI);
-        float pitch_deg = angles.pitch * (180.0f / M_PI);
-        float roll_deg = angles.roll * (180.0f / M_PI);
-        // Output Euler angles in degrees
-        printf("\rYaw: %-5.2f°, Pitch: %-5.2f°, Roll: %-5.2f°", yaw_deg, pitch_deg, roll_deg);
-        fflush(stdout); // Flush the output buffer to ensure it's printed immediately
-
-        HAL_Delay(20); //delay to 50Hz or 20ms
-    }
+    calibration_init();
+    MAGCAL_Init(MAGCAL_FIELD_NORM);
+    gyro_bias_init(); //keep the board still for a few seconds
+
+    //the estimator must finish before its next period starts
+    estimator_loop = LOOPMON_Add("estimator", ESTIMATOR_PERIOD_MS * 1000, ESTIMATOR_PERIOD_MS * 1000);
+
+    SCHED_Init();
+    SCHED_Add(estimator_task, ESTIMATOR_PERIOD_MS, 0, SCHED_PRIORITY_SENSOR);
+#ifdef TELEMETRY
+    TELEM_Init();
+    SCHED_Add(telemetry_task, TELEMETRY_LOOP_MS, 0, SCHED_PRIORITY_BACKGROUND);
+#else
+    SCHED_Add(display_task, DISPLAY_PERIOD_MS, 0, SCHED_PRIORITY_UI);
+#endif
+    SCHED_Add(LOOPMON_Poll, MONITOR_POLL_MS, 0, SCHED_PRIORITY_BACKGROUND);
+    SCHED_Run();
 }
@@ -1,36 +1,44 @@
 /*
 This is the driver code for the esp used to calculate cup height and then communicate with the
 STM.
-*/
-
-
-
-
-
-
 
+The ten photodiode states go out as one 5 byte frame on UART1:
 
+    0xC5, seq, mask low byte, mask high byte, crc8
 
+bit i of the mask is pin i, set when light reaches the diode (no cup in the way). seq counts
+the frames sent, crc8 (poly 0x07, init 0) covers the first four bytes. A frame is sent as soon
+as a state changes and every HEARTBEAT_MS otherwise, so the STM sees a change within one
+sample period and knows the link is alive. The STM side is in sensors.c.
+*/
 
+#define LINK_BAUD 921600                 // must match CUP_LINK_BAUD in sensors.c
+#define FRAME_SYNC 0xC5
+#define SAMPLE_MS 2                      // ADC sweep period
+#define HEARTBEAT_MS 100                 // resend the unchanged state this often
+#define DEBUG_PRINT 0                    // 1 prints each sent state on the USB serial port
 
 const int numPins = 10;                  // Total ADC pins
-const int numReadings = 6;              // Moving average window size
+const int readingsShift = 3;            // Moving average window is 2^readingsShift
+const int numReadings = 1 << readingsShift;
 // Define your ADC pins here
 const int adcPins[numPins] = {36,39,34,35,32,33,25,26,27,14};
 int readings[numPins][numReadings];      // Stores readings for each pin
 int readIndex[numPins] = {0};            // Current index for each pin
 long total[numPins] = {0};               // Running total for each pin
-int average[numPins] = {0};              // Average ADC value for each pin
-int binary[numPins] = {0};
 
 HardwareSerial MySerial(1); // UART1 instance
-byte dataList[10]= {0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01};
-//byte dataList[1]= {0x01};
+uint16_t mask = (1 << numPins) - 1;      // start with every diode lit, no cup
+uint16_t sentMask = mask;
+byte seq = 0;
+unsigned long lastSend = 0;
+unsigned long lastSample = 0;
+
 void setup() {
-  
-  Serial.begin(9600);
+
+  Serial.begin(115200);
   analogReadResolution(12);              // 12-bit resolution
-  MySerial.begin(9600, SERIAL_8N1, 16, 17);
+  MySerial.begin(LINK_BAUD, SERIAL_8N1, 16, 17);
 
   // Initialize readings array
   for (int pin = 0; pin < numPins; pin++) {
@@ -41,33 +49,57 @@ void setup() {
 }
 
 void loop() {
+  unsigned long now = millis();
+  if (now - lastSample < SAMPLE_MS) {
+    return;
+  }
+  lastSample = now;
+
   for (int pin = 0; pin < numPins; pin++) {
-    total[pin] = total[pin] - readings[pin][readIndex[pin]];        // Remove oldest
-    readings[pin][readIndex[pin]] = analogRead(adcPins[pin]);       // Read ADC
-    total[pin] = total[pin] + readings[pin][readIndex[pin]];        // Add new reading
-    readIndex[pin]++;                                               // Move to next index
-    if (readIndex[pin] >= numReadings) {
-      readIndex[pin] = 0;
-    }
-    Printav(pin);
-                                            
+    int index = readIndex[pin];
+    int reading = analogRead(adcPins[pin]);                         // Read ADC
+    total[pin] += reading - readings[pin][index];                   // Swap oldest for newest
+    readings[pin][index] = reading;
+    readIndex[pin] = (index + 1) & (numReadings - 1);               // Wrap with a mask
+    updateState(pin);
+  }
+
+  if (mask != sentMask || now - lastSend >= HEARTBEAT_MS) {
+    sendFrame();
+    sentMask = mask;
+    lastSend = now;
   }
-  // Send the entire array at once
-  MySerial.write(dataList,10);
-  delay(50); // Delay between transmissions
 }
 
-void Printav(int pin){
-  int average = total[pin]/numReadings;
+void updateState(int pin){
+  int average = total[pin] >> readingsShift;
   // Hysteresis for moving average filter
     if(average >= 2150){
-      dataList[pin] = 0x01;
+      mask |= 1 << pin;
     }else if(average <= 2100){
-      dataList[pin] = 0x00;
+      mask &= ~(1 << pin);
+    }
+}
+
+byte crc8(const byte *data, int length){
+  byte crc = 0;
+  for (int i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
     }
+  }
+  return crc;
+}
+
+void sendFrame(){
+  byte frame[5] = {FRAME_SYNC, seq++, (byte)(mask & 0xFF), (byte)(mask >> 8), 0};
+  frame[4] = crc8(frame, 4);
+  // One write, so the STM's idle line detection sees the frame whole
+  MySerial.write(frame, sizeof(frame));
 
-Serial.print("pin: ");
-Serial.print(pin);
-Serial.print("binary: ");
-Serial.println(dataList[pin]);
+#if DEBUG_PRINT
+  Serial.print("mask: ");
+  Serial.println(mask, BIN);
+#endif
 }
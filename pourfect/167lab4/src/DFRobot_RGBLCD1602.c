@@ -15,6 +15,7 @@
  #include <stdlib.h>
  #include <Board.h>
  #include <timers.h>
+#include <Bringup.h>
 #include "DFRobot_RGBLCD1602.h"
 
 
@@ -50,7 +51,14 @@ These were changed to use the writeReg function written specifically for the RGB
 Some functions are commented out as they were not used
 */
 
-void DFRobot_Init()
+static uint8_t init_phase = 0; //DFRobot_InitStep() progress
+static uint8_t init_ready = 0;
+
+static void begin_setup(uint8_t rows);
+static int32_t begin_step(uint8_t phase);
+
+//driver state and I2C, the part of the init that doesn't talk to the LCD
+static void driver_setup(void)
 {
     printf("Initializing driver\n");
     printf("Initializing timers\n");
@@ -92,11 +100,35 @@ printf("Driver installed\n");
 
     // Setup LCD function
     _showFunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
+}
+
+void DFRobot_Init()
+{
+    driver_setup();
     //HAL_Delay(5000);
     printf("entering begin\n");
     begin(_rows);  // Call your LCD initialization function
 }
 
+//same init as DFRobot_Init(), but returns the wait before the next call instead of blocking
+int32_t DFRobot_InitStep(void)
+{
+    if (init_ready) {
+        return BRINGUP_READY;
+    }
+    if (init_phase == 0) {
+        driver_setup();
+        begin_setup(_rows);
+    }
+    int32_t wait = begin_step(init_phase);
+    if (wait == BRINGUP_READY) {
+        init_ready = 1;
+    } else {
+        init_phase++;
+    }
+    return wait;
+}
+
 /**
  * Block the processor for the desired number of milliseconds.
  * @param ms The number of milliseconds to block for.
@@ -265,7 +297,8 @@ inline void command(uint8_t value)
 // }
 
 // /*******************************private*******************************/
-void begin(uint8_t rows) 
+//the part of begin() that doesn't talk to the LCD
+static void begin_setup(uint8_t rows)
 {
     uint8_t charSize = LCD_5x8DOTS;
 
@@ -279,42 +312,67 @@ void begin(uint8_t rows)
     if ((charSize != 0) && (rows == 1)) {
         _showFunction |= LCD_5x10DOTS;
     }
+}
 
-    // Wait for power stabilization (at least 40ms after VCC > 2.7V)
-    DelayMsDFR(100);
-    printf("sending first command\n");
-    command(LCD_FUNCTIONSET | _showFunction);
-    DelayMsDFR(5);
+//one part of begin(), returns the ms the LCD needs before the next part or BRINGUP_READY
+static int32_t begin_step(uint8_t phase)
+{
+    switch (phase) {
+        case 0:
+            // Wait for power stabilization (at least 40ms after VCC > 2.7V)
+            return 100;
 
+        case 1:
+            command(LCD_FUNCTIONSET | _showFunction);
+            return 5;
 
+        case 2:
+            // Second try
+            command(LCD_FUNCTIONSET | _showFunction);
+            return 5;
 
-    // Second try
-    command(LCD_FUNCTIONSET | _showFunction);
-    DelayMsDFR(5);
+        case 3:
+            // Third try
+            command(LCD_FUNCTIONSET | _showFunction);
 
-    // Third try
-    command(LCD_FUNCTIONSET | _showFunction);
+            // Turn the display on with no cursor or blinking default
+            _showControl = LCD_DISPLAYON ;//| LCD_CURSOROFF | LCD_BLINKOFF;
+            display();
 
-    // Turn the display on with no cursor or blinking default
-    _showControl = LCD_DISPLAYON ;//| LCD_CURSOROFF | LCD_BLINKOFF;
-    display();
+            // Clear the display, clear() without its 2 ms wait
+            command(LCD_CLEARDISPLAY);
+            return 2;
 
-    // Clear the display
-    clear();
+        case 4:
+            setCursor(0,0);
 
-    // Initialize to default text direction (for romance languages)
-    _showMode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
-    // Set the entry mode
-    command(LCD_ENTRYMODESET | _showMode);
-    
-    // RGB backlight initialization
+            // Initialize to default text direction (for romance languages)
+            _showMode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+            // Set the entry mode
+            command(LCD_ENTRYMODESET | _showMode);
+
+            // RGB backlight initialization
 
-    setReg(REG_MODE1, 0);
-    setReg(REG_OUTPUT, 0xFF);
-    setReg(REG_MODE2, 0x20);  // Set MODE2 values
+            setReg(REG_MODE1, 0);
+            setReg(REG_OUTPUT, 0xFF);
+            setReg(REG_MODE2, 0x20);  // Set MODE2 values
+
+            // Set color to white
+            setColorWhite();
+            return BRINGUP_READY;
+
+        default:
+            return BRINGUP_READY;
+    }
+}
 
-    // Set color to white
-    setColorWhite();
+void begin(uint8_t rows) 
+{
+    begin_setup(rows);
+    int32_t wait;
+    for (uint8_t phase = 0; (wait = begin_step(phase)) >= 0; phase++) {
+        DelayMsDFR(wait);
+    }
 }
 
 void setColorWhite(){setRGB(255, 255, 255);}
@@ -331,10 +389,9 @@ void setReg(uint8_t addr, uint8_t data)
 }
 
 
-//Clears the row based on row, helper function for clearPrint
+//Clears the row based on row. A character takes the LCD ~40 us, less than one I2C write, so no waits
 void clearRow(int row){
     setCursor(0,row);
-    HAL_Delay(10);
     for(int i = 0; i < _cols; i++){
         write(' ');
     }
@@ -342,13 +399,17 @@ void clearRow(int row){
 }
 
 
+//Writes the string and blanks the rest of the row in one pass, no clear first and no waits
+//(~17 I2C writes, ~6 ms at 100 kHz)
 void clearPrint(const char* string, int row){
-    clearRow(row);
-    HAL_Delay(10);
     setCursor(0,row);
-    HAL_Delay(10);
-    printstr(string);
-    HAL_Delay(100);
+    int i = 0;
+    for(; i < _cols && string[i] != '\0'; i++){
+        write((uint8_t) string[i]);
+    }
+    for(; i < _cols; i++){
+        write(' ');
+    }
 }
 
 void printstr(const char* string){
@@ -97,6 +97,13 @@
    */ 
   void DFRobot_Init();
 
+  /**
+   * @fn DFRobot_InitStep
+   * @brief DFRobot_Init() one part at a time for Bringup.h, never waits
+   * @return the ms the LCD needs before the next call, or BRINGUP_READY
+   */
+  int32_t DFRobot_InitStep(void);
+
   /**
    * @fn clear
    * @brief clear the display and return the cursor to the initial position (position 0)
@@ -268,7 +275,7 @@
 
   /**
    * @fn clearPrint
-   * @brief clears the row indicated by 'row' param and prints, This prevents artifacts from previous prints
+   * @brief prints on the row indicated by 'row' param and blanks the rest of it, This prevents artifacts from previous prints
    * @param string string to be printed
    * @param row row to be cleared and then printed on
    */
@@ -6,6 +6,7 @@
 #include "stm32f411xe.h"
 #include "stm32f4xx_hal_tim.h"
 #include "sensors.h"
+#include "RingBuffer.h"
 
 TIM_HandleTypeDef htim3;
 
@@ -13,11 +14,15 @@ volatile int echo_received = 0; // flag to indicate that an echo has been receiv
 volatile uint32_t start_time = 0; // time at which the echo was sent
 volatile uint32_t elapsed_time = 0; // time between echo sent and received
 
+static PING_Echo echo_storage[PING_ECHO_QUEUE];
+static RING_Buffer echoes; // every measurement, ISRs to PING_GetEcho()
+
 
 char PING_Init(void) {
     // init other libraries
     BOARD_Init();
     TIMER_Init();
+    RING_Init(&echoes, echo_storage, sizeof(PING_Echo), PING_ECHO_QUEUE);
 
     // this block initializes the GPIO output pin (PB8, PWM_5 on shield)
     GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -77,8 +82,11 @@ void EXTI9_5_IRQHandler(void) {
         //if the pin is high, record the start time
         //pin goes high after trigger is sent, and goes low when echo is received
         if(!HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_5)) { 
-            elapsed_time = TIMERS_GetMicroSeconds() - start_time;
+            uint32_t now = TIMERS_GetMicroSeconds();
+            elapsed_time = now - start_time;
             echo_received = 1;
+            PING_Echo echo = {now, elapsed_time};
+            RING_Put(&echoes, &echo);
         } else {
             start_time = TIMERS_GetMicroSeconds();
         }
@@ -118,6 +126,8 @@ void TIM3_IRQHandler(void) {
                 else {
                     current_state = STATE_TRIGGER_SENSOR;
                     elapsed_time = 23200; // set to max distance
+                    PING_Echo echo = {TIMERS_GetMicroSeconds(), elapsed_time}; // queued like a max range echo
+                    RING_Put(&echoes, &echo); // TIM3 and EXTI9_5 are both priority 0, still one producer
                 }
                 break;
         }
@@ -138,3 +148,7 @@ unsigned int PING_GetTimeofFlight(void){
     return elapsed_time;
 }
 
+//oldest measurement not read yet, timeouts come out as a 23200 us echo
+char PING_GetEcho(PING_Echo *echo){
+    return RING_Get(&echoes, echo) == SUCCESS;
+}
@@ -1,10 +1,16 @@
 #include "QEI.h"
 #include "timers.h"
+#include "RingBuffer.h"
 #include <stdio.h>
 volatile int count = 0;
 volatile int count_out = 0;
 
+static QEI_Step step_storage[QEI_STEP_QUEUE];
+static RING_Buffer steps; //every quadrature step, EXTI ISRs (both priority 0) to QEI_GetStep()
+
 void QEI_Init(void) {
+      RING_Init(&steps, step_storage, sizeof(QEI_Step), QEI_STEP_QUEUE); //before the interrupts can fire
+
       //Configure GPIO pins : PB4 PA15
       GPIO_InitTypeDef GPIO_InitStruct = {0};
       GPIO_InitStruct.Pin = GPIO_PIN_4;
@@ -51,6 +57,7 @@ typedef enum { //enum for channel values of A and B
      */
         Event a_state;
         Event b_state;
+        int8_t step = 0;
         if(HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_15)) { //check if b pin is high or low
             b_state = EVENT_B_HIGH;
         } else {
@@ -66,47 +73,52 @@ typedef enum { //enum for channel values of A and B
     switch (current_state_QEI) {
         case STATE_00:
             if (a_state == EVENT_A_HIGH && b_state == EVENT_B_LOW) {  //clockwise
-            count++; 
+            step = 1; 
             current_state_QEI = STATE_10;
             }
             else if (b_state == EVENT_B_HIGH && a_state == EVENT_A_LOW) { //counter clockwise
                 current_state_QEI = STATE_01;
-                count--;
+                step = -1;
             }
             break;
         case STATE_01:
             if (a_state == EVENT_A_HIGH && b_state == EVENT_B_HIGH) { //counter clockwise
                 current_state_QEI = STATE_11;
-                count--;
+                step = -1;
             }
             else if (a_state == EVENT_A_LOW && b_state == EVENT_B_LOW) { //clockwise
                 current_state_QEI = STATE_00;
-                count++;
+                step = 1;
             }
             break;
         case STATE_10:
             if (a_state == EVENT_A_LOW && b_state == EVENT_B_LOW) { //counter clockwise
                 current_state_QEI = STATE_00;
-                count--;
+                step = -1;
             }
             else if (b_state == EVENT_B_HIGH && a_state == EVENT_A_HIGH) { //clockwise
             current_state_QEI = STATE_11;
-            count ++;
+            step = 1;
             }
             break;
         case STATE_11:
             if (a_state == EVENT_A_LOW && b_state == EVENT_B_HIGH) { //clockwise
                 current_state_QEI = STATE_01; 
-                count ++;
+                step = 1;
             }
             else if (b_state == EVENT_B_LOW && a_state == EVENT_A_HIGH) { //counter clockwise
             current_state_QEI = STATE_10;
-            count --;
+            step = -1;
             }
             break;
         default:
            break;
     }
+    if(step != 0){
+        count += step;
+        QEI_Step edge = {TIMERS_GetMicroSeconds(), step};
+        RING_Put(&steps, &edge);
+    }
     //check if count is 4 or -4 and update count_out
     if(count == 4){
         count = 0;
@@ -163,3 +175,8 @@ void QEI_ResetPosition(){
     count = 0;
     count_out = 0;
 }
+
+//oldest quadrature step not read yet, +1 clockwise, -1 counter clockwise
+char QEI_GetStep(QEI_Step *step){
+    return RING_Get(&steps, step) == SUCCESS;
+}
@@ -10,6 +10,23 @@
 #include "sensors.h"
 #include "DFRobot_RGBLCD1602.h"
 #include "pwm.h"
+#include <string.h>
+#include <Scheduler.h>
+#include <Bringup.h>
+#include <LoopMonitor.h>
+#include <Format.h>
+
+#define CONTROL_PERIOD_MS 100 //state machine and button poll
+#define POUR_STEP_MS 200 //one pour step, the control task runs at this rate while pouring
+#define DISPLAY_PERIOD_MS 100 //LCD refresh, rows are only rewritten when they change
+#define LEVEL_CHECK_MS 1000 //wait before each level check
+#define LONG_PRESS_MS 700 //a press held at least this long starts a manual pour
+#define PRESS_TIMEOUT_MS 10000 //a press held longer than this is ignored
+#define LCD_COLUMNS 16
+#define LCD_DEADLINE_MS 500 //LCD power-on sequence takes ~115 ms
+#define IO_DEADLINE_MS 100 //everything else inits in one go
+#define MONITOR_POLL_MS 100 //console check for the loop timing table ('l' prints, 'c' clears)
+#define CUP_POLL_MS 10 //esp32 cup sensor frames, it sends on every change
 
 typedef enum {
     Level_check,
@@ -46,6 +63,20 @@ void stopPump(){
 }
 
 
+//what the LCD should show and what it shows now, display_task() writes the difference
+static char lcd_text[2][LCD_COLUMNS + 1];
+static char lcd_shown[2][LCD_COLUMNS + 1];
+
+/** show()
+ *
+ * Sets the text of an LCD row, the display task writes it out
+ *
+ */
+void show(int row, const char* text){
+    strncpy(lcd_text[row], text, LCD_COLUMNS);
+    lcd_text[row][LCD_COLUMNS] = '\0';
+}
+
 /** checks()
  *
  * Performs checks to ensure cup is present and reserve has enough water
@@ -53,16 +84,22 @@ void stopPump(){
  * @return Returns 0 on failure and 1 on success.
  */
 int checks(){
+    if(!SENSORS_cupLinkUp()){
+        printf("cup sensor link down\r\n");
+        show(0, "Cup sensor down");
+        show(1, "");
+        return 0;
+    }
     if(!SENSORS_cupPresent()){
         printf("no cup present\r\n");
-        clear();
-        printstr("No cup");
+        show(0, "No cup");
+        show(1, "");
         return 0;
     }
     if(!SENSORS_checkWaterLevel()){
         printf("water level is low\r\n");
-        clear();
-        printstr("Not enough water");
+        show(0, "Not enough water");
+        show(1, "");
         return 0;
     }
     return 1;
@@ -73,145 +110,219 @@ State Current_state =  Level_check;
 
 Pour_mode Pour_type = Auto_pour;
 
+static int8_t control_id;
+static int8_t control_loop; //loop monitor of control_task(), the worst run is tagged with its state
+static uint32_t state_entered; //ms, when Current_state was entered
+static uint32_t press_start; //ms, when button 4 went down
+static int8_t pressing = 0;
+static int pour_amount = 0;
+static int pour_count = 0; //manual pour steps done
+static int cup_height = 0; //auto pour target
+static float last_percent = 0;
 
+void enter(State state){
+    Current_state = state;
+    state_entered = TIMERS_GetMilliSeconds();
+    //pour steps run slower than the button poll
+    uint32_t period = state == Pour ? POUR_STEP_MS : CONTROL_PERIOD_MS;
+    SCHED_SetPeriod(control_id, period);
+    LOOPMON_SetPeriod(control_loop, period * 1000);
+}
 
-int main(void) {
-    BOARD_Init();
-    TIMER_Init();
-    BUTTONS_Init();
-    QEI_Init();
-    SENSORS_Init();
-    DFRobot_Init();
-    PWM_Init();
+void show_water_level(){
+    char buffer[32];  // Buffer to hold the formatted string
+    sprintf(buffer, "Water Level: %d%%", SENSORS_getWaterLevel() * 5); //20 pads, 5% each
+    show(0, buffer);
+}
 
-    //Initialize GPIO pin C7
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin = GPIO_PIN_7;
-    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
-    HAL_GPIO_WritePin(GPIOC,GPIO_PIN_7, GPIO_PIN_RESET);  
-    //Done initializing, make sure pin is low so motor does not start
+void start_pour(Pour_mode mode){
+    printf("in pour state\r\n");
+    Pour_type = mode;
+    last_percent = 0;
+    pour_count = 0;
+    if(Pour_type == Auto_pour){
+        printf("pouring automatically\r\n");
+        cup_height = SENSORS_getCupHeight(); //Gets height of the cup
+    } else {
+        printf("pouring manually: %d\r\n", pour_amount);
+    }
+    startPump(); //Starts the pump
+    enter(Pour);
+}
 
-    uint8_t buttons = 0;
-    int pour_amount = 0;
-    char buffer[32];  // Buffer to hold the formatted string
+void finish_pour(){
+    stopPump(); //Done pouring so stop pump
+    enter(Done_Pour);
+}
 
-    while(1){
-        switch(Current_state){ //This is the initial state of our state machine, here a basic check is done to ensure water level is high and a cup is present
-            case Level_check:
-                HAL_Delay(1000);
-                if(!checks()){
-                    continue;
-                }
-                HAL_Delay(100);
-                setCursor(0, 0);
-                sprintf(buffer, "Water Level: %.0f%%", SENSORS_getWaterLevel() / 2.0 * 10);
-
-                clearPrint(buffer,0);
-                printf("moving to button\n");
-                Current_state = Button;
-            break;
-
-            case Button: //In this state button 4 on the STM is polled, if a call to checks fails we go back to the first state
-                pour_amount = SENSORS_getPosition(); //Get the amount to be poured if a manual pour is initiated
-                if(!checks()){
-                    Current_state = Level_check;
-                    continue;
-                }
-                setCursor(0, 0);
-                sprintf(buffer, "Water Level: %.0f%%", SENSORS_getWaterLevel() / 2.0 * 10);
-                clearPrint(buffer,0);
-
-                sprintf(buffer, "Amount: %d ", pour_amount);
-                setCursor(0, 1);
-                clearPrint(buffer,1);
-                buttons = buttons_state(); //Get current state of the buttons
-                if((buttons & 0x1) == 0){
+//one auto pour step: stop once the water reaches the cup height
+void auto_pour_step(){
+    char buffer[32];
+    int water_height = SENSORS_getWaterHeight();
+    if(water_height <= 0){ //ensure no negative values
+        water_height = 1;
+    }
+    printf("pouring auto...\r\n");
+    float percent = 100.0f * water_height / (cup_height * 3.5f); //get percentage of cup filled for printing to screen
+    if (((percent > last_percent) && percent <= 100)  || last_percent == 0){
+        FMT_Fixed(buffer, sizeof(buffer) - 1, percent, 0, 0);
+        strcat(buffer, "%");
+        show(1, buffer);
+        last_percent = percent;
+    }
+    if(!checks() || water_height >= cup_height * 3.5){ //If a check fails while pouring stop pouring
+        printf("broke out\n");
+        finish_pour();
+    }
+}
+
+//one manual pour step: pour and decrement the count set by the QEI
+void manual_pour_step(){
+    char buffer[32];
+    if(pour_count >= pour_amount){
+        finish_pour();
+        return;
+    }
+    sprintf(buffer, "Amount: %d ", pour_amount - pour_count - 1); //print the count
+    show(1, buffer);
+    printf("pouring man...\r\n");
+    pour_count++;
+    if(!checks()){ //If checks fail then stop pouring
+        finish_pour();
+    }
+}
+
+//the dispenser state machine, runs every CONTROL_PERIOD_MS (POUR_STEP_MS while pouring) and never blocks
+void control_task(void){
+    LOOPMON_Start(control_loop);
+    LOOPMON_Mark(control_loop, 1 << Current_state);
+    uint32_t now = TIMERS_GetMilliSeconds();
+    char buffer[32];
+    switch(Current_state){
+        case Level_check: //basic check that the water level is high and a cup is present, once a second
+            if(now - state_entered < LEVEL_CHECK_MS){
+                break;
+            }
+            state_entered = now;
+            if(!checks()){
+                break;
+            }
+            show_water_level();
+            printf("moving to button\n");
+            enter(Button);
+        break;
+
+        case Button: //In this state button 4 on the STM is polled, if a call to checks fails we go back to the first state
+            pour_amount = SENSORS_getPosition(); //Get the amount to be poured if a manual pour is initiated
+            if(!checks()){
+                pressing = 0;
+                enter(Level_check);
+                break;
+            }
+            show_water_level();
+            sprintf(buffer, "Amount: %d ", pour_amount);
+            show(1, buffer);
+
+            if((buttons_state() & 0x1) == 0){ //pressed
+                if(!pressing){
                     printf("press detected\r\n");
-                    for(int i = 0; i <= 100; i++){
-                        buttons = buttons_state();
-                        if((( buttons & 0x1) == 1) && (i >= 7)){ //If the button press was held for more than ~1 second it is a long press and a manual pour is initiated
-                            printf("Long press \r\n");
-                            printf("moving to Check state\n");
-                            Pour_type = Manual_pour;
-                            Current_state = Pour;
-                            break; //Go to pour
-                        }
-                        if(( buttons & 0x1) == 1){ //If the button is held for less than ~1 second initiate a short press
-                            printf("short press\r\n");
-                            printf("moving to check state\n");
-                            Pour_type = Auto_pour;
-                            Current_state = Pour;
-                            break;  //Go to pour
-                        }
-                        HAL_Delay(100);
-                    }
+                    pressing = 1;
+                    press_start = now;
+                } else if(now - press_start > PRESS_TIMEOUT_MS){
+                    pressing = 0; //held too long, wait for the next press
+                }
+            } else if(pressing){ //released: a long press is a manual pour, a short one an auto pour
+                pressing = 0;
+                if(now - press_start >= LONG_PRESS_MS){
+                    printf("Long press \r\n");
+                    start_pour(Manual_pour);
+                } else {
+                    printf("short press\r\n");
+                    start_pour(Auto_pour);
                 }
-                HAL_Delay(100);
-            break;
+            }
+        break;
 
-            case Pour:  //In this state the machine pours either a manual pour or an auto pour
-            printf("in pour state\r\n");
-            float last_percent = 0;
+        case Pour:  //In this state the machine pours either a manual pour or an auto pour, one step per call
             if(Pour_type == Auto_pour){
-                printf("pouring automatically\r\n");
-                int getCupHeight = SENSORS_getCupHeight(); //Gets height of the cup
-                int water_height = 0;
-                startPump(); //Starts the pump
-                while(water_height < getCupHeight * 3.5){ //Make sure height of water is below height of the cup
-                    water_height = SENSORS_getWaterHeight();
-                    if(water_height <= 0){ //ensure no negative values
-                        water_height = 1;
-                    }
-                    printf("pouring auto...\r\n");
-                    float percent = 100.0 * water_height / (getCupHeight * 3.5); //get percentage of cup filled for printing to screen
-                    if (((percent > last_percent) && percent <= 100)  || last_percent == 0){
-                    sprintf(buffer, "%.0f%%",  percent);
-                    setCursor(0, 1);
-                    clearPrint(buffer,1);
-                    last_percent = percent;
-                    }
-                    if(!checks()){ //If a check fails while pouring stop pouring
-                        break;
-                    }
-                    HAL_Delay(200);
-                }
-                printf("broke out\n");
+                auto_pour_step();
             } else {
-                startPump();
-                printf("pouring manually: %d\r\n", pour_amount);
-                int count = 0;
-                while(count < pour_amount){ //Based on QEI value pour and decrement the count
-                    //pour
-                    sprintf(buffer, "Amount: %d ", pour_amount - count - 1); //print the count
-                    setCursor(0, 1);
-                    clearPrint(buffer,1);
-                    printf("pouring man...\r\n");
-                    count++;
-                    if(!checks()){ //If checks fail then stop pouring
-                        break;
-                    }
-                    HAL_Delay(200);
-                }
+                manual_pour_step();
             }
-            stopPump(); //Done pouring so stop pump
-            Current_state = Done_Pour;
-            break;
-
+        break;
 
-            case Done_Pour: //Done pouring, moves to check level
+        case Done_Pour: //Done pouring, moves to check level
             printf("done pouring pour\n moving to check level\n");
-            setCursor(0,0);
-            clearPrint("Enjoy!",0); //Display finish message
-            Current_state = Level_check;
-            break;
+            show(0, "Enjoy!"); //Display finish message
+            enter(Level_check);
+        break;
+    }
+    LOOPMON_End(control_loop);
+}
+
+//writes one LCD row that changed per run, a row is ~6 ms of I2C so the other tasks are never held up longer
+void display_task(void){
+    static int next_row = 0; //checked first, so a busy row can't starve the other one
+    for(int i = 0; i < 2; i++){
+        int row = (next_row + i) % 2;
+        if(strcmp(lcd_text[row], lcd_shown[row]) != 0){
+            clearPrint(lcd_text[row], row);
+            strcpy(lcd_shown[row], lcd_text[row]);
+            next_row = (row + 1) % 2;
+            return;
         }
+    }
+}
+
+//bring-up steps for the devices without waits, each inits in a single call
+int32_t pump_init(void){
+    //Initialize GPIO pin C7
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    GPIO_InitStruct.Pin = GPIO_PIN_7;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+    HAL_GPIO_WritePin(GPIOC,GPIO_PIN_7, GPIO_PIN_RESET);  
+    //Done initializing, make sure pin is low so motor does not start
+    return BRINGUP_READY;
+}
 
+int32_t io_init(void){
+    BUTTONS_Init();
+    SENSORS_Init(); //PING, QEI, I2C and the esp32 uart
+    return BRINGUP_READY;
+}
 
+int32_t pwm_init(void){
+    return PWM_Init() == SUCCESS ? BRINGUP_READY : BRINGUP_FAILED;
+}
 
+int main(void) {
+    BOARD_Init();
+    TIMER_Init();
+
+    //the LCD power-on waits overlap the rest of the init instead of adding to it
+    BRINGUP_Init();
+    BRINGUP_Add("pump", pump_init, IO_DEADLINE_MS);
+    BRINGUP_Add("lcd", DFRobot_InitStep, LCD_DEADLINE_MS);
+    BRINGUP_Add("io", io_init, IO_DEADLINE_MS);
+    BRINGUP_Add("pwm", pwm_init, IO_DEADLINE_MS);
+    if(BRINGUP_Run() != SUCCESS){
+        printf("init failed\r\n");
     }
+    BRINGUP_PrintReport();
+
+    //a control step must finish before the next one is due, pour steps included
+    control_loop = LOOPMON_Add("control", CONTROL_PERIOD_MS * 1000, CONTROL_PERIOD_MS * 1000);
+
+    SCHED_Init();
+    control_id = SCHED_Add(control_task, CONTROL_PERIOD_MS, 0, SCHED_PRIORITY_CONTROL);
+    SCHED_Add(SENSORS_pollCupLink, CUP_POLL_MS, 0, SCHED_PRIORITY_SENSOR);
+    SCHED_Add(display_task, DISPLAY_PERIOD_MS, 0, SCHED_PRIORITY_UI);
+    SCHED_Add(LOOPMON_Poll, MONITOR_POLL_MS, 0, SCHED_PRIORITY_BACKGROUND);
+    enter(Level_check);
+    SCHED_Run();
 
     return 0;
-}
\ No newline at end of file
+}
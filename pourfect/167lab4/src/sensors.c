@@ -4,7 +4,7 @@ void SENSORS_Init(void) {
     PING_Init();
     QEI_Init();
     I2C_Init();  // Initialize I2C for communication with sensors
-    Uart1_Init(9600); //Initialize at 9600 baud rate to communicate with esp32
+    Uart1_Init(CUP_LINK_BAUD); //framed cup sensor states from the esp32
 }
 
 
@@ -18,38 +18,69 @@ int SENSORS_getPosition(void) {
     return QEI_GetPosition(); 
 }
 
-uint8_t data[10] = {0};  // Buffer for UART data
-#define NO_CUP_THRESH 3
-int SENSORS_getCupHeight(void){
+//cup sensor link: the esp32 sends the photodiode states as 5 byte frames (see ESPCODE/ESP.ino),
+//on every change and every 100 ms otherwise
+#define CUP_FRAME_SYNC 0xC5
+#define CUP_FRAME_LENGTH 5
+#define CUP_SENSORS 10
+#define CUP_LINK_TIMEOUT_MS 300 //three missed heartbeats, the esp32 is gone
 
-    int No_cup_count = 0;
-    while(No_cup_count < NO_CUP_THRESH){ //keep track of no cup readings, have to have NO_CUP_THRESH readings of no cup in a row to confirm no cup, this is done to limit errors
-    if(Uart1_rx(data, 10) == -1){ //read data into buffer
-        printf("ERROR\n");
-    }  
-    int height = 0;
-    for(int i = 0; i < 10; i++){
-        if(!data[i]){ //A reading of 0 indicates a blocked LED, which indicates an obstruction
-            height++;
-        } else { //Otherwise a non zero reading indicates an unblocked LED, indicating no obstruction
-            No_cup_count++; 
-            break;
+static uint16_t cup_mask = 0; //latest valid photodiode states, bit i set when diode i sees light
+static uint32_t cup_frame_ms = 0; //when it arrived
+static int cup_link = 0; //a valid frame arrived within CUP_LINK_TIMEOUT_MS
+
+//crc8 poly 0x07, init 0, same as the esp32
+static uint8_t crc8(const uint8_t* data, int length){
+    uint8_t crc = 0;
+    for(int i = 0; i < length; i++){
+        crc ^= data[i];
+        for(int bit = 0; bit < 8; bit++){
+            crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+//keeps the newest valid frame, anything that fails the checks is skipped
+void SENSORS_pollCupLink(void){
+    uint8_t frame[2 * CUP_FRAME_LENGTH];
+    int16_t length;
+    uint32_t now = TIMERS_GetMilliSeconds();
+    while((length = Uart1_rxFrame(frame, sizeof(frame))) > 0){ //the esp32 writes each frame in one go
+        if(length == CUP_FRAME_LENGTH && frame[0] == CUP_FRAME_SYNC && crc8(frame, CUP_FRAME_LENGTH - 1) == frame[4]){
+            cup_mask = frame[2] | frame[3] << 8;
+            cup_frame_ms = now;
+            cup_link = 1;
         }
     }
-    if(height){ 
-        return height;
+    if(cup_link && now - cup_frame_ms > CUP_LINK_TIMEOUT_MS){
+        cup_link = 0;
+    }
+}
+
+int SENSORS_getCupHeight(void){
+    SENSORS_pollCupLink();
+    if(!cup_link){ //no fresh reading, treat it as no cup so nothing pours
+        return 0;
+    }
+    //the esp32 already debounces each diode, count the blocked ones from the bottom up
+    int height = 0;
+    while(height < CUP_SENSORS && !(cup_mask & (1 << height))){ //a dark diode means an obstruction
+        height++;
     }
+    return height;
 }
-    //if we get to this point then a 'no cup' reading was read NO_CUP_THRESH times, giving a good indication that there was no cup
-    return 0; 
+
+int SENSORS_cupLinkUp(void){
+    SENSORS_pollCupLink();
+    return cup_link;
 }
 
 #define PING_DEFAULT_DISTANCE 64  // Default distance for water height calculation, this is based on readings from slotted sensor position to bottom of empty cup
 int SENSORS_getWaterHeight(void) {
     int distance = PING_GetDistance(); 
     int height = PING_DEFAULT_DISTANCE - distance;  // Example calculation
-    HAL_Delay(100);  // Delay for stability
-    return height;
+    return height;  // PING updates every ~60 ms on its own, callers space their reads
 }
 
 
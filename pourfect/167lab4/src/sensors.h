@@ -10,12 +10,14 @@
 #include "BNO055.h"
 #include "timers.h"
 
+#define CUP_LINK_BAUD 921600 //esp32 cup sensor link, must match LINK_BAUD in ESPCODE/ESP.ino
+
 
 
 
 /**
  * @fn SENSORS_Init
- * @brief Inits I2C, QEI, PING, and UART1 to 9600
+ * @brief Inits I2C, QEI, PING, and UART1 to CUP_LINK_BAUD
  */
 void SENSORS_Init(void);
 
@@ -42,11 +44,26 @@ int SENSORS_getPosition(void);
 
 /**
  * @fn SENSORS_getCupHeight
- * @brief Returns the cup height based on RX pin reading on UART1. This is info is sent from the esp32.
- * @return Height of the cup, value between 0 - 10
+ * @brief Returns the cup height from the newest valid frame the esp32 sent on UART1. Never waits,
+ * the esp32 sends on every change
+ * @return Height of the cup, value between 0 - 10, 0 also when the link is down
  */
 int SENSORS_getCupHeight(void);
 
+/**
+ * @fn SENSORS_pollCupLink
+ * @brief Takes the frames the esp32 sent since the last call and keeps the newest valid one. Run it
+ * every few ms: the uart queues 16 frames, and when it is full the newer ones are dropped
+ */
+void SENSORS_pollCupLink(void);
+
+/**
+ * @fn SENSORS_cupLinkUp
+ * @brief Checks the esp32 cup sensor link
+ * @return 1 if a valid frame arrived in the last 300 ms, 0 otherwise
+ */
+int SENSORS_cupLinkUp(void);
+
 /**
  * @fn SENSORS_getWaterLevel
  * @brief Returns the water level as read from water level sensors in water basin
@@ -9,11 +9,20 @@
  *
  * @date    16 Sep 2023
  *
- * @TODO    Switch to an interrupt-driven ADC framework that uses DMA to read/
- *          store data from each of the 7 channels when triggered. This special
- *          approach is required since the ADC SFRs are not labeled by channel,
- *          i.e. otherwise we cannot tell which ADC value was read by which
- *          ADC channel (values are mixed up).
+ * ADC_Read() selects a channel, starts a conversion and waits for it, so a
+ * loop that reads two channels gets them at whatever rate it spins. Scan
+ * mode instead converts all 7 channels in one sequence on every TIM5
+ * compare event, at a fixed sample rate, and DMA stores each scan into a
+ * circular buffer of two halves. While one half fills, the other holds
+ * ADC_SCAN_BLOCK finished scans:
+ *
+ *      ADC_ScanStart(1000);                        // 1 kHz per channel
+ *      uint16_t pot = ADC_Read(POT);               // newest sample, no waiting
+ *      const uint16_t *block = ADC_GetBlock(&seq); // or ADC_SetBlockCallback()
+ *
+ * Samples in a block are interleaved, one scan after the other, each scan in
+ * ADC_ScanIndex() order. The CPU only runs at the half and full complete
+ * interrupts, once per ADC_SCAN_BLOCK scans.
  */
 #ifndef ADC_H
 #define	ADC_H
@@ -35,6 +44,10 @@
 #define ADC_MIN             0
 #define ADC_MAX             4095
 
+#define ADC_SCAN_BLOCK      32          // scans per half of the DMA buffer
+#define ADC_SCAN_MIN_RATE   1           // Hz, scans per second
+#define ADC_SCAN_MAX_RATE   50000       // a 7 channel scan at 28 cycles each takes 13.3 us
+
 #ifndef FALSE
 #define FALSE ((int8_t) 0)
 #endif  /*  FALSE   */
@@ -49,6 +62,12 @@
 #endif  /*  SUCCESS */
 
 ADC_HandleTypeDef hadc1;
+DMA_HandleTypeDef hdma_adc1;            // scan mode, set up in HAL_ADC_MspInit()
+TIM_HandleTypeDef htim5;                // scan trigger
+
+/** Called from the DMA interrupt with ADC_SCAN_BLOCK finished scans and the
+ * time of the last one, in microseconds. */
+typedef void (*ADC_BlockCallback)(const uint16_t *block, uint32_t t_us);
 
 
 /*  PROTOTYPES  */
@@ -78,6 +97,76 @@ int8_t ADC_End(void);
  */
 uint16_t ADC_Read(uint32_t channel);
 
+/** ADC_ScanStart(rate)
+ *
+ * Switches from single conversions to scanning all channels at a fixed rate.
+ * ADC_Read() then returns the newest scanned sample without converting.
+ *
+ * @param   rate    (uint32_t)  scans per second, ADC_SCAN_MIN_RATE to
+ *                              ADC_SCAN_MAX_RATE; TIM5 divides 84 MHz, so
+ *                              rates that don't divide it are rounded
+ * @return          (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t ADC_ScanStart(uint32_t rate);
+
+/** ADC_ScanStop()
+ *
+ * Stops the scan and goes back to single conversions for ADC_Read().
+ *
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t ADC_ScanStop(void);
+
+/** ADC_ScanIndex(channel)
+ *
+ * Position of a channel within each scan of a block.
+ *
+ * @param   channel (uint32_t)  [ADC_0, ADC_1, ..., ADC_5, POT]
+ * @return          (int8_t)    0 to ADC_NUM_CHANNELS - 1, or ERROR
+ */
+int8_t ADC_ScanIndex(uint32_t channel);
+
+/** ADC_Latest(channel)
+ *
+ * Newest sample of a channel from the last finished scan, read straight from
+ * the DMA buffer.
+ *
+ * @param   channel (uint32_t)  [ADC_0, ADC_1, ..., ADC_5, POT]
+ * @return          (uint16_t)  12-bit reading, 0 before the first scan or if
+ *                              not scanning
+ */
+uint16_t ADC_Latest(uint32_t channel);
+
+/** ADC_GetBlock(sequence)
+ *
+ * Newest finished half of the scan buffer, for a task to poll.
+ *
+ * @param   sequence    (uint32_t *)    in: number of the last block the caller
+ *                                      took, out: number of the returned one
+ * @return  (const uint16_t *)  ADC_SCAN_BLOCK * ADC_NUM_CHANNELS samples, or
+ *                              NULL if there is nothing new; valid until the
+ *                              DMA comes around again, ADC_SCAN_BLOCK scans
+ *                              later
+ */
+const uint16_t *ADC_GetBlock(uint32_t *sequence);
+
+/** ADC_SetBlockCallback(callback)
+ *
+ * Hands every finished block to a function, in the DMA interrupt.
+ *
+ * @param   callback    (ADC_BlockCallback) NULL to stop
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t ADC_SetBlockCallback(ADC_BlockCallback callback);
+
+/** ADC_GetOverruns()
+ *
+ * Conversions lost because the DMA was late (the scan is restarted).
+ *
+ * @return  (uint32_t)  count since ADC_ScanStart()
+ */
+uint32_t ADC_GetOverruns(void);
+
 /** ADC_Init()
  *
  * Initializes the ADC subsystem with an interrupt; selects ADC Pin4 by default.
@@ -0,0 +1,75 @@
+/**
+ * @file    AttitudeFilter.h
+ *
+ * Closed-loop (Mahony style) attitude filter: the gyro is integrated into a
+ * DCM and the accel and mag directions are fed back through proportional
+ * gains on the rate and integral gains on a gyro bias estimate. This is
+ * IntegrateClosedLoop.m (matrix exponential integration) with its state and
+ * gains in one struct, so the gains can change at runtime and the same code
+ * runs in the Lab4 applications and the host tools (tools/tune.cpp). No HAL
+ * dependencies.
+ *
+ * R maps inertial to body vectors. Rates are rad/s, the bias estimate is in
+ * the same units as the gyro input.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef ATTITUDE_FILTER_H
+#define	ATTITUDE_FILTER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+typedef struct {
+    float kp_acc;    // accel feedback on the rate
+    float ki_acc;    // accel feedback on the bias
+    float kp_mag;    // mag feedback on the rate
+    float ki_mag;    // mag feedback on the bias
+} ATT_Gains;
+
+typedef struct {
+    float R[3][3];      // inertial to body DCM
+    float bias[3];      // gyro bias estimate
+    ATT_Gains gains;
+} ATT_Filter;
+
+
+/*  PROTOTYPES  */
+/** ATT_Init(f, gains, R0)
+ *
+ * Sets the gains, zeroes the bias estimate and starts from R0.
+ *
+ * @param   f       (ATT_Filter *)      filter
+ * @param   gains   (const ATT_Gains *) feedback gains
+ * @param   R0      (float[3][3])       initial DCM, NULL for the identity
+ */
+void ATT_Init(ATT_Filter *f, const ATT_Gains *gains, float R0[3][3]);
+
+/** ATT_Update(f, gyro, acc, mag, accInertial, magInertial, dt)
+ *
+ * One filter step. The accel and mag readings and references only need the
+ * right direction, they are normalized here.
+ *
+ * @param   f           (ATT_Filter *)  filter
+ * @param   gyro        (float[3])      body rate, rad/s
+ * @param   acc         (float[3])      accel reading
+ * @param   mag         (float[3])      mag reading
+ * @param   accInertial (float[3])      gravity in the inertial frame
+ * @param   magInertial (float[3])      Earth field in the inertial frame
+ * @param   dt          (float)         time step, s
+ */
+void ATT_Update(ATT_Filter *f, const float gyro[3], const float acc[3], const float mag[3],
+                const float accInertial[3], const float magInertial[3], float dt);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  ATTITUDE_FILTER_H   */
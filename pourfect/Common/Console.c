@@ -0,0 +1,215 @@
+/**
+ * @file    Console.c
+ *
+ * DMA backed stdout on USART2.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Board.h>
+#include <Console.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define CONSOLE_TX_MASK (CONSOLE_TX_BUFFER - 1)
+
+// head and tail count bytes since boot, buffer[count & CONSOLE_TX_MASK];
+// head only moves in CONSOLE_Write(), tail and sending only with the USART2
+// interrupt masked or in it
+static uint8_t buffer[CONSOLE_TX_BUFFER];
+static volatile uint32_t head;          // bytes queued
+static volatile uint32_t tail;          // bytes sent
+static volatile uint16_t sending;       // bytes in the running transfer, 0 when idle
+static volatile uint32_t dropped;
+static uint8_t current_policy = CONSOLE_DROP;
+
+
+/*  PRIVATE FUNCTIONS   */
+// starts a transfer of the oldest contiguous piece if the DMA is idle
+static void start_next(void)
+{
+    uint32_t queued = head - tail;
+    if (sending != 0 || queued == 0)
+    {
+        return;
+    }
+    uint32_t index = tail & CONSOLE_TX_MASK;
+    uint32_t length = CONSOLE_TX_BUFFER - index;    // up to the end of the ring, the rest next time
+    if (queued < length)
+    {
+        length = queued;
+    }
+    sending = length;
+    if (HAL_UART_Transmit_DMA(&huart2, &buffer[index], length) != HAL_OK)
+    {
+        sending = 0;                    // not initialized yet or busy, the next write tries again
+    }
+}
+
+static void kick(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    start_next();
+    __set_PRIMASK(primask);
+}
+
+// waiting for room only works with the transfer complete interrupt able to run
+static int8_t can_wait(void)
+{
+    return __get_IPSR() == 0 && __get_PRIMASK() == 0 && huart2.gState != HAL_UART_STATE_RESET;
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** CONSOLE_Write(data, length)
+ *
+ * Queues bytes for USART2 and starts sending if the DMA is idle. This is
+ * what _write() (so printf(), puts(), ...) calls.
+ *
+ * @param   data    (const char *)  bytes to send
+ * @param   length  (int)           number of bytes
+ * @return  (int)   length, also when the bytes were dropped
+ */
+int CONSOLE_Write(const char *data, int length)
+{
+    int done = 0;
+    while (done < length)
+    {
+        uint32_t space = CONSOLE_TX_BUFFER - (head - tail);
+        uint32_t left = length - done;
+        if (space < left && (current_policy == CONSOLE_DROP || !can_wait()))
+        {
+            if (done == 0 && left <= CONSOLE_TX_BUFFER)
+            {
+                dropped += left;        // all or nothing, no half lines in the log
+                break;
+            }
+            // too long to ever fit, or partly out already: send what fits
+            if (space == 0)
+            {
+                dropped += left;
+                break;
+            }
+        }
+        if (space == 0)
+        {
+            kick();                     // blocking, wait for the DMA to free some room
+            continue;
+        }
+
+        uint32_t index = head & CONSOLE_TX_MASK;
+        uint32_t chunk = left < space ? left : space;
+        if (chunk > CONSOLE_TX_BUFFER - index)
+        {
+            chunk = CONSOLE_TX_BUFFER - index;
+        }
+        memcpy(&buffer[index], &data[done], chunk);
+        __DMB();                        // bytes in the ring before the DMA can be pointed at them
+        head += chunk;
+        done += chunk;
+    }
+    kick();
+    return length;
+}
+
+/** CONSOLE_SetPolicy(policy)
+ *
+ * @param   policy  (uint8_t)   CONSOLE_DROP or CONSOLE_BLOCK
+ */
+void CONSOLE_SetPolicy(uint8_t policy)
+{
+    current_policy = policy;
+}
+
+/** CONSOLE_Flush()
+ *
+ * Waits until everything queued is on the wire (the last byte may still be
+ * shifting out).
+ */
+void CONSOLE_Flush(void)
+{
+    if (!can_wait())
+    {
+        return;
+    }
+    while (head != tail)
+    {
+        kick();
+    }
+}
+
+/** CONSOLE_GetDropped()
+ *
+ * @return  (uint32_t)  bytes thrown away because the ring was full
+ */
+uint32_t CONSOLE_GetDropped(void)
+{
+    return dropped;
+}
+
+// stdout and stderr, replaces the weak one in syscalls.c
+int _write(int file, char *ptr, int len)
+{
+    (void) file;
+    return CONSOLE_Write(ptr, len);
+}
+
+// end of a DMA transfer on USART2, the other uarts don't use it
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &huart2)
+    {
+        tail += sending;
+        sending = 0;
+        start_next();
+    }
+}
+
+
+/** CONSOLE_TEST
+ *
+ * Uncomment the below "#define" to run the CONSOLE_TEST.
+ *
+ * SUCCESS - Each second two bursts of 40 numbered lines (~1.4 kB each) are
+ *           printed back to back and the time printf() took is shown: a few
+ *           ms with DMA (it was ~240 ms). The first burst is complete; the
+ *           second one loses the lines that don't fit and the dropped count
+ *           goes up. With CONSOLE_BLOCK every line arrives and the printing
+ *           takes about as long as the wire.
+ */
+//#define CONSOLE_TEST
+#ifdef CONSOLE_TEST
+
+#include <timers.h>
+
+
+static void burst(uint8_t id)
+{
+    for (uint8_t i = 0; i < 40; i++)
+    {
+        printf("burst %u line %2u 0123456789abcdef\r\n", id, i);
+    }
+}
+
+int main(void)
+{
+    BOARD_Init();
+    TIMER_Init();
+
+    for (uint8_t id = 0; TRUE; id++)
+    {
+        uint32_t start = TIMERS_GetMicroSeconds();
+        burst(id);
+        burst(id);
+        uint32_t took = TIMERS_GetMicroSeconds() - start;
+        printf("printf took %lu us, dropped %lu bytes so far\r\n", (unsigned long) took,
+               (unsigned long) CONSOLE_GetDropped());
+        HAL_Delay(1000);
+    }
+}
+
+#endif  /*  CONSOLE_TEST    */
@@ -0,0 +1,75 @@
+/**
+ * @file    Format.h
+ *
+ * Fixed point decimal text for displays, without printf. sprintf("%.2f")
+ * needs newlib's float printf (-u_printf_float, ~10 kB of flash), promotes
+ * the float to a double that the M4 handles in software and goes through
+ * the whole format parser, a few thousand cycles per number. FMT_Fixed()
+ * splits the float's mantissa at the binary point, scales the bits below it
+ * by 10^decimals in one exact 64 bit multiply, rounds what is shifted out and
+ * writes the digits with integer divides: no heap, no locale, no varargs.
+ *
+ * The digits match printf, ties to even included, except that values that
+ * round to zero have no minus sign and magnitudes of 2^32 and more come out
+ * as "inf" (4294967040, the largest float below that, is still written out).
+ *
+ *     char text[16];
+ *     FMT_Fixed(text, sizeof(text), yaw, 2, 0);         // "-12.35"
+ *     FMT_Fixed(text, sizeof(text), percent, 0, 4);     // "  87"
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef FORMAT_H
+#define	FORMAT_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define FMT_MAX_DECIMALS 6              // a float has about 7 significant digits
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** FMT_Fixed(buffer, size, value, decimals, width)
+ *
+ * Writes value rounded to a fixed number of decimals, like "%*.*f".
+ *
+ * @param   buffer      (char *)    output, always '\0' terminated
+ * @param   size        (int)       size of buffer
+ * @param   value       (float)     number to write, NaN comes out as "nan"
+ * @param   decimals    (uint8_t)   digits after the point, at most FMT_MAX_DECIMALS
+ * @param   width       (int8_t)    minimum length, padded with spaces on the
+ *                                  left, on the right if negative, 0 for none
+ * @return  (int)   length written without the '\0', or ERROR if it does not
+ *                  fit (buffer is then "")
+ */
+int FMT_Fixed(char *buffer, int size, float value, uint8_t decimals, int8_t width);
+
+/** FMT_Int(buffer, size, value, width)
+ *
+ * Writes an integer, like "%*ld".
+ *
+ * @param   buffer  (char *)    output, always '\0' terminated
+ * @param   size    (int)       size of buffer
+ * @param   value   (int32_t)   number to write
+ * @param   width   (int8_t)    as FMT_Fixed()
+ * @return  (int)   as FMT_Fixed()
+ */
+int FMT_Int(char *buffer, int size, int32_t value, int8_t width);
+
+
+#endif  /*  FORMAT_H    */
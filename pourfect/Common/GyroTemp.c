@@ -0,0 +1,304 @@
+/**
+ * @file    GyroTemp.c
+ *
+ * Gyro bias against temperature, kept in flash.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <Board.h>
+#include <BNO055.h>
+#include <Calibration.h>
+#include <GyroTemp.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define GTEMP_MAGIC 0x504D4554u         // "TEMP"
+#define GTEMP_VERSION 1
+
+// Flash image, a whole number of words (572 bytes)
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t bins;
+    int16_t bias[GTEMP_BINS][3];        // raw counts * GTEMP_FRAC
+    uint8_t weight[GTEMP_BINS];         // 0 = never taught
+    uint32_t checksum;                  // FNV-1a of everything above
+} GTEMP_Image;
+
+static GTEMP_Image table;
+static float scale[3][3];               // A of the CAL_GYRO map at init
+
+// what GTEMP_Apply() last installed
+static int8_t applied_temp;
+static int8_t applied_valid;
+static int8_t table_changed;
+
+
+/*  PRIVATE FUNCTIONS   */
+static uint32_t checksum(const GTEMP_Image *image)
+{
+    const uint8_t *p = (const uint8_t *) image;
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < offsetof(GTEMP_Image, checksum); i++)
+    {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void clear(void)
+{
+    memset(&table, 0, sizeof(table));
+    table.magic = GTEMP_MAGIC;
+    table.version = GTEMP_VERSION;
+    table.bins = GTEMP_BINS;
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** GTEMP_Init()
+ *
+ * Takes the scale of the current CAL_GYRO map (so call after it has been
+ * installed) and loads the table from flash, empty if there is none.
+ *
+ * @return  (int8_t) SUCCESS if a table was loaded, ERROR if it starts empty
+ */
+int8_t GTEMP_Init(void)
+{
+    CAL_Affine cal;
+    CAL_Get(CAL_GYRO, &cal);
+    memcpy(scale, cal.A, sizeof(scale));
+    applied_valid = FALSE;
+    table_changed = FALSE;
+
+    const GTEMP_Image *stored = (const GTEMP_Image *) GTEMP_FLASH_ADDR;
+    if (stored->magic == GTEMP_MAGIC && stored->version == GTEMP_VERSION && stored->bins == GTEMP_BINS &&
+        stored->checksum == checksum(stored))
+    {
+        table = *stored;
+        return SUCCESS;
+    }
+    clear();
+    return ERROR;
+}
+
+/** GTEMP_ReadTemp()
+ *
+ * @return  (int8_t) BNO055 temperature, deg C
+ */
+int8_t GTEMP_ReadTemp(void)
+{
+    // two's complement byte, 1 deg C per LSB
+    return (int8_t) BNO055_ReadTemp();
+}
+
+/** GTEMP_Learn(temp, bias)
+ *
+ * Folds a measured still bias into the bin of temp.
+ *
+ * @param   temp    (int8_t)        temperature it was measured at, deg C
+ * @param   bias    (float[3])      mean raw gyro x, y, z while still
+ * @return  (int8_t) TRUE if the table changed
+ */
+int8_t GTEMP_Learn(int8_t temp, const float bias[3])
+{
+    int bin = temp - GTEMP_T_MIN;
+    if (bin < 0 || bin >= GTEMP_BINS)
+    {
+        return FALSE;
+    }
+    // running mean over the first GTEMP_MAX_WEIGHT periods, then exponential
+    uint8_t w = table.weight[bin];
+    float n = (float) (w < GTEMP_MAX_WEIGHT ? w + 1 : GTEMP_MAX_WEIGHT);
+    int8_t changed = w == 0;
+    for (int i = 0; i < 3; i++)
+    {
+        float old = table.bias[bin][i] / GTEMP_FRAC;
+        int16_t v = (int16_t) lroundf((old + (bias[i] - old) / n) * GTEMP_FRAC);
+        changed |= v != table.bias[bin][i];
+        table.bias[bin][i] = v;
+    }
+    if (w < GTEMP_MAX_WEIGHT)
+    {
+        table.weight[bin] = w + 1;
+    }
+    table_changed |= changed;
+    return changed;
+}
+
+/** GTEMP_Lookup(temp, bias)
+ *
+ * Interpolates the table.
+ *
+ * @param   temp    (int8_t)        deg C
+ * @param   bias    (float[3])      raw gyro bias x, y, z
+ * @return  (int8_t) FALSE if the table is empty (bias untouched)
+ */
+int8_t GTEMP_Lookup(int8_t temp, float bias[3])
+{
+    int bin = temp - GTEMP_T_MIN;
+    int lo = -1, hi = -1;
+    for (int i = bin < GTEMP_BINS ? bin : GTEMP_BINS - 1; i >= 0; i--)
+    {
+        if (table.weight[i] > 0)
+        {
+            lo = i;
+            break;
+        }
+    }
+    for (int i = bin > 0 ? bin : 0; i < GTEMP_BINS; i++)
+    {
+        if (table.weight[i] > 0)
+        {
+            hi = i;
+            break;
+        }
+    }
+    if (lo < 0 && hi < 0)
+    {
+        return FALSE;
+    }
+    if (lo < 0 || hi < 0 || lo == hi)
+    {
+        int only = lo < 0 ? hi : lo;
+        for (int i = 0; i < 3; i++)
+        {
+            bias[i] = table.bias[only][i] / GTEMP_FRAC;
+        }
+        return TRUE;
+    }
+    float f = (float) (bin - lo) / (float) (hi - lo);
+    for (int i = 0; i < 3; i++)
+    {
+        bias[i] = (table.bias[lo][i] + f * (table.bias[hi][i] - table.bias[lo][i])) / GTEMP_FRAC;
+    }
+    return TRUE;
+}
+
+/** GTEMP_Apply(temp)
+ *
+ * Installs the bias for temp in the CAL_GYRO map if it differs from the one
+ * installed. Cheap when nothing changed, call every loop.
+ *
+ * @param   temp    (int8_t)        deg C
+ * @return  (int8_t) TRUE if a new map was installed
+ */
+int8_t GTEMP_Apply(int8_t temp)
+{
+    if (applied_valid && temp == applied_temp && !table_changed)
+    {
+        return FALSE;
+    }
+    float bias[3];
+    if (!GTEMP_Lookup(temp, bias))
+    {
+        return FALSE;
+    }
+    // out = A * (raw - bias) = A * raw - A * bias
+    CAL_Affine cal;
+    memcpy(cal.A, scale, sizeof(scale));
+    for (int i = 0; i < 3; i++)
+    {
+        cal.b[i] = -(scale[i][0] * bias[0] + scale[i][1] * bias[1] + scale[i][2] * bias[2]);
+    }
+    CAL_Set(CAL_GYRO, &cal);
+    applied_temp = temp;
+    applied_valid = TRUE;
+    table_changed = FALSE;
+    return TRUE;
+}
+
+/** GTEMP_Save()
+ *
+ * Erases the flash sector and writes the table.
+ *
+ * @return  (int8_t) SUCCESS or ERROR
+ */
+int8_t GTEMP_Save(void)
+{
+    table.checksum = checksum(&table);
+
+    FLASH_EraseInitTypeDef erase = {0};
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Sector = GTEMP_FLASH_SECTOR;
+    erase.NbSectors = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    uint32_t bad_sector;
+
+    int8_t result = SUCCESS;
+    HAL_FLASH_Unlock();
+    if (HAL_FLASHEx_Erase(&erase, &bad_sector) != HAL_OK)
+    {
+        result = ERROR;
+    }
+    const uint32_t *words = (const uint32_t *) &table;
+    for (uint32_t i = 0; result == SUCCESS && i < sizeof(table) / 4; i++)
+    {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, GTEMP_FLASH_ADDR + 4 * i, words[i]) != HAL_OK)
+        {
+            result = ERROR;
+        }
+    }
+    HAL_FLASH_Lock();
+    return result;
+}
+
+
+/** GTEMP_TEST
+ *
+ * Uncomment the below "#define" to run the GTEMP_TEST.
+ *
+ * SUCCESS - Leave the IMU still while it warms up. Every still period prints
+ *           the temperature and the learned bias, the table is saved and on
+ *           the next reset "loaded" is printed with the same bins.
+ */
+//#define GTEMP_TEST
+#ifdef GTEMP_TEST
+
+#include <timers.h>
+#include <Stillness.h>
+
+
+int main(void)
+{
+    BOARD_Init();
+    BNO055_Init();
+    TIMER_Init();
+    CAL_Init();
+    printf("%s\r\n", GTEMP_Init() == SUCCESS ? "loaded" : "empty");
+    for (int i = 0; i < GTEMP_BINS; i++)
+    {
+        if (table.weight[i] > 0)
+        {
+            printf("%d C: %.2f, %.2f, %.2f (%u)\r\n", i + GTEMP_T_MIN, table.bias[i][0] / GTEMP_FRAC,
+                   table.bias[i][1] / GTEMP_FRAC, table.bias[i][2] / GTEMP_FRAC, table.weight[i]);
+        }
+    }
+
+    STILL_Init(STILL_TOLERANCE, STILL_WINDOW);
+    while (TRUE)
+    {
+        int16_t acc[3] = {BNO055_ReadAccelX(), BNO055_ReadAccelY(), BNO055_ReadAccelZ()};
+        int16_t gyro[3] = {BNO055_ReadGyroX(), BNO055_ReadGyroY(), BNO055_ReadGyroZ()};
+        if (STILL_Update(acc, gyro) == STILL_CONVERGED)
+        {
+            int8_t temp = GTEMP_ReadTemp();
+            float bias[3];
+            STILL_GetGyroBias(bias);
+            GTEMP_Learn(temp, bias);
+            GTEMP_Apply(temp);
+            printf("%d C: %.2f, %.2f, %.2f, save %s\r\n", temp, bias[0], bias[1], bias[2],
+                   GTEMP_Save() == SUCCESS ? "ok" : "failed");
+            STILL_Init(STILL_TOLERANCE, STILL_WINDOW);
+        }
+        HAL_Delay(20);
+    }
+}
+
+#endif  /*  GTEMP_TEST    */
@@ -0,0 +1,312 @@
+/**
+ * @file    LoopMonitor.c
+ *
+ * Loop period and execution time histograms with deadline tracking.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Board.h>
+#include <timers.h>
+#include <LoopMonitor.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+typedef struct {
+    const char *name;
+    uint32_t period_us;
+    uint32_t deadline_us;
+    uint32_t start_us;                  // of the current iteration
+    uint32_t release_us;                // when the current iteration should have started
+    uint8_t started;                    // FALSE until the first LOOPMON_Start()
+    uint8_t path;                       // LOOPMON_Mark() tags so far
+    LOOPMON_Stats stats;
+} Loop;
+
+static Loop loops[LOOPMON_MAX_LOOPS];
+static uint8_t count;
+
+
+/*  PRIVATE FUNCTIONS   */
+// log2 bucket, one CLZ instruction on the M4
+static uint8_t bucket(uint32_t us)
+{
+    uint8_t k = us == 0 ? 0 : 32 - __builtin_clz(us);
+    return k < LOOPMON_BUCKETS ? k : LOOPMON_BUCKETS - 1;
+}
+
+static uint32_t bucket_floor(uint8_t k)
+{
+    return k == 0 ? 0 : (uint32_t) 1 << (k - 1);
+}
+
+static Loop *get(int8_t id)
+{
+    return id >= 0 && id < count ? &loops[id] : NULL;
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** LOOPMON_Add(name, period_us, deadline_us)
+ *
+ * Registers a loop. TIMER_Init() must have run.
+ *
+ * @param   name        (const char *)  for the table, not copied
+ * @param   period_us   (uint32_t)      nominal time between starts
+ * @param   deadline_us (uint32_t)      time from release the iteration must end by
+ * @return  (int8_t)    loop id, or ERROR if the table is full
+ */
+int8_t LOOPMON_Add(const char *name, uint32_t period_us, uint32_t deadline_us)
+{
+    if (count >= LOOPMON_MAX_LOOPS)
+    {
+        return ERROR;
+    }
+    Loop empty = {0};
+    Loop *l = &loops[count];
+    *l = empty;
+    l->name = name;
+    l->period_us = period_us;
+    l->deadline_us = deadline_us;
+    return count++;
+}
+
+/** LOOPMON_SetPeriod(id, period_us)
+ *
+ * For loops that change rate, takes effect from the next release.
+ *
+ * @param   id          (int8_t)    from LOOPMON_Add()
+ * @param   period_us   (uint32_t)  new nominal period
+ */
+void LOOPMON_SetPeriod(int8_t id, uint32_t period_us)
+{
+    Loop *l = get(id);
+    if (l != NULL)
+    {
+        l->period_us = period_us;
+    }
+}
+
+/** LOOPMON_Start(id)
+ *
+ * Marks the start of an iteration.
+ *
+ * @param   id  (int8_t)    from LOOPMON_Add()
+ */
+void LOOPMON_Start(int8_t id)
+{
+    Loop *l = get(id);
+    if (l == NULL)
+    {
+        return;
+    }
+    uint32_t now = TIMERS_GetMicroSeconds();
+    if (l->started)
+    {
+        uint32_t period = now - l->start_us;
+        l->stats.period[bucket(period)]++;
+        if (period > l->stats.max_period_us)
+        {
+            l->stats.max_period_us = period;
+        }
+        l->release_us = l->start_us + l->period_us;
+    }
+    else
+    {
+        l->release_us = now;            // nothing to be late against yet
+        l->started = TRUE;
+    }
+    l->start_us = now;
+    l->path = 0;
+}
+
+/** LOOPMON_Mark(id, path)
+ *
+ * Tags the current iteration with the branches it took.
+ *
+ * @param   id      (int8_t)    from LOOPMON_Add()
+ * @param   path    (uint8_t)   bits, OR-ed into the tags of this iteration
+ */
+void LOOPMON_Mark(int8_t id, uint8_t path)
+{
+    Loop *l = get(id);
+    if (l != NULL)
+    {
+        l->path |= path;
+    }
+}
+
+/** LOOPMON_End(id)
+ *
+ * Marks the end of the iteration and records it.
+ *
+ * @param   id  (int8_t)    from LOOPMON_Add()
+ */
+void LOOPMON_End(int8_t id)
+{
+    Loop *l = get(id);
+    if (l == NULL || !l->started)
+    {
+        return;
+    }
+    uint32_t now = TIMERS_GetMicroSeconds();
+    uint32_t exec = now - l->start_us;
+    LOOPMON_Stats *s = &l->stats;
+    s->runs++;
+    s->exec[bucket(exec)]++;
+    if (exec > s->max_exec_us)
+    {
+        s->max_exec_us = exec;
+        s->worst_path = l->path;
+    }
+    if (now - l->release_us > l->deadline_us)
+    {
+        s->misses++;
+    }
+}
+
+/** LOOPMON_GetStats(id, stats)
+ *
+ * @param   id      (int8_t)            from LOOPMON_Add()
+ * @param   stats   (LOOPMON_Stats *)   filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if there is no such loop
+ */
+int8_t LOOPMON_GetStats(int8_t id, LOOPMON_Stats *stats)
+{
+    Loop *l = get(id);
+    if (l == NULL)
+    {
+        return ERROR;
+    }
+    *stats = l->stats;
+    return SUCCESS;
+}
+
+/** LOOPMON_Clear()
+ *
+ * Zeroes the statistics of every loop, the loops stay registered.
+ */
+void LOOPMON_Clear(void)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        LOOPMON_Stats empty = {0};
+        loops[i].stats = empty;
+        loops[i].started = FALSE;       // the gap since the last start is not a period
+    }
+}
+
+/** LOOPMON_Print()
+ *
+ * Prints per loop the runs, misses and worst case, then one line per
+ * non-empty bucket: its lower bound in us and the period and exec counts.
+ */
+void LOOPMON_Print(void)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const Loop *l = &loops[i];
+        const LOOPMON_Stats *s = &l->stats;
+        printf("loop %s: period %lu us, deadline %lu us, runs %lu, misses %lu\r\n", l->name,
+               (unsigned long) l->period_us, (unsigned long) l->deadline_us,
+               (unsigned long) s->runs, (unsigned long) s->misses);
+        printf("  worst period %lu us, worst exec %lu us, path 0x%02x\r\n",
+               (unsigned long) s->max_period_us, (unsigned long) s->max_exec_us, s->worst_path);
+        printf("  >= us     period     exec\r\n");
+        for (uint8_t k = 0; k < LOOPMON_BUCKETS; k++)
+        {
+            if (s->period[k] == 0 && s->exec[k] == 0)
+            {
+                continue;
+            }
+            printf("  %8lu %8lu %8lu\r\n", (unsigned long) bucket_floor(k),
+                   (unsigned long) s->period[k], (unsigned long) s->exec[k]);
+        }
+    }
+}
+
+/** LOOPMON_Poll()
+ *
+ * Checks the serial console (USART2) for a key without waiting:
+ * LOOPMON_KEY_PRINT prints the table, LOOPMON_KEY_CLEAR clears it. Run it
+ * as a background task.
+ */
+void LOOPMON_Poll(void)
+{
+    if ((USART2->SR & USART_SR_RXNE) == 0)
+    {
+        return;
+    }
+    char key = (char) USART2->DR;       // reading DR clears RXNE (and an overrun)
+    if (key == LOOPMON_KEY_PRINT)
+    {
+        LOOPMON_Print();
+    }
+    else if (key == LOOPMON_KEY_CLEAR)
+    {
+        LOOPMON_Clear();
+        printf("loop stats cleared\r\n");
+    }
+}
+
+
+/** LOOPMON_TEST
+ *
+ * Uncomment the below "#define" to run the LOOPMON_TEST.
+ *
+ * SUCCESS - A 10 ms loop busy waits 1 ms, 3 ms on every 10th iteration
+ *           (path 0x01) and 15 ms on every 100th (path 0x02). Pressing 'l'
+ *           shows the period around the 8192 us bucket, exec mostly at 512
+ *           and 2048 us, a worst exec of ~15000 us with path 0x03 (the 100th
+ *           is also a 10th), and one miss per 100 runs (the 15 ms iteration
+ *           against a 12 ms deadline). 'c' starts over.
+ */
+//#define LOOPMON_TEST
+#ifdef LOOPMON_TEST
+
+#include <Scheduler.h>
+
+
+static int8_t loop;
+
+static void busy(uint32_t us)
+{
+    uint32_t t = TIMERS_GetMicroSeconds();
+    while (TIMERS_GetMicroSeconds() - t < us);
+}
+
+static void work(void)
+{
+    static uint32_t n = 0;
+    LOOPMON_Start(loop);
+    busy(1000);
+    if (n % 10 == 0)
+    {
+        LOOPMON_Mark(loop, 0x01);
+        busy(2000);
+    }
+    if (n % 100 == 0)
+    {
+        LOOPMON_Mark(loop, 0x02);
+        busy(12000);
+    }
+    n++;
+    LOOPMON_End(loop);
+}
+
+int main(void)
+{
+    BOARD_Init();
+    TIMER_Init();
+    SCHED_Init();
+
+    loop = LOOPMON_Add("work", 10000, 12000);
+    SCHED_Add(work, 10, 0, SCHED_PRIORITY_SENSOR);
+    SCHED_Add(LOOPMON_Poll, 50, 0, SCHED_PRIORITY_BACKGROUND);
+    printf("press l to print, c to clear\r\n");
+    SCHED_Run();
+}
+
+#endif  /*  LOOPMON_TEST    */
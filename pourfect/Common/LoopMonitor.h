@@ -0,0 +1,142 @@
+/**
+ * @file    LoopMonitor.h
+ *
+ * Timing instrumentation for periodic loops. Each iteration is bracketed by
+ * LOOPMON_Start() and LOOPMON_End(); the time between starts (the real loop
+ * period) and the time inside the iteration go into histograms with log2
+ * buckets, so jitter of a few us and stalls of a few seconds fit in the same
+ * 24 counters. An iteration misses its deadline when it ends more than
+ * deadline_us after it was released (previous start + nominal period).
+ *
+ * The loop can tag the branches it took with LOOPMON_Mark(); the tags of the
+ * slowest iteration are kept, so the worst case points at its cause.
+ *
+ * Recording is a few register reads and increments per iteration. Nothing is
+ * printed until asked: LOOPMON_Poll() as a background task prints the table
+ * when 'l' comes in on the serial console and clears it on 'c'.
+ *
+ *     int8_t loop = LOOPMON_Add("filter", 20000, 20000);
+ *     ...
+ *     LOOPMON_Start(loop);
+ *     read_sensors();
+ *     if (saved) LOOPMON_Mark(loop, PATH_SAVE);
+ *     LOOPMON_End(loop);
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef LOOPMONITOR_H
+#define	LOOPMONITOR_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define LOOPMON_MAX_LOOPS 4
+#define LOOPMON_BUCKETS 24              // bucket 0 is 0 us, bucket k is [2^(k-1), 2^k) us, the last is open
+
+// console keys for LOOPMON_Poll()
+#define LOOPMON_KEY_PRINT 'l'
+#define LOOPMON_KEY_CLEAR 'c'
+
+typedef struct {
+    uint32_t runs;                      // completed iterations
+    uint32_t misses;                    // iterations that ended past their deadline
+    uint32_t max_period_us;
+    uint32_t max_exec_us;
+    uint8_t worst_path;                 // LOOPMON_Mark() tags of the max_exec_us iteration
+    uint32_t period[LOOPMON_BUCKETS];   // start to start
+    uint32_t exec[LOOPMON_BUCKETS];     // start to end
+} LOOPMON_Stats;
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** LOOPMON_Add(name, period_us, deadline_us)
+ *
+ * Registers a loop. TIMER_Init() must have run.
+ *
+ * @param   name        (const char *)  for the table, not copied
+ * @param   period_us   (uint32_t)      nominal time between starts
+ * @param   deadline_us (uint32_t)      time from release the iteration must end by
+ * @return  (int8_t)    loop id, or ERROR if the table is full
+ */
+int8_t LOOPMON_Add(const char *name, uint32_t period_us, uint32_t deadline_us);
+
+/** LOOPMON_SetPeriod(id, period_us)
+ *
+ * For loops that change rate, takes effect from the next release.
+ *
+ * @param   id          (int8_t)    from LOOPMON_Add()
+ * @param   period_us   (uint32_t)  new nominal period
+ */
+void LOOPMON_SetPeriod(int8_t id, uint32_t period_us);
+
+/** LOOPMON_Start(id)
+ *
+ * Marks the start of an iteration.
+ *
+ * @param   id  (int8_t)    from LOOPMON_Add()
+ */
+void LOOPMON_Start(int8_t id);
+
+/** LOOPMON_Mark(id, path)
+ *
+ * Tags the current iteration with the branches it took.
+ *
+ * @param   id      (int8_t)    from LOOPMON_Add()
+ * @param   path    (uint8_t)   bits, OR-ed into the tags of this iteration
+ */
+void LOOPMON_Mark(int8_t id, uint8_t path);
+
+/** LOOPMON_End(id)
+ *
+ * Marks the end of the iteration and records it.
+ *
+ * @param   id  (int8_t)    from LOOPMON_Add()
+ */
+void LOOPMON_End(int8_t id);
+
+/** LOOPMON_GetStats(id, stats)
+ *
+ * @param   id      (int8_t)            from LOOPMON_Add()
+ * @param   stats   (LOOPMON_Stats *)   filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if there is no such loop
+ */
+int8_t LOOPMON_GetStats(int8_t id, LOOPMON_Stats *stats);
+
+/** LOOPMON_Clear()
+ *
+ * Zeroes the statistics of every loop, the loops stay registered.
+ */
+void LOOPMON_Clear(void);
+
+/** LOOPMON_Print()
+ *
+ * Prints per loop the runs, misses and worst case, then one line per
+ * non-empty bucket: its lower bound in us and the period and exec counts.
+ */
+void LOOPMON_Print(void);
+
+/** LOOPMON_Poll()
+ *
+ * Checks the serial console (USART2) for a key without waiting:
+ * LOOPMON_KEY_PRINT prints the table, LOOPMON_KEY_CLEAR clears it. Run it
+ * as a background task.
+ */
+void LOOPMON_Poll(void);
+
+
+#endif  /*  LOOPMONITOR_H   */
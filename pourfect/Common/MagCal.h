@@ -0,0 +1,76 @@
+/**
+ * @file    MagCal.h
+ *
+ * Online hard/soft-iron calibration for the magnetometer. Every raw sample is
+ * fed into a recursive least squares fit of the ellipsoid
+ *
+ *      a*x^2 + b*y^2 + c*z^2 + 2d*xy + 2e*xz + 2f*yz + 2g*x + 2h*y + 2i*z = 1
+ *
+ * and every MAGCAL_SOLVE_INTERVAL accepted samples the ellipsoid is turned
+ * back into an offset (hard iron) and a symmetric matrix (soft iron), which
+ * are installed in the CAL_MAG map with CAL_Set().
+ *
+ * The work per call is fixed: one RLS update plus at most one step of the
+ * solve (center, one Jacobi rotation, or the final compose), so the fitter can
+ * sit in the sensor loop next to CAL_Apply().
+ *
+ * The axis convention and misalignment of the CAL_MAG map installed before
+ * MAGCAL_Init() (e.g. from CalibrationData.h) are kept, only the ellipsoid
+ * part is re-estimated.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef MAGCAL_H
+#define	MAGCAL_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define MAGCAL_FIELD_NORM 47613.0f      // |He| in nT, same as calgen --mag-norm
+#define MAGCAL_RAW_SCALE 1024.0f        // raw counts per fit unit, keeps x^2 near 1
+#define MAGCAL_FORGET 0.998f            // RLS forgetting factor, ~500 sample memory
+#define MAGCAL_P_INIT 1000.0f           // initial covariance diagonal
+#define MAGCAL_P_MAX 1.0e5f             // no forgetting above this trace, stops wind up
+#define MAGCAL_MIN_STEP 24              // counts between accepted samples
+#define MAGCAL_SOLVE_INTERVAL 100       // accepted samples between solves
+#define MAGCAL_MIN_SAMPLES 300          // accepted samples before the first install
+#define MAGCAL_MAX_ANISOTROPY 2.0f      // largest soft-iron axis ratio accepted
+#define MAGCAL_MAX_OFFSET 4.0f          // largest hard-iron offset, fit units
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+
+
+/*  PROTOTYPES  */
+/** MAGCAL_Init(fieldNorm)
+ *
+ * Resets the fit and takes the axis frame from the current CAL_MAG map. Call
+ * after the CAL_MAG map has been installed.
+ *
+ * @param   fieldNorm   (float)     magnitude of the calibrated output (e.g. nT)
+ */
+void MAGCAL_Init(float fieldNorm);
+
+/** MAGCAL_Update(raw)
+ *
+ * Feeds one raw magnetometer sample to the fitter. Fixed cost per call.
+ *
+ * @param   raw     (int16_t[3])    raw x, y, z readings
+ * @return  (int8_t) TRUE if a new CAL_MAG map was installed on this call
+ */
+int8_t MAGCAL_Update(const int16_t raw[3]);
+
+/** MAGCAL_GetUpdates()
+ *
+ * @return  (uint32_t) number of CAL_MAG maps installed since MAGCAL_Init()
+ */
+uint32_t MAGCAL_GetUpdates(void);
+
+
+#endif  /*  MAGCAL_H   */
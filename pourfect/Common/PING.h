@@ -100,6 +100,13 @@
 
 TIM_HandleTypeDef htim3;
 
+#define PING_ECHO_QUEUE 16 // echoes kept until PING_GetEcho(), power of two
+
+typedef struct {
+    uint32_t time_us; // TIMERS_GetMicroSeconds() at the end of the echo
+    uint32_t tof_us;  // echo length, the time of flight
+} PING_Echo;
+
 /**
  * @function    PING_Init(void)
  * @brief       Sets up both the timer extrenal interrupt peripherals along with their
@@ -125,4 +132,14 @@ unsigned int PING_GetDistance(void);
  */
 unsigned int PING_GetTimeofFlight(void);
 
+/**
+ * @function    PING_GetEcho(PING_Echo *echo)
+ * @brief       Takes the oldest echo not read yet, so every measurement can be processed
+ *              even when the caller runs less often than the sensor. The last
+ *              PING_ECHO_QUEUE echoes are kept, newer ones are lost while it is full.
+ *              No I/O should be done in this function
+ * @return      TRUE if echo was filled in, FALSE if none is waiting
+ */
+char PING_GetEcho(PING_Echo *echo);
+
 #endif
\ No newline at end of file
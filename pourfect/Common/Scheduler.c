@@ -0,0 +1,343 @@
+/**
+ * @file    Scheduler.c
+ *
+ * Cooperative run-to-completion task scheduler on the TIM2 timestamp.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Board.h>
+#include <timers.h>
+#include <Scheduler.h>
+#include <Format.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define SCHED_MAX_SLEEP_MS 1000         // idle wake up even with no task, keeps the loop observable
+
+typedef struct {
+    SCHED_Function function;            // NULL for a free slot
+    uint32_t period;                    // ms, SCHED_ONE_SHOT runs once
+    uint32_t due;                       // ms
+    uint8_t priority;
+    SCHED_Stats stats;
+} Task;
+
+static Task tasks[SCHED_MAX_TASKS];
+static uint32_t start_us;
+
+
+/*  PRIVATE FUNCTIONS   */
+// wrap safe: the millisecond count rolls over after 49 days
+static int8_t is_due(const Task *t, uint32_t now)
+{
+    return (int32_t) (now - t->due) >= 0;
+}
+
+// most urgent due task, ties go to the one waiting longest
+static int8_t next_due(uint32_t now)
+{
+    int8_t best = -1;
+    for (int8_t i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        const Task *t = &tasks[i];
+        if (t->function == NULL || !is_due(t, now))
+        {
+            continue;
+        }
+        if (best < 0 || t->priority < tasks[best].priority ||
+            (t->priority == tasks[best].priority && (int32_t) (t->due - tasks[best].due) < 0))
+        {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// sleeps until the earliest task is due (or any other interrupt), at most SCHED_MAX_SLEEP_MS
+static void sleep_until_due(void)
+{
+    uint64_t now_us = TIMERS_GetTimestamp();
+    uint32_t now = (uint32_t) (now_us / 1000);
+    uint32_t wait = SCHED_MAX_SLEEP_MS;
+    for (int8_t i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        const Task *t = &tasks[i];
+        if (t->function == NULL)
+        {
+            continue;
+        }
+        if (is_due(t, now))
+        {
+            return;
+        }
+        if (t->due - now < wait)
+        {
+            wait = t->due - now;
+        }
+    }
+    // start of the due millisecond, on the 64 bit count so the ms wrap can't shift it
+    uint32_t wake = (uint32_t) ((now_us / 1000 + wait) * 1000);
+    // masked, so an alarm firing between the check and __WFI() still wakes it
+    __disable_irq();
+    if (TIMERS_WakeAt(wake))
+    {
+        __WFI();
+    }
+    __enable_irq();
+}
+
+static void run(int8_t id, uint32_t now)
+{
+    Task *t = &tasks[id];
+    uint32_t late = now - t->due;
+    if (late > t->stats.max_late_ms)
+    {
+        t->stats.max_late_ms = late;
+    }
+
+    SCHED_Function function = t->function;
+    if (t->period == SCHED_ONE_SHOT)
+    {
+        t->function = NULL;             // free before the call so the task can add itself again
+    }
+    else
+    {
+        // keep the phase, but drop whole periods missed instead of running back to back
+        t->due += t->period;
+        if (is_due(t, now))
+        {
+            uint32_t missed = (now - t->due) / t->period + 1;
+            t->stats.skipped += missed;
+            t->due += missed * t->period;
+        }
+    }
+
+    uint32_t begin = TIMERS_GetMicroSeconds();
+    function();
+    uint32_t elapsed = TIMERS_GetMicroSeconds() - begin;
+
+    // the slot may have been freed or reused by the task itself
+    t->stats.runs++;
+    t->stats.total_us += elapsed;
+    if (elapsed > t->stats.max_us)
+    {
+        t->stats.max_us = elapsed;
+    }
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** SCHED_Init()
+ *
+ * Removes every task and clears the statistics. TIMER_Init() must have run.
+ */
+void SCHED_Init(void)
+{
+    for (int8_t i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        Task empty = {0};
+        tasks[i] = empty;
+    }
+    start_us = TIMERS_GetMicroSeconds();
+}
+
+/** SCHED_Add(function, period_ms, delay_ms, priority)
+ *
+ * Registers a task. It is first due delay_ms from now, then every period_ms;
+ * a period of SCHED_ONE_SHOT runs it once and frees the slot.
+ *
+ * @param   function    (SCHED_Function)    task body, must not block
+ * @param   period_ms   (uint32_t)          period, or SCHED_ONE_SHOT
+ * @param   delay_ms    (uint32_t)          time to the first run
+ * @param   priority    (uint8_t)           0 is the most urgent
+ * @return  (int8_t)    task id, or ERROR if the table is full
+ */
+int8_t SCHED_Add(SCHED_Function function, uint32_t period_ms, uint32_t delay_ms, uint8_t priority)
+{
+    if (function == NULL)
+    {
+        return ERROR;
+    }
+    for (int8_t i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        Task *t = &tasks[i];
+        if (t->function == NULL)
+        {
+            Task added = {0};
+            added.function = function;
+            added.period = period_ms;
+            added.due = TIMERS_GetMilliSeconds() + delay_ms;
+            added.priority = priority;
+            *t = added;
+            return i;
+        }
+    }
+    return ERROR;
+}
+
+/** SCHED_Remove(id)
+ *
+ * A task may remove itself.
+ *
+ * @param   id      (int8_t)    from SCHED_Add()
+ * @return  (int8_t)    SUCCESS, or ERROR if there is no such task
+ */
+int8_t SCHED_Remove(int8_t id)
+{
+    if (id < 0 || id >= SCHED_MAX_TASKS || tasks[id].function == NULL)
+    {
+        return ERROR;
+    }
+    tasks[id].function = NULL;
+    return SUCCESS;
+}
+
+/** SCHED_SetPeriod(id, period_ms)
+ *
+ * Changes the period from the next run on.
+ *
+ * @param   id          (int8_t)    from SCHED_Add()
+ * @param   period_ms   (uint32_t)  new period, or SCHED_ONE_SHOT
+ * @return  (int8_t)    SUCCESS, or ERROR if there is no such task
+ */
+int8_t SCHED_SetPeriod(int8_t id, uint32_t period_ms)
+{
+    if (id < 0 || id >= SCHED_MAX_TASKS || tasks[id].function == NULL)
+    {
+        return ERROR;
+    }
+    tasks[id].period = period_ms;
+    return SUCCESS;
+}
+
+/** SCHED_RunPending()
+ *
+ * Runs every task that is due, most urgent first. A task that becomes due
+ * meanwhile goes ahead of the less urgent ones still waiting.
+ *
+ * @return  (uint8_t)   number of calls made
+ */
+uint8_t SCHED_RunPending(void)
+{
+    uint8_t calls = 0;
+    int8_t id;
+    uint32_t now = TIMERS_GetMilliSeconds();
+    // bounded, a task that is always due can't lock the others out forever
+    while (calls < 2 * SCHED_MAX_TASKS && (id = next_due(now)) >= 0)
+    {
+        run(id, now);
+        calls++;
+        now = TIMERS_GetMilliSeconds();
+    }
+    return calls;
+}
+
+/** SCHED_Run()
+ *
+ * SCHED_RunPending() forever, sleeping in between until the next task is due
+ * (a TIM2 compare) or another interrupt comes in.
+ * Does not return.
+ */
+void SCHED_Run(void)
+{
+    while (TRUE)
+    {
+        if (SCHED_RunPending() == 0)
+        {
+            sleep_until_due();
+        }
+    }
+}
+
+/** SCHED_GetStats(id, stats)
+ *
+ * @param   id      (int8_t)        from SCHED_Add()
+ * @param   stats   (SCHED_Stats *) filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if there is no such task
+ */
+int8_t SCHED_GetStats(int8_t id, SCHED_Stats *stats)
+{
+    if (id < 0 || id >= SCHED_MAX_TASKS || tasks[id].function == NULL)
+    {
+        return ERROR;
+    }
+    *stats = tasks[id].stats;
+    return SUCCESS;
+}
+
+/** SCHED_PrintStats()
+ *
+ * Prints one line per task: runs, mean and worst run time, worst lateness,
+ * skipped periods and share of the CPU since SCHED_Init().
+ */
+void SCHED_PrintStats(void)
+{
+    uint32_t elapsed = TIMERS_GetMicroSeconds() - start_us;
+    printf("task prio period    runs  mean us   max us  late ms  skipped   cpu %%\r\n");
+    for (int8_t i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        const Task *t = &tasks[i];
+        if (t->function == NULL)
+        {
+            continue;
+        }
+        const SCHED_Stats *s = &t->stats;
+        char cpu[12];
+        FMT_Fixed(cpu, sizeof(cpu), elapsed ? 100.0f * (float) s->total_us / (float) elapsed : 0.0f, 2, 7);
+        printf("%4d %4u %6lu %7lu %8lu %8lu %8lu %8lu %s\r\n", i, t->priority, (unsigned long) t->period,
+               (unsigned long) s->runs, (unsigned long) (s->runs ? s->total_us / s->runs : 0),
+               (unsigned long) s->max_us, (unsigned long) s->max_late_ms, (unsigned long) s->skipped, cpu);
+    }
+}
+
+
+/** SCHED_TEST
+ *
+ * Uncomment the below "#define" to run the SCHED_TEST.
+ *
+ * SUCCESS - The LEDs count up every 100 ms, "fast" work runs every 10 ms, a
+ *           one shot prints "hello" after 1 s, and every 2 s a table shows
+ *           ~200 runs of the 10 ms task with mean ~1000 us (its busy wait),
+ *           late ms of a few at most, and the 100 ms task never skipped.
+ */
+//#define SCHED_TEST
+#ifdef SCHED_TEST
+
+#include <leds.h>
+
+
+static void fast(void)
+{
+    uint32_t t = TIMERS_GetMicroSeconds();
+    while (TIMERS_GetMicroSeconds() - t < 1000);    // 1 ms of "work"
+}
+
+static void blink(void)
+{
+    static uint8_t count = 0;
+    set_leds(count++);
+}
+
+static void hello(void)
+{
+    printf("hello\r\n");
+}
+
+int main(void)
+{
+    BOARD_Init();
+    TIMER_Init();
+    LEDS_Init();
+    SCHED_Init();
+
+    SCHED_Add(fast, 10, 0, SCHED_PRIORITY_SENSOR);
+    SCHED_Add(blink, 100, 0, SCHED_PRIORITY_UI);
+    SCHED_Add(hello, SCHED_ONE_SHOT, 1000, SCHED_PRIORITY_BACKGROUND);
+    SCHED_Add(SCHED_PrintStats, 2000, 2000, SCHED_PRIORITY_BACKGROUND);
+    SCHED_Run();
+}
+
+#endif  /*  SCHED_TEST    */
@@ -0,0 +1,80 @@
+/**
+ * @file    Stillness.h
+ *
+ * Startup stationary detection and gyro bias capture. Raw accel and gyro
+ * samples are fed to running (Welford) mean and variance estimates; any sample
+ * that looks like motion restarts them. The gyro bias is ready as soon as the
+ * standard error of every gyro mean, sqrt(var / n), drops below the requested
+ * tolerance, so a quiet board finishes in a few seconds and a noisy one keeps
+ * averaging up to the window limit.
+ *
+ * Everything is in raw sensor counts, convert the bias with the CAL_GYRO map.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef STILLNESS_H
+#define	STILLNESS_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define STILL_TOLERANCE 4.0f            // gyro bias standard error, counts (~0.05 deg/s)
+#define STILL_WINDOW 1000               // most samples averaged, 20 s at 50 Hz
+#define STILL_MIN_SAMPLES 25            // samples before the variance is trusted
+#define STILL_ACCEL_VAR_MAX 400.0f      // counts^2, at rest the BNO055 is ~5 counts rms
+#define STILL_GYRO_VAR_MAX 40000.0f     // counts^2, at rest the BNO055 is ~65 counts rms
+#define STILL_ACCEL_GATE 60.0f          // single sample off the mean, counts
+#define STILL_GYRO_GATE 600.0f          // single sample off the mean, counts
+
+typedef enum {
+    STILL_SETTLING,                     // still, averaging
+    STILL_MOVING,                       // motion seen, statistics restarted
+    STILL_CONVERGED                     // bias ready, see STILL_GetGyroBias()
+} STILL_Status;
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+
+
+/*  PROTOTYPES  */
+/** STILL_Init(tolerance, window)
+ *
+ * Restarts the statistics.
+ *
+ * @param   tolerance   (float)     gyro bias standard error to reach, counts
+ * @param   window      (uint16_t)  most samples to average before giving the
+ *                                  bias regardless of the tolerance
+ */
+void STILL_Init(float tolerance, uint16_t window);
+
+/** STILL_Update(acc, gyro)
+ *
+ * Adds one pair of raw samples. Once STILL_CONVERGED is returned the
+ * statistics are frozen until STILL_Init().
+ *
+ * @param   acc     (int16_t[3])    raw accel x, y, z
+ * @param   gyro    (int16_t[3])    raw gyro x, y, z
+ * @return  (STILL_Status)  state after this sample
+ */
+STILL_Status STILL_Update(const int16_t acc[3], const int16_t gyro[3]);
+
+/** STILL_GetGyroBias(bias)
+ *
+ * @param   bias    (float[3])      mean raw gyro x, y, z over the still period
+ */
+void STILL_GetGyroBias(float bias[3]);
+
+/** STILL_GetSamples()
+ *
+ * @return  (uint16_t) samples in the current still period
+ */
+uint16_t STILL_GetSamples(void);
+
+
+#endif  /*  STILLNESS_H   */
@@ -0,0 +1,211 @@
+/**
+ * @file    Strike.c
+ *
+ * Piezo strike detection on the ADC scan stream.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ADC.h>
+#include <RingBuffer.h>
+#include <Strike.h>
+
+
+/*  PROTOTYPES  */
+static void STRIKE_BlockDone(const uint16_t *block, uint32_t t_us);
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define STRIKE_MIN_RATE 1000            // scans per second
+
+static STRIKE_Event eventStorage[STRIKE_QUEUE];
+static RING_Buffer events;              // DMA interrupt to STRIKE_Get()
+
+static volatile uint16_t trigger;       // threshold, counts
+static int8_t channelIndex;             // within a scan
+static uint32_t period_us;              // between scans
+static uint16_t peakSamples;            // STRIKE_PEAK_US in scans
+static uint16_t rearmSamples;           // STRIKE_REARM_US in scans
+
+// detector state, DMA interrupt only
+static volatile int8_t active;          // between a crossing and the re-arm, read by STRIKE_Held()
+static STRIKE_Event current;
+static uint16_t peakLeft;               // samples until current is queued, 0 once it is
+static uint16_t quiet;                  // samples in a row below threshold
+
+
+/*  PRIVATE FUNCTIONS   */
+/** STRIKE_BlockDone(block, t_us)
+ *
+ * ADC block callback, in the DMA interrupt. Runs the detector over the
+ * watched channel of one block.
+ *
+ * @param   block   (const uint16_t *)  ADC_SCAN_BLOCK interleaved scans
+ * @param   t_us    (uint32_t)          time of the last scan
+ */
+static void STRIKE_BlockDone(const uint16_t *block, uint32_t t_us)
+{
+    uint16_t level = trigger;
+    const uint16_t *sample = block + channelIndex;
+    for (uint16_t i = 0; i < ADC_SCAN_BLOCK; i++, sample += ADC_NUM_CHANNELS)
+    {
+        uint16_t value = *sample;
+        if (active == FALSE)
+        {
+            if (value < level)
+            {
+                continue;
+            }
+            active = TRUE;
+            current.t_us = t_us - (ADC_SCAN_BLOCK - 1 - i) * period_us;
+            current.peak = value;
+            peakLeft = peakSamples;
+            quiet = 0;
+        }
+
+        if (peakLeft > 0)
+        {
+            if (value > current.peak)
+            {
+                current.peak = value;
+            }
+            if (--peakLeft == 0)
+            {
+                RING_Put(&events, &current);
+            }
+        }
+
+        if (value >= level)
+        {
+            quiet = 0;
+        }
+        else if (++quiet >= rearmSamples)
+        {
+            active = FALSE;
+        }
+    }
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** STRIKE_Init(channel, threshold, rate)
+ *
+ * Starts scanning the ADC at rate and watching channel. Takes the ADC block
+ * callback (ADC_SetBlockCallback()); ADC_Read() and ADC_GetBlock() still
+ * work for the other channels. ADC_Init() and TIMER_Init() must have run.
+ *
+ * @param   channel     (uint32_t)  piezo input [ADC_0, ADC_1, ..., ADC_5, POT]
+ * @param   threshold   (uint16_t)  12 bit counts
+ * @param   rate        (uint32_t)  scans per second, at least 1000 so the
+ *                                  peak window holds a couple of samples
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t STRIKE_Init(uint32_t channel, uint16_t threshold, uint32_t rate)
+{
+    int8_t scanIndex = ADC_ScanIndex(channel);
+    if (scanIndex == ERROR || rate < STRIKE_MIN_RATE || rate > ADC_SCAN_MAX_RATE)
+    {
+        return ERROR;
+    }
+    ADC_SetBlockCallback(NULL);
+    RING_Init(&events, eventStorage, sizeof(STRIKE_Event), STRIKE_QUEUE);
+    channelIndex = scanIndex;
+    trigger = threshold;
+    period_us = 1000000 / rate;
+    peakSamples = (uint16_t) ((uint64_t) STRIKE_PEAK_US * rate / 1000000);
+    rearmSamples = (uint16_t) ((uint64_t) STRIKE_REARM_US * rate / 1000000);
+    active = FALSE;
+    peakLeft = 0;
+    if (ADC_ScanStart(rate) == ERROR)
+    {
+        return ERROR;
+    }
+    return ADC_SetBlockCallback(STRIKE_BlockDone);
+}
+
+/** STRIKE_SetThreshold(threshold)
+ *
+ * Takes effect from the next block.
+ *
+ * @param   threshold   (uint16_t)  12 bit counts
+ */
+void STRIKE_SetThreshold(uint16_t threshold)
+{
+    trigger = threshold;
+}
+
+/** STRIKE_Get(event)
+ *
+ * Takes the oldest strike not read yet.
+ *
+ * @param   event   (STRIKE_Event *)    filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if none is waiting
+ */
+int8_t STRIKE_Get(STRIKE_Event *event)
+{
+    return RING_Get(&events, event);
+}
+
+/** STRIKE_Held()
+ *
+ * Whether the last strike is still going on: the channel was at or above
+ * the threshold less than STRIKE_REARM_US ago, as of the last block.
+ *
+ * @return  (int8_t)    [TRUE, FALSE]
+ */
+int8_t STRIKE_Held(void)
+{
+    return active;
+}
+
+/** STRIKE_GetMissed()
+ *
+ * @return  (uint32_t)  strikes lost because STRIKE_QUEUE were already waiting
+ */
+uint32_t STRIKE_GetMissed(void)
+{
+    return events.dropped;
+}
+
+
+/** STRIKE_TEST
+ *
+ * Uncomment the below "#define" to run the STRIKE_TEST, with the piezo on
+ * ADC_1.
+ *
+ * SUCCESS - Each tap prints one line with its time and peak, a harder tap
+ *           a higher peak. Holding the piezo still prints nothing, and the
+ *           ringing after a tap is not a second strike.
+ */
+//#define STRIKE_TEST
+#ifdef STRIKE_TEST
+
+#include <Board.h>
+#include <timers.h>
+
+
+int main(void)
+{
+    BOARD_Init();
+    TIMER_Init();
+    ADC_Init();
+    if (STRIKE_Init(ADC_1, 55, 4000) == ERROR)
+    {
+        printf("STRIKE_Init failed\r\n");
+    }
+
+    STRIKE_Event strike;
+    while (TRUE)
+    {
+        while (STRIKE_Get(&strike) == SUCCESS)
+        {
+            printf("strike at %lu us, peak %u, missed %lu\r\n", (unsigned long) strike.t_us, strike.peak,
+                   (unsigned long) STRIKE_GetMissed());
+        }
+        __WFI();
+    }
+}
+
+#endif  /*  STRIKE_TEST */
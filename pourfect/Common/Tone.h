@@ -0,0 +1,138 @@
+/**
+ * @file    Tone.h
+ *
+ * Direct digital synthesis on PWM_0. PWM_SetFrequency() makes a tone by
+ * changing the timer period, so every pitch change rewrites ARR and all the
+ * duty cycles and can cut a cycle short. Here the PWM runs at a fixed
+ * 328 kHz carrier instead, and its duty cycle is the audio: DMA copies one
+ * sample into TIM1->CCR1 every TONE_REPEAT carrier periods, from a circular
+ * buffer of two halves. While one half plays, the DMA interrupt fills the
+ * other from up to TONE_VOICES phase accumulators stepping through a
+ * 256 entry wave table, so the CPU works once per TONE_BLOCK samples and
+ * the low pass on the output (or the speaker itself) leaves the tone.
+ *
+ *     TONE_Init();
+ *     TONE_Set(0, 440.0f, 200);               // voice 0, A4
+ *     TONE_Set(1, 554.4f, 200);               // and a C#5 on top
+ *     ...
+ *     TONE_SetAmplitude(0, 0);                 // fades out over one block
+ *
+ * A voice keeps its phase across frequency changes and its amplitude moves
+ * to a new value in a straight line over one block, so changes don't click.
+ * Each setting is a single 32 bit store that the interrupt picks up at its
+ * next block, so TONE_Set() and friends can be called from anywhere without
+ * disabling interrupts.
+ *
+ * TIM1 belongs to the engine from TONE_Init() to TONE_End(): PWM_1 to PWM_3
+ * share its counter and must not be used meanwhile, and neither can
+ * PWM_SetFrequency(), which rewrites TIM1 along with TIM4. PWM_4 and PWM_5
+ * are on TIM4 and PWM_SetDutyCycle() scales them by its own period, so they
+ * keep working at the last PWM_SetFrequency().
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef TONE_H
+#define	TONE_H
+
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define TONE_VOICES 4
+#define TONE_BLOCK 64                   // samples per half of the DMA buffer, 1.6 ms
+#define TONE_PWM_TOP 256                // carrier period in timer clocks, 8 bit samples
+#define TONE_REPEAT 8                   // carrier periods per sample
+#define TONE_SAMPLE_RATE (84000000.0f / (TONE_PWM_TOP * TONE_REPEAT))   // 41015.6 Hz
+#define TONE_MAX_FREQUENCY 20000.0f     // Hz, below half the sample rate
+#define TONE_MAX_AMPLITUDE 255          // one voice alone at full scale; voices add and clip
+#define TONE_TABLE_SIZE 256
+
+DMA_HandleTypeDef hdma_tim1_ch1;        // TIM1 CC1 (on update) to CCR1
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** TONE_Init()
+ *
+ * Takes over TIM1 for PWM_0 (calls PWM_Init() if needed) and starts the
+ * DMA with every voice silent, so PWM_0 sits at half duty.
+ *
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t TONE_Init(void);
+
+/** TONE_End()
+ *
+ * Stops the DMA and gives TIM1 back to the PWM module at its last
+ * PWM_SetFrequency() and duty cycles.
+ *
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t TONE_End(void);
+
+/** TONE_Set(voice, frequency, amplitude)
+ *
+ * TONE_SetFrequency() and TONE_SetAmplitude() together.
+ *
+ * @param   voice       (uint8_t)   0 to TONE_VOICES - 1
+ * @param   frequency   (float)     Hz, 0 to TONE_MAX_FREQUENCY
+ * @param   amplitude   (uint8_t)   0 (silent) to TONE_MAX_AMPLITUDE
+ * @return  (int8_t)    SUCCESS, or ERROR if voice or frequency is out of range
+ */
+int8_t TONE_Set(uint8_t voice, float frequency, uint8_t amplitude);
+
+/** TONE_SetFrequency(voice, frequency)
+ *
+ * Changes the pitch from the next block, keeping the phase.
+ *
+ * @param   voice       (uint8_t)   0 to TONE_VOICES - 1
+ * @param   frequency   (float)     Hz, 0 to TONE_MAX_FREQUENCY
+ * @return  (int8_t)    SUCCESS, or ERROR if voice or frequency is out of range
+ */
+int8_t TONE_SetFrequency(uint8_t voice, float frequency);
+
+/** TONE_SetAmplitude(voice, amplitude)
+ *
+ * Ramps the voice to a new amplitude over the next block.
+ *
+ * @param   voice       (uint8_t)   0 to TONE_VOICES - 1
+ * @param   amplitude   (uint8_t)   0 (silent) to TONE_MAX_AMPLITUDE
+ * @return  (int8_t)    SUCCESS, or ERROR if voice is out of range
+ */
+int8_t TONE_SetAmplitude(uint8_t voice, uint8_t amplitude);
+
+/** TONE_SetWaveform(table)
+ *
+ * Plays every voice from another wave table from the next block. The table
+ * is used in place, so it must stay valid.
+ *
+ * @param   table   (const int8_t *)    TONE_TABLE_SIZE samples of one cycle,
+ *                                      or NULL for the built in sine
+ */
+void TONE_SetWaveform(const int8_t *table);
+
+/** TONE_GetUnderruns()
+ *
+ * Blocks the DMA reached before they were filled (the interrupt was held
+ * off for a whole block); each one replays the samples of two blocks ago.
+ *
+ * @return  (uint32_t)  count since TONE_Init()
+ */
+uint32_t TONE_GetUnderruns(void);
+
+
+#endif  /*  TONE_H    */
@@ -22,8 +22,7 @@
 
 static uint8_t init_status = FALSE;
 
-static uint32_t us; //microsecond count
-static uint32_t ms; //millisecond count
+static volatile uint32_t overflows; //TIM2 wraps, the upper 32 bits of the microsecond timestamp
 
 /**
  * @function TIMER_Init(void)
@@ -40,7 +39,7 @@ char TIMER_Init(void) {
         htim2.Instance = TIM2;
         htim2.Init.Prescaler = system_clock_freq - 1; // setting prescaler for 1 Mhz timer clock
         htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
-        htim2.Init.Period = 999; //trigger interrupt every 1ms
+        htim2.Init.Period = 0xFFFFFFFF; //free running 32 bit counter, wraps (one interrupt) every ~71.6 minutes
         htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
         htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
         if (HAL_TIM_Base_Init(&htim2) != HAL_OK)
@@ -59,7 +58,8 @@ char TIMER_Init(void) {
             return ERROR;
         }
 
-        HAL_TIM_Base_Start_IT(&htim2); // start interrupt
+        __HAL_TIM_DISABLE_IT(&htim2, TIM_IT_CC1); // alarm off until TIMERS_WakeAt()
+        HAL_TIM_Base_Start_IT(&htim2); // start counting, update interrupt on overflow only
         init_status = TRUE;
     }
     return SUCCESS;
@@ -72,17 +72,54 @@ char TIMER_Init(void) {
  * @brief ^
  * @author Adam Korycki, 2023.09.29 */
 uint32_t TIMERS_GetMilliSeconds(void) {
-    return ms;
+    return (uint32_t) (TIMERS_GetTimestamp() / 1000);
 }
 
 /**
  * @function TIMERS_GetMicroSeconds(void)
  * @param None
- * @return current microsecond count
+ * @return current microsecond count, wraps every ~71.6 minutes
  * @brief ^
  * @author Adam Korycki, 2023.09.29 */
 uint32_t TIMERS_GetMicroSeconds(void) {
-    return us + TIM2->CNT; // (ms*1000) + (current value of 1Mhz counter)
+    return TIM2->CNT; // the 1Mhz counter itself, a single read can't tear
+}
+
+/**
+ * @function TIMERS_GetTimestamp(void)
+ * @param None
+ * @return microseconds since TIMER_Init(), 64 bits (never wraps)
+ * @brief TIM2 count extended by the overflow interrupt. Safe from any ISR, including ones that run
+ * while the overflow is still pending */
+uint64_t TIMERS_GetTimestamp(void) {
+    uint32_t high, low, pending;
+    do {
+        high = overflows;
+        low = TIM2->CNT;
+        pending = TIM2->SR & TIM_SR_UIF;
+    } while (high != overflows); // overflow serviced in between, read again
+    if (pending && low < 0x80000000u) {
+        high++; // wrapped but the interrupt has not run yet (we are in a higher or equal priority ISR)
+    }
+    return ((uint64_t) high << 32) | low;
+}
+
+/**
+ * @function TIMERS_WakeAt(uint32_t us)
+ * @param us - TIMERS_GetMicroSeconds() value to wake up at
+ * @return TRUE if the alarm is set, FALSE if that time has already passed
+ * @brief Raises one TIM2 compare interrupt at the given time, so __WFI() returns. Only wakes the CPU,
+ * nothing is called. Times more than ~35 minutes ahead count as passed */
+char TIMERS_WakeAt(uint32_t us) {
+    __HAL_TIM_DISABLE_IT(&htim2, TIM_IT_CC1);
+    __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_1, us);
+    __HAL_TIM_CLEAR_IT(&htim2, TIM_IT_CC1);
+    __HAL_TIM_ENABLE_IT(&htim2, TIM_IT_CC1);
+    if ((int32_t) (us - TIM2->CNT) <= 0) { // already there, the compare may have been missed
+        __HAL_TIM_DISABLE_IT(&htim2, TIM_IT_CC1);
+        return FALSE;
+    }
+    return TRUE;
 }
 
 /**
@@ -95,17 +132,23 @@ uint32_t TIMERS_GetSystemClockFreq(void) {
     return HAL_RCC_GetSysClockFreq();
 }
 
-/* timer callback */
+/* timer callbacks */
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
     if (htim == &htim2) {
-        ms++;     // update millisecond count
-        us+=1000; // update microsecond count
+        overflows++; // counter wrapped
+    }
+}
+
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim) {
+    if (htim == &htim2) {
+        __HAL_TIM_DISABLE_IT(&htim2, TIM_IT_CC1); // one shot, waking up was the point
     }
 }
 
 //#define TIMERS_TEST
 #ifdef TIMERS_TEST // TIMERS TEST HARNESS
-//SUCCESS - printed microsecond and millisecond values are are around 100 ms apart
+//SUCCESS - printed microsecond and millisecond values are are around 100 ms apart, the timestamp
+//agrees with both, and the wake test sleeps ~5000 us per line
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -119,9 +162,18 @@ int main(void) {
 
     uint32_t init_ms = TIMERS_GetMilliSeconds();
     uint32_t init_us = TIMERS_GetMicroSeconds();
+    uint64_t init_ts = TIMERS_GetTimestamp();
     while(TRUE) {
-        printf("ms: %011d\r\nus: %011d\r\n\r\n", TIMERS_GetMilliSeconds()-init_ms, TIMERS_GetMicroSeconds()-init_us);
-        HAL_Delay(1);
+        printf("ms: %011lu\r\nus: %011lu\r\nts: %011llu\r\n", (unsigned long) (TIMERS_GetMilliSeconds()-init_ms),
+               (unsigned long) (TIMERS_GetMicroSeconds()-init_us), (unsigned long long) (TIMERS_GetTimestamp()-init_ts));
+        uint32_t start = TIMERS_GetMicroSeconds();
+        if (TIMERS_WakeAt(start + 5000)) {
+            while ((int32_t) (TIMERS_GetMicroSeconds() - (start + 5000)) < 0) {
+                __WFI();
+            }
+        }
+        printf("wake: %lu us\r\n\r\n", (unsigned long) (TIMERS_GetMicroSeconds() - start));
+        HAL_Delay(100);
     }
 }
 #endif
\ No newline at end of file
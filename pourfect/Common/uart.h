@@ -16,10 +16,23 @@
 
 UART_HandleTypeDef huart1;
 UART_HandleTypeDef huart6;
+DMA_HandleTypeDef hdma_usart1_rx; // circular receive, set up in HAL_UART_MspInit()
+DMA_HandleTypeDef hdma_usart6_rx;
+
+#define UART_MIN_BAUD 9600
+#define UART_MAX_BAUD 921600 // USART1/6 run off the 84 MHz APB2 clock, 0.2% off at 16x oversampling
+
+/* receive counters of one uart, from its init on */
+typedef struct {
+    uint32_t frames;   // idle-line frames received
+    uint32_t dropped;  // frames not handed out: queue full, partly lost or too long for the caller
+    uint32_t overruns; // bytes the DMA wrote over before they were read
+    uint32_t errors;   // line errors (overrun, noise, framing), reception restarts after each
+} UART_RxStats;
 
 /**
  * @Function Uart1_Init(Rate)
- * @param Rate - baudrate (must be between 9600 and 115200)
+ * @param Rate - baudrate (must be between UART_MIN_BAUD and UART_MAX_BAUD)
  * @return SUCCESS or ERROR
  * @brief  Initializes uart1 interface at specified baudrate
  * @author Adam Korycki, 2023.11.02 */
@@ -29,11 +42,35 @@ int8_t Uart1_Init(int Rate);
  * @Function Uart1_rx(uint8_t* data, uint8_t size)
  * @param data - pointer to received buffer
  * @param size - number of byte read from buffer
- * @return SUCCESS or ERROR
- * @brief  Reads data from the rx buffer for uart1.
+ * @return SUCCESS or ERROR (fewer than size bytes received so far, nothing is read)
+ * @brief  Reads data from the rx buffer for uart1. Bytes are received in the background
+ *         from Uart1_Init() on and kept in order until read, never blocks.
  * @author Adam Korycki, 2023.11.02 */
 int8_t Uart1_rx(uint8_t* data, uint16_t size);
 
+/**
+ * @Function Uart1_rxFrame(uint8_t* frame, uint16_t size)
+ * @param frame - buffer for one frame
+ * @param size - size of the buffer
+ * @return length of the oldest complete frame copied to frame, 0 if none is waiting
+ * @brief  A frame is the bytes between two idle lines (one byte time of silence), so a
+ *         sender that writes each message in one go gets it back whole and aligned. Frames
+ *         that were partly lost or are longer than size are dropped and counted. Don't mix
+ *         with Uart1_rx() on the same uart, bytes read one way are gone for the other. */
+int16_t Uart1_rxFrame(uint8_t* frame, uint16_t size);
+
+/**
+ * @Function Uart1_rxStats(UART_RxStats* stats)
+ * @param stats - filled in with the receive counters of uart1
+ * @brief  ^ */
+void Uart1_rxStats(UART_RxStats* stats);
+
+/**
+ * @Function Uart1_available(void)
+ * @return number of received bytes waiting in the rx buffer
+ * @brief  Uart1_rx() of up to this many bytes succeeds */
+uint16_t Uart1_available(void);
+
 /**
  * @Function Uart1_tx(uint8_t* data)
  * @param data - byte buffer to transmit
@@ -45,7 +82,7 @@ int8_t Uart1_tx(uint8_t* data, uint16_t size);
 
 /**
  * @Function Uart6_Init(Rate)
- * @param Rate - baudrate (must be between 9600 and 115200)
+ * @param Rate - baudrate (must be between UART_MIN_BAUD and UART_MAX_BAUD)
  * @return SUCCESS or ERROR
  * @brief  Initializes uart6 interface at specified baudrate
  * @author Adam Korycki, 2023.11.02 */
@@ -55,11 +92,32 @@ int8_t Uart6_Init(int Rate);
  * @Function Uart6_rx(uint8_t* data, uint8_t size)
  * @param data - pointer to received buffer
  * @param size - number of byte read from buffer
- * @return SUCCESS or ERROR
- * @brief  Reads data from the rx buffer for uart6.
+ * @return SUCCESS or ERROR (fewer than size bytes received so far, nothing is read)
+ * @brief  Reads data from the rx buffer for uart6. Bytes are received in the background
+ *         from Uart6_Init() on and kept in order until read, never blocks.
  * @author Adam Korycki, 2023.11.02 */
 int8_t Uart6_rx(uint8_t* data, uint16_t size);
 
+/**
+ * @Function Uart6_rxFrame(uint8_t* frame, uint16_t size)
+ * @param frame - buffer for one frame
+ * @param size - size of the buffer
+ * @return length of the oldest complete frame copied to frame, 0 if none is waiting
+ * @brief  Same as Uart1_rxFrame() for uart6 */
+int16_t Uart6_rxFrame(uint8_t* frame, uint16_t size);
+
+/**
+ * @Function Uart6_rxStats(UART_RxStats* stats)
+ * @param stats - filled in with the receive counters of uart6
+ * @brief  ^ */
+void Uart6_rxStats(UART_RxStats* stats);
+
+/**
+ * @Function Uart6_available(void)
+ * @return number of received bytes waiting in the rx buffer
+ * @brief  Uart6_rx() of up to this many bytes succeeds */
+uint16_t Uart6_available(void);
+
 /**
  * @Function Uart6_tx(uint8_t* data)
  * @param data - byte buffer to transmit
@@ -69,4 +127,11 @@ int8_t Uart6_rx(uint8_t* data, uint16_t size);
  * @author Adam Korycki, 2023.11.02 */
 int8_t Uart6_tx(uint8_t* data, uint16_t size);
 
+/**
+ * @Function Uart_IdleHandler(UART_HandleTypeDef* huart)
+ * @param huart - &huart1 or &huart6
+ * @brief  Ends the current rx frame on an idle line. Called from USART1_IRQHandler() and
+ *         USART6_IRQHandler() ahead of HAL_UART_IRQHandler(), which ignores the idle flag */
+void Uart_IdleHandler(UART_HandleTypeDef* huart);
+
 #endif
\ No newline at end of file
@@ -9,28 +9,43 @@
  *
  * @date    16 Sep 2023
  *
- * @TODO    Switch to an interrupt-driven ADC framework that uses DMA to read/
- *          store data from each of the 7 channels when triggered. This special
- *          approach is required since the ADC SFRs are not labeled by channel,
- *          i.e. otherwise we cannot tell which ADC value was read by which
- *          ADC channel (values are mixed up).
+ * Scan mode: TIM5 channel 1 compare events trigger a regular sequence of all
+ * 7 channels; DMA2 stream 0 stores them into a circular buffer and
+ * interrupts at half and full transfer.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include "ADC.h"
+#include "timers.h"
 
 
 /*  PROTOTYPES  */
 static int8_t ADC_ConfigPins(void);
 static int8_t ADC_ConfigClks(void);
+static int8_t ADC_ConfigSingle(void);
+static int8_t ADC_ConfigScan(void);
+static void ADC_BlockDone(const uint16_t *block);
 
 
 /*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define ADC_SCAN_LENGTH (2 * ADC_SCAN_BLOCK * ADC_NUM_CHANNELS)     // samples in the DMA buffer
+#define ADC_SCAN_SAMPLETIME ADC_SAMPLETIME_28CYCLES                 // 1.9 us per channel at 21 MHz
+
 static int8_t initStatus = FALSE;
 
+// scan order, ADC_ScanIndex() of a channel is its place here
+static const uint32_t scanChannels[ADC_NUM_CHANNELS] = {ADC_0, ADC_1, ADC_2, ADC_3, ADC_4, ADC_5, POT};
+
+static uint16_t scanBuffer[ADC_SCAN_LENGTH];
+static volatile int8_t scanning = FALSE;
+static volatile const uint16_t *lastBlock;
+static volatile uint32_t blockSequence;
+static volatile uint32_t overruns;
+static ADC_BlockCallback blockCallback;
+
 
-/*  FUNCTIONS   */
+/*  PRIVATE FUNCTIONS   */
 /** ADC_ConfigPins()
  *
  * Configure pins for use with the ADC.
@@ -66,6 +81,111 @@ static int8_t ADC_ConfigClks(void)
     return SUCCESS;
 }
 
+/** ADC_ConfigSingle()
+ *
+ * Software started single conversions of one channel, the onboard
+ * potentiometer until ADC_Read() selects another.
+ *
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+static int8_t ADC_ConfigSingle(void)
+{
+    /**
+     * Configure the global features of the ADC (clock, resolution, data
+     * alignment and number of conversions).
+     */
+    hadc1.Instance = ADC1;
+    hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
+    hadc1.Init.Resolution = ADC_RESOLUTION_12B;
+    hadc1.Init.ScanConvMode = DISABLE;
+    hadc1.Init.ContinuousConvMode = ENABLE;
+    hadc1.Init.DiscontinuousConvMode = DISABLE;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    hadc1.Init.NbrOfConversion = 1;
+    hadc1.Init.DMAContinuousRequests = DISABLE;
+    hadc1.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+
+    if (HAL_ADC_Init(&hadc1) != HAL_OK)
+    {
+        return ERROR;
+    }
+
+    // By default, select onboard potentiometer.
+    ADC_ChannelConfTypeDef sConfig = {0};
+    sConfig.Channel = POT;
+    sConfig.Rank = 1;
+    sConfig.SamplingTime = ADC_SAMPLETIME_3CYCLES;
+    if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
+    {
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+/** ADC_ConfigScan()
+ *
+ * All channels in one regular sequence, started by the TIM5 CC1 event, with
+ * a DMA request per conversion. HAL_ADC_MspInit() sees DMAContinuousRequests
+ * and sets up the DMA stream.
+ *
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+static int8_t ADC_ConfigScan(void)
+{
+    hadc1.Instance = ADC1;
+    hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
+    hadc1.Init.Resolution = ADC_RESOLUTION_12B;
+    hadc1.Init.ScanConvMode = ENABLE;
+    hadc1.Init.ContinuousConvMode = DISABLE;
+    hadc1.Init.DiscontinuousConvMode = DISABLE;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+    hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T5_CC1;
+    hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    hadc1.Init.NbrOfConversion = ADC_NUM_CHANNELS;
+    hadc1.Init.DMAContinuousRequests = ENABLE;
+    hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+
+    if (HAL_ADC_Init(&hadc1) != HAL_OK)
+    {
+        return ERROR;
+    }
+
+    ADC_ChannelConfTypeDef sConfig = {0};
+    sConfig.SamplingTime = ADC_SCAN_SAMPLETIME;
+    for (uint8_t i = 0; i < ADC_NUM_CHANNELS; i++)
+    {
+        sConfig.Channel = scanChannels[i];
+        sConfig.Rank = i + 1;
+        if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
+        {
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/** ADC_BlockDone(block)
+ *
+ * Hands a finished half of the buffer out, from the DMA interrupt.
+ *
+ * @param   block   (const uint16_t *)  first sample of the half
+ */
+static void ADC_BlockDone(const uint16_t *block)
+{
+    lastBlock = block;
+    blockSequence++;
+    if (blockCallback != NULL)
+    {
+        blockCallback(block, TIMERS_GetMicroSeconds());
+    }
+}
+
+
+/*  PUBLIC FUNCTIONS    */
 /** ADC_Start()
  *
  * Start ADC convesions.
@@ -95,7 +215,8 @@ int8_t ADC_End(void)
 
 /** ADC_Read(channel)
  *
- * Selects ADC channel and returns 12-bit reading.
+ * Selects ADC channel and returns 12-bit reading. While scanning, returns
+ * the newest scanned sample instead (ADC_Latest()).
  *
  * @param   channel (uint32_t)  Select ADC channel:
  *                                  [ADC_0, ADC_1, ..., ADC_5, POT]
@@ -103,6 +224,11 @@ int8_t ADC_End(void)
  */
 uint16_t ADC_Read(uint32_t channel)
 {
+    if (scanning)
+    {
+        return ADC_Latest(channel);
+    }
+
 	// Select channel and sampling time.
 	ADC_ChannelConfTypeDef sConfig = {0};
 	sConfig.Channel = channel;
@@ -130,38 +256,11 @@ int8_t ADC_Init(void)
         ADC_ConfigPins();
         ADC_ConfigClks();
 
-        /**
-         * Configure the global features of the ADC (clock, resolution, data
-         * alignment and number of conversions).
-         */
-        hadc1.Instance = ADC1;
-        hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
-        hadc1.Init.Resolution = ADC_RESOLUTION_12B;
-        hadc1.Init.ScanConvMode = DISABLE;
-        hadc1.Init.ContinuousConvMode = ENABLE;
-        hadc1.Init.DiscontinuousConvMode = DISABLE;
-        hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
-        hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
-        hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
-		hadc1.Init.NbrOfConversion = 1;
-        hadc1.Init.DMAContinuousRequests = DISABLE;
-        hadc1.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
-
-        if (HAL_ADC_Init(&hadc1) != HAL_OK)
+        if (ADC_ConfigSingle() == ERROR)
         {
-          return ERROR;
+            return ERROR;
         }
 
-		// By default, select onboard potentiometer.
-        ADC_ChannelConfTypeDef sConfig = {0};
-		sConfig.Channel = POT;
-		sConfig.Rank = 1;
-		sConfig.SamplingTime = ADC_SAMPLETIME_3CYCLES;
-		if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
-        {
-			return ERROR;
-		}
-
         // Start ADC.
         ADC_Start();
 
@@ -172,6 +271,226 @@ int8_t ADC_Init(void)
 	return SUCCESS;
 }
 
+/** ADC_ScanStart(rate)
+ *
+ * Switches from single conversions to scanning all channels at a fixed rate.
+ * ADC_Read() then returns the newest scanned sample without converting.
+ *
+ * @param   rate    (uint32_t)  scans per second, ADC_SCAN_MIN_RATE to
+ *                              ADC_SCAN_MAX_RATE; TIM5 divides 84 MHz, so
+ *                              rates that don't divide it are rounded
+ * @return          (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t ADC_ScanStart(uint32_t rate)
+{
+    if (initStatus == FALSE || rate < ADC_SCAN_MIN_RATE || rate > ADC_SCAN_MAX_RATE)
+    {
+        return ERROR;
+    }
+    if (scanning)
+    {
+        ADC_ScanStop();
+    }
+
+    // the DMA handle is linked by the MSP init, which only runs after a DeInit
+    HAL_ADC_Stop(&hadc1);
+    HAL_ADC_DeInit(&hadc1);
+    if (ADC_ConfigScan() == ERROR)
+    {
+        return ERROR;
+    }
+
+    // APB1 timers run at twice PCLK1 when it is divided
+    uint32_t clock = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1)
+    {
+        clock *= 2;
+    }
+    uint32_t period = (clock + rate / 2) / rate;
+
+    htim5.Instance = TIM5;
+    htim5.Init.Prescaler = 0;
+    htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim5.Init.Period = period - 1;                 // 32 bit counter, 1 Hz fits
+    htim5.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim5.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    if (HAL_TIM_Base_Init(&htim5) != HAL_OK || HAL_TIM_PWM_Init(&htim5) != HAL_OK)
+    {
+        return ERROR;
+    }
+    // CC1 rises once per period and starts a scan; PA0 stays analog, so
+    // nothing comes out on the pin
+    TIM_OC_InitTypeDef sConfigOC = {0};
+    sConfigOC.OCMode = TIM_OCMODE_PWM1;
+    sConfigOC.Pulse = period / 2;
+    sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+    sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+    if (HAL_TIM_PWM_ConfigChannel(&htim5, &sConfigOC, TIM_CHANNEL_1) != HAL_OK)
+    {
+        return ERROR;
+    }
+
+    lastBlock = NULL;
+    overruns = 0;
+    if (HAL_ADC_Start_DMA(&hadc1, (uint32_t *) scanBuffer, ADC_SCAN_LENGTH) != HAL_OK)
+    {
+        return ERROR;
+    }
+    scanning = TRUE;
+    HAL_TIM_PWM_Start(&htim5, TIM_CHANNEL_1);
+
+    return SUCCESS;
+}
+
+/** ADC_ScanStop()
+ *
+ * Stops the scan and goes back to single conversions for ADC_Read().
+ *
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t ADC_ScanStop(void)
+{
+    if (!scanning)
+    {
+        return SUCCESS;
+    }
+    scanning = FALSE;
+    HAL_TIM_PWM_Stop(&htim5, TIM_CHANNEL_1);
+    HAL_TIM_Base_DeInit(&htim5);
+    HAL_ADC_Stop_DMA(&hadc1);
+    HAL_ADC_DeInit(&hadc1);
+    if (ADC_ConfigSingle() == ERROR)
+    {
+        return ERROR;
+    }
+    ADC_Start();
+
+    return SUCCESS;
+}
+
+/** ADC_ScanIndex(channel)
+ *
+ * Position of a channel within each scan of a block.
+ *
+ * @param   channel (uint32_t)  [ADC_0, ADC_1, ..., ADC_5, POT]
+ * @return          (int8_t)    0 to ADC_NUM_CHANNELS - 1, or ERROR
+ */
+int8_t ADC_ScanIndex(uint32_t channel)
+{
+    for (int8_t i = 0; i < ADC_NUM_CHANNELS; i++)
+    {
+        if (scanChannels[i] == channel)
+        {
+            return i;
+        }
+    }
+    return ERROR;
+}
+
+/** ADC_Latest(channel)
+ *
+ * Newest sample of a channel from the last finished scan, read straight from
+ * the DMA buffer.
+ *
+ * @param   channel (uint32_t)  [ADC_0, ADC_1, ..., ADC_5, POT]
+ * @return          (uint16_t)  12-bit reading, 0 before the first scan or if
+ *                              not scanning
+ */
+uint16_t ADC_Latest(uint32_t channel)
+{
+    int8_t index = ADC_ScanIndex(channel);
+    if (!scanning || index == ERROR)
+    {
+        return 0;
+    }
+    // the DMA counts down what is left of this lap around the buffer; the
+    // scan before the one it is writing is complete
+    uint32_t written = ADC_SCAN_LENGTH - __HAL_DMA_GET_COUNTER(&hdma_adc1);
+    uint32_t scan = written / ADC_NUM_CHANNELS;
+    uint32_t last = (scan == 0 ? 2 * ADC_SCAN_BLOCK : scan) - 1;
+
+    return scanBuffer[last * ADC_NUM_CHANNELS + index];
+}
+
+/** ADC_GetBlock(sequence)
+ *
+ * Newest finished half of the scan buffer, for a task to poll.
+ *
+ * @param   sequence    (uint32_t *)    in: number of the last block the caller
+ *                                      took, out: number of the returned one
+ * @return  (const uint16_t *)  ADC_SCAN_BLOCK * ADC_NUM_CHANNELS samples, or
+ *                              NULL if there is nothing new; valid until the
+ *                              DMA comes around again, ADC_SCAN_BLOCK scans
+ *                              later
+ */
+const uint16_t *ADC_GetBlock(uint32_t *sequence)
+{
+    uint32_t primask = __get_PRIMASK();    // may be called with interrupts already off
+    __disable_irq();
+    uint32_t now = blockSequence;
+    const uint16_t *block = (const uint16_t *) lastBlock;
+    __set_PRIMASK(primask);
+    if (sequence == NULL || block == NULL || now == *sequence)
+    {
+        return NULL;
+    }
+    *sequence = now;
+    return block;
+}
+
+/** ADC_SetBlockCallback(callback)
+ *
+ * Hands every finished block to a function, in the DMA interrupt.
+ *
+ * @param   callback    (ADC_BlockCallback) NULL to stop
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t ADC_SetBlockCallback(ADC_BlockCallback callback)
+{
+    blockCallback = callback;
+    return SUCCESS;
+}
+
+/** ADC_GetOverruns()
+ *
+ * Conversions lost because the DMA was late (the scan is restarted).
+ *
+ * @return  (uint32_t)  count since ADC_ScanStart()
+ */
+uint32_t ADC_GetOverruns(void)
+{
+    return overruns;
+}
+
+// DMA half transfer: the first half of the buffer is done
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC1)
+    {
+        ADC_BlockDone(&scanBuffer[0]);
+    }
+}
+
+// DMA transfer complete: the second half is done, the DMA wraps around
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC1)
+    {
+        ADC_BlockDone(&scanBuffer[ADC_SCAN_LENGTH / 2]);
+    }
+}
+
+// overrun: the ADC stopped requesting DMA, start the sequence over
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC1 && scanning)
+    {
+        overruns++;
+        HAL_ADC_Stop_DMA(hadc);
+        HAL_ADC_Start_DMA(hadc, (uint32_t *) scanBuffer, ADC_SCAN_LENGTH);
+    }
+}
+
 
 /** ADC_TEST
  * 
@@ -212,3 +531,66 @@ int main(void)
 
 
 #endif  /*  ADC_TEST    */
+
+
+/** ADC_SCAN_TEST
+ *
+ * Uncomment the below "#define" to run the ADC_SCAN_TEST.
+ *
+ * SUCCESS - Every half second prints the newest sample of each channel (they
+ *           follow the pot and the inputs like ADC_TEST), the mean of POT over
+ *           the newest block, and the block count, which goes up by
+ *           ADC_SCAN_TEST_RATE / ADC_SCAN_BLOCK per second (~16 per print at
+ *           1 kHz) with no overruns.
+ */
+//#define ADC_SCAN_TEST
+#ifdef ADC_SCAN_TEST
+
+#include <stdio.h>
+#include <Board.h>
+#include <ADC.h>
+
+
+#define ADC_SCAN_TEST_RATE 1000
+
+static volatile uint32_t blocks;
+
+static void count_block(const uint16_t *block, uint32_t t_us)
+{
+    blocks++;
+}
+
+int main(void)
+{
+    BOARD_Init();
+    if (ADC_Init() == ERROR || ADC_ScanStart(ADC_SCAN_TEST_RATE) == ERROR)
+    {
+        printf("ADC scan init error\r\n");
+        while (TRUE);
+    }
+    ADC_SetBlockCallback(count_block);
+
+    uint32_t sequence = 0;
+    int8_t pot = ADC_ScanIndex(POT);
+    while (TRUE)
+    {
+        HAL_Delay(500);
+        printf("POT %4u  ADC_0 %4u  ADC_1 %4u  ADC_2 %4u  ADC_3 %4u  ADC_4 %4u  ADC_5 %4u\r\n",
+               ADC_Read(POT), ADC_Read(ADC_0), ADC_Read(ADC_1), ADC_Read(ADC_2), ADC_Read(ADC_3),
+               ADC_Read(ADC_4), ADC_Read(ADC_5));
+
+        const uint16_t *block = ADC_GetBlock(&sequence);
+        if (block != NULL)
+        {
+            uint32_t sum = 0;
+            for (uint8_t i = 0; i < ADC_SCAN_BLOCK; i++)
+            {
+                sum += block[i * ADC_NUM_CHANNELS + pot];
+            }
+            printf("POT mean %lu, block %lu, blocks %lu, overruns %lu\r\n", sum / ADC_SCAN_BLOCK, sequence,
+                   blocks, ADC_GetOverruns());
+        }
+    }
+}
+
+#endif  /*  ADC_SCAN_TEST   */
@@ -13,6 +13,7 @@
 
 #include <Board.h>
 #include <leds.h>
+#include <Console.h>
 
 
 /*  PROTOTYPES  */
@@ -29,7 +30,8 @@ void Error_Handler(void);
 /*  MODULE-LEVEL DEFINITIONS, MACROS    */
 static uint8_t initStatus = FALSE;
 
-// Define UART2 handler and setup printf() functionality.
+// Define UART2 handler and setup printf() functionality, printf() itself goes
+// through Console.c.
 UART_HandleTypeDef huart2;
 #ifdef __GNUC__
 #define PUTCHAR_PROTOTYPE int __io_putchar(int ch)
@@ -41,7 +43,8 @@ UART_HandleTypeDef huart2;
 
 PUTCHAR_PROTOTYPE
 {
-    HAL_UART_Transmit(&huart2, (uint8_t *)&ch, 1, HAL_MAX_DELAY);
+    char c = ch;
+    CONSOLE_Write(&c, 1);
     return ch;
 }
 
@@ -55,7 +58,7 @@ GETCHAR_PROTOTYPE
     // Wait for reception of a character on the USART RX line and echo this
     // character on console.
     HAL_UART_Receive(&huart2, (uint8_t *)&ch, 1, HAL_MAX_DELAY);
-    HAL_UART_Transmit(&huart2, (uint8_t *)&ch, 1, HAL_MAX_DELAY);
+    __io_putchar(ch);
     return ch;
 }
 
@@ -0,0 +1,99 @@
+/**
+ * @file    Bringup.h
+ *
+ * Power-on initialization of several devices at once. Each device gives a
+ * step function that does the next part of its init and returns how long
+ * to wait before the next part, instead of busy waiting in between;
+ * BRINGUP_Run() interleaves the steps of every device, so the boot takes
+ * about as long as the slowest device instead of the sum of all of them.
+ *
+ * Steps run one at a time, so devices on the same I2C bus never overlap.
+ * A device that has not finished by its deadline counts as failed, and the
+ * time each device took to become ready is kept for BRINGUP_PrintReport().
+ *
+ *     int32_t lcd_step(void)
+ *     {
+ *         static uint8_t phase = 0;
+ *         switch (phase++)
+ *         {
+ *             case 0: power_on(); return 100;     // ms until the next step
+ *             case 1: configure(); return 5;
+ *             default: return BRINGUP_READY;
+ *         }
+ *     }
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef BRINGUP_H
+#define	BRINGUP_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define BRINGUP_MAX_DEVICES 8
+
+// step results besides a wait in ms (>= 0)
+#define BRINGUP_READY (-1)
+#define BRINGUP_FAILED (-2)
+
+typedef int32_t (*BRINGUP_Step)(void);
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** BRINGUP_Init()
+ *
+ * Forgets every device. TIMER_Init() must have run.
+ */
+void BRINGUP_Init(void);
+
+/** BRINGUP_Add(name, step, deadline_ms)
+ *
+ * Registers a device. Its first step runs as soon as BRINGUP_Run() starts.
+ *
+ * @param   name        (const char *)  for the report, not copied
+ * @param   step        (BRINGUP_Step)  returns a wait in ms, BRINGUP_READY
+ *                                      or BRINGUP_FAILED
+ * @param   deadline_ms (uint32_t)      time from the start of BRINGUP_Run()
+ *                                      the device must be ready by
+ * @return  (int8_t)    device id, or ERROR if the table is full
+ */
+int8_t BRINGUP_Add(const char *name, BRINGUP_Step step, uint32_t deadline_ms);
+
+/** BRINGUP_Run()
+ *
+ * Steps every device until each one is ready, failed or past its deadline.
+ *
+ * @return  (int8_t)    SUCCESS if every device is ready, ERROR otherwise
+ */
+int8_t BRINGUP_Run(void);
+
+/** BRINGUP_IsReady(id)
+ *
+ * @param   id  (int8_t)    from BRINGUP_Add()
+ * @return  (int8_t)    TRUE once the device finished its init, FALSE otherwise
+ */
+int8_t BRINGUP_IsReady(int8_t id);
+
+/** BRINGUP_PrintReport()
+ *
+ * Prints each device's time to ready (or why it failed) and step count.
+ */
+void BRINGUP_PrintReport(void);
+
+
+#endif  /*  BRINGUP_H    */
@@ -0,0 +1,84 @@
+/**
+ * @file    Console.h
+ *
+ * Non-blocking stdout on the USB serial port (USART2). printf() used to
+ * send one character at a time with HAL_UART_Transmit(), ~87 us per byte
+ * at 115200 baud, all of it spent waiting. Now _write() copies the text into
+ * a ring buffer and returns; DMA sends it in the background, one contiguous
+ * piece of the ring per transfer, and the transfer complete interrupt starts
+ * the next piece.
+ *
+ * When the ring is full the policy decides: CONSOLE_DROP (the default)
+ * throws the whole write away and counts its bytes, so a chatty print never
+ * stalls a control loop; CONSOLE_BLOCK waits for room, for output that must
+ * not be lost, like a report at boot.
+ *
+ * printf() from interrupts is not supported, the ring has one writer.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef CONSOLE_H
+#define	CONSOLE_H
+
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define CONSOLE_TX_BUFFER 2048          // bytes waiting to be sent, power of two
+
+// what a write does when the ring is full
+#define CONSOLE_DROP 0
+#define CONSOLE_BLOCK 1
+
+UART_HandleTypeDef huart2;              // set up by BOARD_Init()
+DMA_HandleTypeDef hdma_usart2_tx;       // set up in HAL_UART_MspInit()
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** CONSOLE_Write(data, length)
+ *
+ * Queues bytes for USART2 and starts sending if the DMA is idle. This is
+ * what _write() (so printf(), puts(), ...) calls.
+ *
+ * @param   data    (const char *)  bytes to send
+ * @param   length  (int)           number of bytes
+ * @return  (int)   length, also when the bytes were dropped
+ */
+int CONSOLE_Write(const char *data, int length);
+
+/** CONSOLE_SetPolicy(policy)
+ *
+ * @param   policy  (uint8_t)   CONSOLE_DROP or CONSOLE_BLOCK
+ */
+void CONSOLE_SetPolicy(uint8_t policy);
+
+/** CONSOLE_Flush()
+ *
+ * Waits until everything queued is on the wire (the last byte may still be
+ * shifting out).
+ */
+void CONSOLE_Flush(void);
+
+/** CONSOLE_GetDropped()
+ *
+ * @return  (uint32_t)  bytes thrown away because the ring was full
+ */
+uint32_t CONSOLE_GetDropped(void);
+
+
+#endif  /*  CONSOLE_H   */
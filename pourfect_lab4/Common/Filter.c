@@ -0,0 +1,524 @@
+/**
+ * @file    Filter.c
+ *
+ * Moving average, running median and first order low pass filters with
+ * per-instance state.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Filter.h>
+
+
+/*  PROTOTYPES  */
+static uint8_t FILTER_Log2(uint16_t window);
+
+
+/*  PRIVATE FUNCTIONS   */
+/** FILTER_Log2(window)
+ *
+ * @param   window  (uint16_t)  window size
+ * @return  (uint8_t)   log2(window), or 0xFF if window is not a power of two
+ *                      from 1 to FILTER_MAX_WINDOW
+ */
+static uint8_t FILTER_Log2(uint16_t window)
+{
+    if (window == 0 || window > FILTER_MAX_WINDOW || (window & (window - 1)) != 0)
+    {
+        return 0xFF;
+    }
+    uint8_t shift = 0;
+    while ((1u << shift) < window)
+    {
+        shift++;
+    }
+    return shift;
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** FILTER_AverageInit(filter, storage, window)
+ *
+ * Sets up a moving average over the last window samples, all zero to start.
+ *
+ * @param   filter  (FILTER_MovingAverage *)    filter to set up
+ * @param   storage (int32_t *)                 window samples
+ * @param   window  (uint16_t)  samples, a power of two up to FILTER_MAX_WINDOW
+ * @return  (int8_t)    SUCCESS, or ERROR if window is not a power of two
+ */
+int8_t FILTER_AverageInit(FILTER_MovingAverage *filter, int32_t *storage, uint16_t window)
+{
+    uint8_t shift = FILTER_Log2(window);
+    if (shift == 0xFF)
+    {
+        return ERROR;
+    }
+    filter->samples = storage;
+    filter->mask = window - 1;
+    filter->shift = shift;
+    FILTER_AverageReset(filter, 0);
+    return SUCCESS;
+}
+
+/** FILTER_AverageReset(filter, value)
+ *
+ * Fills the window with value, so the average starts there instead of
+ * ramping up from zero.
+ *
+ * @param   filter  (FILTER_MovingAverage *)    filter
+ * @param   value   (int32_t)                   sample to fill with
+ */
+void FILTER_AverageReset(FILTER_MovingAverage *filter, int32_t value)
+{
+    for (uint16_t i = 0; i <= filter->mask; i++)
+    {
+        filter->samples[i] = value;
+    }
+    filter->index = 0;
+    filter->sum = value * (int32_t) (filter->mask + 1);
+}
+
+/** FILTER_AverageAdd(filter, sample)
+ *
+ * Replaces the oldest sample with a new one.
+ *
+ * @param   filter  (FILTER_MovingAverage *)    filter
+ * @param   sample  (int32_t)   new sample, |sample| < 2^20
+ * @return  (int32_t)   mean of the window, rounded down
+ */
+int32_t FILTER_AverageAdd(FILTER_MovingAverage *filter, int32_t sample)
+{
+    int32_t *slot = &filter->samples[filter->index];
+    filter->sum += sample - *slot;
+    *slot = sample;
+    filter->index = (filter->index + 1) & filter->mask;
+    return filter->sum >> filter->shift;
+}
+
+/** FILTER_AverageBlock(filter, block, count, stride, out)
+ *
+ * FILTER_AverageAdd() for count samples, stride apart, of a buffer.
+ *
+ * @param   filter  (FILTER_MovingAverage *)    filter
+ * @param   block   (const uint16_t *)  first sample
+ * @param   count   (uint16_t)  samples to add
+ * @param   stride  (uint16_t)  distance between samples, 1 for a plain array,
+ *                              ADC_NUM_CHANNELS for one channel of a scan block
+ * @param   out     (int32_t *) count averages, or NULL for only the last
+ * @return  (int32_t)   mean of the window after the last sample
+ */
+int32_t FILTER_AverageBlock(FILTER_MovingAverage *filter, const uint16_t *block, uint16_t count,
+                            uint16_t stride, int32_t *out)
+{
+    // The filter state lives in registers for the whole block
+    int32_t *samples = filter->samples;
+    uint16_t mask = filter->mask;
+    uint16_t index = filter->index;
+    uint8_t shift = filter->shift;
+    int32_t sum = filter->sum;
+    for (uint16_t i = 0; i < count; i++, block += stride)
+    {
+        int32_t sample = *block;
+        sum += sample - samples[index];
+        samples[index] = sample;
+        index = (index + 1) & mask;
+        if (out != NULL)
+        {
+            out[i] = sum >> shift;
+        }
+    }
+    filter->index = index;
+    filter->sum = sum;
+    return sum >> shift;
+}
+
+/** FILTER_MedianInit(filter, samples, sorted, window)
+ *
+ * Sets up a running median over the last window samples, all zero to start.
+ * Each new sample costs a binary search plus a shift of the sorted copy by
+ * as many places as the sample moves, so keep windows to a few dozen.
+ *
+ * @param   filter  (FILTER_RunningMedian *)    filter to set up
+ * @param   samples (int32_t *) window samples
+ * @param   sorted  (int32_t *) window samples, kept in order
+ * @param   window  (uint16_t)  samples, a power of two up to FILTER_MAX_WINDOW
+ * @return  (int8_t)    SUCCESS, or ERROR if window is not a power of two
+ */
+int8_t FILTER_MedianInit(FILTER_RunningMedian *filter, int32_t *samples, int32_t *sorted, uint16_t window)
+{
+    if (FILTER_Log2(window) == 0xFF)
+    {
+        return ERROR;
+    }
+    filter->samples = samples;
+    filter->sorted = sorted;
+    filter->mask = window - 1;
+    FILTER_MedianReset(filter, 0);
+    return SUCCESS;
+}
+
+/** FILTER_MedianReset(filter, value)
+ *
+ * Fills the window with value.
+ *
+ * @param   filter  (FILTER_RunningMedian *)    filter
+ * @param   value   (int32_t)                   sample to fill with
+ */
+void FILTER_MedianReset(FILTER_RunningMedian *filter, int32_t value)
+{
+    for (uint16_t i = 0; i <= filter->mask; i++)
+    {
+        filter->samples[i] = value;
+        filter->sorted[i] = value;
+    }
+    filter->index = 0;
+}
+
+/** FILTER_MedianAdd(filter, sample)
+ *
+ * Replaces the oldest sample with a new one.
+ *
+ * @param   filter  (FILTER_RunningMedian *)    filter
+ * @param   sample  (int32_t)                   new sample
+ * @return  (int32_t)   median of the window; with an even window, the upper
+ *                      of the two middle samples, so it is always a sample
+ */
+int32_t FILTER_MedianAdd(FILTER_RunningMedian *filter, int32_t sample)
+{
+    int32_t *sorted = filter->sorted;
+    int32_t oldest = filter->samples[filter->index];
+    filter->samples[filter->index] = sample;
+    filter->index = (filter->index + 1) & filter->mask;
+
+    // Find the oldest sample in the sorted copy (any one of equal values)...
+    uint16_t low = 0;
+    uint16_t high = filter->mask;
+    while (low < high)
+    {
+        uint16_t middle = (low + high) >> 1;
+        if (sorted[middle] < oldest)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    // ...and slide the new one from there to its place, one pass either way
+    if (sample > oldest)
+    {
+        while (low < filter->mask && sorted[low + 1] < sample)
+        {
+            sorted[low] = sorted[low + 1];
+            low++;
+        }
+    }
+    else
+    {
+        while (low > 0 && sorted[low - 1] > sample)
+        {
+            sorted[low] = sorted[low - 1];
+            low--;
+        }
+    }
+    sorted[low] = sample;
+    return sorted[(filter->mask + 1) >> 1];
+}
+
+/** FILTER_MedianBlock(filter, block, count, stride, out)
+ *
+ * FILTER_MedianAdd() for count samples, stride apart, of a buffer.
+ *
+ * @param   filter  (FILTER_RunningMedian *)    filter
+ * @param   block   (const uint16_t *)  first sample
+ * @param   count   (uint16_t)  samples to add
+ * @param   stride  (uint16_t)  distance between samples
+ * @param   out     (int32_t *) count medians, or NULL for only the last
+ * @return  (int32_t)   median of the window after the last sample
+ */
+int32_t FILTER_MedianBlock(FILTER_RunningMedian *filter, const uint16_t *block, uint16_t count,
+                           uint16_t stride, int32_t *out)
+{
+    int32_t median = filter->sorted[(filter->mask + 1) >> 1];
+    for (uint16_t i = 0; i < count; i++, block += stride)
+    {
+        median = FILTER_MedianAdd(filter, *block);
+        if (out != NULL)
+        {
+            out[i] = median;
+        }
+    }
+    return median;
+}
+
+/** FILTER_LowPassInit(filter, shift, value)
+ *
+ * Sets up y += (x - y) / 2^shift, an exponential average with a time
+ * constant of about 2^shift samples (-3 dB at rate / (2 pi 2^shift)). The
+ * output is kept with shift extra fraction bits, so a constant input is
+ * reached exactly.
+ *
+ * @param   filter  (FILTER_LowPass *)  filter to set up
+ * @param   shift   (uint8_t)   0 (no filtering) to FILTER_MAX_SHIFT
+ * @param   value   (int32_t)   starting output
+ * @return  (int8_t)    SUCCESS, or ERROR if shift is too large
+ */
+int8_t FILTER_LowPassInit(FILTER_LowPass *filter, uint8_t shift, int32_t value)
+{
+    if (shift > FILTER_MAX_SHIFT)
+    {
+        return ERROR;
+    }
+    filter->shift = shift;
+    filter->state = value * (1 << shift);
+    return SUCCESS;
+}
+
+/** FILTER_LowPassAdd(filter, sample)
+ *
+ * @param   filter  (FILTER_LowPass *)  filter
+ * @param   sample  (int32_t)   new sample, |sample| < 2^(31 - shift)
+ * @return  (int32_t)   filtered value, rounded down
+ */
+int32_t FILTER_LowPassAdd(FILTER_LowPass *filter, int32_t sample)
+{
+    filter->state += sample - (filter->state >> filter->shift);
+    return filter->state >> filter->shift;
+}
+
+/** FILTER_LowPassBlock(filter, block, count, stride, out)
+ *
+ * FILTER_LowPassAdd() for count samples, stride apart, of a buffer.
+ *
+ * @param   filter  (FILTER_LowPass *)  filter
+ * @param   block   (const uint16_t *)  first sample
+ * @param   count   (uint16_t)  samples to add
+ * @param   stride  (uint16_t)  distance between samples
+ * @param   out     (int32_t *) count outputs, or NULL for only the last
+ * @return  (int32_t)   filtered value after the last sample
+ */
+int32_t FILTER_LowPassBlock(FILTER_LowPass *filter, const uint16_t *block, uint16_t count,
+                            uint16_t stride, int32_t *out)
+{
+    int32_t state = filter->state;
+    uint8_t shift = filter->shift;
+    for (uint16_t i = 0; i < count; i++, block += stride)
+    {
+        state += *block - (state >> shift);
+        if (out != NULL)
+        {
+            out[i] = state >> shift;
+        }
+    }
+    filter->state = state;
+    return state >> shift;
+}
+
+
+/** FILTER_TEST
+ *
+ * Uncomment the below "#define" to run the FILTER_TEST.
+ *
+ * SUCCESS - The first lines end in "ok": every filter matches a brute force
+ *           version on a pseudo random stream, through single samples and
+ *           through blocks taken out of an interleaved buffer. Then the
+ *           DWT cycle counter gives cycles per sample for each filter next
+ *           to the old "% WINDOW_SIZE" moving average, which the masked
+ *           average and the block versions should beat.
+ */
+//#define FILTER_TEST
+#ifdef FILTER_TEST
+
+#include <Board.h>
+
+
+#define TEST_SAMPLES 1024
+#define TEST_CHANNELS 7                 // interleaved like an ADC scan block
+#define TEST_BLOCK 32
+#define OLD_WINDOW 10
+
+static uint16_t input[TEST_SAMPLES * TEST_CHANNELS];
+static int32_t output[TEST_SAMPLES];
+static int32_t expected[TEST_SAMPLES];
+
+static int old_samples[OLD_WINDOW];
+static int old_index = 0;
+static int old_sum = 0;
+
+// The average the labs had before this module, to compare against
+static int OldMovingAverage(int new_sample)
+{
+    old_sum -= old_samples[old_index];
+    old_samples[old_index] = new_sample;
+    old_sum += new_sample;
+    old_index = (old_index + 1) % OLD_WINDOW;
+    return old_sum / OLD_WINDOW;
+}
+
+static int CompareInt32(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t *) a;
+    int32_t y = *(const int32_t *) b;
+    return (x > y) - (x < y);
+}
+
+// Brute force outputs for input channel 0, window samples ending at each one
+static void Expected(uint16_t window, int8_t median)
+{
+    int32_t sorted[64];
+    for (uint16_t i = 0; i < TEST_SAMPLES; i++)
+    {
+        for (uint16_t j = 0; j < window; j++)
+        {
+            sorted[j] = i >= j ? input[(i - j) * TEST_CHANNELS] : 0;
+        }
+        if (median)
+        {
+            qsort(sorted, window, sizeof(int32_t), CompareInt32);
+            expected[i] = sorted[window / 2];
+        }
+        else
+        {
+            int32_t sum = 0;
+            for (uint16_t j = 0; j < window; j++)
+            {
+                sum += sorted[j];
+            }
+            expected[i] = sum / window;
+        }
+    }
+}
+
+static const char *Matches(void)
+{
+    for (uint16_t i = 0; i < TEST_SAMPLES; i++)
+    {
+        if (output[i] != expected[i])
+        {
+            return "FAIL";
+        }
+    }
+    return "ok";
+}
+
+int main(void)
+{
+    BOARD_Init();
+
+    static int32_t storage[64], sorted[64];
+    FILTER_MovingAverage average;
+    FILTER_RunningMedian median;
+    FILTER_LowPass lowpass;
+
+    uint32_t seed = 12345;
+    for (uint16_t i = 0; i < TEST_SAMPLES * TEST_CHANNELS; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        input[i] = (seed >> 20) & 0x0FFF;           // 12 bit, like the ADC
+    }
+
+    printf("window 10: %s\r\n", FILTER_AverageInit(&average, storage, 10) == ERROR ? "ok" : "FAIL");
+
+    FILTER_AverageInit(&average, storage, 16);
+    for (uint16_t i = 0; i < TEST_SAMPLES; i++)
+    {
+        output[i] = FILTER_AverageAdd(&average, input[i * TEST_CHANNELS]);
+    }
+    Expected(16, FALSE);
+    printf("average: %s\r\n", Matches());
+
+    FILTER_AverageInit(&average, storage, 16);
+    for (uint16_t i = 0; i < TEST_SAMPLES; i += TEST_BLOCK)
+    {
+        FILTER_AverageBlock(&average, &input[i * TEST_CHANNELS], TEST_BLOCK, TEST_CHANNELS, &output[i]);
+    }
+    printf("average block: %s\r\n", Matches());
+
+    for (uint16_t window = 1; window <= 64; window <<= 1)
+    {
+        FILTER_MedianInit(&median, storage, sorted, window);
+        for (uint16_t i = 0; i < TEST_SAMPLES; i += TEST_BLOCK)
+        {
+            FILTER_MedianBlock(&median, &input[i * TEST_CHANNELS], TEST_BLOCK, TEST_CHANNELS, &output[i]);
+        }
+        Expected(window, TRUE);
+        printf("median %u: %s\r\n", window, Matches());
+    }
+
+    FILTER_LowPassInit(&lowpass, 4, 0);
+    int32_t settled = 0;
+    for (uint16_t i = 0; i < 400; i++)
+    {
+        settled = FILTER_LowPassAdd(&lowpass, 3000);
+    }
+    FILTER_LowPassInit(&lowpass, 4, 0);
+    int32_t block = FILTER_LowPassBlock(&lowpass, input, TEST_SAMPLES, TEST_CHANNELS, NULL);
+    FILTER_LowPassInit(&lowpass, 4, 0);
+    int32_t single = 0;
+    for (uint16_t i = 0; i < TEST_SAMPLES; i++)
+    {
+        single = FILTER_LowPassAdd(&lowpass, input[i * TEST_CHANNELS]);
+    }
+    printf("low pass: %s\r\n", settled == 3000 && block == single ? "ok" : "FAIL");
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    uint32_t start, cycles;
+    volatile int32_t sink;
+
+    start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < TEST_SAMPLES; i++)
+    {
+        sink = OldMovingAverage(input[i * TEST_CHANNELS]);
+    }
+    cycles = DWT->CYCCNT - start;
+    printf("cycles per sample: %% average %lu", (unsigned long) (cycles / TEST_SAMPLES));
+
+    FILTER_AverageInit(&average, storage, 16);
+    start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < TEST_SAMPLES; i++)
+    {
+        sink = FILTER_AverageAdd(&average, input[i * TEST_CHANNELS]);
+    }
+    cycles = DWT->CYCCNT - start;
+    printf(", average %lu", (unsigned long) (cycles / TEST_SAMPLES));
+
+    start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < TEST_SAMPLES; i += TEST_BLOCK)
+    {
+        sink = FILTER_AverageBlock(&average, &input[i * TEST_CHANNELS], TEST_BLOCK, TEST_CHANNELS, NULL);
+    }
+    cycles = DWT->CYCCNT - start;
+    printf(", average block %lu", (unsigned long) (cycles / TEST_SAMPLES));
+
+    start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < TEST_SAMPLES; i += TEST_BLOCK)
+    {
+        sink = FILTER_LowPassBlock(&lowpass, &input[i * TEST_CHANNELS], TEST_BLOCK, TEST_CHANNELS, NULL);
+    }
+    cycles = DWT->CYCCNT - start;
+    printf(", low pass block %lu", (unsigned long) (cycles / TEST_SAMPLES));
+
+    for (uint16_t window = 8; window <= 32; window <<= 2)
+    {
+        FILTER_MedianInit(&median, storage, sorted, window);
+        start = DWT->CYCCNT;
+        for (uint16_t i = 0; i < TEST_SAMPLES; i++)
+        {
+            sink = FILTER_MedianAdd(&median, input[i * TEST_CHANNELS]);
+        }
+        cycles = DWT->CYCCNT - start;
+        printf(", median %u %lu", window, (unsigned long) (cycles / TEST_SAMPLES));
+    }
+    printf("\r\n");
+    (void) sink;
+
+    while (TRUE);
+}
+
+#endif  /*  FILTER_TEST */
@@ -0,0 +1,205 @@
+/**
+ * @file    Filter.h
+ *
+ * Fixed window integer filters for sensor samples: moving average, running
+ * median and a first order low pass. Each filter is a struct the caller owns,
+ * so any number of them run side by side (one per ADC channel, one in an
+ * ISR and one in the main loop) with no globals. Windows are powers of two:
+ * the ring index wraps with a mask and the average is a shift, so there is no
+ * divide or modulo per sample.
+ *
+ *     static int32_t flex_storage[8];
+ *     static FILTER_MovingAverage flex;
+ *     FILTER_AverageInit(&flex, flex_storage, 8);
+ *     ...
+ *     int32_t smooth = FILTER_AverageAdd(&flex, ADC_Read(ADC_0));
+ *
+ * The Block functions run a filter over one channel of an interleaved buffer,
+ * such as an ADC_GetBlock() block, in one call:
+ *
+ *     FILTER_AverageBlock(&flex, block + ADC_ScanIndex(ADC_0), ADC_SCAN_BLOCK,
+ *                         ADC_NUM_CHANNELS, NULL);
+ *
+ * A window starts out full of zeros; FILTER_AverageReset() and
+ * FILTER_MedianReset() fill it with a value instead.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef FILTER_H
+#define	FILTER_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define FILTER_MAX_WINDOW 1024          // samples, the sum of 2^20 counts fits 31 bits
+#define FILTER_MAX_SHIFT 15             // low pass, a 16 bit sample << 15 fits 31 bits
+
+typedef struct {
+    int32_t *samples;                   // window samples, oldest at index
+    uint16_t mask;                      // window - 1
+    uint16_t index;                     // next slot to overwrite
+    uint8_t shift;                      // log2(window)
+    int32_t sum;                        // of samples[]
+} FILTER_MovingAverage;
+
+typedef struct {
+    int32_t *samples;                   // window samples, oldest at index
+    int32_t *sorted;                    // the same samples in ascending order
+    uint16_t mask;                      // window - 1
+    uint16_t index;                     // next slot to overwrite
+} FILTER_RunningMedian;
+
+typedef struct {
+    int32_t state;                      // output << shift
+    uint8_t shift;                      // alpha = 1 / 2^shift
+} FILTER_LowPass;
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** FILTER_AverageInit(filter, storage, window)
+ *
+ * Sets up a moving average over the last window samples, all zero to start.
+ *
+ * @param   filter  (FILTER_MovingAverage *)    filter to set up
+ * @param   storage (int32_t *)                 window samples
+ * @param   window  (uint16_t)  samples, a power of two up to FILTER_MAX_WINDOW
+ * @return  (int8_t)    SUCCESS, or ERROR if window is not a power of two
+ */
+int8_t FILTER_AverageInit(FILTER_MovingAverage *filter, int32_t *storage, uint16_t window);
+
+/** FILTER_AverageReset(filter, value)
+ *
+ * Fills the window with value, so the average starts there instead of
+ * ramping up from zero.
+ *
+ * @param   filter  (FILTER_MovingAverage *)    filter
+ * @param   value   (int32_t)                   sample to fill with
+ */
+void FILTER_AverageReset(FILTER_MovingAverage *filter, int32_t value);
+
+/** FILTER_AverageAdd(filter, sample)
+ *
+ * Replaces the oldest sample with a new one.
+ *
+ * @param   filter  (FILTER_MovingAverage *)    filter
+ * @param   sample  (int32_t)   new sample, |sample| < 2^20
+ * @return  (int32_t)   mean of the window, rounded down
+ */
+int32_t FILTER_AverageAdd(FILTER_MovingAverage *filter, int32_t sample);
+
+/** FILTER_AverageBlock(filter, block, count, stride, out)
+ *
+ * FILTER_AverageAdd() for count samples, stride apart, of a buffer.
+ *
+ * @param   filter  (FILTER_MovingAverage *)    filter
+ * @param   block   (const uint16_t *)  first sample
+ * @param   count   (uint16_t)  samples to add
+ * @param   stride  (uint16_t)  distance between samples, 1 for a plain array,
+ *                              ADC_NUM_CHANNELS for one channel of a scan block
+ * @param   out     (int32_t *) count averages, or NULL for only the last
+ * @return  (int32_t)   mean of the window after the last sample
+ */
+int32_t FILTER_AverageBlock(FILTER_MovingAverage *filter, const uint16_t *block, uint16_t count,
+                            uint16_t stride, int32_t *out);
+
+/** FILTER_MedianInit(filter, samples, sorted, window)
+ *
+ * Sets up a running median over the last window samples, all zero to start.
+ * Each new sample costs a binary search plus a shift of the sorted copy by
+ * as many places as the sample moves, so keep windows to a few dozen.
+ *
+ * @param   filter  (FILTER_RunningMedian *)    filter to set up
+ * @param   samples (int32_t *) window samples
+ * @param   sorted  (int32_t *) window samples, kept in order
+ * @param   window  (uint16_t)  samples, a power of two up to FILTER_MAX_WINDOW
+ * @return  (int8_t)    SUCCESS, or ERROR if window is not a power of two
+ */
+int8_t FILTER_MedianInit(FILTER_RunningMedian *filter, int32_t *samples, int32_t *sorted, uint16_t window);
+
+/** FILTER_MedianReset(filter, value)
+ *
+ * Fills the window with value.
+ *
+ * @param   filter  (FILTER_RunningMedian *)    filter
+ * @param   value   (int32_t)                   sample to fill with
+ */
+void FILTER_MedianReset(FILTER_RunningMedian *filter, int32_t value);
+
+/** FILTER_MedianAdd(filter, sample)
+ *
+ * Replaces the oldest sample with a new one.
+ *
+ * @param   filter  (FILTER_RunningMedian *)    filter
+ * @param   sample  (int32_t)                   new sample
+ * @return  (int32_t)   median of the window; with an even window, the upper
+ *                      of the two middle samples, so it is always a sample
+ */
+int32_t FILTER_MedianAdd(FILTER_RunningMedian *filter, int32_t sample);
+
+/** FILTER_MedianBlock(filter, block, count, stride, out)
+ *
+ * FILTER_MedianAdd() for count samples, stride apart, of a buffer.
+ *
+ * @param   filter  (FILTER_RunningMedian *)    filter
+ * @param   block   (const uint16_t *)  first sample
+ * @param   count   (uint16_t)  samples to add
+ * @param   stride  (uint16_t)  distance between samples
+ * @param   out     (int32_t *) count medians, or NULL for only the last
+ * @return  (int32_t)   median of the window after the last sample
+ */
+int32_t FILTER_MedianBlock(FILTER_RunningMedian *filter, const uint16_t *block, uint16_t count,
+                           uint16_t stride, int32_t *out);
+
+/** FILTER_LowPassInit(filter, shift, value)
+ *
+ * Sets up y += (x - y) / 2^shift, an exponential average with a time
+ * constant of about 2^shift samples (-3 dB at rate / (2 pi 2^shift)). The
+ * output is kept with shift extra fraction bits, so a constant input is
+ * reached exactly.
+ *
+ * @param   filter  (FILTER_LowPass *)  filter to set up
+ * @param   shift   (uint8_t)   0 (no filtering) to FILTER_MAX_SHIFT
+ * @param   value   (int32_t)   starting output
+ * @return  (int8_t)    SUCCESS, or ERROR if shift is too large
+ */
+int8_t FILTER_LowPassInit(FILTER_LowPass *filter, uint8_t shift, int32_t value);
+
+/** FILTER_LowPassAdd(filter, sample)
+ *
+ * @param   filter  (FILTER_LowPass *)  filter
+ * @param   sample  (int32_t)   new sample, |sample| < 2^(31 - shift)
+ * @return  (int32_t)   filtered value, rounded down
+ */
+int32_t FILTER_LowPassAdd(FILTER_LowPass *filter, int32_t sample);
+
+/** FILTER_LowPassBlock(filter, block, count, stride, out)
+ *
+ * FILTER_LowPassAdd() for count samples, stride apart, of a buffer.
+ *
+ * @param   filter  (FILTER_LowPass *)  filter
+ * @param   block   (const uint16_t *)  first sample
+ * @param   count   (uint16_t)  samples to add
+ * @param   stride  (uint16_t)  distance between samples
+ * @param   out     (int32_t *) count outputs, or NULL for only the last
+ * @return  (int32_t)   filtered value after the last sample
+ */
+int32_t FILTER_LowPassBlock(FILTER_LowPass *filter, const uint16_t *block, uint16_t count,
+                            uint16_t stride, int32_t *out);
+
+
+#endif  /*  FILTER_H    */
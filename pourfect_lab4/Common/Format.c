@@ -0,0 +1,248 @@
+/**
+ * @file    Format.c
+ *
+ * Fixed point decimal formatting without printf.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Format.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define FMT_DIGITS 24                   // sign, 10 integer digits, point, FMT_MAX_DECIMALS and spare
+#define FMT_LIMIT 4294967296.0f         // 2^32, the integer part is a uint32_t
+
+static const uint32_t powers[FMT_MAX_DECIMALS + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+
+/*  PRIVATE FUNCTIONS   */
+// digits of n, last one first; returns how many
+static uint8_t reverse_digits(uint32_t n, char *out, uint8_t at_least)
+{
+    uint8_t count = 0;
+    do
+    {
+        out[count++] = '0' + n % 10;
+        n /= 10;
+    } while (n != 0 || count < at_least);
+    return count;
+}
+
+// copies text (given last character first) into buffer with the padding of width
+static int emit(char *buffer, int size, const char *reversed, uint8_t length, int8_t width)
+{
+    int span = width < 0 ? -width : width;
+    int pad = span > length ? span - length : 0;
+    if (buffer == NULL || size < 1)
+    {
+        return ERROR;
+    }
+    if (length + pad + 1 > size)
+    {
+        buffer[0] = '\0';
+        return ERROR;
+    }
+    char *p = buffer;
+    if (width > 0)
+    {
+        memset(p, ' ', pad);
+        p += pad;
+    }
+    for (uint8_t i = 0; i < length; i++)
+    {
+        *p++ = reversed[length - 1 - i];
+    }
+    if (width < 0)
+    {
+        memset(p, ' ', pad);
+        p += pad;
+    }
+    *p = '\0';
+    return p - buffer;
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** FMT_Fixed(buffer, size, value, decimals, width)
+ *
+ * Writes value rounded to a fixed number of decimals, like "%*.*f".
+ *
+ * @param   buffer      (char *)    output, always '\0' terminated
+ * @param   size        (int)       size of buffer
+ * @param   value       (float)     number to write, NaN comes out as "nan"
+ * @param   decimals    (uint8_t)   digits after the point, at most FMT_MAX_DECIMALS
+ * @param   width       (int8_t)    minimum length, padded with spaces on the
+ *                                  left, on the right if negative, 0 for none
+ * @return  (int)   length written without the '\0', or ERROR if it does not
+ *                  fit (buffer is then "")
+ */
+int FMT_Fixed(char *buffer, int size, float value, uint8_t decimals, int8_t width)
+{
+    char text[FMT_DIGITS];
+    uint8_t length = 0;
+    if (value != value)
+    {
+        return emit(buffer, size, "nan", 3, width);     // a palindrome, reversed is fine
+    }
+    int8_t negative = value < 0.0f;
+    float magnitude = negative ? -value : value;
+    if (magnitude >= FMT_LIMIT)
+    {
+        length = 3;
+        memcpy(text, "fni", 3);
+    }
+    else
+    {
+        if (decimals > FMT_MAX_DECIMALS)
+        {
+            decimals = FMT_MAX_DECIMALS;
+        }
+        // magnitude is mantissa / 2^shift exactly. The bits of the mantissa
+        // below the point times 10^decimals fit in 64 bits (2^24 * 10^6 <
+        // 2^44), so the scaled fraction and what is rounded off are exact,
+        // and it rounds ties to even like printf
+        uint32_t bits;
+        memcpy(&bits, &magnitude, sizeof(bits));
+        int16_t exponent = (bits >> 23) & 0xFF;
+        uint32_t mantissa = bits & 0x7FFFFF;
+        if (exponent == 0)
+        {
+            exponent = 1;                // subnormal, no hidden bit
+        }
+        else
+        {
+            mantissa |= 0x800000;
+        }
+        int16_t shift = 150 - exponent;
+        uint32_t scale = powers[decimals];
+        uint32_t whole = 0;
+        uint32_t fraction = 0;
+        int8_t round_up = FALSE;
+        if (shift <= 0)
+        {
+            whole = mantissa << -shift;  // below FMT_LIMIT, so it fits
+        }
+        else if (shift < 64)
+        {
+            uint64_t below = ((uint64_t) 1 << shift) - 1;
+            uint64_t half = (uint64_t) 1 << (shift - 1);
+            uint64_t scaled = (mantissa & below) * (uint64_t) scale;
+            whole = shift < 32 ? mantissa >> shift : 0;
+            fraction = scaled >> shift;
+            uint64_t rest = scaled & below;
+            uint32_t last = decimals > 0 ? fraction : whole;
+            round_up = rest > half || (rest == half && (last & 1));
+        }
+        // else below 2^-40, the scaled fraction is under 2^44 and rounds to 0
+        if (round_up)
+        {
+            fraction++;
+        }
+        if (fraction >= scale)          // 0.996 to two places carries into the integer part
+        {
+            fraction -= scale;
+            whole++;
+        }
+        if (decimals > 0)
+        {
+            length = reverse_digits(fraction, text, decimals);
+            text[length++] = '.';
+        }
+        length += reverse_digits(whole, &text[length], 1);
+        negative = negative && (whole != 0 || fraction != 0);  // no "-0.00"
+    }
+    if (negative)
+    {
+        text[length++] = '-';
+    }
+    return emit(buffer, size, text, length, width);
+}
+
+/** FMT_Int(buffer, size, value, width)
+ *
+ * Writes an integer, like "%*ld".
+ *
+ * @param   buffer  (char *)    output, always '\0' terminated
+ * @param   size    (int)       size of buffer
+ * @param   value   (int32_t)   number to write
+ * @param   width   (int8_t)    as FMT_Fixed()
+ * @return  (int)   as FMT_Fixed()
+ */
+int FMT_Int(char *buffer, int size, int32_t value, int8_t width)
+{
+    char text[FMT_DIGITS];
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+    uint8_t length = reverse_digits(magnitude, text, 1);
+    if (value < 0)
+    {
+        text[length++] = '-';
+    }
+    return emit(buffer, size, text, length, width);
+}
+
+
+/** FORMAT_TEST
+ *
+ * Uncomment the below "#define" to run the FORMAT_TEST (the project needs
+ * -u_printf_float for the sprintf() side).
+ *
+ * SUCCESS - Prints a few values both ways, they agree, then the cycles per
+ *           value from the DWT cycle counter for 1000 values in [-180, 180):
+ *           FMT_Fixed() at 2 decimals in the low hundreds of cycles,
+ *           sprintf("%.2f") in the thousands.
+ */
+//#define FORMAT_TEST
+#ifdef FORMAT_TEST
+
+#include <Board.h>
+
+
+#define FORMAT_RUNS 1000
+
+static float values[FORMAT_RUNS];
+
+int main(void)
+{
+    BOARD_Init();
+
+    const float samples[] = {0.0f, -0.004f, 1.005f, 99.996f, -123.456f, 3.14159f, 1e6f, -2.5e9f, 4294967040.0f};
+    char fixed[24], reference[24];
+    for (uint8_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        FMT_Fixed(fixed, sizeof(fixed), samples[i], 2, 0);
+        sprintf(reference, "%.2f", samples[i]);
+        printf("%-16s %-16s %s\r\n", fixed, reference, strcmp(fixed, reference) == 0 ? "" : "differs");
+    }
+
+    for (uint16_t i = 0; i < FORMAT_RUNS; i++)
+    {
+        values[i] = -180.0f + 360.0f * i / FORMAT_RUNS + 0.0123f;
+    }
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < FORMAT_RUNS; i++)
+    {
+        FMT_Fixed(fixed, sizeof(fixed), values[i], 2, 0);
+    }
+    uint32_t fmt_cycles = DWT->CYCCNT - start;
+
+    start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < FORMAT_RUNS; i++)
+    {
+        sprintf(reference, "%.2f", values[i]);
+    }
+    uint32_t sprintf_cycles = DWT->CYCCNT - start;
+
+    printf("cycles per value: FMT_Fixed %lu, sprintf %lu\r\n", (unsigned long) (fmt_cycles / FORMAT_RUNS),
+           (unsigned long) (sprintf_cycles / FORMAT_RUNS));
+    while (TRUE);
+}
+
+#endif  /*  FORMAT_TEST */
@@ -0,0 +1,419 @@
+/**
+ * @file    MagCal.c
+ *
+ * Online hard/soft-iron calibration for the magnetometer.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <Calibration.h>
+#include <MagCal.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define MAGCAL_PARAMS 9
+#define MAGCAL_JACOBI_STEPS 12          // 4 sweeps of the 3 off-diagonal pivots
+
+typedef enum {
+    MAGCAL_IDLE,
+    MAGCAL_CENTER,
+    MAGCAL_ROTATE,
+    MAGCAL_COMPOSE
+} MAGCAL_State;
+
+static const uint8_t jacobi_pivot[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+
+// RLS state
+static float theta[MAGCAL_PARAMS];
+static float P[MAGCAL_PARAMS][MAGCAL_PARAMS];
+static int16_t last_raw[3];
+static uint32_t accepted;
+
+// solve state, works on a snapshot of theta
+static MAGCAL_State state;
+static uint8_t step;
+static float S[3][3];
+static float V[3][3];
+static float center[3];
+
+// output
+static float frame[3][3];
+static float field_norm;
+static uint32_t updates;
+
+
+/*  PRIVATE FUNCTIONS   */
+// 3x3 inverse by adjugate, returns the determinant (0 if singular)
+static float inverse3(const float m[3][3], float inv[3][3])
+{
+    float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    if (fabsf(det) < 1e-12f)
+    {
+        return 0.0f;
+    }
+    float id = 1.0f / det;
+    inv[0][0] = c00 * id;
+    inv[1][0] = c01 * id;
+    inv[2][0] = c02 * id;
+    inv[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * id;
+    inv[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * id;
+    inv[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * id;
+    inv[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * id;
+    inv[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * id;
+    inv[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * id;
+    return det;
+}
+
+// Orthogonal factor of the polar decomposition A = R * P by Newton iteration,
+// R = I if A is singular. Only runs at init.
+static void polar_rotation(const float A[3][3], float R[3][3])
+{
+    float X[3][3], inv[3][3];
+    float det = inverse3(A, inv);
+    if (det == 0.0f)
+    {
+        memset(R, 0, sizeof(float) * 9);
+        R[0][0] = R[1][1] = R[2][2] = 1.0f;
+        return;
+    }
+    // scale to |det| = 1 so the iteration starts close to the answer
+    float s = 1.0f / cbrtf(fabsf(det));
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            X[i][j] = A[i][j] * s;
+        }
+    }
+    for (int iter = 0; iter < 20; iter++)
+    {
+        inverse3(X, inv);
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                X[i][j] = 0.5f * (X[i][j] + inv[j][i]);
+            }
+        }
+    }
+    memcpy(R, X, sizeof(X));
+}
+
+// One RLS step on the regressor phi with target 1.
+static void rls_update(const float phi[MAGCAL_PARAMS])
+{
+    float Pphi[MAGCAL_PARAMS];
+    float denom = MAGCAL_FORGET;
+    float err = 1.0f;
+    float trace = 0.0f;
+
+    for (int i = 0; i < MAGCAL_PARAMS; i++)
+    {
+        float acc = 0.0f;
+        for (int j = 0; j < MAGCAL_PARAMS; j++)
+        {
+            acc += P[i][j] * phi[j];
+        }
+        Pphi[i] = acc;
+        denom += phi[i] * acc;
+        err -= phi[i] * theta[i];
+    }
+    float inv_denom = 1.0f / denom;
+    for (int i = 0; i < MAGCAL_PARAMS; i++)
+    {
+        theta[i] += Pphi[i] * inv_denom * err;
+        trace += P[i][i];
+    }
+
+    // P = (P - Pphi Pphi' / denom) / lambda, upper triangle then mirror;
+    // forgetting is switched off while P is already large (poor excitation).
+    float scale = (trace < MAGCAL_P_MAX) ? 1.0f / MAGCAL_FORGET : 1.0f;
+    for (int i = 0; i < MAGCAL_PARAMS; i++)
+    {
+        float ki = Pphi[i] * inv_denom;
+        for (int j = i; j < MAGCAL_PARAMS; j++)
+        {
+            float v = (P[i][j] - ki * Pphi[j]) * scale;
+            P[i][j] = v;
+            P[j][i] = v;
+        }
+    }
+}
+
+// Center of the ellipsoid and the normalized shape matrix S, so that
+// (u - center)' S (u - center) = 1. Returns FALSE if theta isn't an ellipsoid.
+static int8_t solve_center(void)
+{
+    float Q[3][3] = {
+        {theta[0], theta[3], theta[4]},
+        {theta[3], theta[1], theta[5]},
+        {theta[4], theta[5], theta[2]}
+    };
+    float v[3] = {theta[6], theta[7], theta[8]};
+    float inv[3][3];
+
+    if (inverse3(Q, inv) <= 0.0f)
+    {
+        return FALSE;
+    }
+    float k = 1.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        center[i] = -(inv[i][0] * v[0] + inv[i][1] * v[1] + inv[i][2] * v[2]);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        k -= center[i] * v[i];  // 1 + c'Qc with Qc = -v
+    }
+    if (k <= 0.0f)
+    {
+        return FALSE;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            S[i][j] = Q[i][j] / k;
+            V[i][j] = (i == j) ? 1.0f : 0.0f;
+        }
+    }
+    return TRUE;
+}
+
+// One Jacobi rotation of S, accumulated in V.
+static void solve_rotate(uint8_t n)
+{
+    int p = jacobi_pivot[n % 3][0];
+    int q = jacobi_pivot[n % 3][1];
+    float apq = S[p][q];
+    if (fabsf(apq) < 1e-12f)
+    {
+        return;
+    }
+    float t_theta = (S[q][q] - S[p][p]) / (2.0f * apq);
+    float t = (t_theta >= 0.0f ? 1.0f : -1.0f) / (fabsf(t_theta) + sqrtf(t_theta * t_theta + 1.0f));
+    float c = 1.0f / sqrtf(t * t + 1.0f);
+    float s = t * c;
+    for (int k = 0; k < 3; k++)
+    {
+        float skp = S[k][p], skq = S[k][q];
+        S[k][p] = c * skp - s * skq;
+        S[k][q] = s * skp + c * skq;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        float spk = S[p][k], sqk = S[q][k];
+        S[p][k] = c * spk - s * sqk;
+        S[q][k] = s * spk + c * sqk;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        float vkp = V[k][p], vkq = V[k][q];
+        V[k][p] = c * vkp - s * vkq;
+        V[k][q] = s * vkp + c * vkq;
+    }
+}
+
+// M = V sqrt(diag S) V', out = frame * norm * M * (raw/scale - center).
+// Returns FALSE if the fit looks implausible.
+static int8_t solve_compose(void)
+{
+    float root[3];
+    float lo = 1e30f, hi = 0.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        if (S[i][i] <= 0.0f)
+        {
+            return FALSE;
+        }
+        root[i] = sqrtf(S[i][i]);
+        lo = fminf(lo, root[i]);
+        hi = fmaxf(hi, root[i]);
+    }
+    float offset = sqrtf(center[0] * center[0] + center[1] * center[1] + center[2] * center[2]);
+    if (hi > MAGCAL_MAX_ANISOTROPY * lo || offset > MAGCAL_MAX_OFFSET)
+    {
+        return FALSE;
+    }
+
+    float M[3][3], FM[3][3];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            M[i][j] = V[i][0] * root[0] * V[j][0]
+                    + V[i][1] * root[1] * V[j][1]
+                    + V[i][2] * root[2] * V[j][2];
+        }
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            FM[i][j] = field_norm * (frame[i][0] * M[0][j] + frame[i][1] * M[1][j] + frame[i][2] * M[2][j]);
+        }
+    }
+
+    CAL_Affine cal;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            cal.A[i][j] = FM[i][j] / MAGCAL_RAW_SCALE;
+        }
+        cal.b[i] = -(FM[i][0] * center[0] + FM[i][1] * center[1] + FM[i][2] * center[2]);
+    }
+    CAL_Set(CAL_MAG, &cal);
+    updates++;
+    return TRUE;
+}
+
+
+/*  FUNCTIONS   */
+/** MAGCAL_Init(fieldNorm)
+ *
+ * Resets the fit and takes the axis frame from the current CAL_MAG map.
+ */
+void MAGCAL_Init(float fieldNorm)
+{
+    CAL_Affine cal;
+    CAL_Get(CAL_MAG, &cal);
+    polar_rotation(cal.A, frame);
+    field_norm = fieldNorm;
+
+    memset(theta, 0, sizeof(theta));
+    memset(P, 0, sizeof(P));
+    for (int i = 0; i < MAGCAL_PARAMS; i++)
+    {
+        P[i][i] = MAGCAL_P_INIT;
+    }
+    memset(last_raw, 0, sizeof(last_raw));
+    accepted = 0;
+    updates = 0;
+    state = MAGCAL_IDLE;
+    step = 0;
+}
+
+/** MAGCAL_Update(raw)
+ *
+ * One RLS update (if the sample moved far enough from the last accepted one)
+ * plus at most one solve step, so the worst case is the RLS update plus the
+ * compose step.
+ */
+int8_t MAGCAL_Update(const int16_t raw[3])
+{
+    int8_t installed = FALSE;
+
+    // skip near-duplicate samples, a stationary device would otherwise
+    // flood the fit with one direction
+    int32_t d = abs(raw[0] - last_raw[0]) + abs(raw[1] - last_raw[1]) + abs(raw[2] - last_raw[2]);
+    if (d >= MAGCAL_MIN_STEP)
+    {
+        float x = raw[0] * (1.0f / MAGCAL_RAW_SCALE);
+        float y = raw[1] * (1.0f / MAGCAL_RAW_SCALE);
+        float z = raw[2] * (1.0f / MAGCAL_RAW_SCALE);
+        float phi[MAGCAL_PARAMS] = {
+            x * x, y * y, z * z,
+            2.0f * x * y, 2.0f * x * z, 2.0f * y * z,
+            2.0f * x, 2.0f * y, 2.0f * z
+        };
+        rls_update(phi);
+        memcpy(last_raw, raw, sizeof(last_raw));
+        accepted++;
+        if (state == MAGCAL_IDLE && accepted >= MAGCAL_MIN_SAMPLES
+                && (accepted % MAGCAL_SOLVE_INTERVAL) == 0)
+        {
+            state = MAGCAL_CENTER;
+        }
+    }
+
+    // one bounded step of the solve per call
+    switch (state)
+    {
+        case MAGCAL_CENTER:
+            step = 0;
+            state = solve_center() ? MAGCAL_ROTATE : MAGCAL_IDLE;
+            break;
+        case MAGCAL_ROTATE:
+            solve_rotate(step);
+            if (++step >= MAGCAL_JACOBI_STEPS)
+            {
+                state = MAGCAL_COMPOSE;
+            }
+            break;
+        case MAGCAL_COMPOSE:
+            installed = solve_compose();
+            state = MAGCAL_IDLE;
+            break;
+        default:
+            break;
+    }
+    return installed;
+}
+
+/** MAGCAL_GetUpdates()
+ *
+ * @return  (uint32_t) number of CAL_MAG maps installed since MAGCAL_Init()
+ */
+uint32_t MAGCAL_GetUpdates(void)
+{
+    return updates;
+}
+
+
+/** MAGCAL_TEST
+ *
+ * Uncomment the below "#define" to run the MAGCAL_TEST.
+ *
+ * SUCCESS - Tumble the IMU. After a few hundred samples "maps" starts counting
+ *           up and |mag| settles near the field norm in every orientation.
+ *           "max us" is the worst MAGCAL_Update() time.
+ */
+//#define MAGCAL_TEST
+#ifdef MAGCAL_TEST
+
+#include <Board.h>
+#include <BNO055.h>
+#include <timers.h>
+
+
+int main(void)
+{
+    BOARD_Init();
+    BNO055_Init();
+    TIMER_Init();
+    CAL_Init();
+    MAGCAL_Init(MAGCAL_FIELD_NORM);
+
+    uint32_t max_us = 0;
+    uint32_t n = 0;
+    while (TRUE)
+    {
+        int16_t raw[3] = {BNO055_ReadMagX(), BNO055_ReadMagY(), BNO055_ReadMagZ()};
+        uint32_t start = TIMERS_GetMicroSeconds();
+        MAGCAL_Update(raw);
+        uint32_t us = TIMERS_GetMicroSeconds() - start;
+        if (us > max_us)
+        {
+            max_us = us;
+        }
+
+        float mag[3];
+        CAL_Apply(CAL_MAG, raw, mag);
+        if (++n % 50 == 0)
+        {
+            printf("maps %lu, max us %lu, |mag| %.0f\r\n", (unsigned long) MAGCAL_GetUpdates(),
+                   (unsigned long) max_us, sqrtf(mag[0] * mag[0] + mag[1] * mag[1] + mag[2] * mag[2]));
+        }
+        HAL_Delay(20);
+    }
+}
+
+#endif  /*  MAGCAL_TEST    */
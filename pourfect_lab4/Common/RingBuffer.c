@@ -0,0 +1,197 @@
+/**
+ * @file    RingBuffer.c
+ *
+ * Wait-free single producer, single consumer ring buffer.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stm32f4xx_hal.h"
+#include <RingBuffer.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+// Order matters on both sides: the item must be in memory before head says
+// so, and must be copied out before tail gives the slot back. __DMB() orders
+// the accesses for the core and is a compiler barrier too.
+
+
+/*  PUBLIC FUNCTIONS    */
+/** RING_Init(ring, storage, item_size, capacity)
+ *
+ * Empties the ring and points it at storage. Call before the producer
+ * starts (before the interrupt is enabled).
+ *
+ * @param   ring        (RING_Buffer *) ring to set up
+ * @param   storage     (void *)        capacity * item_size bytes
+ * @param   item_size   (uint16_t)      bytes per item
+ * @param   capacity    (uint16_t)      items, a power of two
+ * @return  (int8_t)    SUCCESS, or ERROR if capacity is not a power of two
+ */
+int8_t RING_Init(RING_Buffer *ring, void *storage, uint16_t item_size, uint16_t capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 || item_size == 0)
+    {
+        return ERROR;
+    }
+    ring->data = storage;
+    ring->item_size = item_size;
+    ring->mask = capacity - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    return SUCCESS;
+}
+
+/** RING_Put(ring, item)
+ *
+ * Producer side. Copies one item in; a full ring keeps what it has and
+ * counts the item in ring->dropped.
+ *
+ * @param   ring    (RING_Buffer *) ring
+ * @param   item    (const void *)  item_size bytes
+ * @return  (int8_t)    SUCCESS, or ERROR if the ring was full
+ */
+int8_t RING_Put(RING_Buffer *ring, const void *item)
+{
+    uint32_t head = ring->head;
+    if (head - ring->tail > ring->mask)
+    {
+        ring->dropped++;
+        return ERROR;
+    }
+    memcpy(&ring->data[(head & ring->mask) * ring->item_size], item, ring->item_size);
+    __DMB();                            // item written before it is published
+    ring->head = head + 1;
+    return SUCCESS;
+}
+
+/** RING_Get(ring, item)
+ *
+ * Consumer side. Copies the oldest item out and frees its slot.
+ *
+ * @param   ring    (RING_Buffer *) ring
+ * @param   item    (void *)        item_size bytes, filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if the ring was empty
+ */
+int8_t RING_Get(RING_Buffer *ring, void *item)
+{
+    if (RING_Peek(ring, item) == ERROR)
+    {
+        return ERROR;
+    }
+    __DMB();                            // item read before the slot is handed back
+    ring->tail = ring->tail + 1;
+    return SUCCESS;
+}
+
+/** RING_Peek(ring, item)
+ *
+ * Consumer side. RING_Get() without freeing the slot.
+ *
+ * @param   ring    (RING_Buffer *) ring
+ * @param   item    (void *)        item_size bytes, filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if the ring was empty
+ */
+int8_t RING_Peek(RING_Buffer *ring, void *item)
+{
+    uint32_t tail = ring->tail;
+    if (ring->head == tail)
+    {
+        return ERROR;
+    }
+    __DMB();                            // head read before the item it published
+    memcpy(item, &ring->data[(tail & ring->mask) * ring->item_size], ring->item_size);
+    return SUCCESS;
+}
+
+/** RING_Count(ring)
+ *
+ * Items waiting. Exact for the consumer; the producer may add more at any
+ * time, so it is a lower bound.
+ *
+ * @param   ring    (const RING_Buffer *)   ring
+ * @return  (uint16_t)  items in the ring
+ */
+uint16_t RING_Count(const RING_Buffer *ring)
+{
+    uint32_t tail = ring->tail;
+    return (uint16_t) (ring->head - tail);
+}
+
+/** RING_Flush(ring)
+ *
+ * Consumer side. Drops every item waiting.
+ *
+ * @param   ring    (RING_Buffer *) ring
+ */
+void RING_Flush(RING_Buffer *ring)
+{
+    ring->tail = ring->head;
+}
+
+
+/** RING_TEST
+ *
+ * Uncomment the below "#define" to run the RING_TEST.
+ *
+ * SUCCESS - Every line ends in "ok": items come out in order across the
+ *           32-bit counter wrap, a full ring drops exactly the overflow, and
+ *           a bad capacity is refused.
+ */
+//#define RING_TEST
+#ifdef RING_TEST
+
+#include <Board.h>
+
+
+typedef struct {
+    uint32_t time_us;
+    int32_t value;
+} Event;
+
+int main(void)
+{
+    BOARD_Init();
+
+    static Event storage[8];
+    RING_Buffer ring;
+    Event e;
+    int8_t ok;
+
+    printf("capacity 6: %s\r\n", RING_Init(&ring, storage, sizeof(Event), 6) == ERROR ? "ok" : "FAIL");
+
+    RING_Init(&ring, storage, sizeof(Event), 8);
+    ring.head = ring.tail = 0xFFFFFFFC;             // wraps halfway through
+    ok = TRUE;
+    for (int32_t i = 0; i < 100; i++)
+    {
+        e.time_us = i;
+        e.value = -i;
+        RING_Put(&ring, &e);
+        if (RING_Count(&ring) != 1 || RING_Get(&ring, &e) == ERROR || e.value != -i)
+        {
+            ok = FALSE;
+        }
+    }
+    printf("in order: %s\r\n", ok && RING_Get(&ring, &e) == ERROR ? "ok" : "FAIL");
+
+    for (int32_t i = 0; i < 11; i++)
+    {
+        e.value = i;
+        RING_Put(&ring, &e);
+    }
+    ok = RING_Count(&ring) == 8 && ring.dropped == 3;
+    for (int32_t i = 0; i < 8; i++)
+    {
+        ok = ok && RING_Get(&ring, &e) == SUCCESS && e.value == i;
+    }
+    printf("full: %s\r\n", ok ? "ok" : "FAIL");
+
+    while (TRUE);
+}
+
+#endif  /*  RING_TEST    */
@@ -0,0 +1,118 @@
+/**
+ * @file    RingBuffer.h
+ *
+ * Single producer, single consumer ring buffer of fixed size items, for
+ * handing data from an interrupt to the main loop (or back) without
+ * disabling interrupts. Put and Get never wait and never block the other
+ * side: the producer only writes head, the consumer only writes tail, and
+ * both are 32-bit counters so every load and store is a single access.
+ *
+ * The capacity must be a power of two. One ring has exactly one producer
+ * and one consumer; two ISRs of the same NVIC priority count as one producer
+ * since they can't preempt each other.
+ *
+ *     static PING_Echo storage[16];
+ *     static RING_Buffer echoes;
+ *     RING_Init(&echoes, storage, sizeof(PING_Echo), 16);
+ *     ...
+ *     RING_Put(&echoes, &echo);            // in the ISR
+ *     while (RING_Get(&echoes, &echo) == SUCCESS) { ... }     // main loop
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef RINGBUFFER_H
+#define	RINGBUFFER_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+typedef struct {
+    uint8_t *data;                      // capacity * item_size bytes
+    uint16_t item_size;                 // bytes
+    uint16_t mask;                      // capacity - 1
+    volatile uint32_t head;             // items written, producer only
+    volatile uint32_t tail;             // items read, consumer only
+    volatile uint32_t dropped;          // Put() calls on a full ring, producer only
+} RING_Buffer;
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** RING_Init(ring, storage, item_size, capacity)
+ *
+ * Empties the ring and points it at storage. Call before the producer
+ * starts (before the interrupt is enabled).
+ *
+ * @param   ring        (RING_Buffer *) ring to set up
+ * @param   storage     (void *)        capacity * item_size bytes
+ * @param   item_size   (uint16_t)      bytes per item
+ * @param   capacity    (uint16_t)      items, a power of two
+ * @return  (int8_t)    SUCCESS, or ERROR if capacity is not a power of two
+ */
+int8_t RING_Init(RING_Buffer *ring, void *storage, uint16_t item_size, uint16_t capacity);
+
+/** RING_Put(ring, item)
+ *
+ * Producer side. Copies one item in; a full ring keeps what it has and
+ * counts the item in ring->dropped.
+ *
+ * @param   ring    (RING_Buffer *) ring
+ * @param   item    (const void *)  item_size bytes
+ * @return  (int8_t)    SUCCESS, or ERROR if the ring was full
+ */
+int8_t RING_Put(RING_Buffer *ring, const void *item);
+
+/** RING_Get(ring, item)
+ *
+ * Consumer side. Copies the oldest item out and frees its slot.
+ *
+ * @param   ring    (RING_Buffer *) ring
+ * @param   item    (void *)        item_size bytes, filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if the ring was empty
+ */
+int8_t RING_Get(RING_Buffer *ring, void *item);
+
+/** RING_Peek(ring, item)
+ *
+ * Consumer side. RING_Get() without freeing the slot.
+ *
+ * @param   ring    (RING_Buffer *) ring
+ * @param   item    (void *)        item_size bytes, filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if the ring was empty
+ */
+int8_t RING_Peek(RING_Buffer *ring, void *item);
+
+/** RING_Count(ring)
+ *
+ * Items waiting. Exact for the consumer; the producer may add more at any
+ * time, so it is a lower bound.
+ *
+ * @param   ring    (const RING_Buffer *)   ring
+ * @return  (uint16_t)  items in the ring
+ */
+uint16_t RING_Count(const RING_Buffer *ring);
+
+/** RING_Flush(ring)
+ *
+ * Consumer side. Drops every item waiting.
+ *
+ * @param   ring    (RING_Buffer *) ring
+ */
+void RING_Flush(RING_Buffer *ring);
+
+
+#endif  /*  RINGBUFFER_H    */
@@ -0,0 +1,128 @@
+/**
+ * @file    Scheduler.h
+ *
+ * Cooperative run-to-completion task scheduler on the TIM2 timestamp
+ * (timers.c). Tasks are plain functions registered with a period (or as one
+ * shots) and a priority; SCHED_Run() calls whatever is due, most urgent
+ * first, and when nothing is sleeps until the next task is due. A task runs to
+ * its end, so it must not block: anything that used to HAL_Delay() becomes a
+ * task period or a state kept between calls.
+ *
+ * Every call is timed with TIMERS_GetMicroSeconds(), SCHED_GetStats() gives
+ * the run count, total and worst run time and how late the task started.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef SCHEDULER_H
+#define	SCHEDULER_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define SCHED_MAX_TASKS 12
+#define SCHED_ONE_SHOT 0                // period of a task that runs once
+
+// priorities, lower runs first when several tasks are due
+#define SCHED_PRIORITY_SENSOR 0
+#define SCHED_PRIORITY_CONTROL 1
+#define SCHED_PRIORITY_UI 2
+#define SCHED_PRIORITY_BACKGROUND 3
+
+typedef void (*SCHED_Function)(void);
+
+typedef struct {
+    uint32_t runs;                      // calls so far
+    uint32_t total_us;                  // time spent in the task, wraps after ~71 minutes of CPU
+    uint32_t max_us;                    // longest single call
+    uint32_t max_late_ms;               // longest wait past the due time
+    uint32_t skipped;                   // periods dropped because the task was too late
+} SCHED_Stats;
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** SCHED_Init()
+ *
+ * Removes every task and clears the statistics. TIMER_Init() must have run.
+ */
+void SCHED_Init(void);
+
+/** SCHED_Add(function, period_ms, delay_ms, priority)
+ *
+ * Registers a task. It is first due delay_ms from now, then every period_ms;
+ * a period of SCHED_ONE_SHOT runs it once and frees the slot.
+ *
+ * @param   function    (SCHED_Function)    task body, must not block
+ * @param   period_ms   (uint32_t)          period, or SCHED_ONE_SHOT
+ * @param   delay_ms    (uint32_t)          time to the first run
+ * @param   priority    (uint8_t)           0 is the most urgent
+ * @return  (int8_t)    task id, or ERROR if the table is full
+ */
+int8_t SCHED_Add(SCHED_Function function, uint32_t period_ms, uint32_t delay_ms, uint8_t priority);
+
+/** SCHED_Remove(id)
+ *
+ * A task may remove itself.
+ *
+ * @param   id      (int8_t)    from SCHED_Add()
+ * @return  (int8_t)    SUCCESS, or ERROR if there is no such task
+ */
+int8_t SCHED_Remove(int8_t id);
+
+/** SCHED_SetPeriod(id, period_ms)
+ *
+ * Changes the period from the next run on.
+ *
+ * @param   id          (int8_t)    from SCHED_Add()
+ * @param   period_ms   (uint32_t)  new period, or SCHED_ONE_SHOT
+ * @return  (int8_t)    SUCCESS, or ERROR if there is no such task
+ */
+int8_t SCHED_SetPeriod(int8_t id, uint32_t period_ms);
+
+/** SCHED_RunPending()
+ *
+ * Runs every task that is due, most urgent first. A task that becomes due
+ * meanwhile goes ahead of the less urgent ones still waiting.
+ *
+ * @return  (uint8_t)   number of calls made
+ */
+uint8_t SCHED_RunPending(void);
+
+/** SCHED_Run()
+ *
+ * SCHED_RunPending() forever, sleeping until the next interrupt in between.
+ * Does not return.
+ */
+void SCHED_Run(void);
+
+/** SCHED_GetStats(id, stats)
+ *
+ * @param   id      (int8_t)        from SCHED_Add()
+ * @param   stats   (SCHED_Stats *) filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if there is no such task
+ */
+int8_t SCHED_GetStats(int8_t id, SCHED_Stats *stats);
+
+/** SCHED_PrintStats()
+ *
+ * Prints one line per task: runs, mean and worst run time, worst lateness,
+ * skipped periods and share of the CPU since SCHED_Init().
+ */
+void SCHED_PrintStats(void);
+
+
+#endif  /*  SCHEDULER_H   */
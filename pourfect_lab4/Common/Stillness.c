@@ -0,0 +1,192 @@
+/**
+ * @file    Stillness.c
+ *
+ * Startup stationary detection and gyro bias capture.
+ *
+ * @date    19 Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <Stillness.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define STILL_CHANNELS 6                // accel x, y, z then gyro x, y, z
+
+// Welford running statistics, m2 is the sum of squared deviations
+static float mean[STILL_CHANNELS];
+static float m2[STILL_CHANNELS];
+static uint16_t count;
+
+static float tolerance2;
+static uint16_t window_max;
+static STILL_Status status;
+
+
+/*  PRIVATE FUNCTIONS   */
+static void restart(void)
+{
+    for (int i = 0; i < STILL_CHANNELS; i++)
+    {
+        mean[i] = 0.0f;
+        m2[i] = 0.0f;
+    }
+    count = 0;
+}
+
+// TRUE if sample x of channel i is too far from the running mean
+static int8_t off_gate(int i, float x)
+{
+    float gate = i < 3 ? STILL_ACCEL_GATE : STILL_GYRO_GATE;
+    return count >= STILL_MIN_SAMPLES && fabsf(x - mean[i]) > gate;
+}
+
+
+/*  PUBLIC FUNCTIONS    */
+/** STILL_Init(tolerance, window)
+ *
+ * Restarts the statistics.
+ *
+ * @param   tolerance   (float)     gyro bias standard error to reach, counts
+ * @param   window      (uint16_t)  most samples to average before giving the
+ *                                  bias regardless of the tolerance
+ */
+void STILL_Init(float tolerance, uint16_t window)
+{
+    tolerance2 = tolerance * tolerance;
+    window_max = window < STILL_MIN_SAMPLES ? STILL_MIN_SAMPLES : window;
+    status = STILL_SETTLING;
+    restart();
+}
+
+/** STILL_Update(acc, gyro)
+ *
+ * Adds one pair of raw samples. Once STILL_CONVERGED is returned the
+ * statistics are frozen until STILL_Init().
+ *
+ * @param   acc     (int16_t[3])    raw accel x, y, z
+ * @param   gyro    (int16_t[3])    raw gyro x, y, z
+ * @return  (STILL_Status)  state after this sample
+ */
+STILL_Status STILL_Update(const int16_t acc[3], const int16_t gyro[3])
+{
+    if (status == STILL_CONVERGED)
+    {
+        return status;
+    }
+
+    float x[STILL_CHANNELS] = {acc[0], acc[1], acc[2], gyro[0], gyro[1], gyro[2]};
+    for (int i = 0; i < STILL_CHANNELS; i++)
+    {
+        if (off_gate(i, x[i]))
+        {
+            restart();
+            status = STILL_MOVING;
+            return status;
+        }
+    }
+
+    count++;
+    for (int i = 0; i < STILL_CHANNELS; i++)
+    {
+        float d = x[i] - mean[i];
+        mean[i] += d / count;
+        m2[i] += d * (x[i] - mean[i]);
+    }
+    status = STILL_SETTLING;
+    if (count < STILL_MIN_SAMPLES)
+    {
+        return status;
+    }
+
+    // var = m2 / (n - 1); slow drift or shaking that stays inside the gates
+    int8_t converged = TRUE;
+    for (int i = 0; i < STILL_CHANNELS; i++)
+    {
+        float var = m2[i] / (count - 1);
+        if (var > (i < 3 ? STILL_ACCEL_VAR_MAX : STILL_GYRO_VAR_MAX))
+        {
+            restart();
+            status = STILL_MOVING;
+            return status;
+        }
+        // standard error of the gyro means
+        if (i >= 3 && var > tolerance2 * count)
+        {
+            converged = FALSE;
+        }
+    }
+    if (converged || count >= window_max)
+    {
+        status = STILL_CONVERGED;
+    }
+    return status;
+}
+
+/** STILL_GetGyroBias(bias)
+ *
+ * @param   bias    (float[3])      mean raw gyro x, y, z over the still period
+ */
+void STILL_GetGyroBias(float bias[3])
+{
+    bias[0] = mean[3];
+    bias[1] = mean[4];
+    bias[2] = mean[5];
+}
+
+/** STILL_GetSamples()
+ *
+ * @return  (uint16_t) samples in the current still period
+ */
+uint16_t STILL_GetSamples(void)
+{
+    return count;
+}
+
+
+/** STILL_TEST
+ *
+ * Uncomment the below "#define" to run the STILL_TEST.
+ *
+ * SUCCESS - Leave the IMU on the bench: "converged" is printed after a few
+ *           seconds with a bias close to the CAL_GYRO bias of calgen. Nudge
+ *           the board while it averages and "moving" restarts the count.
+ */
+//#define STILL_TEST
+#ifdef STILL_TEST
+
+#include <Board.h>
+#include <BNO055.h>
+#include <timers.h>
+
+
+int main(void)
+{
+    BOARD_Init();
+    BNO055_Init();
+    TIMER_Init();
+    STILL_Init(STILL_TOLERANCE, STILL_WINDOW);
+
+    uint32_t start = TIMERS_GetMilliSeconds();
+    STILL_Status s = STILL_SETTLING;
+    while (s != STILL_CONVERGED)
+    {
+        int16_t acc[3] = {BNO055_ReadAccelX(), BNO055_ReadAccelY(), BNO055_ReadAccelZ()};
+        int16_t gyro[3] = {BNO055_ReadGyroX(), BNO055_ReadGyroY(), BNO055_ReadGyroZ()};
+        s = STILL_Update(acc, gyro);
+        if (s == STILL_MOVING)
+        {
+            printf("moving\r\n");
+        }
+        HAL_Delay(20);
+    }
+    float bias[3];
+    STILL_GetGyroBias(bias);
+    printf("converged: %u samples in %lu ms, bias %.2f, %.2f, %.2f\r\n", STILL_GetSamples(),
+           (unsigned long) (TIMERS_GetMilliSeconds() - start), bias[0], bias[1], bias[2]);
+    while (TRUE);
+}
+
+#endif  /*  STILL_TEST    */
@@ -0,0 +1,104 @@
+/**
+ * @file    Strike.h
+ *
+ * Piezo strike detection on the ADC scan stream. STRIKE_Init() starts the
+ * scan (ADC_ScanStart()) and looks at one channel of every finished block in
+ * the DMA interrupt, so nothing polls the ADC. A strike starts at the first
+ * sample at or above the threshold; its peak is the largest sample in the
+ * STRIKE_PEAK_US after that, and it is queued as soon as that window is
+ * over. The detector re-arms once the channel has stayed below the
+ * threshold for STRIKE_REARM_US, so the ringing after a hit is not counted
+ * as more hits. Until then STRIKE_Held() is TRUE, for callers that keep
+ * something going while the piezo is pressed.
+ *
+ *     STRIKE_Init(ADC_1, 55, 4000);
+ *     ...
+ *     STRIKE_Event strike;
+ *     while (STRIKE_Get(&strike) == SUCCESS) { ... }
+ *
+ * A strike is seen at the end of the block it falls in, up to
+ * ADC_SCAN_BLOCK / rate later (8 ms at 4 kHz); its time stamp is that of
+ * the sample that crossed the threshold.
+ *
+ * @date    19 Oct 2026
+ */
+
+#ifndef STRIKE_H
+#define	STRIKE_H
+
+#include <stdint.h>
+
+
+/*  MODULE-LEVEL DEFINITIONS, MACROS    */
+#define STRIKE_QUEUE 8                  // strikes waiting for STRIKE_Get(), a power of two
+#define STRIKE_PEAK_US 2000             // peak search after the threshold crossing
+#define STRIKE_REARM_US 20000           // quiet time before the next strike counts
+
+typedef struct {
+    uint32_t t_us;                      // threshold crossing, TIMERS_GetMicroSeconds() clock
+    uint16_t peak;                      // largest sample, 12 bit counts
+} STRIKE_Event;
+
+#ifndef FALSE
+#define FALSE ((int8_t) 0)
+#endif  /*  FALSE   */
+#ifndef TRUE
+#define TRUE ((int8_t) 1)
+#endif  /*  TRUE    */
+#ifndef ERROR
+#define ERROR ((int8_t) -1)
+#endif  /*  ERROR   */
+#ifndef SUCCESS
+#define SUCCESS ((int8_t) 1)
+#endif  /*  SUCCESS */
+
+
+/*  PROTOTYPES  */
+/** STRIKE_Init(channel, threshold, rate)
+ *
+ * Starts scanning the ADC at rate and watching channel. Takes the ADC block
+ * callback (ADC_SetBlockCallback()); ADC_Read() and ADC_GetBlock() still
+ * work for the other channels. ADC_Init() and TIMER_Init() must have run.
+ *
+ * @param   channel     (uint32_t)  piezo input [ADC_0, ADC_1, ..., ADC_5, POT]
+ * @param   threshold   (uint16_t)  12 bit counts
+ * @param   rate        (uint32_t)  scans per second, at least 1000 so the
+ *                                  peak window holds a couple of samples
+ * @return  (int8_t)    [SUCCESS, ERROR]
+ */
+int8_t STRIKE_Init(uint32_t channel, uint16_t threshold, uint32_t rate);
+
+/** STRIKE_SetThreshold(threshold)
+ *
+ * Takes effect from the next block.
+ *
+ * @param   threshold   (uint16_t)  12 bit counts
+ */
+void STRIKE_SetThreshold(uint16_t threshold);
+
+/** STRIKE_Get(event)
+ *
+ * Takes the oldest strike not read yet.
+ *
+ * @param   event   (STRIKE_Event *)    filled in
+ * @return  (int8_t)    SUCCESS, or ERROR if none is waiting
+ */
+int8_t STRIKE_Get(STRIKE_Event *event);
+
+/** STRIKE_Held()
+ *
+ * Whether the last strike is still going on: the channel was at or above
+ * the threshold less than STRIKE_REARM_US ago, as of the last block.
+ *
+ * @return  (int8_t)    [TRUE, FALSE]
+ */
+int8_t STRIKE_Held(void);
+
+/** STRIKE_GetMissed()
+ *
+ * @return  (uint32_t)  strikes lost because STRIKE_QUEUE were already waiting
+ */
+uint32_t STRIKE_GetMissed(void);
+
+
+#endif  /*  STRIKE_H    */
@@ -11,6 +11,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <uart.h>
+#include <RingBuffer.h>
 
 // Boolean defines for TRUE, FALSE, SUCCESS and ERROR
 #ifndef FALSE
@@ -25,15 +26,157 @@
 static uint8_t init_status_uart1 = FALSE;
 static uint8_t init_status_uart6 = FALSE;
 
+#define UART_RX_BUFFER 256 // bytes kept per uart until read, power of two
+#define UART_RX_MASK (UART_RX_BUFFER - 1)
+#define UART_RX_FRAMES 16 // frames kept per uart until read, power of two
+
+/* The DMA receives into data[] in circles, on its own. Positions are byte counts since init
+ * (they only grow), data[(count - origin) & UART_RX_MASK] holds byte number count. The
+ * interrupts (DMA half/full and idle line) only move written and, on an idle line, queue
+ * where the frame started and ended; everything else happens in the reader. */
+typedef struct {
+    uint32_t start, end;
+} Frame;
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    uint8_t data[UART_RX_BUFFER];
+    volatile uint32_t written; // bytes the DMA had written at its last interrupt
+    volatile uint32_t origin; // byte count at data[0] when the DMA last (re)started
+    uint32_t frame_end; // end of the last frame queued
+    uint32_t read; // bytes taken by the reader
+    Frame frame_storage[UART_RX_FRAMES];
+    RING_Buffer frames; // idle interrupt to Uart*_rxFrame()
+    UART_RxStats stats;
+} Rx;
+
+static Rx rx1 = {.huart = &huart1};
+static Rx rx6 = {.huart = &huart6};
+
+static Rx* rx_port(UART_HandleTypeDef *huart) {
+    if (huart == &huart1) {
+        return &rx1;
+    } else if (huart == &huart6) {
+        return &rx6;
+    }
+    return NULL;
+}
+
+/* starts the circular DMA at data[0], reception never stops after this */
+static void rx_start(Rx *r) {
+    r->origin = r->written;
+    r->frame_end = r->written;
+    HAL_UART_Receive_DMA(r->huart, r->data, UART_RX_BUFFER);
+    __HAL_UART_ENABLE_IT(r->huart, UART_IT_IDLE);
+}
+
+static void rx_init(Rx *r) {
+    r->written = 0;
+    r->read = 0;
+    UART_RxStats empty = {0};
+    r->stats = empty;
+    RING_Init(&r->frames, r->frame_storage, sizeof(Frame), UART_RX_FRAMES);
+    rx_start(r);
+}
+
+/* interrupt side, catches written up with the DMA. Runs at least every half buffer (DMA half
+ * and full transfer), so the DMA is never a whole lap ahead of the last position */
+static void rx_event(Rx *r) {
+    uint16_t pos = UART_RX_BUFFER - __HAL_DMA_GET_COUNTER(r->huart->hdmarx);
+    uint16_t last = (r->written - r->origin) & UART_RX_MASK;
+    r->written += (uint16_t) (pos - last) & UART_RX_MASK;
+}
+
+/* bytes received so far, up to where the DMA is right now */
+static uint32_t rx_received(Rx *r) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t written = r->written;
+    uint16_t pos = UART_RX_BUFFER - __HAL_DMA_GET_COUNTER(r->huart->hdmarx);
+    uint16_t last = (written - r->origin) & UART_RX_MASK;
+    __set_PRIMASK(primask);
+    return written + ((uint16_t) (pos - last) & UART_RX_MASK);
+}
+
+/* moves read past the bytes the DMA wrote over (or a restart threw away) before they were read */
+static void rx_skip_lost(Rx *r, uint32_t received) {
+    uint32_t oldest = received - UART_RX_BUFFER;
+    if ((int32_t) (r->origin - oldest) > 0) {
+        oldest = r->origin;
+    }
+    if ((int32_t) (oldest - r->read) > 0) {
+        r->stats.overruns += oldest - r->read;
+        r->read = oldest;
+    }
+}
+
+/* copies len bytes from position start, ERROR if the DMA got to them during the copy */
+static int8_t rx_copy(Rx *r, uint32_t start, uint8_t *dst, uint16_t len) {
+    uint32_t errors = r->stats.errors;
+    uint32_t origin = r->origin;
+    for (uint16_t i = 0; i < len; i++) {
+        dst[i] = r->data[(start + i - origin) & UART_RX_MASK];
+    }
+    uint32_t received = rx_received(r);
+    if (r->stats.errors != errors || received - start > UART_RX_BUFFER) {
+        rx_skip_lost(r, received);
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+static int8_t rx_bytes(Rx *r, uint8_t *data, uint16_t size) {
+    uint32_t received = rx_received(r);
+    rx_skip_lost(r, received);
+    if (received - r->read < size || rx_copy(r, r->read, data, size) == ERROR) {
+        return ERROR;
+    }
+    r->read += size;
+    return SUCCESS;
+}
+
+static uint16_t rx_available(Rx *r) {
+    uint32_t received = rx_received(r);
+    rx_skip_lost(r, received);
+    return received - r->read;
+}
+
+static int16_t rx_frame(Rx *r, uint8_t *frame, uint16_t size) {
+    Frame f;
+    while (RING_Get(&r->frames, &f) == SUCCESS) {
+        rx_skip_lost(r, rx_received(r));
+        if ((int32_t) (f.end - r->read) <= 0) {
+            continue; // already read as bytes, or lost and counted as overrun
+        }
+        if ((int32_t) (r->read - f.start) > 0 || f.end - f.start > size) {
+            r->stats.dropped++; // its start is gone, or it doesn't fit
+            r->read = f.end;
+            continue;
+        }
+        // bytes before its start, if any, belong to frames that didn't fit the queue
+        if (rx_copy(r, f.start, frame, f.end - f.start) == ERROR) {
+            continue;
+        }
+        r->read = f.end;
+        return f.end - f.start;
+    }
+    return 0;
+}
+
+static void rx_stats(Rx *r, UART_RxStats *stats) {
+    *stats = r->stats;
+    stats->dropped += r->frames.dropped;
+}
+
 /**
  * @Function Uart1_Init(Rate)
- * @param Rate - baudrate (must be between 9600 and 115200)
+ * @param Rate - baudrate (must be between UART_MIN_BAUD and UART_MAX_BAUD)
  * @return SUCCESS or ERROR
  * @brief  Initializes uart1 interface at specified baudrate
  * @author Adam Korycki, 2023.11.02 */
 int8_t Uart1_Init(int Rate) {
-    if ((Rate < 9600) ||(Rate > 115200)) { // check if baudrate is within limits
-        printf("baudrate must be between 9600 and 115200\r\n");
+    if ((Rate < UART_MIN_BAUD) ||(Rate > UART_MAX_BAUD)) { // check if baudrate is within limits
+        printf("baudrate must be between %d and %d\r\n", UART_MIN_BAUD, UART_MAX_BAUD);
         return ERROR;
     }
     if (init_status_uart1 == FALSE) {
@@ -49,6 +192,7 @@ int8_t Uart1_Init(int Rate) {
         {
             return ERROR;
         }
+        rx_init(&rx1); // receive in the background from now on
         init_status_uart1 = TRUE;
     }
     return SUCCESS;
@@ -58,16 +202,52 @@ int8_t Uart1_Init(int Rate) {
  * @Function Uart1_rx(uint8_t* data, uint8_t size)
  * @param data - pointer to received buffer
  * @param size - number of bytes to read from buffer
- * @return SUCCESS or ERROR
- * @brief  Reads data from the rx buffer for uart1.
+ * @return SUCCESS or ERROR (fewer than size bytes received so far, nothing is read)
+ * @brief  Reads data from the rx buffer for uart1. Bytes are received in the background
+ *         from Uart1_Init() on and kept in order until read, never blocks.
  * @author Adam Korycki, 2023.11.02 */
 int8_t Uart1_rx(uint8_t* data, uint16_t size) {
     if (init_status_uart1 == FALSE) {
         printf("Uart1 not yet initialized\r\n");
         return ERROR;
     }
-    HAL_UART_Receive_IT(&huart1, data, size);
-    return SUCCESS;
+    return rx_bytes(&rx1, data, size);
+}
+
+/**
+ * @Function Uart1_rxFrame(uint8_t* frame, uint16_t size)
+ * @param frame - buffer for one frame
+ * @param size - size of the buffer
+ * @return length of the oldest complete frame copied to frame, 0 if none is waiting
+ * @brief  A frame is the bytes between two idle lines (one byte time of silence), so a
+ *         sender that writes each message in one go gets it back whole and aligned. Frames
+ *         that were partly lost or are longer than size are dropped and counted. Don't mix
+ *         with Uart1_rx() on the same uart, bytes read one way are gone for the other. */
+int16_t Uart1_rxFrame(uint8_t* frame, uint16_t size) {
+    if (init_status_uart1 == FALSE) {
+        printf("Uart1 not yet initialized\r\n");
+        return ERROR;
+    }
+    return rx_frame(&rx1, frame, size);
+}
+
+/**
+ * @Function Uart1_rxStats(UART_RxStats* stats)
+ * @param stats - filled in with the receive counters of uart1
+ * @brief  ^ */
+void Uart1_rxStats(UART_RxStats* stats) {
+    rx_stats(&rx1, stats);
+}
+
+/**
+ * @Function Uart1_available(void)
+ * @return number of received bytes waiting in the rx buffer
+ * @brief  Uart1_rx() of up to this many bytes succeeds */
+uint16_t Uart1_available(void) {
+    if (init_status_uart1 == FALSE) {
+        return 0;
+    }
+    return rx_available(&rx1);
 }
 
 /**
@@ -88,13 +268,13 @@ int8_t Uart1_tx(uint8_t* data, uint16_t size) {
 
 /**
  * @Function Uart6_Init(Rate)
- * @param Rate - baudrate (must be between 9600 and 115200)
+ * @param Rate - baudrate (must be between UART_MIN_BAUD and UART_MAX_BAUD)
  * @return SUCCESS or ERROR
  * @brief  Initializes uart6 interface at specified baudrate
  * @author Adam Korycki, 2023.11.02 */
 int8_t Uart6_Init(int Rate) {
-    if ((Rate < 9600) ||(Rate > 115200)) { // check if baudrate is within limits
-        printf("baudrate must be between 9600 and 115200\r\n");
+    if ((Rate < UART_MIN_BAUD) ||(Rate > UART_MAX_BAUD)) { // check if baudrate is within limits
+        printf("baudrate must be between %d and %d\r\n", UART_MIN_BAUD, UART_MAX_BAUD);
         return ERROR;
     }
     if (init_status_uart6 == FALSE) {
@@ -110,6 +290,7 @@ int8_t Uart6_Init(int Rate) {
         {
             return ERROR;
         }
+        rx_init(&rx6); // receive in the background from now on
         init_status_uart6 = TRUE;
     }
     return SUCCESS;
@@ -119,16 +300,52 @@ int8_t Uart6_Init(int Rate) {
  * @Function Uart6_rx(uint8_t* data, uint8_t size)
  * @param data - pointer to received buffer
  * @param size - number of bytes to read from buffer
- * @return SUCCESS or ERROR
- * @brief  Reads data from the rx buffer for uart6.
+ * @return SUCCESS or ERROR (fewer than size bytes received so far, nothing is read)
+ * @brief  Reads data from the rx buffer for uart6. Bytes are received in the background
+ *         from Uart6_Init() on and kept in order until read, never blocks.
  * @author Adam Korycki, 2023.11.02 */
 int8_t Uart6_rx(uint8_t* data, uint16_t size) {
     if (init_status_uart6 == FALSE) {
-        printf("Uart1 not yet initialized\r\n");
+        printf("Uart6 not yet initialized\r\n");
         return ERROR;
     }
-    HAL_UART_Receive_IT(&huart6, data, size);
-    return SUCCESS;
+    return rx_bytes(&rx6, data, size);
+}
+
+/**
+ * @Function Uart6_rxFrame(uint8_t* frame, uint16_t size)
+ * @param frame - buffer for one frame
+ * @param size - size of the buffer
+ * @return length of the oldest complete frame copied to frame, 0 if none is waiting
+ * @brief  A frame is the bytes between two idle lines (one byte time of silence), so a
+ *         sender that writes each message in one go gets it back whole and aligned. Frames
+ *         that were partly lost or are longer than size are dropped and counted. Don't mix
+ *         with Uart6_rx() on the same uart, bytes read one way are gone for the other. */
+int16_t Uart6_rxFrame(uint8_t* frame, uint16_t size) {
+    if (init_status_uart6 == FALSE) {
+        printf("Uart6 not yet initialized\r\n");
+        return ERROR;
+    }
+    return rx_frame(&rx6, frame, size);
+}
+
+/**
+ * @Function Uart6_rxStats(UART_RxStats* stats)
+ * @param stats - filled in with the receive counters of uart6
+ * @brief  ^ */
+void Uart6_rxStats(UART_RxStats* stats) {
+    rx_stats(&rx6, stats);
+}
+
+/**
+ * @Function Uart6_available(void)
+ * @return number of received bytes waiting in the rx buffer
+ * @brief  Uart6_rx() of up to this many bytes succeeds */
+uint16_t Uart6_available(void) {
+    if (init_status_uart6 == FALSE) {
+        return 0;
+    }
+    return rx_available(&rx6);
 }
 
 /**
@@ -147,6 +364,52 @@ int8_t Uart6_tx(uint8_t* data, uint16_t size) {
     return SUCCESS;
 }
 
+/**
+ * @Function Uart_IdleHandler(UART_HandleTypeDef* huart)
+ * @param huart - &huart1 or &huart6
+ * @brief  Ends the current rx frame on an idle line. Called from USART1_IRQHandler() and
+ *         USART6_IRQHandler() ahead of HAL_UART_IRQHandler(), which ignores the idle flag */
+void Uart_IdleHandler(UART_HandleTypeDef* huart) {
+    Rx *r = rx_port(huart);
+    if (r == NULL || !__HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE)) {
+        return;
+    }
+    __HAL_UART_CLEAR_IDLEFLAG(huart);
+    rx_event(r);
+    if (r->written != r->frame_end) {
+        Frame f = {r->frame_end, r->written};
+        RING_Put(&r->frames, &f); // counted in frames.dropped when the reader is behind
+        r->stats.frames++;
+        r->frame_end = r->written;
+    }
+}
+
+/* circular DMA half and full transfer, only keeps track of the position */
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart) {
+    Rx *r = rx_port(huart);
+    if (r != NULL) {
+        rx_event(r);
+    }
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+    Rx *r = rx_port(huart);
+    if (r != NULL) {
+        rx_event(r);
+    }
+}
+
+/* overrun, noise or framing error: the HAL stops the DMA, start again. The frame it was in
+ * is corrupt so it is never queued, and bytes not read yet are thrown away with it */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    Rx *r = rx_port(huart);
+    if (r != NULL && huart->RxState == HAL_UART_STATE_READY) {
+        rx_event(r);
+        r->stats.errors++;
+        rx_start(r);
+    }
+}
+
 //#define UART_TEST
 #ifdef UART_TEST //UART TEST HARNESS
 
@@ -158,7 +421,8 @@ int8_t Uart6_tx(uint8_t* data, uint16_t size) {
 #include <uart.h>
 
 /* connect UART1 and UART6 together, 
- * if a classic chant is printed to std_out over uart2 then all is well */
+ * if a classic chant is printed to std_out over uart2 then all is well, one line per frame,
+ * and the counters at the end of each line stay at 0 */
 int main(void) {
     BOARD_Init();
 
@@ -171,8 +435,15 @@ int main(void) {
        while (TRUE) {
         sprintf(tx, "%d bottles of beer on the wall\r\n", beer);
         Uart6_tx(tx, strlen(tx));
-        Uart1_rx(rx, strlen(tx));
-        printf("%s", rx);
+        HAL_Delay(10); // ~3 ms on the wire at 115200
+        int16_t length = Uart1_rxFrame((uint8_t*) rx, sizeof(rx) - 1);
+        if (length > 2) {
+            UART_RxStats stats;
+            Uart1_rxStats(&stats);
+            rx[length - 2] = '\0'; // without the \r\n
+            printf("%s (dropped %lu, overruns %lu, errors %lu)\r\n", rx, (unsigned long) stats.dropped,
+                   (unsigned long) stats.overruns, (unsigned long) stats.errors);
+        }
         beer++;
         HAL_Delay(100);
        }
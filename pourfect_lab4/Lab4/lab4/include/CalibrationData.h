@@ -0,0 +1,44 @@
+/**
+ * @file    CalibrationData.h
+ *
+ * GENERATED by tools/calgen, do not edit. Regenerate with:
+ *
+ *     calgen --tumble pourfect_lab4/matlab/Lab4/BatchMisalignment/AccelMagTumbleNoCal.csv --gyro-still hhuan143/matlab/Lab3/gyro_10min.csv --accel-sign -1,-1,1 --mag-sign -1,-1,-1 -o pourfect_lab4/Lab4/lab4/include/CalibrationData.h
+ */
+
+#ifndef CALIBRATION_DATA_H
+#define CALIBRATION_DATA_H
+
+#include <Calibration.h>
+
+/** Accelerometer, raw -> g. */
+static const CAL_Affine CAL_ACCEL_DATA = {
+    {
+        {-0.00100231968f, 3.46586947e-06f, -9.07736425e-06f},
+        {5.04114612e-06f, -0.000993481376f, 2.91189601e-07f},
+        {1.23693191e-05f, -4.05912469e-07f, 0.000988588324f},
+    },
+    {-0.00477784525f, -0.0480985568f, 0.00463737666f}
+};
+
+/** Magnetometer, raw -> nT, misalignment to the accel frame folded in. */
+static const CAL_Affine CAL_MAG_DATA = {
+    {
+        {48.4578647f, 29.0575675f, 17.7695283f},
+        {-26.9072484f, 52.8705652f, -5.55449227f},
+        {14.0408971f, 2.10570252f, -57.7618081f},
+    },
+    {-45407.7678f, -9756.1426f, -44317.1189f}
+};
+
+/** Gyro, raw -> rate with the stationary bias removed. */
+static const CAL_Affine CAL_GYRO_DATA = {
+    {
+        {0.0133333333f, 0.0f, 0.0f},
+        {0.0f, 0.0133333333f, 0.0f},
+        {0.0f, 0.0f, 0.0133333333f},
+    },
+    {0.174069009f, 0.257741777f, -0.0728339996f}
+};
+
+#endif  /*  CALIBRATION_DATA_H  */
@@ -7,98 +7,146 @@
 #include "ClosedLoopIntegration.h"
 #include <Oled.h>
 #include <timers.h>
+#include <Calibration.h>
+#include <MagCal.h>
+#include <Scheduler.h>
+#include <Bringup.h>
+#include <LoopMonitor.h>
+#include <Format.h>
 
 
 #define OPEN_LOOP
 #define CLOSED_LOOP
 
+#define ESTIMATOR_PERIOD_MS 20 //50Hz sensor read and filter step
+#define DISPLAY_PERIOD_MS 100 //10Hz OLED, OledUpdate() is slow
+#define IMU_DEADLINE_MS 3000 //BNO055 power-on and reset waits are ~2.1 s
+#define OLED_DEADLINE_MS 500
+#define MONITOR_POLL_MS 100 //console check for the loop timing table ('l' prints, 'c' clears)
+
+static float yaw = 0, pitch = 0, roll = 0;
+#ifdef OPEN_LOOP
+static float open_yaw = 0, open_pitch = 0, open_roll = 0;
+#endif
+static int8_t estimator_loop, display_loop;
+
+static int8_t estimator_restart = TRUE; //the next step has no previous one to measure from
+static uint32_t estimator_last_us;
+
+//time step (s) since the previous estimator run, the nominal period after a restart
+static float estimator_dt(void) {
+    uint32_t now = TIMERS_GetMicroSeconds();
+    float dt = estimator_restart ? ESTIMATOR_PERIOD_MS / 1000.0f : (now - estimator_last_us) / 1000000.0f;
+    estimator_last_us = now;
+    estimator_restart = FALSE;
+    return dt;
+}
+
+//background one shot: the flash write stops everything for a second or two, so it runs after the estimator
+//and the other tasks, and the estimator restarts its time step instead of integrating the pause as one step
+void gyro_save_task(void) {
+    gyro_temp_save();
+    estimator_restart = TRUE;
+}
+
+//50Hz: read the sensors, calibrate and run the attitude filter
+void estimator_task(void) {
+     LOOPMON_Start(estimator_loop);
+     float deltaT = estimator_dt(); // Time step (s)
+     //get raw sensor readings and apply accelerometer calibration
+     collect_and_average_accelerometer(1);
+     int16_t acc_raw[3] = {x_avg_acc, y_avg_acc, z_avg_acc};
+     float acc_calibrated[3];
+     CAL_Apply(CAL_ACCEL, acc_raw, acc_calibrated);
+     //printf("\rcalibrated: %.2f, %.2f, %.2f\n", acc_calibrated[0], acc_calibrated[1], acc_calibrated[2]);
+
+     //get raw sensor readings and apply magnetometer calibration
+     collect_and_average_magnetometer(1);
+     int16_t mag_raw[3] = {x_avg_mag, y_avg_mag, z_avg_mag};
+     MAGCAL_Update(mag_raw); //keeps refining hard/soft iron as the board moves
+     float mag_calibrated[3];
+     CAL_Apply(CAL_MAG, mag_raw, mag_calibrated);
+     //printf("\r%.2f, %.2f, %.2f", mag_calibrated[0], mag_calibrated[1], mag_calibrated[2]);
+
+     //collect and calibrate gyro
+     collect_and_convert_gyroscope();
+     if (gyro_temp_update(acc_raw) && SCHED_Add(gyro_save_task, SCHED_ONE_SHOT, 0, SCHED_PRIORITY_BACKGROUND) == ERROR) {
+         gyro_save_task(); //task table full, save now rather than never
+     }
+
+     //printf("\rdegree: X: %.2f°, Y: %.2f°, Z: %.2f°", angle_x, angle_y, angle_z);
+
+     Vector3 gyros_deg = {gyro_dps[0], gyro_dps[1], gyro_dps[2]}; // calibrated gyro rate (deg/s), not the integrated angles
+     Vector3 gyros_rad = DegreesToRadians(gyros_deg);
+     Vector3 accels = {acc_calibrated[0], acc_calibrated[1], acc_calibrated[2]};  // Accelerometer data (g)
+     Vector3 accelInertial = {0.0f, 0.0f, -1.0f}; // Inertial gravity vector 
+     Vector3 mags = {mag_calibrated[0], mag_calibrated[1], mag_calibrated[2]};
+     Vector3 magInertial = {-23000.0f, 1000.0f, -41000.0f};  // Magnetic field points towards magnetic north
+
+    // Integrate orientation
+    IntegrateClosedLoop(gyros_rad, accels, mags, accelInertial, magInertial, deltaT, &yaw, &pitch, &roll);
+   // printf("------Closed Loop-----/nYaw: %.2f, Pitch: %.2f, Roll: %.2f\n", yaw, pitch, roll);
+
+    #ifdef OPEN_LOOP
+    float p = ((BNO055_ReadGyroX()) * M_PI / 180.0);   // covert Gyro of X into radians/sec
+    float q = ((BNO055_ReadGyroY()) * M_PI / 180.0);   // covert Gyro of Y into radians/sec
+    float r = ((BNO055_ReadGyroZ()) * M_PI / 180.0);  // covert Gyro of Z into radians/sec
+
+    OpenLoopIntegrate(p,q,r, &open_yaw, &open_pitch, &open_roll);
+    #endif
+    LOOPMON_End(estimator_loop);
+}
+
+//10Hz: closed loop angles on the OLED, open loop ones on the serial port
+void display_task(void) {
+    LOOPMON_Start(display_loop);
+    char OledString[50];
+    char yaw_text[12], pitch_text[12], roll_text[12];
+    FMT_Fixed(yaw_text, sizeof(yaw_text), yaw, 2, 0);
+    FMT_Fixed(pitch_text, sizeof(pitch_text), pitch, 2, 0);
+    FMT_Fixed(roll_text, sizeof(roll_text), roll, 2, 0);
+    sprintf(OledString, "Yaw: %s\nPitch: %s\nRoll: %s\n", yaw_text, pitch_text, roll_text);
+
+    OledDrawString(OledString);
+    OledUpdate();
+
+    #ifdef OPEN_LOOP
+    FMT_Fixed(yaw_text, sizeof(yaw_text), open_yaw, 2, 0);
+    FMT_Fixed(pitch_text, sizeof(pitch_text), open_pitch, 2, 0);
+    FMT_Fixed(roll_text, sizeof(roll_text), open_roll, 2, 0);
+    printf("\n------Open Loop-----\nYaw: %s, Pitch: %s, Roll: %s\n", yaw_text, pitch_text, roll_text);
+    #endif
+    LOOPMON_End(display_loop);
+}
+
+//OLED bring-up, no waits so it is done in one call
+int32_t oled_init(void){
+    OledInit();
+    return BRINGUP_READY;
+}
+
 int main(){
     BOARD_Init();
-    BNO055_Init();
     TIMER_Init();
-    OledInit();
-    float yaw = 0, pitch = 0, roll = 0;
-    char OledString[50];
-    float x_scale_factor = (ACC_X_FACEBACKWARD-ACC_X_FACEFOWARD) / -2;
-    float x_bias = (ACC_X_FACEFOWARD+(ACC_X_FACEBACKWARD)) / 2;
-
-    float y_scale_factor = (ACC_Y_FACELEFT-ACC_Y_FACERIGHT) / -2;
-    float y_bias = (ACC_Y_FACERIGHT+(ACC_Y_FACELEFT)) / 2;
-     
-    float z_scale_factor = (ACC_Z_FACEDOWN-ACC_Z_FACEUP) / -2;
-    float z_bias = (ACC_Z_FACEUP+(ACC_Z_FACEDOWN)) / 2;
-
-    float x_scale_factor_mag = (EXPECTED_MAG_SOUTH-EXPECTED_MAG_NORTH) / (MAG_X_SOUTH-MAG_X_NORTH);
-    float x_bias_mag = EXPECTED_MAG_NORTH - (x_scale_factor_mag*MAG_X_NORTH);
- 
-    float y_scale_factor_mag = (EXPECTED_MAG_SOUTH-EXPECTED_MAG_NORTH) / (MAG_Y_SOUTH-MAG_Y_NORTH);
-    float y_bias_mag = EXPECTED_MAG_NORTH - (y_scale_factor_mag*MAG_Y_NORTH);
-
-    float z_scale_factor_mag = (EXPECTED_MAG_DOWN-EXPECTED_MAG_UP) / (MAG_Z_FACEDOWN-MAG_Z_FACEUP);
-    float z_bias_mag = EXPECTED_MAG_UP - (z_scale_factor_mag*MAG_Z_FACEUP);
-
-    while(1){
-         //2 point calibration for accelerometer, calcualting bias and scale factor
-         collect_and_average_accelerometer(1);
-         float x_calibrated = (x_avg_acc - x_bias) / x_scale_factor;
-         //printf("x: %.2f, %.2f\n", x_scale_factor, x_bias);
-         float y_calibrated = (y_avg_acc - y_bias) / y_scale_factor;
-         //printf("y: %.2f, %.2f\n", y_scale_factor, y_bias);
-         float z_calibrated = (z_avg_acc - z_bias) / z_scale_factor;
-         //printf("z: %.2f, %.2f\n", z_scale_factor, z_bias);
-         
-         //printf("\rcalibrated: %.2f, %.2f, %.2f\n", x_calibrated, y_calibrated, z_calibrated);
- 
-         //get raw sensor readings
-         collect_and_average_magnetometer(1);
- 
-         //2 point calibrations for the magnetometer
-         float x_calibrated_mag = (x_scale_factor_mag*x_avg_mag) + x_bias_mag;
-         //printf("x: %.2f, %.2f\n", x_scale_factor_mag, x_bias_mag);
-         float y_calibrated_mag = (y_scale_factor_mag*y_avg_mag) + y_bias_mag;
-         //printf("y: %.2f, %.2f\n", y_scale_factor_mag, y_bias_mag);
- 
-         float z_calibrated_mag = (z_scale_factor_mag*z_avg_mag) + z_bias_mag;
-         //printf("z: %.2f, %.2f\n", z_scale_factor_mag, z_bias_mag);
-         
-         //printf("\r%.2f, %.2f, %.2f", x_calibrated_mag, y_calibrated_mag, z_calibrated_mag);
-         
-         //collect and calibrate gyro, all previous code may need to be uncommented due to timing
-         collect_and_convert_gyroscope();
-
-
-
-         //printf("\rdegree: X: %.2f°, Y: %.2f°, Z: %.2f°", angle_x, angle_y, angle_z);
-         
-         Vector3 gyros_deg = {angle_x, angle_y, angle_z}; // Gyroscope data (rad/s)
-         //printf("Gyro: %.2f, %.2f, %.2f\n", angle_x, angle_y, angle_z);
-         Vector3 gyros_rad = DegreesToRadians(gyros_deg);
-         Vector3 accels = {x_calibrated, y_calibrated, z_calibrated};  // Accelerometer data (g)
-         Vector3 accelInertial = {0.0f, 0.0f, -1.0f}; // Inertial gravity vector 
-         Vector3 mags = {x_calibrated_mag, y_calibrated_mag, z_calibrated_mag};
-         Vector3 magInertial = {-23000.0f, 1000.0f, -41000.0f};  // Magnetic field points towards magnetic north
-         float deltaT = 0.02f; // Time step (s)
- 
-        // Integrate orientation
-        IntegrateClosedLoop(gyros_rad, accels, mags, accelInertial, magInertial, deltaT, &yaw, &pitch, &roll);
-       // printf("------Closed Loop-----/nYaw: %.2f, Pitch: %.2f, Roll: %.2f\n", yaw, pitch, roll);
-
-        sprintf(OledString, "Yaw: %.2f\nPitch: %.2f\nRoll: %.2f\n", yaw, pitch, roll);
-
-        OledDrawString(OledString);
-        OledUpdate();
-
-        #ifdef OPEN_LOOP
-        float p = ((BNO055_ReadGyroX()) * M_PI / 180.0);   // covert Gyro of X into radians/sec
-        float q = ((BNO055_ReadGyroY()) * M_PI / 180.0);   // covert Gyro of Y into radians/sec
-        float r = ((BNO055_ReadGyroZ()) * M_PI / 180.0);  // covert Gyro of Z into radians/sec
-
-        OpenLoopIntegrate(p,q,r, &yaw, &pitch, &roll);
-        printf("\n------Open Loop-----\nYaw: %.2f, Pitch: %.2f, Roll: %.2f\n", yaw, pitch, roll);
-        #endif
-
-
-
-        HAL_Delay(20);
+    //the OLED is set up while the BNO055 is still in its power-on waits
+    BRINGUP_Init();
+    BRINGUP_Add("imu", BNO055_InitStep, IMU_DEADLINE_MS);
+    BRINGUP_Add("oled", oled_init, OLED_DEADLINE_MS);
+    if (BRINGUP_Run() != SUCCESS) {
+        printf("init failed\n");
     }
-}
\ No newline at end of file
+    BRINGUP_PrintReport();
+    calibration_init(); //reads the BNO055 temperature, needs the imu ready
+    MAGCAL_Init(MAGCAL_FIELD_NORM);
+    gyro_bias_init(); //keep the board still for a few seconds
+
+    //each must finish before its next period starts
+    estimator_loop = LOOPMON_Add("estimator", ESTIMATOR_PERIOD_MS * 1000, ESTIMATOR_PERIOD_MS * 1000);
+    display_loop = LOOPMON_Add("display", DISPLAY_PERIOD_MS * 1000, DISPLAY_PERIOD_MS * 1000);
+
+    SCHED_Init();
+    SCHED_Add(estimator_task, ESTIMATOR_PERIOD_MS, 0, SCHED_PRIORITY_SENSOR);
+    SCHED_Add(display_task, DISPLAY_PERIOD_MS, 0, SCHED_PRIORITY_UI);
+    SCHED_Add(LOOPMON_Poll, MONITOR_POLL_MS, 0, SCHED_PRIORITY_BACKGROUND);
+    SCHED_Run();
+}
@@ -0,0 +1,381 @@
+/*
+ * File:   allan.cpp
+ *
+ * Overlapping Allan deviation of the three gyro axes of a stationary capture,
+ * and the bias estimator bandwidth it suggests:
+ *
+ *     allan --rate 50 hhuan143/matlab/Lab3/gyro_10min.csv
+ *     allan gyro_10min.imucap --csv > adev.csv
+ *
+ * The rates are integrated once into angle prefix sums while the file is
+ * streamed, after which each cluster size m is a single pass
+ *
+ *     avar(m) = sum (th[k+2m] - 2 th[k+m] + th[k])^2 / (2 tau^2 (N - 2m))
+ *
+ * and the cluster sizes are spread over a thread pool.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CsvCapture.h"
+#include "CsvStream.h"
+#include "ImuCapture.h"
+#include "ThreadPool.h"
+
+// Allan deviation at the flicker floor is 0.664 B (IEEE Std 952).
+#define FLICKER_FACTOR 0.664
+#define DEG_PER_RAD (180.0 / M_PI)
+
+struct Options {
+    std::string in;
+    std::string names[3];
+    double rate = 0.0;
+    double gain = 180.0 / 13500.0;  // deg/s per LSB, as in the Lab4 apps
+    double kp = 5.0;                // Kp_a in ClosedLoopIntegration.h
+    int perDecade = 10;
+    unsigned threads = 0;
+    bool csv = false;
+};
+
+// Integrated angle of the three axes after sample i, in deg.
+struct Angle {
+    double v[3];
+};
+
+struct Point {
+    std::uint64_t m;
+    double tau;
+    double adev[3];
+};
+
+static void Usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s [options] gyro.csv|gyro.imucap\n"
+        "  --gyro a,b,c        CSV columns for gx, gy, gz (default: first three)\n"
+        "  --rate HZ           sample rate (default: from the capture, else 50)\n"
+        "  --gyro-gain G       deg/s per LSB for raw data (default 180/13500)\n"
+        "  --kp K              proportional gain the Ki suggestion is for (default 5)\n"
+        "  --per-decade N      cluster sizes per decade (default 10)\n"
+        "  --threads N         worker threads (default: all cores)\n"
+        "  --csv               print the table as CSV\n",
+        prog);
+}
+
+static bool ParseTriad(const char *s, std::string *names) {
+    int k = 0;
+    std::string cur;
+    for (const char *p = s;; p++) {
+        if (*p == ',' || *p == '\0') {
+            if (k == 3) {
+                return false;
+            }
+            names[k++] = cur;
+            cur.clear();
+            if (*p == '\0') {
+                break;
+            }
+        } else {
+            cur.push_back(*p);
+        }
+    }
+    return k == 3;
+}
+
+static bool ParseArgs(int argc, char **argv, Options &o) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a[0] != '-') {
+            o.in = a;
+            continue;
+        }
+        if (a == "--csv") {
+            o.csv = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *next = argv[++i];
+        if (a == "--gyro") { if (!ParseTriad(next, o.names)) return false; }
+        else if (a == "--rate") o.rate = std::atof(next);
+        else if (a == "--gyro-gain") o.gain = std::atof(next);
+        else if (a == "--kp") o.kp = std::atof(next);
+        else if (a == "--per-decade") o.perDecade = std::atoi(next);
+        else if (a == "--threads") o.threads = (unsigned)std::atoi(next);
+        else return false;
+    }
+    return !o.in.empty() && o.perDecade > 0;
+}
+
+/**
+ * Integrates one sample into the prefix sums. The running sum is compensated
+ * (Kahan) so that hours of a biased gyro don't eat the short-tau resolution.
+ */
+class Integrator {
+public:
+    explicit Integrator(std::vector<Angle> &theta) : theta_(theta) {
+        theta_.assign(1, Angle{{0.0, 0.0, 0.0}});
+    }
+
+    void Add(const double w[3], double dt) {
+        Angle a;
+        for (int k = 0; k < 3; k++) {
+            double y = w[k] * dt - carry_[k];
+            double t = sum_[k] + y;
+            carry_[k] = (t - sum_[k]) - y;
+            sum_[k] = t;
+            a.v[k] = t;
+        }
+        theta_.push_back(a);
+    }
+
+private:
+    std::vector<Angle> &theta_;
+    double sum_[3] = {0.0, 0.0, 0.0};
+    double carry_[3] = {0.0, 0.0, 0.0};
+};
+
+// Loads the capture as rates in deg/s into the prefix sums, returns the rate.
+static bool Load(const Options &o, std::vector<Angle> &theta, double &rate, std::string &err) {
+    Integrator integ(theta);
+    double w[3];
+    rate = o.rate;
+
+    if (IsCapture(o.in)) {
+        CaptureReader in;
+        if (!in.Open(o.in, err)) {
+            return false;
+        }
+        const CaptureHeader &h = in.Header();
+        if ((h.channels & CAPTURE_GYRO) != CAPTURE_GYRO) {
+            err = o.in + ": no gyro channels";
+            return false;
+        }
+        double scale[3];
+        for (int k = 0; k < 3; k++) {
+            int c = 6 + k;
+            scale[k] = h.scale[c];
+            if (h.units[c] == CAPTURE_RAW) scale[k] *= o.gain;
+            else if (h.units[c] == CAPTURE_RAD_S) scale[k] *= DEG_PER_RAD;
+            else if (h.units[c] != CAPTURE_DEG_S) {
+                err = o.in + ": gyro channels are not a rate";
+                return false;
+            }
+        }
+        if (rate <= 0.0) {
+            if (h.rateHz > 0.0f) {
+                rate = h.rateHz;
+            } else if (h.count > 1 && std::strcmp(h.timeUnits, "s") == 0 && h.t1 > h.t0) {
+                rate = (double)(h.count - 1) / (h.t1 - h.t0);
+            }
+        }
+        if (rate <= 0.0) {
+            rate = 50.0;
+            std::fprintf(stderr, "%s: no rate in the capture, assuming %g Hz\n", o.in.c_str(), rate);
+        }
+        theta.reserve(h.count + 1);
+        for (const ImuRecord &r : in.All()) {
+            for (int k = 0; k < 3; k++) {
+                w[k] = r.Channel(6 + k) * scale[k];
+            }
+            integ.Add(w, 1.0 / rate);
+        }
+        return true;
+    }
+
+    CsvStream::Columns cols;
+    const char *positional[3] = {"x", "y", "z"};
+    for (int k = 0; k < 3; k++) {
+        cols.name[6 + k] = o.names[k].empty() ? positional[k] : o.names[k].c_str();
+    }
+    CsvStream in;
+    if (!in.Open(o.in, cols, CSV_SPARSE_WINDOW, err)) {
+        return false;
+    }
+    if (rate <= 0.0) {
+        rate = 50.0;
+        std::fprintf(stderr, "%s: no --rate, assuming %g Hz\n", o.in.c_str(), rate);
+    }
+    for (const ImuRecord &r : in) {
+        for (int k = 0; k < 3; k++) {
+            w[k] = r.Channel(6 + k) * o.gain;
+        }
+        integ.Add(w, 1.0 / rate);
+    }
+    return true;
+}
+
+// Log spaced cluster sizes from 1 to the largest with two full clusters.
+static std::vector<std::uint64_t> ClusterSizes(std::uint64_t n, int perDecade) {
+    std::vector<std::uint64_t> m;
+    std::uint64_t last = (n - 1) / 2;
+    for (int i = 0;; i++) {
+        std::uint64_t v = (std::uint64_t)std::llround(std::pow(10.0, (double)i / perDecade));
+        if (v > last) {
+            break;
+        }
+        if (m.empty() || v != m.back()) {
+            m.push_back(v);
+        }
+    }
+    return m;
+}
+
+static void Deviation(const std::vector<Angle> &theta, double tau0, Point &p) {
+    std::uint64_t n = theta.size() - 1;     // samples
+    std::uint64_t m = p.m;
+    double sum[3] = {0.0, 0.0, 0.0};
+    const Angle *th = theta.data();
+    for (std::uint64_t k = 0; k + 2 * m <= n; k++) {
+        for (int a = 0; a < 3; a++) {
+            double d = th[k + 2 * m].v[a] - 2.0 * th[k + m].v[a] + th[k].v[a];
+            sum[a] += d * d;
+        }
+    }
+    p.tau = (double)m * tau0;
+    for (int a = 0; a < 3; a++) {
+        p.adev[a] = std::sqrt(sum[a] / (2.0 * p.tau * p.tau * (double)(n + 1 - 2 * m)));
+    }
+}
+
+/**
+ * Noise terms read off one axis:
+ *  arw, angle random walk: the -1/2 slope line at tau = 1 s, deg/sqrt(s)
+ *  bias, bias instability: the floor / 0.664, deg/s, at tauMin
+ *  rrw, rate random walk: the +1/2 slope line at tau = 3 s, 0 if not reached
+ */
+struct Noise {
+    double arw, bias, tauMin, rrw;
+};
+
+static Noise Characterize(const std::vector<Point> &pts, int axis) {
+    Noise r{0.0, 0.0, 0.0, 0.0};
+    std::size_t floor = 0;
+    for (std::size_t i = 1; i < pts.size(); i++) {
+        if (pts[i].adev[axis] < pts[floor].adev[axis]) {
+            floor = i;
+        }
+    }
+    r.bias = pts[floor].adev[axis] / FLICKER_FACTOR;
+    r.tauMin = pts[floor].tau;
+
+    // White noise region: a decade below the floor (at least the first point).
+    double sum = 0.0;
+    int count = 0;
+    for (std::size_t i = 0; i <= floor; i++) {
+        if (count == 0 || pts[i].tau <= r.tauMin / 10.0) {
+            sum += std::log(pts[i].adev[axis] * std::sqrt(pts[i].tau));
+            count++;
+        }
+    }
+    r.arw = std::exp(sum / count);
+
+    sum = 0.0;
+    count = 0;
+    for (std::size_t i = floor + 1; i < pts.size(); i++) {
+        if (pts[i].tau >= 3.0 * r.tauMin) {
+            sum += std::log(pts[i].adev[axis] * std::sqrt(3.0 / pts[i].tau));
+            count++;
+        }
+    }
+    if (count > 0) {
+        r.rrw = std::exp(sum / count);
+    }
+    return r;
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!ParseArgs(argc, argv, o)) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Angle> theta;
+    double rate;
+    std::string err;
+    if (!Load(o, theta, rate, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    std::uint64_t n = theta.size() - 1;
+    if (n < 8) {
+        std::fprintf(stderr, "%s: %llu samples is too short\n", o.in.c_str(), (unsigned long long)n);
+        return 1;
+    }
+    auto loaded = std::chrono::steady_clock::now();
+
+    std::vector<std::uint64_t> sizes = ClusterSizes(n, o.perDecade);
+    std::vector<Point> pts(sizes.size());
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        pts[i].m = sizes[i];
+    }
+    ThreadPool pool(o.threads);
+    ParallelFor(pool, pts.size(), [&](std::size_t i) { Deviation(theta, 1.0 / rate, pts[i]); });
+    auto done = std::chrono::steady_clock::now();
+
+    if (o.csv) {
+        std::printf("tau_s,m,adev_x,adev_y,adev_z\n");
+        for (const Point &p : pts) {
+            std::printf("%.6g,%llu,%.6g,%.6g,%.6g\n", p.tau, (unsigned long long)p.m,
+                        p.adev[0], p.adev[1], p.adev[2]);
+        }
+    } else {
+        // Relative error of the estimate, ~1 / sqrt(2 (N / m - 1)).
+        std::printf("%12s %10s %12s %12s %12s %7s\n", "tau (s)", "m", "x (deg/s)", "y (deg/s)", "z (deg/s)", "+-%");
+        for (const Point &p : pts) {
+            double clusters = (double)n / (double)p.m;
+            std::printf("%12.4g %10llu %12.4e %12.4e %12.4e %7.1f\n", p.tau, (unsigned long long)p.m,
+                        p.adev[0], p.adev[1], p.adev[2], 100.0 / std::sqrt(2.0 * (clusters - 1.0)));
+        }
+    }
+
+    FILE *out = o.csv ? stderr : stdout;
+    std::fprintf(out, "\n%s: %llu samples at %g Hz (%.1f s)\n", o.in.c_str(), (unsigned long long)n, rate,
+                 (double)n / rate);
+    const char axis[3] = {'x', 'y', 'z'};
+    double tauMin = 0.0;
+    for (int a = 0; a < 3; a++) {
+        Noise z = Characterize(pts, a);
+        std::fprintf(out, "  %c: ARW %.4g deg/sqrt(h), bias instability %.4g deg/h at tau %.4g s", axis[a],
+                     z.arw * 60.0, z.bias * 3600.0, z.tauMin);
+        if (z.rrw > 0.0) {
+            std::fprintf(out, ", RRW %.4g deg/h/sqrt(h)", z.rrw * 3600.0 * 60.0);
+        }
+        std::fprintf(out, "\n");
+        // The axis that turns up first limits how long the bias can be averaged.
+        if (a == 0 || z.tauMin < tauMin) {
+            tauMin = z.tauMin;
+        }
+    }
+
+    /*
+     * Per axis the closed loop filter is e' = -Kp e + (b - b_hat),
+     * b_hat' = -Ki e: poles at s^2 + Kp s + Ki, the slow (bias) one near
+     * Ki / Kp when Kp^2 >> 4 Ki. Its time constant should be about the
+     * averaging time where the Allan deviation bottoms out; shorter follows
+     * white noise, longer lets the bias wander away.
+     */
+    double ki = o.kp / tauMin;
+    std::fprintf(out, "suggested bias estimator: time constant %.4g s, bandwidth %.4g Hz, Ki = Kp / %.4g",
+                 tauMin, 1.0 / (2.0 * M_PI * tauMin), tauMin);
+    std::fprintf(out, " (Kp %g -> Ki %.4g)\n", o.kp, ki);
+    if (o.kp * o.kp < 4.0 * ki) {
+        std::fprintf(out, "  warning: Kp^2 < 4 Ki, the loop is underdamped; raise Kp\n");
+    }
+    if (tauMin >= pts.back().tau) {
+        std::fprintf(out, "  warning: the floor is at the end of the capture, record longer\n");
+    }
+
+    double tl = std::chrono::duration<double>(loaded - start).count();
+    double tc = std::chrono::duration<double>(done - loaded).count();
+    std::fprintf(stderr, "load %.3f s, %zu cluster sizes on %u threads %.3f s\n", tl, pts.size(), pool.Size(), tc);
+    return 0;
+}
@@ -0,0 +1,419 @@
+/*
+ * File:   boardsim.cpp
+ *
+ * Stands in for the Nucleo on a pseudo-terminal, so capd and telem2cap can
+ * be run end to end without hardware:
+ *
+ *     boardsim --link /tmp/board --mode binary --rate 50 --wait &
+ *     capd --port /tmp/board --dir captures
+ *
+ * The stream is what hhuan143/Lab4 sends: with TELEMETRY, raw, calibrated
+ * and attitude records every estimator step plus a loop record once a second
+ * (from ImuSim, so the numbers are a plausible trajectory); without it,
+ * display_task()'s "\rYaw: ...°, Pitch: ...°, Roll: ...°" ten times a
+ * second, byte for byte. Frames go through a model of
+ * the console ring (Common/Console.c with CONSOLE_DROP): the link drains it
+ * at --baud, a frame that does not fit is dropped and its sequence number is
+ * lost, like on the board. --drop and --corrupt add random losses and
+ * flipped bytes on top, and the counts are printed at the end to check the
+ * receiver's report against.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ImuSim.h"
+#include "TelemetryDecoder.h"
+
+#define CONSOLE_RING_BYTES 2048     // CONSOLE_TX_BUFFER in Common/Console.h
+#define DISPLAY_PERIOD_S 0.1        // DISPLAY_PERIOD_MS in hhuan143/Lab4
+
+struct Options {
+    bool text = false;
+    double rate = 50.0;
+    double seconds = 0.0;           // 0 runs until Ctrl-C
+    double speed = 1.0;
+    int baud = 115200;              // 0 for an unlimited link
+    double drop = 0.0;
+    double corrupt = 0.0;
+    double textEvery = 0.0;
+    double t0 = 0.0;
+    std::uint64_t seed = 1;
+    bool wait = false;
+    std::string link;
+};
+
+struct SimStats {
+    std::uint64_t frames = 0;       // records (or lines in text mode) sent
+    std::uint64_t ringDrops = 0;    // did not fit, like CONSOLE_DROP
+    std::uint64_t randomDrops = 0;
+    std::uint64_t corrupted = 0;
+    std::uint64_t textLines = 0;    // printf lines between binary frames
+    std::uint64_t textDrops = 0;    // of those, lost to the ring or --drop (no sequence number)
+    std::uint64_t bytes = 0;        // written to the pty
+    std::uint64_t refused = 0;      // bytes the pty had no room for (nobody reading)
+};
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void OnSignal(int) {
+    g_stop = 1;
+}
+
+static void Usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --link PATH         symlink to the pty, e.g. /tmp/board (removed on exit)\n"
+        "  --mode M            binary (TELEMETRY) or text (the printf angle display)\n"
+        "                      (default binary)\n"
+        "  --rate HZ           estimator rate (default 50)\n"
+        "  --seconds S         stop after S seconds of board time (default: Ctrl-C)\n"
+        "  --speed X           run X times faster than real time (default 1)\n"
+        "  --baud B            link speed the console ring drains at, 0 for no\n"
+        "                      limit (default 115200)\n"
+        "  --drop P            drop frames at random with probability P\n"
+        "  --corrupt P         flip a byte of a frame with probability P\n"
+        "  --text-every S      binary mode: print a text line every S seconds\n"
+        "  --t0 S              board clock at the start, e.g. 4290 to cross the\n"
+        "                      32 bit microsecond wrap soon\n"
+        "  --seed N            random seed (default 1)\n"
+        "  --wait              start once a reader has opened the pty, so it\n"
+        "                      sees the whole run\n",
+        prog);
+}
+
+static bool ParseArgs(int argc, char **argv, Options &o) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--wait") {
+            o.wait = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *next = argv[++i];
+        double v = std::atof(next);
+        if (a == "--link") o.link = next;
+        else if (a == "--mode") {
+            if (std::strcmp(next, "text") == 0) o.text = true;
+            else if (std::strcmp(next, "binary") == 0) o.text = false;
+            else return false;
+        }
+        else if (a == "--rate") o.rate = v;
+        else if (a == "--seconds") o.seconds = v;
+        else if (a == "--speed") o.speed = v;
+        else if (a == "--baud") o.baud = std::atoi(next);
+        else if (a == "--drop") o.drop = v;
+        else if (a == "--corrupt") o.corrupt = v;
+        else if (a == "--text-every") o.textEvery = v;
+        else if (a == "--t0") o.t0 = v;
+        else if (a == "--seed") o.seed = std::strtoull(next, nullptr, 10);
+        else return false;
+    }
+    return o.rate > 0.0 && o.speed > 0.0 && o.baud >= 0;
+}
+
+// Master side of a new pty in raw mode, non-blocking so a full pty (nobody
+// reading) loses bytes instead of stalling the board.
+static int OpenPty(std::string &slave, std::string &err) {
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        err = std::string("can't create a pty: ") + std::strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    slave = ptsname(fd);
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// Bytes waiting in the pty for the reader, through a slave descriptor.
+static int Unread(int slave) {
+    int n = 0;
+    return ioctl(slave, FIONREAD, &n) == 0 ? n : 0;
+}
+
+// Waits up to tries * 10 ms (0 for no limit) for the reader to take what was
+// written. A write takes a moment to show up in Unread(), so sleep first.
+static void WaitRead(int slave, int tries) {
+    for (int i = 0; !g_stop && (tries == 0 || i < tries); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (Unread(slave) == 0) {
+            return;
+        }
+    }
+}
+
+// Shepperd's method as in Common/Telemetry.c, w >= 0.
+static void Quaternion(const Mat3 &R, float q[4]) {
+    const double(*m)[3] = R.m;
+    double tr = m[0][0] + m[1][1] + m[2][2];
+    double w, x, y, z;
+    if (tr > 0.0) {
+        double s = 2.0 * std::sqrt(1.0 + tr);
+        w = 0.25 * s;
+        x = (m[1][2] - m[2][1]) / s;
+        y = (m[2][0] - m[0][2]) / s;
+        z = (m[0][1] - m[1][0]) / s;
+    } else if (m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+        double s = 2.0 * std::sqrt(1.0 + m[0][0] - m[1][1] - m[2][2]);
+        w = (m[1][2] - m[2][1]) / s;
+        x = 0.25 * s;
+        y = (m[0][1] + m[1][0]) / s;
+        z = (m[2][0] + m[0][2]) / s;
+    } else if (m[1][1] > m[2][2]) {
+        double s = 2.0 * std::sqrt(1.0 + m[1][1] - m[0][0] - m[2][2]);
+        w = (m[2][0] - m[0][2]) / s;
+        x = (m[0][1] + m[1][0]) / s;
+        y = 0.25 * s;
+        z = (m[1][2] + m[2][1]) / s;
+    } else {
+        double s = 2.0 * std::sqrt(1.0 + m[2][2] - m[0][0] - m[1][1]);
+        w = (m[0][1] - m[1][0]) / s;
+        x = (m[2][0] + m[0][2]) / s;
+        y = (m[1][2] + m[2][1]) / s;
+        z = 0.25 * s;
+    }
+    double sign = w < 0.0 ? -1.0 : 1.0;
+    q[0] = (float)(sign * w);
+    q[1] = (float)(sign * x);
+    q[2] = (float)(sign * y);
+    q[3] = (float)(sign * z);
+}
+
+/** The board's console ring and serial link, in board time. */
+class Link {
+public:
+    Link(int fd, const Options &o, SimStats &stats) : fd_(fd), o_(o), stats_(stats), rng_(o.seed ^ 0x5eed) {}
+
+    /** Lets the link drain up to board time t. */
+    void Advance(double t) {
+        if (o_.baud == 0) {
+            fill_ = 0.0;
+        } else {
+            fill_ = std::fmax(0.0, fill_ - (t - t_) * o_.baud / 10.0);
+        }
+        t_ = t;
+    }
+
+    /** Queues one frame or line; false if the ring (or --drop) lost it. */
+    bool Send(std::vector<std::uint8_t> frame, bool binary) {
+        if (fill_ + frame.size() > CONSOLE_RING_BYTES) {
+            (binary || o_.text ? stats_.ringDrops : stats_.textDrops)++;
+            return false;
+        }
+        if (o_.drop > 0.0 && rng_.Uniform() < o_.drop) {
+            (binary || o_.text ? stats_.randomDrops : stats_.textDrops)++;
+            return false;
+        }
+        if (binary && o_.corrupt > 0.0 && frame.size() > 2 && rng_.Uniform() < o_.corrupt) {
+            // Any byte but the delimiter, never to 0x00, which would split the frame.
+            std::size_t at = rng_.Next() % (frame.size() - 1);
+            std::uint8_t flip = (std::uint8_t)(1u << (rng_.Next() % 8));
+            if ((frame[at] ^ flip) == 0) {
+                flip = flip == 1 ? 2 : 1;
+            }
+            frame[at] ^= flip;
+            stats_.corrupted++;
+        }
+        fill_ += frame.size();
+        Write(frame.data(), frame.size());
+        return true;
+    }
+
+private:
+    void Write(const std::uint8_t *p, std::size_t n) {
+        while (n > 0) {
+            ssize_t w = write(fd_, p, n);
+            if (w < 0 && errno == EINTR) {
+                continue;
+            }
+            if (w <= 0) {
+                stats_.refused += n;
+                return;
+            }
+            stats_.bytes += (std::uint64_t)w;
+            p += w;
+            n -= (std::size_t)w;
+        }
+    }
+
+    int fd_;
+    const Options &o_;
+    SimStats &stats_;
+    Rng rng_;
+    double fill_ = 0.0;
+    double t_ = 0.0;
+};
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!ParseArgs(argc, argv, o)) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    std::string slave, err;
+    int fd = OpenPty(slave, err);
+    if (fd < 0) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    if (!o.link.empty()) {
+        unlink(o.link.c_str());
+        if (symlink(slave.c_str(), o.link.c_str()) != 0) {
+            std::fprintf(stderr, "can't link %s: %s\n", o.link.c_str(), std::strerror(errno));
+            close(fd);
+            return 1;
+        }
+    }
+    // Never read, only kept to see how much the reader has not taken yet.
+    int peek = open(slave.c_str(), O_RDONLY | O_NOCTTY);
+    std::printf("%s\n", o.link.empty() ? slave.c_str() : o.link.c_str());
+    std::fflush(stdout);
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    SimConfig config;
+    config.rate = o.rate;
+    config.seed = o.seed;
+    config.accelLsb = SIM_ACCEL_LSB;
+    config.magLsb = SIM_MAG_LSB;
+    config.gyroLsb = SIM_GYRO_LSB;
+    ImuSim sim(config);
+
+    SimStats stats;
+    Link link(fd, o, stats);
+    std::uint16_t seq = 0;
+    std::vector<std::uint8_t> frame;
+    auto send = [&](std::uint8_t type, std::uint32_t tUs, const void *payload, std::size_t size) {
+        TelemEncode(type, seq++, tUs, payload, size, frame);
+        return link.Send(frame, true);
+    };
+    auto print = [&](const char *text) {
+        return link.Send(std::vector<std::uint8_t>(text, text + std::strlen(text)), false);
+    };
+
+    if (o.wait) {
+        // A reader has opened the port once this byte is read or flushed.
+        std::uint8_t nothing = o.text ? '\n' : 0;
+        if (write(fd, &nothing, 1) == 1) {
+            WaitRead(peek, 0);
+        }
+    }
+
+    // TELEM_Init(): a lone delimiter ends whatever was on the line before.
+    if (!o.text) {
+        link.Send(std::vector<std::uint8_t>(1, 0), false);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t steps = o.seconds > 0.0 ? (std::uint64_t)std::llround(o.seconds * o.rate) : 0;
+    std::uint64_t perSecond = (std::uint64_t)std::llround(o.rate);
+    std::uint64_t textEvery = (std::uint64_t)std::llround(o.textEvery * o.rate);
+    std::uint64_t displayEvery = std::max<std::uint64_t>(1, (std::uint64_t)std::llround(DISPLAY_PERIOD_S * o.rate));
+    std::uint32_t runs = 0;
+    for (std::uint64_t k = 0; !g_stop && (steps == 0 || k < steps); k++) {
+        double t = k / o.rate;
+        std::this_thread::sleep_until(start + std::chrono::duration<double>(t / o.speed));
+        link.Advance(t);
+
+        ImuRecord raw;
+        SimTruth truth;
+        sim.Next(raw, &truth);
+        float acc[3], mag[3], gyro[3];
+        for (int i = 0; i < 3; i++) {
+            acc[i] = (float)(raw.Channel(i) / SIM_ACCEL_LSB);
+            mag[i] = (float)(raw.Channel(3 + i) / SIM_MAG_LSB);
+            gyro[i] = (float)(raw.Channel(6 + i) / SIM_GYRO_LSB);
+        }
+        std::uint32_t tUs = (std::uint32_t)(std::uint64_t)std::llround((o.t0 + t) * 1e6);
+        runs++;
+
+        if (o.text) {
+            if (k % displayEvery == 0) {
+                // FMT_Fixed(..., 2, -5) is "%-5.2f"; no newline, the next line overwrites it
+                char line[160];
+                std::snprintf(line, sizeof(line), "\rYaw: %-5.2f°, Pitch: %-5.2f°, Roll: %-5.2f°",
+                              truth.yaw, truth.pitch, truth.roll);
+                stats.frames += print(line);
+            }
+            continue;
+        }
+
+        TelemRaw r;
+        for (int i = 0; i < 3; i++) {
+            r.acc[i] = (std::int16_t)raw.Channel(i);
+            r.mag[i] = (std::int16_t)raw.Channel(3 + i);
+            r.gyro[i] = (std::int16_t)raw.Channel(6 + i);
+        }
+        stats.frames += send(TELEM_RAW, tUs, &r, sizeof(r));
+        TelemCalibrated c;
+        std::memcpy(c.acc, acc, sizeof(acc));
+        std::memcpy(c.mag, mag, sizeof(mag));
+        std::memcpy(c.gyro, gyro, sizeof(gyro));
+        stats.frames += send(TELEM_CALIBRATED, tUs, &c, sizeof(c));
+        TelemAttitude a;
+        Quaternion(truth.R, a.q);
+        for (int i = 0; i < 3; i++) {
+            a.bias[i] = (float)(truth.gyroBias[i] * M_PI / 180.0);
+        }
+        stats.frames += send(TELEM_ATTITUDE, tUs, &a, sizeof(a));
+        if ((k + 1) % perSecond == 0) {
+            TelemLoop l = {};
+            l.runs = runs;
+            l.maxPeriodUs = (std::uint32_t)(1e6 / o.rate);
+            l.maxExecUs = 1800;
+            stats.frames += send(TELEM_LOOP, tUs, &l, sizeof(l));
+        }
+        if (textEvery > 0 && (k + 1) % textEvery == 0) {
+            stats.textLines += print("estimator   50 Hz   0 misses\r\n");
+        }
+    }
+
+    // Unread input is thrown away when the master closes, give the reader a
+    // moment to take the rest.
+    WaitRead(peek, 100);
+    close(peek);
+    close(fd);
+    if (!o.link.empty()) {
+        unlink(o.link.c_str());
+    }
+    std::fprintf(stderr, "%llu %s sent, %llu bytes; dropped %llu (ring full) + %llu (--drop), corrupted %llu",
+                 (unsigned long long)stats.frames, o.text ? "lines" : "frames",
+                 (unsigned long long)stats.bytes, (unsigned long long)stats.ringDrops,
+                 (unsigned long long)stats.randomDrops, (unsigned long long)stats.corrupted);
+    if (stats.textLines + stats.textDrops > 0) {
+        std::fprintf(stderr, ", text lines %llu (+ %llu dropped)", (unsigned long long)stats.textLines,
+                     (unsigned long long)stats.textDrops);
+    }
+    if (stats.refused > 0) {
+        std::fprintf(stderr, ", %llu bytes not read in time", (unsigned long long)stats.refused);
+    }
+    std::fprintf(stderr, "\n");
+    return 0;
+}
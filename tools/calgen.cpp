@@ -0,0 +1,381 @@
+/*
+ * File:   calgen.cpp
+ *
+ * Calibration compiler. Reads raw accel/mag/gyro captures, runs the ellipsoid
+ * fit (accel and mag), the mag to accel misalignment and the gyro bias in one
+ * pass and writes a header of const CAL_Affine maps for Calibration.h:
+ *
+ *     calgen --accel acc_raw.csv --mag mag_raw.csv --gyro-still gyro_10min.csv \
+ *            -o include/CalibrationData.h
+ *
+ * The application then just does CAL_Set(CAL_ACCEL, &CAL_ACCEL_DATA) etc.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CsvCapture.h"
+#include "CsvStream.h"
+#include "ImuCapture.h"
+#include "ImuMath.h"
+
+#define DEFAULT_ITERATIONS 10
+#define DEFAULT_REJECT_SIGMA 3.0
+// Same gain the labs used: out = (raw - bias) * 180 / GYRO_SCALE.
+#define DEFAULT_GYRO_GAIN (180.0 / 13500.0)
+// |He| in nT, the norm of EXPECTED_MAG_NORTH/EAST/UP.
+#define DEFAULT_MAG_NORM 47613.0
+
+struct Options {
+    std::string accel, mag, tumble, gyro, out;
+    std::vector<std::string> accelCols, magCols;
+    int iterations = DEFAULT_ITERATIONS;
+    double reject = DEFAULT_REJECT_SIGMA;
+    double gyroGain = DEFAULT_GYRO_GAIN;
+    double magNorm = DEFAULT_MAG_NORM;
+    Vec3 accelSign{1, 1, 1}, magSign{1, 1, 1};
+    Vec3 accelRef{0.0, 0.0, 1.0};
+    Vec3 magRef{22770.0, 5329.0, 41510.2};
+    bool align = true;
+};
+
+struct Result {
+    Mat3 A = Mat3::Identity();
+    Vec3 b;
+    bool valid = false;
+    bool aligned = false;           // mag only: rotated into the accel frame
+};
+
+static void Usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s [options] -o CalibrationData.h\n"
+        "  --accel FILE        accel tumble, x,y,z raw rows (CSV or .imucap)\n"
+        "  --mag FILE          mag tumble, x,y,z raw rows\n"
+        "  --accel-cols a,b,c  header names to read --accel from (e.g. the raw\n"
+        "                      Accelx,Accely,Accelz of AccelrerometerPointCloud.csv)\n"
+        "  --mag-cols a,b,c    header names to read --mag from\n"
+        "  --tumble FILE       Teleplot tumble with Accel_x..Mag_z columns; used for\n"
+        "                      any of accel/mag not given and for misalignment\n"
+        "  --gyro-still FILE   stationary gyro capture, x,y,z raw rows\n"
+        "  --gyro-gain G       output units per gyro LSB (default %g)\n"
+        "  --mag-norm N        magnitude of the calibrated mag (default %g nT)\n"
+        "  --accel-sign s,s,s  axis signs applied after the fit (default 1,1,1)\n"
+        "  --mag-sign s,s,s    axis signs applied after the fit (default 1,1,1)\n"
+        "  --accel-ref x,y,z   inertial accel direction (default 0,0,1)\n"
+        "  --mag-ref x,y,z     inertial mag direction (default 22770,5329,41510.2)\n"
+        "  --no-align          skip the mag to accel misalignment\n"
+        "  --iter K            ellipsoid fit iterations (default %d)\n"
+        "  --reject S          drop samples S sigma off the sphere and refit, 0=off\n"
+        "                      (default %g)\n",
+        prog, DEFAULT_GYRO_GAIN, DEFAULT_MAG_NORM, DEFAULT_ITERATIONS, DEFAULT_REJECT_SIGMA);
+}
+
+static bool ParseTriple(const char *s, Vec3 &v) {
+    return std::sscanf(s, "%lf,%lf,%lf", &v.x, &v.y, &v.z) == 3;
+}
+
+static bool ParseNames(const char *s, std::vector<std::string> &names) {
+    names.clear();
+    std::string cur;
+    for (const char *p = s;; p++) {
+        if (*p == ',' || *p == '\0') {
+            names.push_back(cur);
+            cur.clear();
+            if (*p == '\0') {
+                break;
+            }
+        } else {
+            cur.push_back(*p);
+        }
+    }
+    return names.size() == 3;
+}
+
+static bool ParseArgs(int argc, char **argv, Options &o) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char *next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (a == "--no-align") {
+            o.align = false;
+            continue;
+        }
+        if (next == nullptr) {
+            return false;
+        }
+        i++;
+        if (a == "--accel") o.accel = next;
+        else if (a == "--mag") o.mag = next;
+        else if (a == "--accel-cols") { if (!ParseNames(next, o.accelCols)) return false; }
+        else if (a == "--mag-cols") { if (!ParseNames(next, o.magCols)) return false; }
+        else if (a == "--tumble") o.tumble = next;
+        else if (a == "--gyro-still") o.gyro = next;
+        else if (a == "-o") o.out = next;
+        else if (a == "--iter") o.iterations = std::atoi(next);
+        else if (a == "--reject") o.reject = std::atof(next);
+        else if (a == "--gyro-gain") o.gyroGain = std::atof(next);
+        else if (a == "--mag-norm") o.magNorm = std::atof(next);
+        else if (a == "--accel-sign") { if (!ParseTriple(next, o.accelSign)) return false; }
+        else if (a == "--mag-sign") { if (!ParseTriple(next, o.magSign)) return false; }
+        else if (a == "--accel-ref") { if (!ParseTriple(next, o.accelRef)) return false; }
+        else if (a == "--mag-ref") { if (!ParseTriple(next, o.magRef)) return false; }
+        else return false;
+    }
+    return !o.out.empty() && o.iterations > 0;
+}
+
+// Ellipsoid fit, then optionally drop the samples far off the unit sphere
+// (hand motion during the tumble) and fit again from the raw data.
+static bool FitSphere(const char *name, const std::vector<Vec3> &raw, const Options &o, Result &r) {
+    if (!EllipsoidFit(raw, o.iterations, r.A, r.b)) {
+        std::fprintf(stderr, "%s: ellipsoid fit failed (%zu samples)\n", name, raw.size());
+        return false;
+    }
+    double sum = 0.0, sum2 = 0.0;
+    for (const Vec3 &v : raw) {
+        double e = Norm(r.A * v + r.b) - 1.0;
+        sum += e;
+        sum2 += e * e;
+    }
+    double mean = sum / raw.size();
+    double sd = std::sqrt(std::max(0.0, sum2 / raw.size() - mean * mean));
+    std::size_t kept = raw.size();
+    if (o.reject > 0.0) {
+        std::vector<Vec3> inliers;
+        inliers.reserve(raw.size());
+        for (const Vec3 &v : raw) {
+            if (std::fabs(Norm(r.A * v + r.b) - 1.0 - mean) <= o.reject * sd) {
+                inliers.push_back(v);
+            }
+        }
+        if (inliers.size() < raw.size() && !EllipsoidFit(inliers, o.iterations, r.A, r.b)) {
+            std::fprintf(stderr, "%s: refit failed (%zu inliers)\n", name, inliers.size());
+            return false;
+        }
+        kept = inliers.size();
+    }
+    std::fprintf(stderr, "%s: %zu samples, %zu kept, norm error sd %.4f\n", name, raw.size(), kept, sd);
+    r.valid = true;
+    return true;
+}
+
+// Triad 0/1/2 (accel/mag/gyro) from a binary capture, or the named columns
+// of a CSV.
+static bool ReadTriad(const std::string &path, const std::vector<std::string> &cols, int triad,
+                      std::vector<Vec3> &out, std::string &err) {
+    if (!IsCapture(path)) {
+        return ReadCsvTriples(path, cols, out, err);
+    }
+    CaptureReader cap;
+    if (!cap.Open(path, err)) {
+        return false;
+    }
+    if ((cap.Header().channels & (7u << (3 * triad))) != (7u << (3 * triad))) {
+        err = path + ": capture has no such sensor";
+        return false;
+    }
+    out.clear();
+    out.reserve(cap.Size());
+    for (const ImuRecord &r : cap.All()) {
+        out.push_back({r.Channel(3 * triad), r.Channel(3 * triad + 1), r.Channel(3 * triad + 2)});
+    }
+    return true;
+}
+
+static void ApplySignScale(Result &r, const Vec3 &sign, double scale) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            r.A.m[i][j] *= sign[i] * scale;
+        }
+        r.b[i] *= sign[i] * scale;
+    }
+}
+
+static bool GyroBias(const std::vector<Vec3> &raw, const Options &o, Result &r) {
+    Vec3 mean, var;
+    for (const Vec3 &v : raw) {
+        mean = mean + v;
+    }
+    mean = (1.0 / raw.size()) * mean;
+    for (const Vec3 &v : raw) {
+        for (int k = 0; k < 3; k++) {
+            var[k] += (v[k] - mean[k]) * (v[k] - mean[k]);
+        }
+    }
+    // Clip the odd glitch sample, then average again.
+    if (o.reject > 0.0) {
+        Vec3 sum;
+        double n = 0.0;
+        for (const Vec3 &v : raw) {
+            bool in = true;
+            for (int k = 0; k < 3; k++) {
+                in = in && std::fabs(v[k] - mean[k]) <= o.reject * std::sqrt(var[k] / raw.size());
+            }
+            if (in) {
+                sum = sum + v;
+                n += 1.0;
+            }
+        }
+        if (n > 0.0) {
+            mean = (1.0 / n) * sum;
+        }
+    }
+    r.A = Mat3::Identity();
+    for (int k = 0; k < 3; k++) {
+        r.A.m[k][k] = o.gyroGain;
+        r.b[k] = -mean[k] * o.gyroGain;
+    }
+    std::fprintf(stderr, "gyro: %zu samples, bias %.3f %.3f %.3f LSB\n", raw.size(), mean.x, mean.y, mean.z);
+    r.valid = true;
+    return true;
+}
+
+// Round-trippable float literal, "0" becomes "0.0f".
+static std::string FloatLiteral(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    std::string s = buf;
+    if (s.find_first_of(".e") == std::string::npos) {
+        s += ".0";
+    }
+    return s + "f";
+}
+
+static void WriteAffine(FILE *f, const char *name, const char *what, const Result &r) {
+    std::fprintf(f, "/** %s */\n", what);
+    std::fprintf(f, "static const CAL_Affine %s = {\n    {\n", name);
+    for (int i = 0; i < 3; i++) {
+        std::fprintf(f, "        {%s, %s, %s},\n", FloatLiteral(r.A.m[i][0]).c_str(),
+                     FloatLiteral(r.A.m[i][1]).c_str(), FloatLiteral(r.A.m[i][2]).c_str());
+    }
+    std::fprintf(f, "    },\n    {%s, %s, %s}\n};\n\n", FloatLiteral(r.b.x).c_str(),
+                 FloatLiteral(r.b.y).c_str(), FloatLiteral(r.b.z).c_str());
+}
+
+static bool WriteHeader(const Options &o, int argc, char **argv,
+                        const Result &acc, const Result &mag, const Result &gyro) {
+    FILE *f = std::fopen(o.out.c_str(), "w");
+    if (f == nullptr) {
+        std::fprintf(stderr, "can't write %s\n", o.out.c_str());
+        return false;
+    }
+    std::fprintf(f, "/**\n * @file    CalibrationData.h\n *\n"
+                    " * GENERATED by tools/calgen, do not edit. Regenerate with:\n *\n *     calgen");
+    for (int i = 1; i < argc; i++) {
+        std::fprintf(f, " %s", argv[i]);
+    }
+    std::fprintf(f, "\n */\n\n#ifndef CALIBRATION_DATA_H\n#define CALIBRATION_DATA_H\n\n#include <Calibration.h>\n\n");
+    if (acc.valid) {
+        WriteAffine(f, "CAL_ACCEL_DATA", "Accelerometer, raw -> g.", acc);
+    }
+    if (mag.valid) {
+        WriteAffine(f, "CAL_MAG_DATA",
+                    mag.aligned ? "Magnetometer, raw -> nT, misalignment to the accel frame folded in."
+                                : "Magnetometer, raw -> nT.",
+                    mag);
+    }
+    if (gyro.valid) {
+        WriteAffine(f, "CAL_GYRO_DATA", "Gyro, raw -> rate with the stationary bias removed.", gyro);
+    }
+    std::fprintf(f, "#endif  /*  CALIBRATION_DATA_H  */\n");
+    std::fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!ParseArgs(argc, argv, o)) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    std::string err;
+    std::vector<Vec3> accRaw, magRaw, tumbleAcc, tumbleMag, gyroRaw;
+    if (!o.accel.empty() && !ReadTriad(o.accel, o.accelCols, 0, accRaw, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    if (!o.mag.empty() && !ReadTriad(o.mag, o.magCols, 1, magRaw, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    if (!o.tumble.empty() && IsCapture(o.tumble)) {
+        if (!ReadTriad(o.tumble, {}, 0, tumbleAcc, err) || !ReadTriad(o.tumble, {}, 1, tumbleMag, err)) {
+            std::fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+    } else if (!o.tumble.empty()) {
+        // One pass over all six columns so accel and mag stay paired.
+        CsvStream::Columns cols;
+        const char *names[6] = {"Accel_x", "Accel_y", "Accel_z", "Mag_x", "Mag_y", "Mag_z"};
+        for (int c = 0; c < 6; c++) {
+            cols.name[c] = names[c];
+        }
+        CsvStream in;
+        if (!in.Open(o.tumble, cols, CSV_SPARSE_WINDOW, err)) {
+            std::fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+        for (const ImuRecord &r : in) {
+            tumbleAcc.push_back({r.ax, r.ay, r.az});
+            tumbleMag.push_back({r.mx, r.my, r.mz});
+        }
+    }
+    if (!o.tumble.empty()) {
+        if (accRaw.empty()) accRaw = tumbleAcc;
+        if (magRaw.empty()) magRaw = tumbleMag;
+    }
+    if (!o.gyro.empty() && !ReadTriad(o.gyro, {}, 2, gyroRaw, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+
+    Result acc, mag, gyro;
+    if (!accRaw.empty()) {
+        if (!FitSphere("accel", accRaw, o, acc)) return 1;
+        ApplySignScale(acc, o.accelSign, 1.0);
+    }
+    if (!magRaw.empty()) {
+        if (!FitSphere("mag", magRaw, o, mag)) return 1;
+        ApplySignScale(mag, o.magSign, 1.0);
+    }
+
+    // Misalignment needs simultaneous accel and mag, i.e. a combined tumble.
+    if (o.align && acc.valid && mag.valid && !tumbleAcc.empty()) {
+        std::vector<Vec3> a(tumbleAcc.size()), m(tumbleMag.size());
+        for (std::size_t i = 0; i < a.size(); i++) {
+            a[i] = acc.A * tumbleAcc[i] + acc.b;
+            m[i] = mag.A * tumbleMag[i] + mag.b;
+        }
+        Mat3 Rmis = AlignPrimarySecondary(a, m, o.accelRef, o.magRef, 100);
+        Mat3 RT = Transpose(Rmis);
+        mag.A = RT * mag.A;
+        mag.b = RT * mag.b;
+        mag.aligned = true;
+
+        double dot = 0.0;
+        for (std::size_t i = 0; i < a.size(); i++) {
+            dot += Dot(Normalize(a[i]), Normalize(RT * m[i]));
+        }
+        double angle = std::acos(Dot(Normalize(o.accelRef), Normalize(o.magRef))) * 180.0 / M_PI;
+        std::fprintf(stderr, "align: mean accel/mag angle %.2f deg, reference %.2f deg\n",
+                     std::acos(dot / a.size()) * 180.0 / M_PI, angle);
+    }
+    if (mag.valid) {
+        ApplySignScale(mag, Vec3{1, 1, 1}, o.magNorm);
+    }
+
+    if (!gyroRaw.empty()) {
+        GyroBias(gyroRaw, o, gyro);
+    }
+    if (!acc.valid && !mag.valid && !gyro.valid) {
+        std::fprintf(stderr, "nothing to calibrate\n");
+        Usage(argv[0]);
+        return 2;
+    }
+    return WriteHeader(o, argc, argv, acc, mag, gyro) ? 0 : 1;
+}
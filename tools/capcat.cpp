@@ -0,0 +1,71 @@
+/*
+ * File:   capcat.cpp
+ *
+ * Prints a binary capture, or a time window of it, as CSV:
+ *
+ *     capcat tumble.imucap --from 10 --to 12
+ *     capcat tumble.imucap --info
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "ImuCapture.h"
+
+static const char *kNames[IMU_CHANNELS] = {"ax", "ay", "az", "mx", "my", "mz", "gx", "gy", "gz"};
+
+int main(int argc, char **argv) {
+    std::string path;
+    double from = -1e300, to = 1e300;
+    bool info = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--info") info = true;
+        else if (a == "--from" && i + 1 < argc) from = std::atof(argv[++i]);
+        else if (a == "--to" && i + 1 < argc) to = std::atof(argv[++i]);
+        else if (a[0] != '-') path = a;
+        else path.clear(), i = argc;
+    }
+    if (path.empty()) {
+        std::fprintf(stderr, "usage: %s file.imucap [--info] [--from T] [--to T]\n", argv[0]);
+        return 2;
+    }
+
+    CaptureReader cap;
+    std::string err;
+    if (!cap.Open(path, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    const CaptureHeader &h = cap.Header();
+    if (info) {
+        std::printf("source   %s\nrecords  %llu\ntime     %.6f .. %.6f %s\nrate     %g Hz\nchannels",
+                    h.source, (unsigned long long)h.count, h.t0, h.t1, h.timeUnits, h.rateHz);
+        for (int c = 0; c < IMU_CHANNELS; c++) {
+            if (h.channels & (1u << c)) {
+                std::printf(" %s", kNames[c]);
+            }
+        }
+        std::printf("\n");
+        return 0;
+    }
+
+    std::printf("t");
+    for (int c = 0; c < IMU_CHANNELS; c++) {
+        if (h.channels & (1u << c)) {
+            std::printf(",%s", kNames[c]);
+        }
+    }
+    std::printf("\n");
+    for (const ImuRecord &r : cap.Window(from, to)) {
+        std::printf("%.6f", r.t);
+        for (int c = 0; c < IMU_CHANNELS; c++) {
+            if (h.channels & (1u << c)) {
+                std::printf(",%g", r.Channel(c));
+            }
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
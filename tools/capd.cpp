@@ -0,0 +1,706 @@
+/*
+ * File:   capd.cpp
+ *
+ * Capture daemon: stays on the board's serial port (or a boardsim pty),
+ * stamps every record with the host clock as it arrives and writes rotating
+ * .imucap segments, with a throughput and loss report every few seconds:
+ *
+ *     capd --port /dev/ttyACM0 --dir /var/lib/capd --rotate-minutes 60 --keep 48
+ *     capd --port /tmp/board --dir captures --mode text --report 5
+ *
+ * The board's output is either the binary telemetry of Common/Telemetry.h
+ * or printf lines of numbers; --mode auto (the default) takes whichever
+ * shows up first after each (re)connect. Binary frames are checked as in
+ * telem2cap and the raw (or --calibrated) records are captured; the first
+ * nine numbers of a text line become the channels in order.
+ *
+ * A segment is written as NAME.imucap.part and renamed when it is closed, so
+ * readers only ever see whole captures. Segments rotate on size, age,
+ * SIGHUP, a reconnect and a board reset (with --clock board). When the port
+ * goes away (USB unplugged, boardsim restarted) capd closes the segment and
+ * tries again every second. SIGINT or SIGTERM closes the segment and exits.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ImuCapture.h"
+#include "SerialPort.h"
+#include "TelemetryDecoder.h"
+
+#define LINE_MAX_BYTES 256          // longer "lines" are binary or a lost newline
+#define TEXT_LOCK_LINES 3           // same-shaped lines in a row before --mode auto picks text
+#define RETRY_SECONDS 1.0
+
+enum Mode { MODE_AUTO, MODE_BINARY, MODE_TEXT };
+
+struct Options {
+    std::string port, dir = ".", prefix = "capd", log;
+    Mode mode = MODE_AUTO;
+    int baud = 115200;
+    bool calibrated = false;
+    bool boardClock = false;
+    double rotateMb = 64.0;
+    double rotateMinutes = 60.0;
+    int keep = 0;                   // finished segments to keep, 0 keeps all
+    double report = 10.0;
+    double seconds = 0.0;
+    double rate = 0.0;
+    bool once = false;
+    bool daemon = false;
+};
+
+#ifndef CAPD_TEST
+static volatile std::sig_atomic_t g_stop = 0;
+static volatile std::sig_atomic_t g_rotate = 0;
+
+static void OnSignal(int sig) {
+    if (sig == SIGHUP) {
+        g_rotate = 1;
+    } else {
+        g_stop = 1;
+    }
+}
+
+static void Usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s --port DEV [options]\n"
+        "  --port DEV          serial port, boardsim pty, byte stream file or -\n"
+        "  --baud B            serial port speed (default 115200)\n"
+        "  --mode M            auto, binary (telemetry) or text (printf lines)\n"
+        "  --calibrated        binary: capture the calibrated records, not raw counts\n"
+        "  --clock C           host (arrival time, default) or board (binary only)\n"
+        "  --dir DIR           where the segments go (default .)\n"
+        "  --prefix NAME       segment names, NAME-YYYYmmdd-HHMMSS.imucap (default capd)\n"
+        "  --rotate-mb M       start a new segment at M MB (default 64)\n"
+        "  --rotate-minutes N  ... or after N minutes (default 60), 0 for no limit\n"
+        "  --keep N            delete all but the newest N segments of this run\n"
+        "  --rate HZ           nominal rate for the capture headers\n"
+        "  --report S          throughput and loss report every S seconds (default 10)\n"
+        "  --seconds S         exit after S seconds\n"
+        "  --once              exit when the port closes instead of reconnecting\n"
+        "  --log FILE          append the reports to FILE instead of stderr\n"
+        "  --daemon            detach from the terminal (use with --log)\n",
+        prog);
+}
+
+static bool ParseArgs(int argc, char **argv, Options &o) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--calibrated") {
+            o.calibrated = true;
+            continue;
+        }
+        if (a == "--once") {
+            o.once = true;
+            continue;
+        }
+        if (a == "--daemon") {
+            o.daemon = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *next = argv[++i];
+        double v = std::atof(next);
+        if (a == "--port") o.port = next;
+        else if (a == "--baud") o.baud = std::atoi(next);
+        else if (a == "--mode") {
+            if (std::strcmp(next, "auto") == 0) o.mode = MODE_AUTO;
+            else if (std::strcmp(next, "binary") == 0) o.mode = MODE_BINARY;
+            else if (std::strcmp(next, "text") == 0) o.mode = MODE_TEXT;
+            else return false;
+        }
+        else if (a == "--clock") {
+            if (std::strcmp(next, "host") == 0) o.boardClock = false;
+            else if (std::strcmp(next, "board") == 0) o.boardClock = true;
+            else return false;
+        }
+        else if (a == "--dir") o.dir = next;
+        else if (a == "--prefix") o.prefix = next;
+        else if (a == "--rotate-mb") o.rotateMb = v;
+        else if (a == "--rotate-minutes") o.rotateMinutes = v;
+        else if (a == "--keep") o.keep = std::atoi(next);
+        else if (a == "--rate") o.rate = v;
+        else if (a == "--report") o.report = v;
+        else if (a == "--seconds") o.seconds = v;
+        else if (a == "--log") o.log = next;
+        else return false;
+    }
+    return !o.port.empty() && o.rotateMb > 0.0 && o.report > 0.0;
+}
+#endif  // CAPD_TEST
+
+// Seconds on the monotonic clock, for intervals.
+static double Monotonic() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Unix time that never steps back: wall clock at start plus monotonic time
+// since, so an NTP correction can't put records out of order.
+class HostClock {
+public:
+    HostClock()
+        : wall0_(std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count()),
+          mono0_(Monotonic()) {}
+
+    double Now() const { return wall0_ + (Monotonic() - mono0_); }
+
+private:
+    double wall0_, mono0_;
+};
+
+// Timestamped line on stderr (the log file with --log).
+static void Log(const char *fmt, ...) {
+    char when[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+    std::fprintf(stderr, "%s capd: ", when);
+    va_list args;
+    va_start(args, fmt);
+    std::vfprintf(stderr, fmt, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+    std::fflush(stderr);
+}
+
+/**
+ * Splits printf output at CR or LF and hands out the numbers of each line.
+ * A number starts a token ("Yaw: -12.50°," gives -12.5, "ax1" gives nothing).
+ */
+class LineDecoder {
+public:
+    struct Stats {
+        std::uint64_t lines = 0;        // non-empty lines
+        std::uint64_t numeric = 0;      // lines with at least one number
+        std::uint64_t bad = 0;          // too long or not printable (binary, a lost newline)
+    };
+
+    template <typename Fn> void Feed(const std::uint8_t *data, std::size_t n, Fn fn) {
+        for (std::size_t i = 0; i < n; i++) {
+            std::uint8_t c = data[i];
+            if (c == '\n' || c == '\r') {
+                Line(fn);
+                continue;
+            }
+            if (line_.size() < LINE_MAX_BYTES) {
+                line_.push_back((char)c);
+            } else {
+                overflow_ = true;
+            }
+            // Bytes from 0x80 up are UTF-8, the "°" of the Lab4 angle line.
+            binary_ = binary_ || (c < 0x20 && c != '\t') || c == 0x7F;
+        }
+    }
+
+    const Stats &GetStats() const { return stats_; }
+
+private:
+    template <typename Fn> void Line(Fn fn) {
+        bool skip = line_.empty();
+        if (!skip) {
+            stats_.lines++;
+        }
+        if (!skip && (overflow_ || binary_)) {
+            stats_.bad++;
+            skip = true;
+        }
+        if (!skip) {
+            double v[IMU_CHANNELS];
+            int count = 0;
+            line_.push_back('\0');
+            const char *p = line_.data();
+            const char *end = p + line_.size() - 1;
+            while (p < end && count < IMU_CHANNELS) {
+                bool start = p == line_.data() || !(std::isalnum((unsigned char)p[-1]) || p[-1] == '_' || p[-1] == '.');
+                char *stop = nullptr;
+                double x = start ? std::strtod(p, &stop) : 0.0;
+                if (start && stop != p && std::isfinite(x)) {
+                    v[count++] = x;
+                    p = stop;
+                } else {
+                    p++;
+                }
+            }
+            if (count > 0) {
+                stats_.numeric++;
+                fn(v, count);
+            }
+        }
+        line_.clear();
+        overflow_ = false;
+        binary_ = false;
+    }
+
+    std::vector<char> line_;
+    bool overflow_ = false;
+    bool binary_ = false;
+    Stats stats_;
+};
+
+/** Rotating .imucap segments. */
+class SegmentWriter {
+public:
+    explicit SegmentWriter(const Options &o) : o_(o) {}
+    ~SegmentWriter() { Close(); }
+
+    /** Header of the segments from now on; closes the current one if it differs. */
+    void SetHeader(const CaptureHeader &h) {
+        if (open_ && std::memcmp(&h, &header_, sizeof(h)) != 0) {
+            Close();
+        }
+        header_ = h;
+    }
+
+    /** Appends, starting a new segment when needed; false if it could not be written. */
+    bool Append(const ImuRecord &r) {
+        double now = Monotonic();
+        if (open_ && ((cap_.Count() + 1) * sizeof(CaptureRecord) > o_.rotateMb * 1e6
+                      || (o_.rotateMinutes > 0.0 && now - opened_ >= o_.rotateMinutes * 60.0))) {
+            Close();
+        }
+        if (!open_ && !Open(now)) {
+            return false;
+        }
+        if (cap_.Count() > 0 && r.t < lastT_) {
+            // Only a board clock goes back, the board was reset.
+            Log("board clock went back %.3f s, starting a new segment", lastT_ - r.t);
+            Close();
+            if (!Open(now)) {
+                return false;
+            }
+        }
+        lastT_ = r.t;
+        return cap_.Append(r);
+    }
+
+    /** Finishes the current segment: index, header, rename to .imucap. */
+    void Close() {
+        if (!open_) {
+            return;
+        }
+        open_ = false;
+        std::string err;
+        std::uint64_t count = cap_.Count();
+        if (!cap_.Close(err) && !err.empty()) {
+            Log("%s: %s", part_.c_str(), err.c_str());
+        }
+        if (count == 0) {
+            unlink(part_.c_str());
+            return;
+        }
+        if (std::rename(part_.c_str(), name_.c_str()) != 0) {
+            Log("can't rename %s: %s", part_.c_str(), std::strerror(errno));
+            return;
+        }
+        Log("closed %s, %llu records", name_.c_str(), (unsigned long long)count);
+        done_.push_back(name_);
+        while (o_.keep > 0 && (int)done_.size() > o_.keep) {
+            unlink(done_.front().c_str());
+            done_.pop_front();
+        }
+    }
+
+    const std::string &Name() const { return name_; }
+    std::uint64_t Count() const { return open_ ? cap_.Count() : 0; }
+    std::uint64_t Segments() const { return segments_; }
+
+private:
+    bool Open(double now) {
+        if (now < retryAt_) {
+            return false;
+        }
+        char stamp[32];
+        std::time_t wall = std::time(nullptr);
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&wall));
+        name_ = o_.dir + "/" + o_.prefix + "-" + stamp + ".imucap";
+        struct stat st;
+        for (int k = 1; stat(name_.c_str(), &st) == 0; k++) {
+            name_ = o_.dir + "/" + o_.prefix + "-" + stamp + "-" + std::to_string(k) + ".imucap";
+        }
+        part_ = name_ + ".part";
+        std::string err;
+        if (!cap_.Open(part_, header_, err)) {
+            Log("%s, retrying in %.0f s", err.c_str(), RETRY_SECONDS * 5);
+            retryAt_ = now + RETRY_SECONDS * 5;
+            return false;
+        }
+        open_ = true;
+        opened_ = now;
+        segments_++;
+        return true;
+    }
+
+    const Options &o_;
+    CaptureHeader header_ = CaptureDefaultHeader();
+    CaptureWriter cap_;
+    bool open_ = false;
+    double opened_ = 0.0;
+    double retryAt_ = 0.0;
+    double lastT_ = 0.0;
+    std::string name_, part_;
+    std::deque<std::string> done_;
+    std::uint64_t segments_ = 0;
+};
+
+/** Running totals over every connection, and the last report's values. */
+struct Totals {
+    std::uint64_t bytes = 0;
+    std::uint64_t frames = 0;       // telemetry frames or numeric lines
+    std::uint64_t records = 0;      // written to a segment
+    std::uint64_t unwritten = 0;    // decoded but not written (disk trouble)
+    std::uint64_t lost = 0;         // sequence gaps
+    std::uint64_t crcErrors = 0;
+    std::uint64_t malformed = 0;    // bad frames, text between frames, bad lines
+    std::uint64_t connects = 0;
+};
+
+/** One connection to the port: the decoders and what they have counted. */
+struct Session {
+    TelemetryDecoder telemetry;
+    LineDecoder lines;
+    std::uint64_t bytes = 0;
+    Mode mode = MODE_AUTO;
+    int textChannels = 0;
+    std::vector<ImuRecord> pending; // same-shaped lines in a row, held until MODE_AUTO picks text
+    std::uint64_t mismatched = 0;   // lines with a different number count
+    std::uint64_t bytesSeen = 0;    // values already added to the totals
+    TelemStats telemSeen;
+    LineDecoder::Stats linesSeen;
+    std::uint64_t mismatchedSeen = 0;
+};
+
+// Adds what the session counted since the last call to the totals.
+#ifndef CAPD_TEST
+static void Collect(Session &s, Totals &t) {
+    const TelemStats &ts = s.telemetry.Stats();
+    const LineDecoder::Stats &ls = s.lines.GetStats();
+    t.bytes += s.bytes - s.bytesSeen;
+    if (s.mode != MODE_TEXT) {
+        t.frames += ts.frames - s.telemSeen.frames;
+        t.lost += ts.lost - s.telemSeen.lost;
+        t.crcErrors += ts.crcErrors - s.telemSeen.crcErrors;
+        t.malformed += ts.malformed - s.telemSeen.malformed;
+    }
+    if (s.mode == MODE_TEXT) {
+        t.frames += ls.numeric - s.linesSeen.numeric;
+        t.malformed += ls.bad - s.linesSeen.bad + s.mismatched - s.mismatchedSeen;
+    }
+    s.bytesSeen = s.bytes;
+    s.telemSeen = ts;
+    s.linesSeen = ls;
+    s.mismatchedSeen = s.mismatched;
+}
+
+static CaptureHeader BinaryHeader(const Options &o) {
+    CaptureHeader h = CaptureDefaultHeader();
+    h.channels = CAPTURE_ACCEL | CAPTURE_MAG | CAPTURE_GYRO;
+    for (int c = 0; c < IMU_CHANNELS; c++) {
+        static const CaptureUnits kCalibrated[3] = {CAPTURE_G, CAPTURE_NT, CAPTURE_DEG_S};
+        h.units[c] = o.calibrated ? kCalibrated[c / 3] : CAPTURE_RAW;
+    }
+    h.rateHz = (float)o.rate;
+    std::snprintf(h.source, sizeof(h.source), "capd %s telemetry%s, %s time", o.port.c_str(),
+                  o.calibrated ? " (calibrated)" : "", o.boardClock ? "board" : "unix");
+    return h;
+}
+
+static CaptureHeader TextHeader(const Options &o, int channels) {
+    CaptureHeader h = CaptureDefaultHeader();
+    h.channels = (1u << channels) - 1;
+    for (int c = 0; c < IMU_CHANNELS; c++) {
+        h.units[c] = CAPTURE_OTHER;
+    }
+    h.rateHz = (float)o.rate;
+    std::snprintf(h.source, sizeof(h.source), "capd %s text, %d values per line, unix time", o.port.c_str(),
+                  channels);
+    return h;
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!ParseArgs(argc, argv, o)) {
+        Usage(argv[0]);
+        return 2;
+    }
+    if (o.boardClock && o.mode == MODE_TEXT) {
+        std::fprintf(stderr, "--clock board needs binary telemetry, text lines have no board time\n");
+        return 2;
+    }
+    if (!o.log.empty() && std::freopen(o.log.c_str(), "a", stderr) == nullptr) {
+        std::fprintf(stdout, "can't write %s\n", o.log.c_str());
+        return 1;
+    }
+    if (o.daemon && daemon(1, 1) != 0) {
+        Log("can't detach: %s", std::strerror(errno));
+        return 1;
+    }
+
+    struct sigaction sa = {};
+    sa.sa_handler = OnSignal;           // no SA_RESTART, poll() returns on a signal
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGHUP, &sa, nullptr);
+
+    HostClock clock;
+    SegmentWriter out(o);
+    Totals total, reported;
+    double start = Monotonic();
+    double lastReport = start;
+    std::vector<std::uint8_t> buf(1 << 16);
+    bool complained = false;
+    int status = 0;
+
+    while (!g_stop && !(o.seconds > 0.0 && Monotonic() - start >= o.seconds)) {
+        std::string err;
+        int fd = SerialOpen(o.port, o.baud, err);
+        if (fd < 0) {
+            if (o.once) {
+                Log("%s", err.c_str());
+                status = 1;
+                break;
+            }
+            if (!complained) {
+                Log("%s, retrying every %.0f s", err.c_str(), RETRY_SECONDS);
+                complained = true;
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(RETRY_SECONDS));
+            continue;
+        }
+        complained = false;
+        bool stream = !isatty(fd);      // a file or a pipe ends for good
+        total.connects++;
+        Log("reading %s", o.port.c_str());
+
+        Session s;
+        s.mode = o.mode;
+        if (s.mode == MODE_BINARY) {
+            out.SetHeader(BinaryHeader(o));
+        }
+        std::uint8_t capType = o.calibrated ? TELEM_CALIBRATED : TELEM_RAW;
+        double arrival = 0.0;
+
+        auto write = [&](const ImuRecord &r) {
+            if (out.Append(r)) {
+                total.records++;
+            } else {
+                total.unwritten++;
+            }
+        };
+        auto onFrame = [&](const TelemFrame &f) {
+            if (s.mode == MODE_AUTO) {
+                Log("binary telemetry");
+                s.mode = MODE_BINARY;
+                out.SetHeader(BinaryHeader(o));
+            }
+            if (s.mode != MODE_BINARY || f.header.type != capType) {
+                return;
+            }
+            ImuRecord r;
+            r.t = o.boardClock ? f.t : arrival;
+            for (int k = 0; k < 3; k++) {
+                if (o.calibrated) {
+                    TelemCalibrated c = f.As<TelemCalibrated>();
+                    r.Channel(k) = c.acc[k];
+                    r.Channel(3 + k) = c.mag[k];
+                    r.Channel(6 + k) = c.gyro[k];
+                } else {
+                    TelemRaw raw = f.As<TelemRaw>();
+                    r.Channel(k) = raw.acc[k];
+                    r.Channel(3 + k) = raw.mag[k];
+                    r.Channel(6 + k) = raw.gyro[k];
+                }
+            }
+            write(r);
+        };
+        auto onLine = [&](const double *v, int count) {
+            if (s.mode == MODE_BINARY) {
+                return;
+            }
+            ImuRecord r;
+            r.t = arrival;
+            for (int c = 0; c < count; c++) {
+                r.Channel(c) = (float)v[c];
+            }
+            if (s.mode == MODE_AUTO) {
+                if (count != s.textChannels) {
+                    s.pending.clear();
+                    s.textChannels = count;
+                }
+                s.pending.push_back(r);
+                if (s.pending.size() < TEXT_LOCK_LINES) {
+                    return;
+                }
+                Log("text, %d values per line", count);
+                s.mode = MODE_TEXT;
+                out.SetHeader(TextHeader(o, count));
+                for (const ImuRecord &p : s.pending) {
+                    write(p);
+                }
+                return;
+            }
+            if (s.textChannels == 0) {
+                s.textChannels = count;
+                out.SetHeader(TextHeader(o, count));
+            }
+            if (count != s.textChannels) {
+                s.mismatched++;
+                return;
+            }
+            write(r);
+        };
+
+        while (!g_stop) {
+            double now = Monotonic();
+            if (o.seconds > 0.0 && now - start >= o.seconds) {
+                break;
+            }
+            if (g_rotate) {
+                g_rotate = 0;
+                out.Close();
+            }
+            if (now - lastReport >= o.report) {
+                Collect(s, total);
+                double span = now - lastReport;
+                std::uint64_t frames = total.frames - reported.frames;
+                std::uint64_t lost = total.lost - reported.lost;
+                Log("%s %.1f kB/s, %.1f frames/s, %.1f records/s written; lost %llu (%.2f%%), crc %llu, "
+                    "malformed %llu%s; %s %llu records",
+                    s.mode == MODE_BINARY ? "binary" : s.mode == MODE_TEXT ? "text" : "waiting",
+                    (total.bytes - reported.bytes) / span / 1e3, frames / span,
+                    (total.records - reported.records) / span, (unsigned long long)lost,
+                    frames + lost > 0 ? 100.0 * lost / (frames + lost) : 0.0,
+                    (unsigned long long)(total.crcErrors - reported.crcErrors),
+                    (unsigned long long)(total.malformed - reported.malformed),
+                    total.unwritten > reported.unwritten ? ", NOT WRITTEN some records" : "",
+                    out.Count() > 0 ? out.Name().c_str() : "no segment", (unsigned long long)out.Count());
+                reported = total;
+                lastReport = now;
+            }
+
+            struct pollfd p = {fd, POLLIN, 0};
+            double wait = std::fmin(o.report - (now - lastReport), 1.0);
+            int ready = poll(&p, 1, (int)std::ceil(std::fmax(wait, 0.0) * 1000.0));
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready == 0) {
+                continue;
+            }
+            ssize_t n = read(fd, buf.data(), buf.size());
+            if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+                continue;
+            }
+            if (n <= 0) {
+                Log("%s closed: %s", o.port.c_str(), n < 0 ? std::strerror(errno) : "end of file");
+                break;
+            }
+            s.bytes += (std::uint64_t)n;
+            // Everything that completes in this read arrived now.
+            arrival = clock.Now();
+            if (s.mode != MODE_TEXT) {
+                s.telemetry.Feed(buf.data(), (std::size_t)n, onFrame);
+            }
+            if (s.mode != MODE_BINARY) {
+                s.lines.Feed(buf.data(), (std::size_t)n, onLine);
+            }
+        }
+        Collect(s, total);
+        out.Close();
+        SerialClose(fd);
+        if (stream || o.once) {
+            break;
+        }
+    }
+    out.Close();
+
+    double span = Monotonic() - start;
+    Log("done after %.1f s: %llu bytes, %llu frames, %llu records in %llu segments; lost %llu, crc %llu, "
+        "malformed %llu, not written %llu, %llu connections",
+        span, (unsigned long long)total.bytes, (unsigned long long)total.frames,
+        (unsigned long long)total.records, (unsigned long long)out.Segments(), (unsigned long long)total.lost,
+        (unsigned long long)total.crcErrors, (unsigned long long)total.malformed,
+        (unsigned long long)total.unwritten, (unsigned long long)total.connects);
+    return status;
+}
+
+#else   // CAPD_TEST
+
+// Text lines as the boards print them, fed the way read() hands them out:
+//
+//     g++ -std=c++17 -pthread -DCAPD_TEST -Itools/lib tools/capd.cpp tools/lib/*.cpp -o capd_test && ./capd_test
+int main() {
+    struct Case {
+        const char *name;
+        const char *bytes;
+        int lines;                  // numeric lines expected
+        int values;                 // numbers in each
+        int bad;
+    };
+    const Case cases[] = {
+        // hhuan143/Lab4 display_task(): CR first, FMT_Fixed(..., 2, -5), "°" is 0xC2 0xB0
+        {"lab4 angles", "\rYaw: -12.35°, Pitch: 3.10 °, Roll: 178.00°\rYaw: 0.00 °, Pitch: -0.01°, Roll: 5.50 °\r", 2,
+         3, 0},
+        {"csv", "0.012, -0.003, 1.001, 21, -4, 40, 0.12, -0.50, 0.03\r\n", 1, 9, 0},
+        {"no numbers", "keep the board still\r\n", 0, 0, 0},
+        {"not a number", "ax1 ay2\n", 0, 0, 0},
+        {"binary", "Yaw: 1.00\x01\x02, Pitch: 2.00\n", 0, 0, 1},
+        {"delete", "Yaw: 1.00\x7F\n", 0, 0, 1},
+    };
+
+    int failed = 0;
+    for (const Case &c : cases) {
+        const std::uint8_t *bytes = (const std::uint8_t *)c.bytes;
+        std::size_t n = std::strlen(c.bytes);
+        // One byte at a time splits the UTF-8 pairs too, then all at once.
+        for (std::size_t step : {(std::size_t)1, n}) {
+            LineDecoder d;
+            int lines = 0;
+            bool shaped = true;
+            for (std::size_t i = 0; i < n; i += step) {
+                d.Feed(bytes + i, std::min(step, n - i), [&](const double *, int count) {
+                    lines++;
+                    shaped = shaped && count == c.values;
+                });
+            }
+            bool ok = lines == c.lines && shaped && d.GetStats().bad == (std::uint64_t)c.bad;
+            std::printf("%-14s %s, %zu byte reads: %d lines, %llu bad\n", c.name, ok ? "ok" : "FAIL", step, lines,
+                        (unsigned long long)d.GetStats().bad);
+            failed += !ok;
+        }
+    }
+
+    // The numbers themselves, from the first angle line.
+    LineDecoder d;
+    double got[3] = {};
+    d.Feed((const std::uint8_t *)cases[0].bytes, std::strlen(cases[0].bytes), [&](const double *v, int count) {
+        if (count == 3 && got[0] == 0.0) {
+            std::copy(v, v + 3, got);
+        }
+    });
+    bool ok = got[0] == -12.35 && got[1] == 3.10 && got[2] == 178.0;
+    std::printf("%-14s %s: %.2f %.2f %.2f\n", "angle values", ok ? "ok" : "FAIL", got[0], got[1], got[2]);
+    failed += !ok;
+    return failed == 0 ? 0 : 1;
+}
+
+#endif  // CAPD_TEST
@@ -0,0 +1,173 @@
+/*
+ * File:   csv2cap.cpp
+ *
+ * Converts a CSV capture (any layout CsvStream reads) to the binary .imucap
+ * format:
+ *
+ *     csv2cap --accel Accel_x,Accel_y,Accel_z --mag Mag_x,Mag_y,Mag_z \
+ *             AccelMagTumbleNoCal.csv -o tumble.imucap
+ *     csv2cap --gyro x,y,z --rate 50 gyro_10min.csv -o gyro_10min.imucap
+ *
+ * For headerless files the names only say how many columns there are, they
+ * are taken in order.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "CsvCapture.h"
+#include "CsvStream.h"
+#include "ImuCapture.h"
+
+struct Options {
+    std::string in, out;
+    std::string names[IMU_CHANNELS];
+    CaptureUnits units[3] = {CAPTURE_RAW, CAPTURE_RAW, CAPTURE_RAW};
+    double rate = 0.0;
+    double window = CSV_SPARSE_WINDOW;
+    std::string timeUnits = "s";
+};
+
+static void Usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s [options] in.csv -o out.imucap\n"
+        "  --accel a,b,c       columns for ax, ay, az\n"
+        "  --mag a,b,c         columns for mx, my, mz\n"
+        "  --gyro a,b,c        columns for gx, gy, gz\n"
+        "                      (default: --accel Accel_x,.. --mag Mag_x,..)\n"
+        "  --accel-units U     raw or g (default raw)\n"
+        "  --mag-units U       raw or nT (default raw)\n"
+        "  --gyro-units U      raw, deg/s or rad/s (default raw)\n"
+        "  --rate HZ           nominal rate; headerless files get t = row / HZ\n"
+        "  --time-units U      units of the timestamp column (default s)\n"
+        "  --window W          sparse row reassembly window (default %g)\n",
+        prog, CSV_SPARSE_WINDOW);
+}
+
+static bool ParseTriad(const char *s, std::string *names) {
+    int k = 0;
+    std::string cur;
+    for (const char *p = s;; p++) {
+        if (*p == ',' || *p == '\0') {
+            if (k == 3) {
+                return false;
+            }
+            names[k++] = cur;
+            cur.clear();
+            if (*p == '\0') {
+                break;
+            }
+        } else {
+            cur.push_back(*p);
+        }
+    }
+    return k == 3;
+}
+
+static bool ParseUnits(const char *s, CaptureUnits &u) {
+    if (std::strcmp(s, "raw") == 0) u = CAPTURE_RAW;
+    else if (std::strcmp(s, "g") == 0) u = CAPTURE_G;
+    else if (std::strcmp(s, "nT") == 0) u = CAPTURE_NT;
+    else if (std::strcmp(s, "deg/s") == 0) u = CAPTURE_DEG_S;
+    else if (std::strcmp(s, "rad/s") == 0) u = CAPTURE_RAD_S;
+    else return false;
+    return true;
+}
+
+static bool ParseArgs(int argc, char **argv, Options &o) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a[0] != '-') {
+            o.in = a;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *next = argv[++i];
+        if (a == "-o") o.out = next;
+        else if (a == "--accel") { if (!ParseTriad(next, &o.names[0])) return false; }
+        else if (a == "--mag") { if (!ParseTriad(next, &o.names[3])) return false; }
+        else if (a == "--gyro") { if (!ParseTriad(next, &o.names[6])) return false; }
+        else if (a == "--accel-units") { if (!ParseUnits(next, o.units[0])) return false; }
+        else if (a == "--mag-units") { if (!ParseUnits(next, o.units[1])) return false; }
+        else if (a == "--gyro-units") { if (!ParseUnits(next, o.units[2])) return false; }
+        else if (a == "--rate") o.rate = std::atof(next);
+        else if (a == "--time-units") o.timeUnits = next;
+        else if (a == "--window") o.window = std::atof(next);
+        else return false;
+    }
+    return !o.in.empty() && !o.out.empty();
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!ParseArgs(argc, argv, o)) {
+        Usage(argv[0]);
+        return 2;
+    }
+    bool any = false;
+    for (const std::string &n : o.names) {
+        any = any || !n.empty();
+    }
+    if (!any) {
+        const char *tumble[6] = {"Accel_x", "Accel_y", "Accel_z", "Mag_x", "Mag_y", "Mag_z"};
+        for (int c = 0; c < 6; c++) {
+            o.names[c] = tumble[c];
+        }
+    }
+
+    CsvStream::Columns cols;
+    CaptureHeader h = CaptureDefaultHeader();
+    for (int c = 0; c < IMU_CHANNELS; c++) {
+        cols.name[c] = o.names[c].c_str();
+        if (!o.names[c].empty()) {
+            h.channels |= 1u << c;
+        }
+        h.units[c] = o.units[c / 3];
+    }
+    h.rateHz = (float)o.rate;
+    std::snprintf(h.source, sizeof(h.source), "%s", o.in.c_str());
+
+    std::string err;
+    CsvStream in;
+    if (!in.Open(o.in, cols, o.window, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    // Headerless files only have row numbers for time.
+    ImuRecord r;
+    bool haveFirst = in.Next(r);
+    bool rowTime = haveFirst && r.t == 1.0 && in.Rows() == 1;
+    if (rowTime) {
+        std::snprintf(h.timeUnits, sizeof(h.timeUnits), "%s", o.rate > 0.0 ? "s" : "sample");
+    } else {
+        std::snprintf(h.timeUnits, sizeof(h.timeUnits), "%s", o.timeUnits.c_str());
+    }
+
+    CaptureWriter out;
+    if (!out.Open(o.out, h, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    std::uint64_t skipped = 0;
+    for (bool more = haveFirst; more; more = in.Next(r)) {
+        if (rowTime && o.rate > 0.0) {
+            r.t = (r.t - 1.0) / o.rate;
+        }
+        if (!out.Append(r)) {
+            skipped++;
+        }
+    }
+    std::uint64_t written = out.Count();
+    if (!out.Close(err) && skipped == 0) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "%s: %llu rows, %llu records, %llu dropped, %llu out of order\n", o.out.c_str(),
+                 (unsigned long long)in.Rows(), (unsigned long long)written,
+                 (unsigned long long)in.Dropped(), (unsigned long long)skipped);
+    return 0;
+}
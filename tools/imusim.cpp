@@ -0,0 +1,178 @@
+/*
+ * File:   imusim.cpp
+ *
+ * Synthetic IMU capture generator (CreateTrajectoryData.m and
+ * CreateTumbleData.m, natively), writes .imucap:
+ *
+ *     imusim --motion trajectory --seconds 600 -o traj.imucap --truth traj.csv
+ *     imusim --motion tumble --scale-error 0.2 --cross 0.04 --misalign 3 \
+ *            --accel-bias 0.05 --mag-bias 2000 --units raw -o tumble.imucap
+ *     imusim --motion still --hours 3 --gyro-walk 0.002 --units raw -o still.imucap
+ *
+ * The drawn distortion matrices and biases are printed, they are the ground
+ * truth for calgen and allan runs on the output.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "ImuCapture.h"
+#include "ImuSim.h"
+
+struct Options {
+    SimConfig sim;
+    double seconds = 60.0;
+    bool raw = false;
+    std::string out, truth;
+};
+
+static void Usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s [options] -o out.imucap\n"
+        "  --motion M          trajectory, tumble or still (default trajectory)\n"
+        "  --seconds S         length (default 60), or --hours H\n"
+        "  --rate HZ           sample rate (default 50)\n"
+        "  --seed N            random seed (default 1)\n"
+        "  --units U           si (g, nT, deg/s) or raw BNO055 counts (default si)\n"
+        "  --truth file.csv    also write t, yaw, pitch, roll, gyro bias\n"
+        " errors, sensor units (g, nT, deg/s), drawn uniform +-X/2 per axis:\n"
+        "  --scale-error F     scale factor error of every triad\n"
+        "  --cross F           cross coupling of every triad\n"
+        "  --misalign DEG      mag to accel misalignment\n"
+        "  --accel-bias B      (default 0)\n"
+        "  --mag-bias B        (default 0)\n"
+        "  --gyro-bias B       (default 10)\n"
+        "  --gyro-walk W       gyro bias random walk, deg/s/sqrt(s) (default 0)\n"
+        " white noise rms:\n"
+        "  --accel-noise N     (default 0.008)\n"
+        "  --mag-noise N       (default 476)\n"
+        "  --gyro-noise N      (default 0.1)\n"
+        "  --tumble-rate R     rms body rate of a tumble, deg/s (default 90)\n",
+        prog);
+}
+
+static bool ParseArgs(int argc, char **argv, Options &o) {
+    SimConfig &s = o.sim;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *next = argv[++i];
+        double v = std::atof(next);
+        if (a == "-o") o.out = next;
+        else if (a == "--truth") o.truth = next;
+        else if (a == "--motion") {
+            if (std::strcmp(next, "trajectory") == 0) s.motion = SIM_TRAJECTORY;
+            else if (std::strcmp(next, "tumble") == 0) s.motion = SIM_TUMBLE;
+            else if (std::strcmp(next, "still") == 0) s.motion = SIM_STILL;
+            else return false;
+        }
+        else if (a == "--units") {
+            if (std::strcmp(next, "raw") == 0) o.raw = true;
+            else if (std::strcmp(next, "si") == 0) o.raw = false;
+            else return false;
+        }
+        else if (a == "--seconds") o.seconds = v;
+        else if (a == "--hours") o.seconds = v * 3600.0;
+        else if (a == "--rate") s.rate = v;
+        else if (a == "--seed") s.seed = std::strtoull(next, nullptr, 10);
+        else if (a == "--scale-error") s.accel.scale = s.mag.scale = s.gyro.scale = v;
+        else if (a == "--cross") s.accel.cross = s.mag.cross = s.gyro.cross = v;
+        else if (a == "--misalign") s.mag.misalign = v;
+        else if (a == "--accel-bias") s.accel.bias = v;
+        else if (a == "--mag-bias") s.mag.bias = v;
+        else if (a == "--gyro-bias") s.gyro.bias = v;
+        else if (a == "--gyro-walk") s.gyroWalk = v;
+        else if (a == "--accel-noise") s.accel.noise = v;
+        else if (a == "--mag-noise") s.mag.noise = v;
+        else if (a == "--gyro-noise") s.gyro.noise = v;
+        else if (a == "--tumble-rate") s.tumbleRate = v;
+        else return false;
+    }
+    return !o.out.empty() && s.rate > 0.0 && o.seconds > 0.0;
+}
+
+static void PrintModel(const ImuSim &sim) {
+    const char *names[3] = {"accel", "mag", "gyro"};
+    for (int s = 0; s < 3; s++) {
+        const Mat3 &D = sim.Distortion(s);
+        const Vec3 &b = sim.Bias(s);
+        std::fprintf(stderr, "%-5s D = [%9.6f %9.6f %9.6f; %9.6f %9.6f %9.6f; %9.6f %9.6f %9.6f]  b = [%g %g %g]\n",
+                     names[s], D.m[0][0], D.m[0][1], D.m[0][2], D.m[1][0], D.m[1][1], D.m[1][2],
+                     D.m[2][0], D.m[2][1], D.m[2][2], b.x + 0.0, b.y + 0.0, b.z + 0.0);
+    }
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!ParseArgs(argc, argv, o)) {
+        Usage(argv[0]);
+        return 2;
+    }
+    if (o.raw) {
+        o.sim.accelLsb = SIM_ACCEL_LSB;
+        o.sim.magLsb = SIM_MAG_LSB;
+        o.sim.gyroLsb = SIM_GYRO_LSB;
+    }
+
+    CaptureHeader h = CaptureDefaultHeader();
+    h.channels = CAPTURE_ACCEL | CAPTURE_MAG | CAPTURE_GYRO;
+    h.rateHz = (float)o.sim.rate;
+    std::snprintf(h.timeUnits, sizeof(h.timeUnits), "s");
+    const char *motion[3] = {"trajectory", "tumble", "still"};
+    std::snprintf(h.source, sizeof(h.source), "imusim %s seed %llu", motion[o.sim.motion],
+                  (unsigned long long)o.sim.seed);
+    for (int c = 0; c < IMU_CHANNELS; c++) {
+        if (o.raw) {
+            h.units[c] = CAPTURE_RAW;
+        } else {
+            h.units[c] = c < 3 ? CAPTURE_G : (c < 6 ? CAPTURE_NT : CAPTURE_DEG_S);
+        }
+    }
+
+    std::string err;
+    CaptureWriter out;
+    if (!out.Open(o.out, h, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    FILE *truth = nullptr;
+    if (!o.truth.empty()) {
+        truth = std::fopen(o.truth.c_str(), "w");
+        if (truth == nullptr) {
+            std::fprintf(stderr, "can't write %s\n", o.truth.c_str());
+            return 1;
+        }
+        std::fprintf(truth, "t,yaw,pitch,roll,bias_x,bias_y,bias_z\n");
+    }
+
+    ImuSim sim(o.sim);
+    PrintModel(sim);
+    std::uint64_t n = (std::uint64_t)(o.seconds * o.sim.rate + 0.5);
+    auto start = std::chrono::steady_clock::now();
+    ImuRecord rec;
+    SimTruth t;
+    for (std::uint64_t k = 0; k < n; k++) {
+        sim.Next(rec, truth != nullptr ? &t : nullptr);
+        out.Append(rec);
+        if (truth != nullptr) {
+            std::fprintf(truth, "%.6f,%.4f,%.4f,%.4f,%.5f,%.5f,%.5f\n", rec.t, t.yaw, t.pitch, t.roll,
+                         t.gyroBias.x, t.gyroBias.y, t.gyroBias.z);
+        }
+    }
+    if (!out.Close(err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+    if (truth != nullptr) {
+        std::fclose(truth);
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%s: %llu samples (%.0f s at %g Hz) in %.3f s, %.2f M samples/s\n", o.out.c_str(),
+                 (unsigned long long)n, o.seconds, o.sim.rate, s, (double)n / s / 1e6);
+    return 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * File:   CsvCapture.cpp
+ *
+ * CSV capture readers for the host tools.
+ */
+
+#include "CsvCapture.h"
+
+#include "CsvStream.h"
+
+std::vector<std::string> TriadColumns(const std::string &prefix) {
+    return {prefix + "_x", prefix + "_y", prefix + "_z"};
+}
+
+bool ReadCsvTriples(const std::string &path, const std::vector<std::string> &columns,
+                    std::vector<Vec3> &out, std::string &err) {
+    CsvStream::Columns cols;
+    const char *positional[3] = {"x", "y", "z"};
+    for (int k = 0; k < 3; k++) {
+        cols.name[k] = columns.empty() ? positional[k] : columns[k].c_str();
+    }
+    CsvStream in;
+    if (!in.Open(path, cols, CSV_SPARSE_WINDOW, err)) {
+        return false;
+    }
+    out.clear();
+    for (const ImuRecord &r : in) {
+        out.push_back({r.ax, r.ay, r.az});
+    }
+    if (out.empty()) {
+        err = path + ": no samples";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file    CsvCapture.h
+ *
+ * Readers for the raw sensor captures kept under matlab/:
+ *
+ *  + plain "x, y, z" rows (acc_raw.csv, gyro_10min.csv, ...), '\n' or '\r'
+ *    line endings, no header
+ *  + Teleplot exports with a "timestamp(ms),Accel_x,...," header, quoted or
+ *    unquoted values, columns in any order (AccelMagTumble*.csv)
+ *  + sparse Teleplot exports with one value per row (*PointCloud.csv)
+ *
+ * These are convenience wrappers around CsvStream for tools that want the
+ * whole capture in memory.
+ */
+
+#ifndef CSV_CAPTURE_H
+#define CSV_CAPTURE_H
+
+#include <string>
+#include <vector>
+
+#include "ImuMath.h"
+
+// Sparse rows further apart than this (file time units) don't form a sample.
+#define CSV_SPARSE_WINDOW 0.05
+
+/**
+ * ReadCsvTriples loads one sensor triad from a capture.
+ * @param: path, CSV file
+ * @param: columns, header names of the x, y, z columns (e.g. "Mag_x"...); an
+ *         empty list reads the first three columns of a headerless file
+ * @param: out, receives one Vec3 per complete sample
+ * @param: err, receives a message on failure
+ * @return: false if the file can't be opened or the columns aren't found
+ */
+bool ReadCsvTriples(const std::string &path, const std::vector<std::string> &columns,
+                    std::vector<Vec3> &out, std::string &err);
+
+/** Column names "<prefix>_x", "<prefix>_y", "<prefix>_z". */
+std::vector<std::string> TriadColumns(const std::string &prefix);
+
+#endif // CSV_CAPTURE_H
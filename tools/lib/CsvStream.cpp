@@ -0,0 +1,226 @@
+/*
+ * File:   CsvStream.cpp
+ *
+ * Memory mapped CSV capture reader.
+ */
+
+#include "CsvStream.h"
+
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(const std::string &path, std::string &err, bool sequential) {
+    Close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        err = "can't open " + path;
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        err = "can't stat " + path;
+        return false;
+    }
+    size_ = (std::size_t)st.st_size;
+    if (size_ > 0) {
+        void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            err = "can't map " + path;
+            return false;
+        }
+        ::madvise(p, size_, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        data_ = (const char *)p;
+    }
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_ != nullptr) {
+        ::munmap((void *)data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+// Field [b, e) with blanks and the Teleplot quotes trimmed.
+static void Trim(const char *&b, const char *&e) {
+    while (b < e && (*b == ' ' || *b == '\t' || *b == '"')) b++;
+    while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '"')) e--;
+}
+
+static bool ParseNumber(const char *b, const char *e, double &v) {
+    Trim(b, e);
+    if (b == e) {
+        return false;
+    }
+    if (*b == '+') {
+        b++;
+    }
+    auto r = std::from_chars(b, e, v);
+    return r.ec == std::errc() && r.ptr == e;
+}
+
+// End of the line starting at p, the next line starts after any '\r'/'\n'.
+static const char *LineEnd(const char *p, const char *end) {
+    while (p < end && *p != '\n' && *p != '\r') p++;
+    return p;
+}
+
+static const char *SkipEol(const char *p, const char *end) {
+    while (p < end && (*p == '\n' || *p == '\r')) p++;
+    return p;
+}
+
+bool CsvStream::Open(const std::string &path, const Columns &columns, double window, std::string &err) {
+    if (!file_.Open(path, err)) {
+        return false;
+    }
+    window_ = window;
+    pos_ = SkipEol(file_.Data(), file_.Data() + file_.Size());
+    end_ = file_.Data() + file_.Size();
+    for (int &s : slot_) s = -1;
+    wanted_ = 0;
+    numColumns_ = 0;
+
+    // A header is a first line with a non-numeric field.
+    const char *le = LineEnd(pos_, end_);
+    bool header = false;
+    for (const char *b = pos_; b <= le;) {
+        const char *e = b;
+        while (e < le && *e != ',') e++;
+        double v;
+        const char *tb = b, *te = e;
+        Trim(tb, te);
+        if (tb != te && !ParseNumber(tb, te, v)) {
+            header = true;
+        }
+        b = e + 1;
+    }
+
+    if (header) {
+        timed_ = true;
+        int col = 0;
+        for (const char *b = pos_; b <= le && col < 32; col++) {
+            const char *e = b;
+            while (e < le && *e != ',') e++;
+            const char *tb = b, *te = e;
+            Trim(tb, te);
+            for (int c = 0; c < IMU_CHANNELS; c++) {
+                std::size_t n = std::strlen(columns.name[c]);
+                if (n > 0 && (std::size_t)(te - tb) == n && std::memcmp(tb, columns.name[c], n) == 0) {
+                    slot_[col] = c;
+                    wanted_ |= (std::uint16_t)(1u << c);
+                }
+            }
+            b = e + 1;
+        }
+        numColumns_ = col;
+        for (int c = 0; c < IMU_CHANNELS; c++) {
+            if (columns.name[c][0] != '\0' && !(wanted_ & (1u << c))) {
+                err = path + ": no column " + columns.name[c];
+                return false;
+            }
+        }
+        pos_ = SkipEol(le, end_);
+    } else {
+        timed_ = false;
+        int c = 0;
+        for (int k = 0; k < IMU_CHANNELS; k++) {
+            if (columns.name[k][0] != '\0') {
+                slot_[c++] = k;
+                wanted_ |= (std::uint16_t)(1u << k);
+            }
+        }
+        numColumns_ = c;
+    }
+    if (wanted_ == 0) {
+        err = path + ": no columns selected";
+        return false;
+    }
+    first_ = pos_;
+    Rewind();
+    return true;
+}
+
+void CsvStream::Rewind() {
+    pos_ = first_;
+    filled_ = 0;
+    open_ = false;
+    rows_ = records_ = dropped_ = 0;
+}
+
+bool CsvStream::Next(ImuRecord &rec) {
+    while (pos_ < end_) {
+        const char *le = LineEnd(pos_, end_);
+        const char *b = pos_;
+        pos_ = SkipEol(le, end_);
+        rows_++;
+
+        double t = (double)rows_;
+        int col = 0;
+        if (timed_) {
+            const char *e = b;
+            while (e < le && *e != ',') e++;
+            if (!ParseNumber(b, e, t)) {
+                continue;
+            }
+            b = e + 1;
+            col = 1;
+        }
+
+        // Window expired: whatever is pending will never complete.
+        if (open_ && t - pending_.t > window_) {
+            dropped_++;
+            open_ = false;
+            filled_ = 0;
+        }
+
+        for (; b <= le && col < numColumns_; col++) {
+            const char *e = b;
+            while (e < le && *e != ',') e++;
+            int c = slot_[col];
+            double v;
+            if (c >= 0 && ParseNumber(b, e, v)) {
+                std::uint16_t bit = (std::uint16_t)(1u << c);
+                if (open_ && (filled_ & bit)) {
+                    // Column repeated before the record completed.
+                    dropped_++;
+                    open_ = false;
+                    filled_ = 0;
+                }
+                if (!open_) {
+                    pending_ = ImuRecord();
+                    pending_.t = t;
+                    open_ = true;
+                }
+                pending_.Channel(c) = (float)v;
+                filled_ |= bit;
+            }
+            b = e + 1;
+        }
+
+        if (open_ && filled_ == wanted_) {
+            rec = pending_;
+            open_ = false;
+            filled_ = 0;
+            records_++;
+            return true;
+        }
+    }
+    if (open_) {
+        dropped_++;
+        open_ = false;
+        filled_ = 0;
+    }
+    return false;
+}
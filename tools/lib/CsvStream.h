@@ -0,0 +1,139 @@
+/**
+ * @file    CsvStream.h
+ *
+ * Streaming reader for the sensor CSV captures. The file is memory mapped and
+ * parsed in place, one record at a time, with no allocation per row.
+ *
+ * Handles every layout we have:
+ *
+ *  + headerless "x, y, z" rows (acc_raw.csv, gyro_10min.csv), '\r' or '\n'
+ *  + dense Teleplot exports, one complete sample per row (AccelMagTumble*.csv)
+ *  + sparse Teleplot exports, where every value sits on its own timestamped
+ *    row and the other columns are empty (AccelrerometerPointCloud.csv,
+ *    magnetometerPointCloud.csv)
+ *
+ * Sparse rows are put back together with a sliding timestamp window: a
+ * sample starts at the first value, collects the following rows, and is
+ * emitted as soon as every mapped column has been seen. If a column repeats
+ * or the window runs out first the partial sample is dropped. State is one
+ * record, so memory is O(1) in the file size.
+ */
+
+#ifndef CSV_STREAM_H
+#define CSV_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+/** One IMU sample, unmapped channels stay 0. Channels are contiguous. */
+struct ImuRecord {
+    double t = 0.0;
+    float ax = 0, ay = 0, az = 0;
+    float mx = 0, my = 0, mz = 0;
+    float gx = 0, gy = 0, gz = 0;
+
+    float &Channel(int i) { return (&ax)[i]; }
+    float Channel(int i) const { return (&ax)[i]; }
+};
+
+#define IMU_CHANNELS 9
+
+/** Read-only memory mapping of a whole file. */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /** sequential = false hints random access (replay windows). */
+    bool Open(const std::string &path, std::string &err, bool sequential = true);
+    void Close();
+
+    const char *Data() const { return data_; }
+    std::size_t Size() const { return size_; }
+
+private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+class CsvStream {
+public:
+    /** Columns to load into ax..az, mx..mz, gx..gz; "" leaves a channel unused. */
+    struct Columns {
+        const char *name[IMU_CHANNELS] = {"", "", "", "", "", "", "", "", ""};
+    };
+
+    /**
+     * Open maps the file and resolves the column names against the header.
+     * For a headerless file the names are ignored and the first columns are
+     * loaded in order (as many as there are non-empty names), t = row number.
+     * @param: path, CSV file
+     * @param: columns, header names per channel
+     * @param: window, sparse reassembly window in file time units
+     * @param: err, receives a message on failure
+     */
+    bool Open(const std::string &path, const Columns &columns, double window, std::string &err);
+
+    /** Next complete record, false at end of file. */
+    bool Next(ImuRecord &rec);
+
+    /** Rewinds to the first data row. */
+    void Rewind();
+
+    std::uint64_t Rows() const { return rows_; }
+    std::uint64_t Records() const { return records_; }
+    std::uint64_t Dropped() const { return dropped_; }
+
+    /** Single pass input iterator over the records. */
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = ImuRecord;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ImuRecord *;
+        using reference = const ImuRecord &;
+
+        explicit Iterator(CsvStream *s) : s_(s) { ++*this; }
+        Iterator() = default;
+        reference operator*() const { return rec_; }
+        pointer operator->() const { return &rec_; }
+        Iterator &operator++() {
+            if (s_ != nullptr && !s_->Next(rec_)) {
+                s_ = nullptr;
+            }
+            return *this;
+        }
+        bool operator==(const Iterator &o) const { return s_ == o.s_; }
+        bool operator!=(const Iterator &o) const { return s_ != o.s_; }
+
+    private:
+        CsvStream *s_ = nullptr;
+        ImuRecord rec_;
+    };
+
+    Iterator begin() { return Iterator(this); }
+    Iterator end() { return Iterator(); }
+
+private:
+    MappedFile file_;
+    const char *pos_ = nullptr;
+    const char *end_ = nullptr;
+    const char *first_ = nullptr;       // first data row
+    bool timed_ = false;                // column 0 is a timestamp
+    double window_ = 0.0;
+    int slot_[32];                      // file column -> channel, -1 unused
+    int numColumns_ = 0;
+    std::uint16_t wanted_ = 0;          // channels that make a complete record
+
+    ImuRecord pending_;
+    std::uint16_t filled_ = 0;
+    bool open_ = false;                 // a partial record is pending
+
+    std::uint64_t rows_ = 0, records_ = 0, dropped_ = 0;
+};
+
+#endif // CSV_STREAM_H
@@ -0,0 +1,185 @@
+/*
+ * File:   ImuCapture.cpp
+ *
+ * Binary IMU capture writer and mapped reader.
+ */
+
+#include "ImuCapture.h"
+
+#include <algorithm>
+#include <cstring>
+
+CaptureHeader CaptureDefaultHeader() {
+    CaptureHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    h.version = CAPTURE_VERSION;
+    h.headerSize = sizeof(CaptureHeader);
+    h.recordSize = sizeof(CaptureRecord);
+    h.dataOffset = sizeof(CaptureHeader);
+    h.indexStride = CAPTURE_INDEX_STRIDE;
+    for (int c = 0; c < IMU_CHANNELS; c++) {
+        h.scale[c] = 1.0f;
+        h.units[c] = CAPTURE_RAW;
+    }
+    std::strncpy(h.timeUnits, "s", sizeof(h.timeUnits) - 1);
+    return h;
+}
+
+CaptureWriter::~CaptureWriter() {
+    if (f_ != nullptr) {
+        std::string err;
+        Close(err);
+    }
+}
+
+bool CaptureWriter::Open(const std::string &path, const CaptureHeader &header, std::string &err) {
+    f_ = std::fopen(path.c_str(), "wb");
+    if (f_ == nullptr) {
+        err = "can't write " + path;
+        return false;
+    }
+    buffer_.resize(1 << 20);
+    std::setvbuf(f_, buffer_.data(), _IOFBF, buffer_.size());
+    header_ = header;
+    header_.headerSize = sizeof(CaptureHeader);
+    header_.recordSize = sizeof(CaptureRecord);
+    header_.dataOffset = sizeof(CaptureHeader);
+    header_.count = 0;
+    if (header_.indexStride == 0) {
+        header_.indexStride = CAPTURE_INDEX_STRIDE;
+    }
+    index_.clear();
+    ordered_ = true;
+    // Placeholder, rewritten with the counts and offsets on Close().
+    return std::fwrite(&header_, sizeof(header_), 1, f_) == 1;
+}
+
+bool CaptureWriter::Append(const ImuRecord &rec) {
+    if (header_.count > 0 && rec.t < header_.t1) {
+        ordered_ = false;
+        return false;
+    }
+    CaptureRecord r;
+    r.t = rec.t;
+    for (int c = 0; c < IMU_CHANNELS; c++) {
+        r.v[c] = rec.Channel(c) / header_.scale[c];
+    }
+    if (header_.count % header_.indexStride == 0) {
+        index_.push_back(rec.t);
+    }
+    if (header_.count == 0) {
+        header_.t0 = rec.t;
+    }
+    header_.t1 = rec.t;
+    header_.count++;
+    return std::fwrite(&r, sizeof(r), 1, f_) == 1;
+}
+
+bool CaptureWriter::Close(std::string &err) {
+    if (f_ == nullptr) {
+        return true;
+    }
+    bool ok = true;
+    // Keep the index 8-byte aligned in the mapped file.
+    std::uint64_t end = header_.dataOffset + header_.count * sizeof(CaptureRecord);
+    std::uint64_t pad = (8 - end % 8) % 8;
+    static const char zeros[8] = {0};
+    ok = ok && std::fwrite(zeros, 1, pad, f_) == pad;
+    header_.indexOffset = end + pad;
+    header_.indexCount = index_.size();
+    ok = ok && (index_.empty() || std::fwrite(index_.data(), sizeof(double), index_.size(), f_) == index_.size());
+    ok = ok && std::fseek(f_, 0, SEEK_SET) == 0;
+    ok = ok && std::fwrite(&header_, sizeof(header_), 1, f_) == 1;
+    ok = (std::fclose(f_) == 0) && ok;
+    f_ = nullptr;
+    if (!ordered_) {
+        err = "timestamps went backwards, out of order records were skipped";
+    } else if (!ok) {
+        err = "write failed";
+    }
+    return ok;
+}
+
+bool CaptureReader::Open(const std::string &path, std::string &err) {
+    if (!file_.Open(path, err, false)) {
+        return false;
+    }
+    if (file_.Size() < sizeof(CaptureHeader)) {
+        err = path + ": too short for a capture";
+        return false;
+    }
+    header_ = (const CaptureHeader *)file_.Data();
+    if (std::memcmp(header_->magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0 ||
+        header_->version != CAPTURE_VERSION || header_->recordSize != sizeof(CaptureRecord)) {
+        err = path + ": not a version " + std::to_string(CAPTURE_VERSION) + " capture";
+        return false;
+    }
+    std::uint64_t dataEnd = header_->dataOffset + header_->count * header_->recordSize;
+    std::uint64_t indexEnd = header_->indexOffset + header_->indexCount * sizeof(double);
+    if (dataEnd > file_.Size() || indexEnd > file_.Size() || header_->indexStride == 0) {
+        err = path + ": truncated capture";
+        return false;
+    }
+    data_ = file_.Data() + header_->dataOffset;
+    index_ = file_.Data() + header_->indexOffset;
+    return true;
+}
+
+ImuRecord CaptureReader::At(std::uint64_t i) const {
+    CaptureRecord r;
+    std::memcpy(&r, data_ + i * sizeof(CaptureRecord), sizeof(r));
+    ImuRecord out;
+    out.t = r.t;
+    for (int c = 0; c < IMU_CHANNELS; c++) {
+        out.Channel(c) = r.v[c] * header_->scale[c];
+    }
+    return out;
+}
+
+std::uint64_t CaptureReader::LowerBound(double time) const {
+    // Index block first: last entry with t < time.
+    std::uint64_t lo = 0, hi = header_->indexCount;
+    while (lo < hi) {
+        std::uint64_t mid = (lo + hi) / 2;
+        double t;
+        std::memcpy(&t, index_ + mid * sizeof(double), sizeof(t));
+        if (t < time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    std::uint64_t first = (lo == 0) ? 0 : (lo - 1) * header_->indexStride;
+    std::uint64_t last = std::min<std::uint64_t>(lo * header_->indexStride + 1, header_->count);
+
+    // Then the records of that block.
+    while (first < last) {
+        std::uint64_t mid = (first + last) / 2;
+        double t;
+        std::memcpy(&t, data_ + mid * sizeof(CaptureRecord), sizeof(t));
+        if (t < time) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+CaptureReader::Range CaptureReader::Window(double t0, double t1) const {
+    std::uint64_t a = LowerBound(t0);
+    std::uint64_t b = std::max(a, LowerBound(t1));
+    return Range{this, a, b};
+}
+
+bool IsCapture(const std::string &path) {
+    char magic[8] = {0};
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = std::fread(magic, 1, sizeof(magic), f) == sizeof(magic);
+    std::fclose(f);
+    return ok && std::memcmp(magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) == 0;
+}
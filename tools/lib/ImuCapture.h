@@ -0,0 +1,156 @@
+/**
+ * @file    ImuCapture.h
+ *
+ * Binary IMU capture format (.imucap), for replay and batch tools that would
+ * otherwise re-parse the CSVs every run.
+ *
+ *      +----------------------+  offset 0
+ *      | CaptureHeader        |  256 bytes
+ *      +----------------------+  header.dataOffset
+ *      | CaptureRecord[count] |  fixed size, sorted by t
+ *      +----------------------+  header.indexOffset
+ *      | double[indexCount]   |  t of every indexStride'th record
+ *      +----------------------+
+ *
+ * Everything is little-endian. Records are fixed size, so record i is at
+ * dataOffset + i * recordSize; the index narrows a time lookup to one block
+ * of indexStride records that is then binary searched, touching a handful of
+ * pages of a mapped file.
+ */
+
+#ifndef IMU_CAPTURE_H
+#define IMU_CAPTURE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "CsvStream.h"
+
+#define CAPTURE_MAGIC "IMUCAP1"
+#define CAPTURE_VERSION 1
+#define CAPTURE_INDEX_STRIDE 256
+
+/** Channel bits of CaptureHeader.channels, same order as ImuRecord. */
+enum {
+    CAPTURE_ACCEL = 0x007,
+    CAPTURE_MAG = 0x038,
+    CAPTURE_GYRO = 0x1C0,
+};
+
+/** What each channel holds. */
+enum CaptureUnits : std::uint8_t {
+    CAPTURE_RAW = 0,        // sensor LSB
+    CAPTURE_G = 1,
+    CAPTURE_NT = 2,
+    CAPTURE_DEG_S = 3,
+    CAPTURE_RAD_S = 4,
+    CAPTURE_OTHER = 255,
+};
+
+#pragma pack(push, 1)
+struct CaptureHeader {
+    char magic[8];                  // CAPTURE_MAGIC
+    std::uint32_t version;
+    std::uint32_t headerSize;       // sizeof(CaptureHeader)
+    std::uint32_t recordSize;       // sizeof(CaptureRecord)
+    std::uint32_t channels;         // CAPTURE_ACCEL | ... bits that are valid
+    std::uint64_t dataOffset;
+    std::uint64_t count;            // number of records
+    std::uint64_t indexOffset;
+    std::uint64_t indexCount;
+    std::uint32_t indexStride;      // records per index entry
+    float rateHz;                   // nominal sample rate, 0 if unknown
+    double t0, t1;                  // first and last timestamp
+    float scale[IMU_CHANNELS];      // units per stored value (1 = as recorded)
+    std::uint8_t units[IMU_CHANNELS];
+    char timeUnits[8];              // "s", "ms", "sample"
+    char source[96];                // where the data came from
+    std::uint8_t reserved[256 - 8 - 4 * 4 - 8 * 4 - 4 - 4 - 16 - 4 * IMU_CHANNELS - IMU_CHANNELS - 8 - 96];
+};
+
+struct CaptureRecord {
+    double t;
+    float v[IMU_CHANNELS];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(CaptureHeader) == 256, "CaptureHeader must stay 256 bytes");
+static_assert(sizeof(CaptureRecord) == 44, "CaptureRecord layout changed");
+
+/** Fills a header with defaults: no channels, scale 1, raw units. */
+CaptureHeader CaptureDefaultHeader();
+
+/**
+ * CaptureWriter appends records and writes the index on Close(). Timestamps
+ * must not go backwards.
+ */
+class CaptureWriter {
+public:
+    ~CaptureWriter();
+
+    bool Open(const std::string &path, const CaptureHeader &header, std::string &err);
+    bool Append(const ImuRecord &rec);
+    bool Close(std::string &err);
+
+    std::uint64_t Count() const { return header_.count; }
+
+private:
+    FILE *f_ = nullptr;
+    CaptureHeader header_{};
+    std::vector<double> index_;
+    std::vector<char> buffer_;
+    bool ordered_ = true;
+};
+
+/** CaptureReader maps a capture for random access. */
+class CaptureReader {
+public:
+    bool Open(const std::string &path, std::string &err);
+
+    const CaptureHeader &Header() const { return *header_; }
+    std::uint64_t Size() const { return header_->count; }
+
+    /** Record i, 0 <= i < Size(). */
+    ImuRecord At(std::uint64_t i) const;
+
+    /** First record with t >= time (Size() if none). */
+    std::uint64_t LowerBound(double time) const;
+
+    /** Records in [begin, end), e.g. from LowerBound() of a time window. */
+    struct Range {
+        const CaptureReader *r;
+        std::uint64_t first, last;
+
+        class Iterator {
+        public:
+            Iterator(const CaptureReader *r, std::uint64_t i) : r_(r), i_(i) {}
+            ImuRecord operator*() const { return r_->At(i_); }
+            Iterator &operator++() { i_++; return *this; }
+            bool operator!=(const Iterator &o) const { return i_ != o.i_; }
+
+        private:
+            const CaptureReader *r_;
+            std::uint64_t i_;
+        };
+        Iterator begin() const { return Iterator(r, first); }
+        Iterator end() const { return Iterator(r, last); }
+        std::uint64_t size() const { return last - first; }
+    };
+
+    /** All records with t0 <= t < t1. */
+    Range Window(double t0, double t1) const;
+    Range All() const { return Range{this, 0, Size()}; }
+
+private:
+    MappedFile file_;
+    const CaptureHeader *header_ = nullptr;
+    const char *data_ = nullptr;
+    const char *index_ = nullptr;
+};
+
+/** True if the path looks like a binary capture (by its magic). */
+bool IsCapture(const std::string &path);
+
+#endif // IMU_CAPTURE_H
@@ -0,0 +1,330 @@
+/*
+ * File:   ImuMath.cpp
+ *
+ * Host side vector math and batch calibration algorithms.
+ */
+
+#include "ImuMath.h"
+
+#include <algorithm>
+#include <cstring>
+
+Mat3 Mat3::Identity() {
+    Mat3 I;
+    I.m[0][0] = I.m[1][1] = I.m[2][2] = 1.0;
+    return I;
+}
+
+Vec3 operator+(const Vec3 &a, const Vec3 &b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+Vec3 operator-(const Vec3 &a, const Vec3 &b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Vec3 operator*(double s, const Vec3 &v) { return {s * v.x, s * v.y, s * v.z}; }
+
+Vec3 operator*(const Mat3 &A, const Vec3 &v) {
+    return {A.m[0][0] * v.x + A.m[0][1] * v.y + A.m[0][2] * v.z,
+            A.m[1][0] * v.x + A.m[1][1] * v.y + A.m[1][2] * v.z,
+            A.m[2][0] * v.x + A.m[2][1] * v.y + A.m[2][2] * v.z};
+}
+
+Mat3 operator*(const Mat3 &A, const Mat3 &B) {
+    Mat3 R;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            R.m[i][j] = A.m[i][0] * B.m[0][j] + A.m[i][1] * B.m[1][j] + A.m[i][2] * B.m[2][j];
+        }
+    }
+    return R;
+}
+
+double Dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+Vec3 Cross(const Vec3 &a, const Vec3 &b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+double Norm(const Vec3 &v) { return std::sqrt(Dot(v, v)); }
+
+Vec3 Normalize(const Vec3 &v) {
+    double n = Norm(v);
+    return n > 0.0 ? (1.0 / n) * v : v;
+}
+
+Mat3 Transpose(const Mat3 &A) {
+    Mat3 T;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            T.m[i][j] = A.m[j][i];
+        }
+    }
+    return T;
+}
+
+double Determinant(const Mat3 &A) {
+    const double(*m)[3] = A.m;
+    return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+         - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+         + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+Mat3 Rexp(const Vec3 &w, double dt) {
+    double wnorm = Norm(w);
+    double theta = wnorm * dt;
+    double sinc, oneMinusCos;
+    if (std::fabs(theta) < 1e-3) {
+        double t2 = theta * theta;
+        sinc = dt * (1.0 - t2 / 6.0 + t2 * t2 / 120.0);
+        oneMinusCos = dt * dt * (0.5 - t2 / 24.0 + t2 * t2 / 720.0);
+    } else {
+        sinc = std::sin(theta) / wnorm;
+        oneMinusCos = (1.0 - std::cos(theta)) / (wnorm * wnorm);
+    }
+    // rcross(w) = [0 -wz wy; wz 0 -wx; -wy wx 0], R = I - sinc*W + (1-cos)*W^2
+    Mat3 W;
+    W.m[0][1] = -w.z; W.m[0][2] = w.y;
+    W.m[1][0] = w.z;  W.m[1][2] = -w.x;
+    W.m[2][0] = -w.y; W.m[2][1] = w.x;
+    Mat3 W2 = W * W;
+    Mat3 R = Mat3::Identity();
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            R.m[i][j] += -sinc * W.m[i][j] + oneMinusCos * W2.m[i][j];
+        }
+    }
+    return R;
+}
+
+void SymmetricEigen(double *a, int n, double *values, double *vectors) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            vectors[i * n + j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+    for (int sweep = 0; sweep < 64; sweep++) {
+        double off = 0.0;
+        for (int p = 0; p < n; p++) {
+            for (int q = p + 1; q < n; q++) {
+                off += a[p * n + q] * a[p * n + q];
+            }
+        }
+        if (off < 1e-30) {
+            break;
+        }
+        for (int p = 0; p < n; p++) {
+            for (int q = p + 1; q < n; q++) {
+                double apq = a[p * n + q];
+                if (std::fabs(apq) < 1e-300) {
+                    continue;
+                }
+                double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+                for (int k = 0; k < n; k++) {
+                    double akp = a[k * n + p], akq = a[k * n + q];
+                    a[k * n + p] = c * akp - s * akq;
+                    a[k * n + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; k++) {
+                    double apk = a[p * n + k], aqk = a[q * n + k];
+                    a[p * n + k] = c * apk - s * aqk;
+                    a[q * n + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; k++) {
+                    double vkp = vectors[k * n + p], vkq = vectors[k * n + q];
+                    vectors[k * n + p] = c * vkp - s * vkq;
+                    vectors[k * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        values[i] = a[i * n + i];
+    }
+}
+
+// Solves the 4x4 SPD system N x = r by Cholesky, three right hand sides.
+static bool Cholesky4(double N[4][4], double r[3][4], double x[3][4]) {
+    double L[4][4] = {{0}};
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j <= i; j++) {
+            double s = N[i][j];
+            for (int k = 0; k < j; k++) {
+                s -= L[i][k] * L[j][k];
+            }
+            if (i == j) {
+                if (s <= 0.0) {
+                    return false;
+                }
+                L[i][i] = std::sqrt(s);
+            } else {
+                L[i][j] = s / L[j][j];
+            }
+        }
+    }
+    for (int c = 0; c < 3; c++) {
+        double y[4];
+        for (int i = 0; i < 4; i++) {
+            double s = r[c][i];
+            for (int k = 0; k < i; k++) {
+                s -= L[i][k] * y[k];
+            }
+            y[i] = s / L[i][i];
+        }
+        for (int i = 3; i >= 0; i--) {
+            double s = y[i];
+            for (int k = i + 1; k < 4; k++) {
+                s -= L[k][i] * x[c][k];
+            }
+            x[c][i] = s / L[i][i];
+        }
+    }
+    return true;
+}
+
+bool EllipsoidFit(const std::vector<Vec3> &raw, int kstep, Mat3 &A, Vec3 &b) {
+    if (raw.size() < 12) {
+        return false;
+    }
+    // Start from the mean-centered data, exactly like the MATLAB version.
+    Vec3 mean;
+    for (const Vec3 &v : raw) {
+        mean = mean + v;
+    }
+    mean = (1.0 / raw.size()) * mean;
+    A = Mat3::Identity();
+    b = -1.0 * mean;
+
+    std::vector<Vec3> xi(raw.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+        xi[i] = raw[i] + b;
+    }
+
+    // The 3n x 12 system in M\Y is block diagonal: every output row shares the
+    // regressor [x y z 1], so it collapses to one 4x4 normal matrix with three
+    // right hand sides.
+    for (int k = 0; k < kstep; k++) {
+        double N[4][4] = {{0}};
+        double r[3][4] = {{0}};
+        for (const Vec3 &v : xi) {
+            double n = Norm(v);
+            if (n == 0.0) {
+                continue;
+            }
+            double phi[4] = {v.x, v.y, v.z, 1.0};
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    N[i][j] += phi[i] * phi[j];
+                }
+                for (int c = 0; c < 3; c++) {
+                    r[c][i] += phi[i] * v[c] / n;
+                }
+            }
+        }
+        double p[3][4];
+        if (!Cholesky4(N, r, p)) {
+            return false;
+        }
+        Mat3 Ak;
+        Vec3 bk;
+        for (int c = 0; c < 3; c++) {
+            Ak.m[c][0] = p[c][0];
+            Ak.m[c][1] = p[c][1];
+            Ak.m[c][2] = p[c][2];
+            bk[c] = p[c][3];
+        }
+        for (Vec3 &v : xi) {
+            v = Ak * v + bk;
+        }
+        b = Ak * b + bk;
+        A = Ak * A;
+    }
+    return true;
+}
+
+Mat3 Wahba(const std::vector<Vec3> &from, const std::vector<Vec3> &to) {
+    // Attitude profile matrix B = sum to_i from_i', Davenport K matrix, and the
+    // quaternion is the eigenvector of the largest eigenvalue of K.
+    Mat3 B;
+    size_t n = std::min(from.size(), to.size());
+    for (size_t i = 0; i < n; i++) {
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                B.m[r][c] += to[i][r] * from[i][c];
+            }
+        }
+    }
+    double sigma = B.m[0][0] + B.m[1][1] + B.m[2][2];
+    double z[3] = {B.m[1][2] - B.m[2][1], B.m[2][0] - B.m[0][2], B.m[0][1] - B.m[1][0]};
+    double K[16];
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            K[r * 4 + c] = B.m[r][c] + B.m[c][r] - (r == c ? sigma : 0.0);
+        }
+        K[r * 4 + 3] = z[r];
+        K[3 * 4 + r] = z[r];
+    }
+    K[15] = sigma;
+
+    double values[4], vectors[16];
+    SymmetricEigen(K, 4, values, vectors);
+    int best = 0;
+    for (int i = 1; i < 4; i++) {
+        if (values[i] > values[best]) {
+            best = i;
+        }
+    }
+    double q1 = vectors[0 * 4 + best], q2 = vectors[1 * 4 + best];
+    double q3 = vectors[2 * 4 + best], q4 = vectors[3 * 4 + best];
+
+    // Attitude matrix of q (maps "from" into "to").
+    Mat3 R;
+    R.m[0][0] = q1 * q1 - q2 * q2 - q3 * q3 + q4 * q4;
+    R.m[0][1] = 2.0 * (q1 * q2 + q3 * q4);
+    R.m[0][2] = 2.0 * (q1 * q3 - q2 * q4);
+    R.m[1][0] = 2.0 * (q1 * q2 - q3 * q4);
+    R.m[1][1] = -q1 * q1 + q2 * q2 - q3 * q3 + q4 * q4;
+    R.m[1][2] = 2.0 * (q2 * q3 + q1 * q4);
+    R.m[2][0] = 2.0 * (q1 * q3 + q2 * q4);
+    R.m[2][1] = 2.0 * (q2 * q3 - q1 * q4);
+    R.m[2][2] = -q1 * q1 - q2 * q2 + q3 * q3 + q4 * q4;
+    return R;
+}
+
+Mat3 AlignPrimarySecondary(const std::vector<Vec3> &Pb, const std::vector<Vec3> &Sb,
+                           const Vec3 &pi, const Vec3 &si, int iterations) {
+    const double tol = 1e-15;
+    size_t n = std::min(Pb.size(), Sb.size());
+    Vec3 pin = Normalize(pi), sin = Normalize(si);
+    std::vector<Vec3> Pbn(n), Sbn(n), Sbhat(n), Sihat(n);
+    for (size_t i = 0; i < n; i++) {
+        Pbn[i] = Normalize(Pb[i]);
+        Sbn[i] = Normalize(Sb[i]);
+    }
+    std::vector<Vec3> inertial = {pin, sin};
+    std::vector<Vec3> body(2);
+
+    Mat3 Rmis = Mat3::Identity();
+    for (int iter = 0; iter < iterations; iter++) {
+        Mat3 RmisT = Transpose(Rmis);
+        for (size_t i = 0; i < n; i++) {
+            // Attitude of sample i from the primary and the corrected secondary,
+            // then the secondary's inertial direction seen in the body frame.
+            body[0] = Pbn[i];
+            body[1] = RmisT * Sbn[i];
+            Mat3 Ri = Wahba(inertial, body);
+            Sihat[i] = Ri * sin;
+        }
+        Mat3 old = Rmis;
+        Rmis = Wahba(Sihat, Sbn);
+        double delta = 0.0;
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                double d = Rmis.m[r][c] - old.m[r][c];
+                delta += d * d;
+            }
+        }
+        if (std::sqrt(delta) < tol) {
+            break;
+        }
+    }
+    return Rmis;
+}
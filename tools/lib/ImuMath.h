@@ -0,0 +1,93 @@
+/**
+ * @file    ImuMath.h
+ *
+ * Small double precision 3-vector / 3x3 matrix library for the host tools,
+ * plus the batch calibration algorithms used in the Lab3/Lab4 MATLAB code:
+ *
+ *  + EllipsoidFit()   - iterated least squares ellipsoid calibration
+ *                       (CalibrateEllipsoidData3D.m, Dorveaux)
+ *  + Wahba()          - optimal rotation between two vector sets
+ *                       (whabaSVD.m, solved with Davenport's q-method)
+ *  + AlignPrimarySecondary() - misalignment of a secondary sensor triad
+ *                       against a primary one (AlignPrimarySecondary.m)
+ *
+ * Matrices are row-major, same as MatrixMath on the device.
+ */
+
+#ifndef IMU_MATH_H
+#define IMU_MATH_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+struct Vec3 {
+    double x = 0.0, y = 0.0, z = 0.0;
+
+    double &operator[](int i) { return i == 0 ? x : (i == 1 ? y : z); }
+    double operator[](int i) const { return i == 0 ? x : (i == 1 ? y : z); }
+};
+
+struct Mat3 {
+    double m[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+
+    static Mat3 Identity();
+};
+
+Vec3 operator+(const Vec3 &a, const Vec3 &b);
+Vec3 operator-(const Vec3 &a, const Vec3 &b);
+Vec3 operator*(double s, const Vec3 &v);
+Vec3 operator*(const Mat3 &A, const Vec3 &v);
+Mat3 operator*(const Mat3 &A, const Mat3 &B);
+
+double Dot(const Vec3 &a, const Vec3 &b);
+Vec3 Cross(const Vec3 &a, const Vec3 &b);
+double Norm(const Vec3 &v);
+Vec3 Normalize(const Vec3 &v);
+Mat3 Transpose(const Mat3 &A);
+double Determinant(const Mat3 &A);
+
+/** Rodrigues formula, exp([w x] dt), same as Rexp.m. */
+Mat3 Rexp(const Vec3 &w, double dt);
+
+/**
+ * SymmetricEigen solves A v = lambda v for a symmetric NxN matrix with the
+ * cyclic Jacobi method.
+ * @param: a, row-major NxN matrix, destroyed
+ * @param: n, dimension
+ * @param: values, receives the N eigenvalues
+ * @param: vectors, row-major NxN, column k is the eigenvector of values[k]
+ */
+void SymmetricEigen(double *a, int n, double *values, double *vectors);
+
+/**
+ * EllipsoidFit calibrates a 3D tumble so that A*raw + b lies on the unit
+ * sphere, iterating the linear least squares step kstep times.
+ * @param: raw, tumble samples
+ * @param: kstep, number of iterations (2-20)
+ * @param: A, receives the scale/cross-coupling matrix
+ * @param: b, receives the offset
+ * @return: false if the data are degenerate
+ */
+bool EllipsoidFit(const std::vector<Vec3> &raw, int kstep, Mat3 &A, Vec3 &b);
+
+/**
+ * Wahba returns the rotation R minimizing sum |to_i - R from_i|^2 over unit
+ * vectors, equal weights.
+ */
+Mat3 Wahba(const std::vector<Vec3> &from, const std::vector<Vec3> &to);
+
+/**
+ * AlignPrimarySecondary finds Rmis such that Rmis' * Sbmeas lines up with the
+ * primary sensor frame, given the inertial directions of both fields.
+ * @param: Pb, primary body measurements (e.g. accel)
+ * @param: Sb, secondary body measurements (e.g. mag)
+ * @param: pi, primary inertial reference
+ * @param: si, secondary inertial reference
+ * @param: iterations, maximum number of iterations
+ * @return: Rmis
+ */
+Mat3 AlignPrimarySecondary(const std::vector<Vec3> &Pb, const std::vector<Vec3> &Sb,
+                           const Vec3 &pi, const Vec3 &si, int iterations);
+
+#endif // IMU_MATH_H
@@ -0,0 +1,202 @@
+/*
+ * File:   ImuSim.cpp
+ *
+ * Synthetic IMU streams.
+ */
+
+#include "ImuSim.h"
+
+#include <cmath>
+
+#define DEG2RAD (M_PI / 180.0)
+#define RAD2DEG (180.0 / M_PI)
+
+// splitmix64, spreads a small seed over the xoshiro state
+static std::uint64_t SplitMix(std::uint64_t &x) {
+    std::uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline std::uint64_t Rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+Rng::Rng(std::uint64_t seed) {
+    for (std::uint64_t &s : s_) {
+        s = SplitMix(seed);
+    }
+}
+
+std::uint64_t Rng::Next() {
+    std::uint64_t result = Rotl(s_[1] * 5, 7) * 9;
+    std::uint64_t t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = Rotl(s_[3], 45);
+    return result;
+}
+
+double Rng::Uniform() { return (double)(Next() >> 11) * 0x1.0p-53; }
+
+double Rng::Normal() {
+    if (haveSpare_) {
+        haveSpare_ = false;
+        return spare_;
+    }
+    double u, v, s;
+    do {
+        u = 2.0 * Uniform() - 1.0;
+        v = 2.0 * Uniform() - 1.0;
+        s = u * u + v * v;
+    } while (s >= 1.0 || s == 0.0);
+    double f = std::sqrt(-2.0 * std::log(s) / s);
+    spare_ = v * f;
+    haveSpare_ = true;
+    return u * f;
+}
+
+// Gram-Schmidt on the rows, keeps a long product of Rexp a rotation.
+static void Orthonormalize(Mat3 &R) {
+    Vec3 r0{R.m[0][0], R.m[0][1], R.m[0][2]};
+    Vec3 r1{R.m[1][0], R.m[1][1], R.m[1][2]};
+    r0 = Normalize(r0);
+    r1 = Normalize(r1 - Dot(r0, r1) * r0);
+    Vec3 r2 = Cross(r0, r1);
+    for (int j = 0; j < 3; j++) {
+        R.m[0][j] = r0[j];
+        R.m[1][j] = r1[j];
+        R.m[2][j] = r2[j];
+    }
+}
+
+static Vec3 RandomVector(Rng &rng, double scale) {
+    return {scale * rng.Centered(), scale * rng.Centered(), scale * rng.Centered()};
+}
+
+// I + scale and cross coupling terms, then the misalignment rotation.
+static Mat3 RandomDistortion(Rng &rng, const SimSensorError &e) {
+    Mat3 D = Mat3::Identity();
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            D.m[i][j] += (i == j ? e.scale : e.cross) * rng.Centered();
+        }
+    }
+    if (e.misalign != 0.0) {
+        Vec3 axis = Normalize({rng.Normal(), rng.Normal(), rng.Normal()});
+        D = Rexp(axis, e.misalign * DEG2RAD) * D;
+    }
+    return D;
+}
+
+static void Euler(const Mat3 &R, SimTruth &t) {
+    t.yaw = std::atan2(R.m[0][1], R.m[0][0]) * RAD2DEG;
+    t.pitch = -std::asin(std::fmax(-1.0, std::fmin(1.0, R.m[0][2]))) * RAD2DEG;
+    t.roll = std::atan2(R.m[1][2], R.m[2][2]) * RAD2DEG;
+}
+
+// Rate profile of CreateTrajectoryData.m, deg/s: 1 s still, 180 deg out with
+// a smooth rise and fall, 1 s still, back, 1 s still.
+static std::vector<double> RoundTrip(double dt) {
+    const double Tp = 0.5, Tc = 3.0, total = 180.0;
+    const double maxRate = total / (Tp + Tc);
+    int rise = (int)std::lround(Tp / dt);
+    int cruise = (int)std::lround(Tc / dt);
+    int still = (int)std::lround(1.0 / dt) + 1;
+
+    std::vector<double> leg;
+    for (int i = 0; i < rise; i++) {
+        double x = i * dt / Tp;
+        leg.push_back(maxRate * (3 * x * x - 2 * x * x * x));
+    }
+    leg.insert(leg.end(), cruise, maxRate);
+    for (int i = 0; i < rise; i++) {
+        double x = i * dt / Tp;
+        leg.push_back(maxRate * (1.0 - (3 * x * x - 2 * x * x * x)));
+    }
+    leg.push_back(0.0);
+
+    std::vector<double> trip(still, 0.0);
+    trip.insert(trip.end(), leg.begin(), leg.end());
+    trip.insert(trip.end(), still, 0.0);
+    for (double w : leg) {
+        trip.push_back(-w);
+    }
+    trip.insert(trip.end(), still, 0.0);
+    return trip;
+}
+
+static const double tripAxes[6][3] = {
+    {0, 0, 1}, {0, 1, 0}, {1, 0, 0}, {1, 0, -1}, {0, -1, 1}, {-1, 1, 0},
+};
+
+ImuSim::ImuSim(const SimConfig &config) : c_(config), rng_(config.seed), dt_(1.0 / config.rate) {
+    R_ = Rexp(RandomVector(rng_, 2.0 * M_PI), 1.0);
+    const SimSensorError *e[3] = {&c_.accel, &c_.mag, &c_.gyro};
+    for (int s = 0; s < 3; s++) {
+        D_[s] = RandomDistortion(rng_, *e[s]);
+        bias_[s] = RandomVector(rng_, e[s]->bias);
+    }
+    trip_ = RoundTrip(dt_);
+}
+
+Vec3 ImuSim::TrajectoryRate() {
+    const double *axes = tripAxes[(k_ / trip_.size()) % 6];
+    double w = trip_[k_ % trip_.size()];
+    return {axes[0] * w, axes[1] * w, axes[2] * w};
+}
+
+Vec3 ImuSim::TumbleRate() {
+    // exact discretization of dw = -w / T dt + sigma sqrt(2 / T) dW
+    double a = std::exp(-dt_ / c_.tumbleTime);
+    double b = c_.tumbleRate * std::sqrt(1.0 - a * a);
+    for (int i = 0; i < 3; i++) {
+        rate_[i] = a * rate_[i] + b * rng_.Normal();
+    }
+    return rate_;
+}
+
+void ImuSim::Next(ImuRecord &rec, SimTruth *truth) {
+    Vec3 w;
+    switch (c_.motion) {
+    case SIM_TRAJECTORY: w = TrajectoryRate(); break;
+    case SIM_TUMBLE: w = TumbleRate(); break;
+    default: break;
+    }
+
+    Vec3 a = D_[0] * (R_ * c_.gravity) + bias_[0];
+    Vec3 h = D_[1] * (R_ * c_.field) + bias_[1];
+    Vec3 g = D_[2] * w + bias_[2];
+    double lsb[3] = {c_.accelLsb, c_.magLsb, c_.gyroLsb};
+    const SimSensorError *e[3] = {&c_.accel, &c_.mag, &c_.gyro};
+    Vec3 *v[3] = {&a, &h, &g};
+    rec.t = (double)k_ * dt_;
+    for (int s = 0; s < 3; s++) {
+        for (int i = 0; i < 3; i++) {
+            double x = (*v[s])[i] + e[s]->noise * rng_.Normal();
+            rec.Channel(3 * s + i) = (float)(lsb[s] > 0.0 ? std::nearbyint(x * lsb[s]) : x);
+        }
+    }
+
+    if (truth != nullptr) {
+        truth->R = R_;
+        truth->rate = w;
+        truth->gyroBias = bias_[2];
+        Euler(R_, *truth);
+    }
+
+    if (c_.gyroWalk > 0.0) {
+        double step = c_.gyroWalk * std::sqrt(dt_);
+        for (int i = 0; i < 3; i++) {
+            bias_[2][i] += step * rng_.Normal();
+        }
+    }
+    if (c_.motion != SIM_STILL) {
+        R_ = Rexp(DEG2RAD * w, dt_) * R_;
+    }
+    if ((++k_ & 1023) == 0) {
+        Orthonormalize(R_);
+    }
+}
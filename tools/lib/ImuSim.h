@@ -0,0 +1,128 @@
+/**
+ * @file    ImuSim.h
+ *
+ * Synthetic IMU streams for the host tools, the native version of
+ * CreateTrajectoryData.m and CreateTumbleData.m: a true attitude is propagated
+ * along a motion profile and turned into accel, mag and gyro readings with
+ * per-sensor scale error, cross coupling, misalignment, bias and noise.
+ *
+ * Samples come out one at a time as ImuRecord (same layout the CSV and
+ * .imucap readers give), so a generator can feed an estimator directly or be
+ * written to a capture.
+ *
+ * Frames follow the MATLAB code: R maps inertial (NED) to body, a = R * g,
+ * h = R * He, and R(k+1) = Rexp(w dt) * R(k) with w the body rate.
+ */
+
+#ifndef IMU_SIM_H
+#define IMU_SIM_H
+
+#include <cstdint>
+#include <vector>
+
+#include "CsvStream.h"
+#include "ImuMath.h"
+
+/** xoshiro256** with a polar method normal, ~2 ns per draw. */
+class Rng {
+public:
+    explicit Rng(std::uint64_t seed = 1);
+
+    std::uint64_t Next();
+    /** Uniform in [0, 1). */
+    double Uniform();
+    /** Uniform in [-0.5, 0.5), MATLAB's rand - 0.5. */
+    double Centered() { return Uniform() - 0.5; }
+    double Normal();
+
+private:
+    std::uint64_t s_[4];
+    double spare_ = 0.0;
+    bool haveSpare_ = false;
+};
+
+enum SimMotion {
+    SIM_TRAJECTORY,     // CreateTrajectoryData.m round trips about each axis pair, repeated
+    SIM_TUMBLE,         // random smooth rotation covering the sphere (calibration tumbles)
+    SIM_STILL,          // constant attitude (bias, Allan deviation)
+};
+
+/** Error model of one sensor triad: out = D * truth + bias + noise. */
+struct SimSensorError {
+    double scale = 0.0;         // per axis scale error, uniform +-scale/2
+    double cross = 0.0;         // off-diagonal coupling, uniform +-cross/2
+    double misalign = 0.0;      // rotation about a random axis, deg
+    double bias = 0.0;          // per axis bias, uniform +-bias/2, sensor units
+    double noise = 0.0;         // white noise rms, sensor units
+};
+
+struct SimConfig {
+    SimMotion motion = SIM_TRAJECTORY;
+    double rate = 50.0;                     // Hz
+    std::uint64_t seed = 1;
+
+    // Sensor units: g, nT, deg/s. Defaults are CreateTrajectoryData.m's.
+    SimSensorError accel{0.0, 0.0, 0.0, 0.0, 0.008};
+    SimSensorError mag{0.0, 0.0, 0.0, 0.0, 0.01 * 47613.0};
+    SimSensorError gyro{0.0, 0.0, 0.0, 10.0, 0.1};
+    double gyroWalk = 0.0;                  // bias random walk, deg/s/sqrt(s)
+
+    Vec3 gravity{0.0, 0.0, 1.0};            // g, NED
+    Vec3 field{22770.0, 5329.0, 41510.2};   // He in nT, NED
+
+    // Tumble: body rate is an Ornstein-Uhlenbeck process.
+    double tumbleRate = 90.0;               // rms per axis, deg/s
+    double tumbleTime = 1.0;                // correlation time, s
+
+    // Raw output: readings are rounded to counts at these scales,
+    // 0 leaves them in sensor units.
+    double accelLsb = 0.0;                  // counts per g
+    double magLsb = 0.0;                    // counts per nT
+    double gyroLsb = 0.0;                   // counts per deg/s
+};
+
+/** BNO055 scales as the firmware sees them (acc_raw.csv, 180 / 13500 gyro). */
+#define SIM_ACCEL_LSB 1000.0
+#define SIM_MAG_LSB 0.016
+#define SIM_GYRO_LSB 75.0
+
+/** True state of a sample. */
+struct SimTruth {
+    Mat3 R;                 // inertial to body
+    Vec3 rate;              // body rate, deg/s
+    Vec3 gyroBias;          // deg/s
+    double yaw, pitch, roll;    // deg, same extraction as the MATLAB code
+};
+
+class ImuSim {
+public:
+    explicit ImuSim(const SimConfig &config);
+
+    /** Next sample, t = k / rate. truth may be null. */
+    void Next(ImuRecord &rec, SimTruth *truth = nullptr);
+
+    /** Distortion matrices drawn for this run, out = D * truth + bias. */
+    const Mat3 &Distortion(int sensor) const { return D_[sensor]; }
+    const Vec3 &Bias(int sensor) const { return bias_[sensor]; }
+
+    const SimConfig &Config() const { return c_; }
+    std::uint64_t Count() const { return k_; }
+
+private:
+    Vec3 TrajectoryRate();
+    Vec3 TumbleRate();
+
+    SimConfig c_;
+    Rng rng_;
+    double dt_;
+    std::uint64_t k_ = 0;
+    Mat3 R_;
+    Mat3 D_[3];
+    Vec3 bias_[3];
+    Vec3 rate_;             // tumble state
+
+    // CreateTrajectoryData.m: one round trip rate profile, flown about 6 axis patterns
+    std::vector<double> trip_;
+};
+
+#endif // IMU_SIM_H
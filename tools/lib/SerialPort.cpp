@@ -0,0 +1,61 @@
+/*
+ * File:   SerialPort.cpp
+ *
+ * Raw mode serial input for the capture tools.
+ */
+
+#include "SerialPort.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+static speed_t BaudConstant(int baud) {
+    switch (baud) {
+    case 9600: return B9600;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B0;
+    }
+}
+
+int SerialOpen(const std::string &path, int baud, std::string &err) {
+    if (path == "-") {
+        return STDIN_FILENO;
+    }
+    int fd = open(path.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        err = "can't open " + path + ": " + std::strerror(errno);
+        return -1;
+    }
+    if (isatty(fd)) {
+        speed_t speed = BaudConstant(baud);
+        struct termios tio;
+        if (speed == B0 || tcgetattr(fd, &tio) != 0) {
+            err = speed == B0 ? "unsupported baud rate " + std::to_string(baud)
+                              : path + ": " + std::strerror(errno);
+            close(fd);
+            return -1;
+        }
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIFLUSH);
+    }
+    return fd;
+}
+
+void SerialClose(int fd) {
+    if (fd >= 0 && fd != STDIN_FILENO) {
+        close(fd);
+    }
+}
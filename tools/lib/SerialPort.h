@@ -0,0 +1,24 @@
+/**
+ * @file    SerialPort.h
+ *
+ * Opening the board's serial port (or a pty standing in for it) for the
+ * capture tools: raw mode, no echo, no CR/LF translation, so binary frames
+ * and printf text arrive byte for byte.
+ */
+
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <string>
+
+/**
+ * Opens path read only; "-" is stdin. A tty is put in raw mode at baud
+ * (9600 to 921600, ignored by a pty). Returns the descriptor, or -1 with
+ * err set.
+ */
+int SerialOpen(const std::string &path, int baud, std::string &err);
+
+/** Closes a descriptor from SerialOpen(), leaving stdin alone. */
+void SerialClose(int fd);
+
+#endif // SERIAL_PORT_H
@@ -0,0 +1,159 @@
+/*
+ * File:   TelemetryDecoder.cpp
+ *
+ * COBS/CRC decoder (and encoder) for the firmware telemetry stream.
+ */
+
+#include "TelemetryDecoder.h"
+
+#include <cstring>
+
+// Longest encoded frame the firmware sends, anything longer is not a frame.
+static const std::size_t kMaxPacket = sizeof(TelemHeader) + TELEM_MAX_PAYLOAD + 2;
+static const std::size_t kMaxFrame = kMaxPacket + kMaxPacket / 254 + 1;
+
+std::uint16_t TelemetryDecoder::Crc16(const std::uint8_t *data, std::size_t n) {
+    std::uint16_t crc = 0xFFFF;
+    for (std::size_t i = 0; i < n; i++) {
+        crc ^= (std::uint16_t)(data[i] << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (std::uint16_t)((crc << 1) ^ 0x1021) : (std::uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool TelemetryDecoder::CobsDecode(const std::uint8_t *in, std::size_t n, std::vector<std::uint8_t> &out) {
+    out.clear();
+    std::size_t i = 0;
+    while (i < n) {
+        std::uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > n) {
+            return false;
+        }
+        out.insert(out.end(), in + i, in + i + code - 1);
+        i += code - 1;
+        // A block shorter than 254 stood for a zero, except at the very end.
+        if (code != 0xFF && i < n) {
+            out.push_back(0);
+        }
+    }
+    return true;
+}
+
+std::size_t TelemetryDecoder::PayloadSize(std::uint8_t type) {
+    switch (type) {
+    case TELEM_RAW: return sizeof(TelemRaw);
+    case TELEM_CALIBRATED: return sizeof(TelemCalibrated);
+    case TELEM_ATTITUDE: return sizeof(TelemAttitude);
+    case TELEM_LOOP: return sizeof(TelemLoop);
+    default: return 0;
+    }
+}
+
+void TelemetryDecoder::Feed(const std::uint8_t *data, std::size_t n, const Handler &fn) {
+    stats_.bytes += n;
+    for (std::size_t i = 0; i < n; i++) {
+        if (data[i] != 0) {
+            if (frame_.size() < kMaxFrame) {
+                frame_.push_back(data[i]);
+            } else {
+                overflow_ = true;
+            }
+            continue;
+        }
+        if (overflow_) {
+            stats_.malformed++;
+        } else if (!frame_.empty()) {
+            Frame(fn);
+        }
+        frame_.clear();
+        overflow_ = false;
+    }
+}
+
+void TelemetryDecoder::Frame(const Handler &fn) {
+    if (!CobsDecode(frame_.data(), frame_.size(), packet_) || packet_.size() < sizeof(TelemHeader) + 2) {
+        stats_.malformed++;
+        return;
+    }
+    std::size_t body = packet_.size() - 2;
+    std::uint16_t crc = (std::uint16_t)(packet_[body] | packet_[body + 1] << 8);
+    if (Crc16(packet_.data(), body) != crc) {
+        stats_.crcErrors++;
+        return;
+    }
+
+    TelemFrame f;
+    std::memcpy(&f.header, packet_.data(), sizeof(f.header));
+    f.payload = packet_.data() + sizeof(TelemHeader);
+    f.size = body - sizeof(TelemHeader);
+
+    // The sequence counts every frame, unknown types included.
+    if (haveSeq_ && f.header.seq != nextSeq_) {
+        stats_.lost += (std::uint16_t)(f.header.seq - nextSeq_);
+    }
+    haveSeq_ = true;
+    nextSeq_ = (std::uint16_t)(f.header.seq + 1);
+
+    if (f.header.version != TELEM_VERSION) {
+        stats_.malformed++;
+        return;
+    }
+    std::size_t expect = PayloadSize(f.header.type);
+    if (expect == 0) {
+        stats_.unknownTypes++;
+        return;
+    }
+    if (f.size != expect) {
+        stats_.malformed++;
+        return;
+    }
+
+    // t_us wraps every 2^32 us; frames of different tasks can be a little out
+    // of order, so step by the signed difference.
+    if (haveTime_) {
+        timeUs_ += (std::int32_t)(f.header.tUs - lastUs_);
+    } else {
+        timeUs_ = f.header.tUs;
+        haveTime_ = true;
+    }
+    lastUs_ = f.header.tUs;
+    f.t = timeUs_ * 1e-6;
+
+    stats_.frames++;
+    stats_.perType[f.header.type]++;
+    fn(f);
+}
+
+void TelemEncode(std::uint8_t type, std::uint16_t seq, std::uint32_t tUs, const void *payload,
+                 std::size_t size, std::vector<std::uint8_t> &out) {
+    TelemHeader h = {TELEM_VERSION, type, seq, tUs};
+    const std::uint8_t *head = reinterpret_cast<const std::uint8_t *>(&h);
+    const std::uint8_t *body = static_cast<const std::uint8_t *>(payload);
+    std::vector<std::uint8_t> packet(head, head + sizeof(h));
+    packet.insert(packet.end(), body, body + size);
+    std::uint16_t crc = TelemetryDecoder::Crc16(packet.data(), packet.size());
+    packet.push_back((std::uint8_t)crc);
+    packet.push_back((std::uint8_t)(crc >> 8));
+
+    // COBS: each block starts with the distance to the next zero.
+    out.assign(1, 0);
+    std::size_t code = 0;
+    for (std::uint8_t b : packet) {
+        if (b == 0) {
+            out[code] = (std::uint8_t)(out.size() - code);
+            code = out.size();
+            out.push_back(0);
+            continue;
+        }
+        out.push_back(b);
+        if (out.size() - code == 0xFF) {
+            out[code] = 0xFF;
+            code = out.size();
+            out.push_back(0);
+        }
+    }
+    out[code] = (std::uint8_t)(out.size() - code);
+    out.push_back(0);
+}
@@ -0,0 +1,138 @@
+/**
+ * @file    TelemetryDecoder.h
+ *
+ * Host side of the firmware's binary telemetry (Common/Telemetry.h): splits
+ * the serial byte stream at the 0x00 delimiters, undoes the COBS encoding,
+ * checks the CRC and hands out whole records. Anything else on the port
+ * (printf text, a frame cut by a reset) fails the checks, is counted and
+ * skipped; the next delimiter starts clean. TelemEncode() goes the other
+ * way, for the board simulator.
+ *
+ * The record layouts are copied from Common/Telemetry.h, bump both together.
+ */
+
+#ifndef TELEMETRY_DECODER_H
+#define TELEMETRY_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#define TELEM_VERSION 1
+#define TELEM_MAX_PAYLOAD 64
+
+enum TelemType : std::uint8_t {
+    TELEM_RAW = 1,
+    TELEM_CALIBRATED = 2,
+    TELEM_ATTITUDE = 3,
+    TELEM_LOOP = 4,
+};
+
+#pragma pack(push, 1)
+struct TelemHeader {
+    std::uint8_t version;
+    std::uint8_t type;
+    std::uint16_t seq;
+    std::uint32_t tUs;
+};
+
+struct TelemRaw {               // sensor counts
+    std::int16_t acc[3];
+    std::int16_t mag[3];
+    std::int16_t gyro[3];
+};
+
+struct TelemCalibrated {        // g, nT, deg/s
+    float acc[3];
+    float mag[3];
+    float gyro[3];
+};
+
+struct TelemAttitude {
+    float q[4];                 // w, x, y, z of the inertial to body DCM
+    float bias[3];              // rad/s
+};
+
+struct TelemLoop {
+    std::uint8_t id;
+    std::uint8_t worstPath;
+    std::uint16_t reserved;
+    std::uint32_t runs;
+    std::uint32_t misses;
+    std::uint32_t maxPeriodUs;
+    std::uint32_t maxExecUs;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TelemHeader) == 8, "TelemHeader layout changed");
+static_assert(sizeof(TelemRaw) == 18, "TelemRaw layout changed");
+static_assert(sizeof(TelemCalibrated) == 36, "TelemCalibrated layout changed");
+static_assert(sizeof(TelemAttitude) == 28, "TelemAttitude layout changed");
+static_assert(sizeof(TelemLoop) == 20, "TelemLoop layout changed");
+
+/** One checked record. */
+struct TelemFrame {
+    TelemHeader header;
+    double t;                   // seconds since the board's TIMER_Init(), unwrapped
+    const std::uint8_t *payload;
+    std::size_t size;
+
+    /** Copies the payload out; the caller has checked header.type. */
+    template <typename T> T As() const {
+        T v;
+        std::memcpy(&v, payload, sizeof(v));
+        return v;
+    }
+};
+
+struct TelemStats {
+    std::uint64_t bytes = 0;
+    std::uint64_t frames = 0;        // delivered
+    std::uint64_t crcErrors = 0;     // corrupted frames
+    std::uint64_t malformed = 0;     // bad COBS (printf text), too short or long, wrong version or size
+    std::uint64_t unknownTypes = 0;  // valid frames of a newer firmware, skipped
+    std::uint64_t lost = 0;          // sequence numbers that never arrived
+    std::uint64_t perType[256] = {};
+};
+
+class TelemetryDecoder {
+public:
+    using Handler = std::function<void(const TelemFrame &)>;
+
+    /** Decodes a chunk of the stream; frames may span chunks. */
+    void Feed(const std::uint8_t *data, std::size_t n, const Handler &fn);
+
+    const TelemStats &Stats() const { return stats_; }
+
+    /** CRC-16/CCITT-FALSE, as the firmware computes it. */
+    static std::uint16_t Crc16(const std::uint8_t *data, std::size_t n);
+
+    /** COBS decode of one frame without its delimiter, false if malformed. */
+    static bool CobsDecode(const std::uint8_t *in, std::size_t n, std::vector<std::uint8_t> &out);
+
+    /** Payload size of a known type, 0 for unknown types. */
+    static std::size_t PayloadSize(std::uint8_t type);
+
+private:
+    void Frame(const Handler &fn);
+
+    std::vector<std::uint8_t> frame_, packet_;
+    bool overflow_ = false;
+    bool haveSeq_ = false;
+    std::uint16_t nextSeq_ = 0;
+    bool haveTime_ = false;
+    std::uint32_t lastUs_ = 0;
+    std::int64_t timeUs_ = 0;
+    TelemStats stats_;
+};
+
+/**
+ * The firmware's TELEM_Send() on the host, for simulators: header, payload
+ * and CRC, COBS encoded and followed by the 0x00 delimiter. out is replaced.
+ */
+void TelemEncode(std::uint8_t type, std::uint16_t seq, std::uint32_t tUs, const void *payload,
+                 std::size_t size, std::vector<std::uint8_t> &out);
+
+#endif // TELEMETRY_DECODER_H
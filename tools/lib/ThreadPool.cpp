@@ -0,0 +1,83 @@
+/*
+ * File:   ThreadPool.cpp
+ *
+ * Worker threads for the batch tools.
+ */
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        workers_.emplace_back(&ThreadPool::Worker, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &t : workers_) {
+        t.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push(std::move(job));
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return jobs_.empty() && running_ == 0; });
+}
+
+void ThreadPool::Worker() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (stop_ && jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop();
+            running_++;
+        }
+        job();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_--;
+            if (jobs_.empty() && running_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
+
+void ParallelFor(ThreadPool &pool, std::size_t n, const std::function<void(std::size_t)> &fn) {
+    auto next = std::make_shared<std::atomic<std::size_t>>(0);
+    unsigned workers = pool.Size();
+    for (unsigned w = 0; w < workers; w++) {
+        pool.Submit([next, n, &fn] {
+            for (std::size_t i = (*next)++; i < n; i = (*next)++) {
+                fn(i);
+            }
+        });
+    }
+    pool.Wait();
+}
@@ -0,0 +1,50 @@
+/**
+ * @file    ThreadPool.h
+ *
+ * Fixed set of worker threads for the batch tools, plus ParallelFor() which
+ * hands out loop indices to the workers through an atomic counter so that
+ * uneven work items (long and short Allan clusters, Monte Carlo runs that
+ * stop early) balance themselves.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    /** threads = 0 uses std::thread::hardware_concurrency(). */
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void Submit(std::function<void()> job);
+
+    /** Blocks until every submitted job has finished. */
+    void Wait();
+
+    unsigned Size() const { return (unsigned)workers_.size(); }
+
+private:
+    void Worker();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable wake_, idle_;
+    std::size_t running_ = 0;
+    bool stop_ = false;
+};
+
+/** Runs fn(i) for i in [0, n) on the pool and waits for all of them. */
+void ParallelFor(ThreadPool &pool, std::size_t n, const std::function<void(std::size_t)> &fn);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,233 @@
+/*
+ * File:   telem2cap.cpp
+ *
+ * Decodes the firmware's binary telemetry (Common/Telemetry.h) from a serial
+ * port or a saved byte stream into an .imucap capture, plus CSVs for the
+ * attitude and loop records:
+ *
+ *     telem2cap /dev/ttyACM0 -o bench.imucap --attitude bench_att.csv
+ *     telem2cap stream.bin --calibrated -o bench_cal.imucap
+ *
+ * A serial port is read until Ctrl-C or --seconds; the files are closed
+ * properly either way.
+ */
+
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+#include "ImuCapture.h"
+#include "SerialPort.h"
+#include "TelemetryDecoder.h"
+
+struct Options {
+    std::string in, out, attitude, loops;
+    bool calibrated = false;
+    double rate = 0.0;
+    double seconds = 0.0;
+    int baud = 115200;
+};
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void OnSignal(int) {
+    g_stop = 1;
+}
+
+static void Usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s [options] in -o out.imucap\n"
+        "  in                  serial port, byte stream file, or - for stdin\n"
+        "  -o FILE             accel/mag/gyro capture\n"
+        "  --calibrated        capture the calibrated records (g, nT, deg/s)\n"
+        "                      instead of the raw counts\n"
+        "  --attitude FILE     CSV of the attitude records\n"
+        "  --loops FILE        CSV of the loop monitor records\n"
+        "  --rate HZ           nominal rate for the capture header\n"
+        "  --seconds S         stop after S seconds of board time\n"
+        "  --baud B            serial port speed (default 115200)\n",
+        prog);
+}
+
+static bool ParseArgs(int argc, char **argv, Options &o) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-" || a[0] != '-') {
+            o.in = a;
+            continue;
+        }
+        if (a == "--calibrated") {
+            o.calibrated = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *next = argv[++i];
+        if (a == "-o") o.out = next;
+        else if (a == "--attitude") o.attitude = next;
+        else if (a == "--loops") o.loops = next;
+        else if (a == "--rate") o.rate = std::atof(next);
+        else if (a == "--seconds") o.seconds = std::atof(next);
+        else if (a == "--baud") o.baud = std::atoi(next);
+        else return false;
+    }
+    return !o.in.empty() && (!o.out.empty() || !o.attitude.empty() || !o.loops.empty());
+}
+
+static void EulerDeg(const float q[4], double &yaw, double &pitch, double &roll) {
+    // Same angles as ExtractEulerAngles() on the DCM the quaternion came from.
+    double w = q[0], x = q[1], y = q[2], z = q[3];
+    const double deg = 180.0 / M_PI;
+    double s = std::fmax(-1.0, std::fmin(1.0, -2.0 * (x * z - w * y)));
+    yaw = std::atan2(2.0 * (x * y + w * z), w * w + x * x - y * y - z * z) * deg;
+    pitch = std::asin(s) * deg;
+    roll = std::atan2(2.0 * (y * z + w * x), w * w - x * x - y * y + z * z) * deg;
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!ParseArgs(argc, argv, o)) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    std::string err;
+    int fd = SerialOpen(o.in, o.baud, err);
+    if (fd < 0) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+
+    CaptureWriter cap;
+    if (!o.out.empty()) {
+        CaptureHeader h = CaptureDefaultHeader();
+        h.channels = CAPTURE_ACCEL | CAPTURE_MAG | CAPTURE_GYRO;
+        for (int c = 0; c < IMU_CHANNELS; c++) {
+            static const CaptureUnits kCalibrated[3] = {CAPTURE_G, CAPTURE_NT, CAPTURE_DEG_S};
+            h.units[c] = o.calibrated ? kCalibrated[c / 3] : CAPTURE_RAW;
+        }
+        h.rateHz = (float)o.rate;
+        std::snprintf(h.source, sizeof(h.source), "telemetry %s%s", o.in.c_str(),
+                      o.calibrated ? " (calibrated)" : "");
+        if (!cap.Open(o.out, h, err)) {
+            std::fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+    }
+    FILE *att = nullptr, *loops = nullptr;
+    if (!o.attitude.empty()) {
+        att = std::fopen(o.attitude.c_str(), "w");
+        if (att == nullptr) {
+            std::fprintf(stderr, "can't write %s\n", o.attitude.c_str());
+            return 1;
+        }
+        std::fprintf(att, "t,qw,qx,qy,qz,yaw,pitch,roll,bx,by,bz\n");
+    }
+    if (!o.loops.empty()) {
+        loops = std::fopen(o.loops.c_str(), "w");
+        if (loops == nullptr) {
+            std::fprintf(stderr, "can't write %s\n", o.loops.c_str());
+            return 1;
+        }
+        std::fprintf(loops, "t,id,runs,misses,max_period_us,max_exec_us,worst_path\n");
+    }
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+
+    TelemetryDecoder dec;
+    std::uint8_t capType = o.calibrated ? TELEM_CALIBRATED : TELEM_RAW;
+    bool started = false;
+    double first = 0.0, last = 0.0;
+    std::uint64_t outOfOrder = 0;
+    auto onFrame = [&](const TelemFrame &f) {
+        if (!started) {
+            first = f.t;
+            started = true;
+        }
+        last = f.t;
+        if (f.header.type == capType && !o.out.empty()) {
+            ImuRecord r;
+            r.t = f.t;
+            if (o.calibrated) {
+                TelemCalibrated c = f.As<TelemCalibrated>();
+                for (int k = 0; k < 3; k++) {
+                    r.Channel(k) = c.acc[k];
+                    r.Channel(3 + k) = c.mag[k];
+                    r.Channel(6 + k) = c.gyro[k];
+                }
+            } else {
+                TelemRaw raw = f.As<TelemRaw>();
+                for (int k = 0; k < 3; k++) {
+                    r.Channel(k) = raw.acc[k];
+                    r.Channel(3 + k) = raw.mag[k];
+                    r.Channel(6 + k) = raw.gyro[k];
+                }
+            }
+            if (!cap.Append(r)) {
+                outOfOrder++;           // the board was reset, its clock started over
+            }
+        } else if (f.header.type == TELEM_ATTITUDE && att != nullptr) {
+            TelemAttitude a = f.As<TelemAttitude>();
+            double yaw, pitch, roll;
+            EulerDeg(a.q, yaw, pitch, roll);
+            std::fprintf(att, "%.6f,%.6f,%.6f,%.6f,%.6f,%.3f,%.3f,%.3f,%g,%g,%g\n", f.t, a.q[0], a.q[1],
+                         a.q[2], a.q[3], yaw, pitch, roll, a.bias[0], a.bias[1], a.bias[2]);
+        } else if (f.header.type == TELEM_LOOP && loops != nullptr) {
+            TelemLoop l = f.As<TelemLoop>();
+            std::fprintf(loops, "%.6f,%u,%u,%u,%u,%u,0x%02x\n", f.t, l.id, l.runs, l.misses, l.maxPeriodUs,
+                         l.maxExecUs, l.worstPath);
+        }
+    };
+
+    std::vector<std::uint8_t> buf(1 << 16);
+    while (!g_stop && !(o.seconds > 0.0 && started && last - first >= o.seconds)) {
+        ssize_t n = read(fd, buf.data(), buf.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        dec.Feed(buf.data(), (std::size_t)n, onFrame);
+    }
+    SerialClose(fd);
+
+    int status = 0;
+    if (!o.out.empty() && !cap.Close(err)) {
+        std::fprintf(stderr, "%s: %s\n", o.out.c_str(), err.c_str());
+        status = 1;
+    }
+    if (att != nullptr) {
+        std::fclose(att);
+    }
+    if (loops != nullptr) {
+        std::fclose(loops);
+    }
+
+    const TelemStats &s = dec.Stats();
+    double span = last - first;
+    std::fprintf(stderr, "%llu bytes, %llu frames over %.3f s\n", (unsigned long long)s.bytes,
+                 (unsigned long long)s.frames, span);
+    static const char *kTypes[] = {"", "raw", "calibrated", "attitude", "loop"};
+    for (int t = TELEM_RAW; t <= TELEM_LOOP; t++) {
+        if (s.perType[t] > 0) {
+            std::fprintf(stderr, "  %-10s %10llu  %8.1f Hz\n", kTypes[t], (unsigned long long)s.perType[t],
+                         span > 0.0 ? (s.perType[t] - 1) / span : 0.0);
+        }
+    }
+    std::fprintf(stderr, "lost %llu, crc errors %llu, malformed %llu, unknown types %llu\n",
+                 (unsigned long long)s.lost, (unsigned long long)s.crcErrors, (unsigned long long)s.malformed,
+                 (unsigned long long)s.unknownTypes);
+    if (outOfOrder > 0) {
+        std::fprintf(stderr, "%llu records went back in time (board reset?) and were left out\n",
+                     (unsigned long long)outOfOrder);
+    }
+    return status;
+}
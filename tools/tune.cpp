@@ -0,0 +1,467 @@
+/*
+ * File:   tune.cpp
+ *
+ * Monte Carlo gain sweep of the closed loop attitude filter
+ * (Common/AttitudeFilter, the IntegrateClosedLoop() of both Lab4 apps):
+ *
+ *     tune --kp 1,2,5,10,20 --ki 0.02,0.05,0.1,0.2 --seeds 32
+ *     tune --motion tumble --kp 2,5,10 --kp-m 1,5 --ki 0.1 --ki-m 0.05,0.1 --csv all.csv
+ *     tune --capture bench.imucap --kp 2,5,10
+ *
+ * Every gain set runs on the same synthetic flights (ImuSim, one per seed,
+ * starting from the identity like the firmware while the board is somewhere
+ * else), or on a recorded capture against the accel/mag TRIAD attitude. The
+ * gain sets are spread over a thread pool; each is scored by
+ *
+ *     convergence   time until the attitude error stays below --settle
+ *     error         rms attitude error over the second half
+ *     bias          rms gyro bias error over the second half (recorded:
+ *                   how much the estimate wanders, there is no truth)
+ *
+ * and the sets no other set beats on all three are printed.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AttitudeFilter.h"
+#include "ImuCapture.h"
+#include "ImuSim.h"
+#include "ThreadPool.h"
+
+#define DEG2RAD (M_PI / 180.0)
+#define RAD2DEG (180.0 / M_PI)
+
+struct Options {
+    std::vector<double> kp{1.0, 2.0, 5.0, 10.0, 20.0};
+    std::vector<double> ki{0.02, 0.05, 0.1, 0.2};   // Ki / Kp
+    std::vector<double> kpm, kim;                   // empty: mag gains follow the accel ones
+    int seeds = 16;
+    double seconds = 120.0;
+    double settle = 2.0;                            // deg
+    SimConfig sim;
+    std::string capture;
+    double gain = 180.0 / 13500.0;                  // deg/s per LSB, as in the Lab4 apps
+    unsigned threads = 0;
+    std::string csv;
+};
+
+// One filter input and the attitude it should come out at.
+struct Sample {
+    float gyro[3];          // rad/s
+    float acc[3];
+    float mag[3];
+    float R[3][3];          // true (or TRIAD) inertial to body
+    float bias[3];          // true gyro bias, deg/s
+};
+
+struct Flight {
+    std::vector<Sample> s;
+    double dt;
+    float gravity[3], field[3];
+    bool hasBias;
+};
+
+struct Score {
+    ATT_Gains g;
+    double conv = 0.0;      // s
+    double err = 0.0;       // deg
+    double bias = 0.0;      // deg/s
+    int converged = 0;
+    bool front = false;
+};
+
+// The gains each application ships with.
+static const struct {
+    const char *name;
+    ATT_Gains g;
+} firmware[] = {
+    {"pourfect_lab4", {5.0f, 0.5f, 5.0f, 0.5f}},
+    {"hhuan143", {10.0f, 1.0f, 10.0f, 1.0f}},
+};
+
+static void Usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        " gains, comma separated lists, every combination is run:\n"
+        "  --kp LIST           Kp_a (default 1,2,5,10,20)\n"
+        "  --ki LIST           Ki_a as a fraction of Kp_a (default 0.02,0.05,0.1,0.2)\n"
+        "  --kp-m LIST         Kp_m (default: same as Kp_a)\n"
+        "  --ki-m LIST         Ki_m as a fraction of Kp_m (default: same as Ki_a)\n"
+        " data:\n"
+        "  --seeds N           synthetic flights per gain set (default 16)\n"
+        "  --seconds S         length of each flight (default 120)\n"
+        "  --motion M          trajectory or tumble (default trajectory)\n"
+        "  --rate HZ           sample rate (default 50)\n"
+        "  --gyro-bias B       gyro bias, uniform +-B/2 deg/s (default 10)\n"
+        "  --gyro-noise N      (default 0.1 deg/s), --accel-noise, --mag-noise as imusim\n"
+        "  --gyro-walk W       gyro bias random walk, deg/s/sqrt(s) (default 0)\n"
+        "  --capture F.imucap  run on a recording (accel, mag and gyro) instead\n"
+        "  --gyro-gain G       deg/s per LSB for a raw gyro capture (default 180/13500)\n"
+        " scoring:\n"
+        "  --settle DEG        converged once the error stays below this (default 2)\n"
+        "  --threads N         worker threads (default: all cores)\n"
+        "  --csv FILE          also write every gain set\n",
+        prog);
+}
+
+static bool ParseList(const char *s, std::vector<double> &v) {
+    v.clear();
+    for (const char *p = s; *p != '\0';) {
+        char *end;
+        double x = std::strtod(p, &end);
+        if (end == p || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+        v.push_back(x);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !v.empty();
+}
+
+static bool ParseArgs(int argc, char **argv, Options &o) {
+    SimConfig &s = o.sim;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *next = argv[++i];
+        double v = std::atof(next);
+        if (a == "--kp") { if (!ParseList(next, o.kp)) return false; }
+        else if (a == "--ki") { if (!ParseList(next, o.ki)) return false; }
+        else if (a == "--kp-m") { if (!ParseList(next, o.kpm)) return false; }
+        else if (a == "--ki-m") { if (!ParseList(next, o.kim)) return false; }
+        else if (a == "--motion") {
+            if (std::strcmp(next, "trajectory") == 0) s.motion = SIM_TRAJECTORY;
+            else if (std::strcmp(next, "tumble") == 0) s.motion = SIM_TUMBLE;
+            else return false;
+        }
+        else if (a == "--seeds") o.seeds = std::atoi(next);
+        else if (a == "--seconds") o.seconds = v;
+        else if (a == "--rate") s.rate = v;
+        else if (a == "--gyro-bias") s.gyro.bias = v;
+        else if (a == "--gyro-noise") s.gyro.noise = v;
+        else if (a == "--accel-noise") s.accel.noise = v;
+        else if (a == "--mag-noise") s.mag.noise = v;
+        else if (a == "--gyro-walk") s.gyroWalk = v;
+        else if (a == "--capture") o.capture = next;
+        else if (a == "--gyro-gain") o.gain = v;
+        else if (a == "--settle") o.settle = v;
+        else if (a == "--threads") o.threads = (unsigned)std::atoi(next);
+        else if (a == "--csv") o.csv = next;
+        else return false;
+    }
+    return o.seeds > 0 && o.seconds > 0.0 && s.rate > 0.0 && o.settle > 0.0;
+}
+
+static void Store(const Mat3 &R, float out[3][3]) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            out[i][j] = (float)R.m[i][j];
+        }
+    }
+}
+
+static void Store(const Vec3 &v, float out[3]) {
+    out[0] = (float)v.x;
+    out[1] = (float)v.y;
+    out[2] = (float)v.z;
+}
+
+static Flight Simulate(const Options &o, int seed) {
+    SimConfig c = o.sim;
+    c.seed = (std::uint64_t)seed + 1;
+    ImuSim sim(c);
+    Flight f;
+    f.dt = 1.0 / c.rate;
+    Store(c.gravity, f.gravity);
+    Store(c.field, f.field);
+    f.hasBias = true;
+    f.s.resize((std::size_t)(o.seconds * c.rate + 0.5));
+    ImuRecord rec;
+    SimTruth t;
+    for (Sample &s : f.s) {
+        sim.Next(rec, &t);
+        for (int i = 0; i < 3; i++) {
+            s.acc[i] = rec.Channel(i);
+            s.mag[i] = rec.Channel(3 + i);
+            s.gyro[i] = (float)(rec.Channel(6 + i) * DEG2RAD);
+        }
+        Store(t.R, s.R);
+        Store(t.gyroBias, s.bias);
+    }
+    return f;
+}
+
+// Body and inertial triads of two vector pairs, R maps the inertial one onto the body one.
+static Mat3 Triad(const Vec3 &a, const Vec3 &m, const Vec3 &g, const Vec3 &h) {
+    Vec3 b1 = Normalize(a), b2 = Normalize(Cross(a, m)), b3 = Cross(b1, b2);
+    Vec3 i1 = Normalize(g), i2 = Normalize(Cross(g, h)), i3 = Cross(i1, i2);
+    Mat3 R;
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            R.m[r][c] = b1[r] * i1[c] + b2[r] * i2[c] + b3[r] * i3[c];
+        }
+    }
+    return R;
+}
+
+static bool Record(const Options &o, Flight &f, std::string &err) {
+    CaptureReader in;
+    if (!in.Open(o.capture, err)) {
+        return false;
+    }
+    const CaptureHeader &h = in.Header();
+    const std::uint32_t all = CAPTURE_ACCEL | CAPTURE_MAG | CAPTURE_GYRO;
+    if ((h.channels & all) != all) {
+        err = o.capture + ": needs accel, mag and gyro channels";
+        return false;
+    }
+    double scale[IMU_CHANNELS];
+    for (int c = 0; c < IMU_CHANNELS; c++) {
+        scale[c] = h.scale[c];
+    }
+    for (int c = 6; c < 9; c++) {
+        if (h.units[c] == CAPTURE_RAW) scale[c] *= o.gain * DEG2RAD;
+        else if (h.units[c] == CAPTURE_DEG_S) scale[c] *= DEG2RAD;
+        else if (h.units[c] != CAPTURE_RAD_S) {
+            err = o.capture + ": gyro channels are not a rate";
+            return false;
+        }
+    }
+    double rate = h.rateHz > 0.0f ? h.rateHz : o.sim.rate;
+    f.dt = 1.0 / rate;
+    Store(o.sim.gravity, f.gravity);
+    Store(o.sim.field, f.field);
+    f.hasBias = false;
+    f.s.reserve(h.count);
+    for (const ImuRecord &r : in.All()) {
+        Sample s;
+        for (int i = 0; i < 3; i++) {
+            s.acc[i] = (float)(r.Channel(i) * scale[i]);
+            s.mag[i] = (float)(r.Channel(3 + i) * scale[3 + i]);
+            s.gyro[i] = (float)(r.Channel(6 + i) * scale[6 + i]);
+            s.bias[i] = 0.0f;
+        }
+        Vec3 a{s.acc[0], s.acc[1], s.acc[2]}, m{s.mag[0], s.mag[1], s.mag[2]};
+        Store(Triad(a, m, o.sim.gravity, o.sim.field), s.R);
+        f.s.push_back(s);
+    }
+    if (f.s.size() < 4) {
+        err = o.capture + ": too short";
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Angle between the estimate and the truth. The float DCM drifts off SO(3) a
+ * little, the rows are straightened first to measure only the rotation.
+ */
+static double ErrorDeg(const float E[3][3], const float T[3][3]) {
+    Vec3 r0{E[0][0], E[0][1], E[0][2]}, r1{E[1][0], E[1][1], E[1][2]};
+    r0 = Normalize(r0);
+    r1 = Normalize(r1 - Dot(r0, r1) * r0);
+    Vec3 r2 = Cross(r0, r1);
+    const Vec3 *rows[3] = {&r0, &r1, &r2};
+    double trace = 0.0;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            trace += (*rows[i])[j] * T[i][j];
+        }
+    }
+    return std::acos(std::fmax(-1.0, std::fmin(1.0, 0.5 * (trace - 1.0)))) * RAD2DEG;
+}
+
+static void Fly(const Flight &f, double settle, Score &sc) {
+    ATT_Filter filt;
+    ATT_Init(&filt, &sc.g, nullptr);
+    std::size_t n = f.s.size(), half = n / 2, last = 0;
+    bool out = true;
+    double err2 = 0.0, b[3] = {0.0, 0.0, 0.0}, b2 = 0.0;
+    for (std::size_t k = 0; k < n; k++) {
+        // the estimate of sample k is the one from before its update
+        const Sample &s = f.s[k];
+        double e = ErrorDeg(filt.R, s.R);
+        out = !(e < settle);        // NaN counts as out
+        if (out) {
+            last = k + 1;
+        }
+        if (k >= half) {
+            err2 += e * e;
+            for (int i = 0; i < 3; i++) {
+                double d = filt.bias[i] * RAD2DEG - (f.hasBias ? s.bias[i] : 0.0);
+                b[i] += d;
+                b2 += d * d;
+            }
+        }
+        ATT_Update(&filt, s.gyro, s.acc, s.mag, f.gravity, f.field, (float)f.dt);
+    }
+    double m = (double)(n - half);
+    sc.conv += out ? n * f.dt : last * f.dt;
+    sc.converged += out ? 0 : 1;
+    sc.err += std::sqrt(err2 / m);
+    if (f.hasBias) {
+        sc.bias += std::sqrt(b2 / m);
+    } else {
+        // no truth: spread of the estimate about its own mean
+        double mean2 = (b[0] * b[0] + b[1] * b[1] + b[2] * b[2]) / (m * m);
+        sc.bias += std::sqrt(std::fmax(0.0, b2 / m - mean2));
+    }
+}
+
+static bool Dominates(const Score &a, const Score &b) {
+    return a.conv <= b.conv && a.err <= b.err && a.bias <= b.bias &&
+           (a.conv < b.conv || a.err < b.err || a.bias < b.bias);
+}
+
+static bool SameGains(const ATT_Gains &a, const ATT_Gains &b) {
+    return std::fabs(a.kp_acc - b.kp_acc) < 1e-6f && std::fabs(a.ki_acc - b.ki_acc) < 1e-6f &&
+           std::fabs(a.kp_mag - b.kp_mag) < 1e-6f && std::fabs(a.ki_mag - b.ki_mag) < 1e-6f;
+}
+
+static std::vector<Score> Grid(const Options &o) {
+    std::vector<Score> v;
+    auto add = [&](const ATT_Gains &g) {
+        for (const Score &s : v) {
+            if (SameGains(s.g, g)) {
+                return;
+            }
+        }
+        Score s;
+        s.g = g;
+        v.push_back(s);
+    };
+    const std::vector<double> &kpm = o.kpm.empty() ? o.kp : o.kpm;
+    const std::vector<double> &kim = o.kim.empty() ? o.ki : o.kim;
+    bool tied = o.kpm.empty() && o.kim.empty();
+    for (double kp : o.kp) {
+        for (double ki : o.ki) {
+            if (tied) {
+                add(ATT_Gains{(float)kp, (float)(kp * ki), (float)kp, (float)(kp * ki)});
+                continue;
+            }
+            for (double pm : kpm) {
+                for (double im : kim) {
+                    add(ATT_Gains{(float)kp, (float)(kp * ki), (float)pm, (float)(pm * im)});
+                }
+            }
+        }
+    }
+    for (const auto &fw : firmware) {
+        add(fw.g);
+    }
+    return v;
+}
+
+static void PrintRow(const Score &s, int flights, const char *note) {
+    std::printf("%7.3g %7.3g %7.3g %7.3g %9.2f %9.3f %10.4f %4d/%-4d %s\n", s.g.kp_acc, s.g.ki_acc, s.g.kp_mag,
+                s.g.ki_mag, s.conv, s.err, s.bias, s.converged, flights, note);
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!ParseArgs(argc, argv, o)) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ThreadPool pool(o.threads);
+    std::vector<Flight> flights;
+    if (!o.capture.empty()) {
+        flights.resize(1);
+        std::string err;
+        if (!Record(o, flights[0], err)) {
+            std::fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+    } else {
+        flights.resize(o.seeds);
+        ParallelFor(pool, flights.size(), [&](std::size_t i) { flights[i] = Simulate(o, (int)i); });
+    }
+    auto loaded = std::chrono::steady_clock::now();
+
+    std::vector<Score> scores = Grid(o);
+    ParallelFor(pool, scores.size(), [&](std::size_t i) {
+        Score &s = scores[i];
+        for (const Flight &f : flights) {
+            Fly(f, o.settle, s);
+        }
+        s.conv /= flights.size();
+        s.err /= flights.size();
+        s.bias /= flights.size();
+        if (!std::isfinite(s.err) || !std::isfinite(s.bias)) {
+            // diverged: keep it off the front
+            s.err = s.bias = HUGE_VAL;
+        }
+    });
+    auto done = std::chrono::steady_clock::now();
+
+    std::vector<Score *> front;
+    for (Score &a : scores) {
+        a.front = true;
+        for (const Score &b : scores) {
+            if (Dominates(b, a)) {
+                a.front = false;
+                break;
+            }
+        }
+        if (a.front) {
+            front.push_back(&a);
+        }
+    }
+    std::sort(front.begin(), front.end(), [](const Score *a, const Score *b) { return a->err < b->err; });
+
+    int nf = (int)flights.size();
+    std::printf("%7s %7s %7s %7s %9s %9s %10s %9s\n", "Kp_a", "Ki_a", "Kp_m", "Ki_m", "conv (s)", "err (deg)",
+                o.capture.empty() ? "bias (d/s)" : "wander", "settled");
+    for (const Score *s : front) {
+        const char *note = "";
+        for (const auto &fw : firmware) {
+            if (SameGains(s->g, fw.g)) {
+                note = fw.name;
+            }
+        }
+        PrintRow(*s, nf, note);
+    }
+    std::printf("\nshipped gains:\n");
+    for (const auto &fw : firmware) {
+        for (const Score &s : scores) {
+            if (SameGains(s.g, fw.g)) {
+                PrintRow(s, nf, s.front ? fw.name : (std::string(fw.name) + ", dominated").c_str());
+            }
+        }
+    }
+
+    if (!o.csv.empty()) {
+        FILE *out = std::fopen(o.csv.c_str(), "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "can't write %s\n", o.csv.c_str());
+            return 1;
+        }
+        std::fprintf(out, "kp_a,ki_a,kp_m,ki_m,conv_s,err_deg,bias_dps,settled,flights,pareto\n");
+        for (const Score &s : scores) {
+            std::fprintf(out, "%g,%g,%g,%g,%.4f,%.5f,%.6f,%d,%d,%d\n", s.g.kp_acc, s.g.ki_acc, s.g.kp_mag,
+                         s.g.ki_mag, s.conv, s.err, s.bias, s.converged, nf, s.front ? 1 : 0);
+        }
+        std::fclose(out);
+    }
+
+    std::size_t samples = 0;
+    for (const Flight &f : flights) {
+        samples += f.s.size();
+    }
+    double tl = std::chrono::duration<double>(loaded - start).count();
+    double tr = std::chrono::duration<double>(done - loaded).count();
+    std::fprintf(stderr, "%zu gain sets x %d flights (%zu samples) on %u threads: data %.3f s, runs %.3f s, %.1f M steps/s\n",
+                 scores.size(), nf, samples, pool.Size(), tl, tr, (double)samples * scores.size() / tr / 1e6);
+    return 0;
+}